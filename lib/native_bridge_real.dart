@@ -40,6 +40,10 @@ final class MelConfigNative extends Struct {
   
   @Float()
   external double maxFreq;
+
+  // Non-zero selects the integer DSP pipeline
+  @Int32()
+  external int fixedPoint;
 }
 
 typedef InitAudioInputFunc = Int32 Function(Pointer<AudioConfigNative> config);
@@ -59,6 +63,31 @@ typedef ProcessAudioFrameFunc = Int32 Function(Pointer<Int16> inputBuffer, Int32
 typedef ProcessAudioFrame = int Function(Pointer<Int16> inputBuffer, int bufferSize, 
                                          Pointer<Float> outputBuffer, int outputSize);
 
+typedef ProcessAudioFramesFunc = Int32 Function(Pointer<Int16> input, Int32 numSamples,
+                                                Pointer<Float> output, Int32 outputCapacity,
+                                                Pointer<Int32> framesProduced);
+typedef ProcessAudioFrames = int Function(Pointer<Int16> input, int numSamples,
+                                          Pointer<Float> output, int outputCapacity,
+                                          Pointer<Int32> framesProduced);
+
+typedef EnableMelRingFunc = Int32 Function(Int32 capacity);
+typedef EnableMelRing = int Function(int capacity);
+
+typedef GetMelRingFunc = Pointer<Uint8> Function(Pointer<Int32> sizeBytes);
+typedef GetMelRing = Pointer<Uint8> Function(Pointer<Int32> sizeBytes);
+
+typedef StartPipelineFunc = Int32 Function(Int32 columnCapacity);
+typedef StartPipeline = int Function(int columnCapacity);
+
+typedef SetPipelineInputRateFunc = Int32 Function(Int32 sampleRate);
+typedef SetPipelineInputRate = int Function(int sampleRate);
+
+typedef CanonicalAnalysisRateFunc = Int32 Function(Int32 inputRate, Float maxFreq);
+typedef CanonicalAnalysisRate = int Function(int inputRate, double maxFreq);
+
+typedef PipelineControlFunc = Int32 Function();
+typedef PipelineControl = int Function();
+
 typedef GetMelDataSizeFunc = Int32 Function();
 typedef GetMelDataSize = int Function();
 
@@ -80,6 +109,48 @@ typedef SetTextureColorMap = int Function(int colorMapType);
 typedef SetTextureMinMaxFunc = Int32 Function(Double minValue, Double maxValue);
 typedef SetTextureMinMax = int Function(double minValue, double maxValue);
 
+/// Read-only view of the native mel frame ring (layout in mel_frame_ring.h).
+///
+/// Frames are read straight out of native memory: poll [sequence] and take
+/// [latestFrame] when it changes. No FFI call happens per frame; the only
+/// copy is the frame itself, into a caller-supplied list if one is given.
+class MelRingView {
+  MelRingView._(this._base) {
+    final header = _base.cast<Uint32>();
+    capacity = header[2];
+    numMelBands = header[3];
+    _frameStride = header[4] ~/ 4;
+    _frames = (_base + header[5]).cast<Float>().asTypedList(capacity * _frameStride);
+    _counters = (_base + 24).cast<Uint64>();
+  }
+
+  final Pointer<Uint8> _base;
+  late final int capacity;
+  late final int numMelBands;
+  late final int _frameStride;
+  late final Float32List _frames;
+  late final Pointer<Uint64> _counters;
+
+  /// Number of frames published so far.
+  int get sequence => _counters[0];
+
+  /// Copy of the newest frame, or null if none is available intact.
+  ///
+  /// The copy goes into [into] when it holds numMelBands floats, otherwise
+  /// into a new list. It is taken before the write counter is checked, so a
+  /// frame the writer started overwriting mid-copy is reported as null.
+  Float32List? latestFrame([Float32List? into]) {
+    final published = sequence;
+    if (published == 0) return null;
+    final index = published - 1;
+    final start = (index % capacity) * _frameStride;
+    final frame = into != null && into.length == numMelBands ? into : Float32List(numMelBands);
+    frame.setRange(0, numMelBands, _frames, start);
+    // Intact unless the writer had started overwriting this slot by the end of the copy
+    return _counters[1] <= index + capacity ? frame : null;
+  }
+}
+
 class NativeBridgeReal {
   static DynamicLibrary? _lib;
   static bool _initialized = false;
@@ -90,6 +161,14 @@ class NativeBridgeReal {
   static StopRecording? _stopRecording;
   static InitMelProcessor? _initMelProcessor;
   static ProcessAudioFrame? _processAudioFrame;
+  static ProcessAudioFrames? _processAudioFrames;
+  static EnableMelRing? _enableMelRing;
+  static GetMelRing? _getMelRing;
+  static StartPipeline? _startPipeline;
+  static PipelineControl? _stopPipeline;
+  static PipelineControl? _pollPipeline;
+  static SetPipelineInputRate? _setPipelineInputRate;
+  static CanonicalAnalysisRate? _canonicalAnalysisRate;
   static GetMelDataSize? _getMelDataSize;
   static GetErrorMessage? _getErrorMessage;
   static InitTextureRenderer? _initTextureRenderer;
@@ -98,6 +177,34 @@ class NativeBridgeReal {
   static SetTextureColorMap? _setTextureColorMap;
   static SetTextureMinMax? _setTextureMinMax;
   
+  // Native buffers reused across calls; grown on demand, never freed per call
+  static Pointer<Int16> _sampleBuffer = nullptr;
+  static int _sampleCapacity = 0;
+  static Pointer<Float> _melBuffer = nullptr;
+  static int _melCapacity = 0;
+  static Pointer<Int32> _framesProduced = nullptr;
+  static Float32List _lastMel = Float32List(0);
+  static int _analysisRate = 0;
+  static int _frameSize = 1024;
+  
+  static void _ensureSampleCapacity(int samples) {
+    if (samples <= _sampleCapacity) return;
+    if (_sampleBuffer != nullptr) malloc.free(_sampleBuffer);
+    _sampleBuffer = malloc<Int16>(samples);
+    _sampleCapacity = samples;
+  }
+  
+  // The first [keep] floats survive a reallocation, which then at least doubles
+  static void _ensureMelCapacity(int floats, {int keep = 0}) {
+    if (floats <= _melCapacity) return;
+    final capacity = keep > 0 ? math.max(floats, 2 * _melCapacity) : floats;
+    final grown = malloc<Float>(capacity);
+    if (keep > 0) grown.asTypedList(keep).setAll(0, _melBuffer.asTypedList(keep));
+    if (_melBuffer != nullptr) malloc.free(_melBuffer);
+    _melBuffer = grown;
+    _melCapacity = capacity;
+  }
+  
   static void _loadLibrary() {
     if (_lib != null) return;
     
@@ -126,6 +233,14 @@ class NativeBridgeReal {
     _stopRecording = _lib!.lookupFunction<StopRecordingFunc, StopRecording>('stop_recording');
     _initMelProcessor = _lib!.lookupFunction<InitMelProcessorFunc, InitMelProcessor>('init_mel_processor');
     _processAudioFrame = _lib!.lookupFunction<ProcessAudioFrameFunc, ProcessAudioFrame>('process_audio_frame');
+    _processAudioFrames = _lib!.lookupFunction<ProcessAudioFramesFunc, ProcessAudioFrames>('process_audio_frames');
+    _enableMelRing = _lib!.lookupFunction<EnableMelRingFunc, EnableMelRing>('enable_mel_ring');
+    _getMelRing = _lib!.lookupFunction<GetMelRingFunc, GetMelRing>('get_mel_ring');
+    _startPipeline = _lib!.lookupFunction<StartPipelineFunc, StartPipeline>('start_pipeline');
+    _stopPipeline = _lib!.lookupFunction<PipelineControlFunc, PipelineControl>('stop_pipeline');
+    _pollPipeline = _lib!.lookupFunction<PipelineControlFunc, PipelineControl>('poll_pipeline');
+    _setPipelineInputRate = _lib!.lookupFunction<SetPipelineInputRateFunc, SetPipelineInputRate>('set_pipeline_input_rate');
+    _canonicalAnalysisRate = _lib!.lookupFunction<CanonicalAnalysisRateFunc, CanonicalAnalysisRate>('canonical_analysis_rate');
     _getMelDataSize = _lib!.lookupFunction<GetMelDataSizeFunc, GetMelDataSize>('get_mel_data_size');
     _getErrorMessage = _lib!.lookupFunction<GetErrorMessageFunc, GetErrorMessage>('get_error_message');
     _initTextureRenderer = _lib!.lookupFunction<InitTextureRendererFunc, InitTextureRenderer>('init_texture_renderer');
@@ -156,6 +271,11 @@ class NativeBridgeReal {
     return result;
   }
   
+  /// Sets up the mel processor for audio arriving at [sampleRate].
+  ///
+  /// The processor runs at the native canonical analysis rate for [maxFreq]
+  /// (16 or 32 kHz when the band fits, otherwise [sampleRate]); pipeline audio
+  /// is resampled to it on the DSP thread.
   static int initializeMelProcessor({
     required int numFilters,
     required double minFreq,
@@ -164,20 +284,34 @@ class NativeBridgeReal {
   }) {
     if (!_initialized) _loadLibrary();
     
+    final deviceRate = sampleRate.toInt();
+    final analysisRate = _canonicalAnalysisRate!(deviceRate, maxFreq);
+    if (analysisRate <= 0) return -1;
+    
+    // Same 32 ms window at 16 kHz as 1024 samples give at 32 kHz
+    final frameSize = analysisRate <= 16000 ? 512 : 1024;
+    
     final config = malloc<MelConfigNative>();
-    config.ref.sampleRate = sampleRate.toInt();
-    config.ref.frameSize = 1024;
-    config.ref.hopSize = 512;
+    config.ref.sampleRate = analysisRate;
+    config.ref.frameSize = frameSize;
+    config.ref.hopSize = frameSize ~/ 2;
     config.ref.numMelBands = numFilters;
     config.ref.minFreq = minFreq;
     config.ref.maxFreq = maxFreq;
+    config.ref.fixedPoint = 0;
     
     final result = _initMelProcessor!(config);
     malloc.free(config);
+    if (result != 0) return result;
     
-    return result;
+    _analysisRate = analysisRate;
+    _frameSize = frameSize;
+    return _setPipelineInputRate!(deviceRate == analysisRate ? 0 : deviceRate);
   }
   
+  /// Rate the mel processor runs at; 0 before [initializeMelProcessor].
+  static int get analysisRate => _analysisRate;
+  
   static int startRecording() {
     if (!_initialized) return -1;
     return _startRecording!();
@@ -192,28 +326,96 @@ class NativeBridgeReal {
     if (!_initialized) return -1;
     
     // Generate mock audio data for now
-    final mockData = malloc<Int16>(1024);
-    final outputBuffer = malloc<Float>(256);
+    _ensureSampleCapacity(_frameSize);
+    _ensureMelCapacity(256);
     
-    for (int i = 0; i < 1024; i++) {
-      mockData[i] = (math.sin(i * 0.1) * 32767).toInt();
+    for (int i = 0; i < _frameSize; i++) {
+      _sampleBuffer[i] = (math.sin(i * 0.1) * 32767).toInt();
     }
     
-    final result = _processAudioFrame!(mockData, 1024, outputBuffer, 256);
-    
-    malloc.free(mockData);
-    malloc.free(outputBuffer);
+    final result = _processAudioFrame!(_sampleBuffer, _frameSize, _melBuffer, 256);
+    if (result > 0) {
+      _lastMel = Float32List.fromList(_melBuffer.asTypedList(result));
+    }
     
     return result;
   }
   
+  /// Streams [samples] through hop-based framing.
+  ///
+  /// Direct calls are not resampled: [samples] must be at [analysisRate].
+  /// Returns all mel frames produced, back to back (getMelDataSize() floats
+  /// each). Native calls take up to [maxFrames] frames each and repeat until
+  /// every sample is consumed. The list is a view of a reused native buffer
+  /// and is only valid until the next call; copy it if it must outlive that.
+  static Float32List processAudioSamples(Int16List samples, {int maxFrames = 64}) {
+    if (!_initialized) return Float32List(0);
+    
+    final numBands = _getMelDataSize!();
+    if (numBands <= 0 || maxFrames <= 0) return Float32List(0);
+    
+    _ensureSampleCapacity(samples.length);
+    _ensureMelCapacity(maxFrames * numBands);
+    if (_framesProduced == nullptr) _framesProduced = malloc<Int32>();
+    _sampleBuffer.asTypedList(samples.length).setAll(0, samples);
+    
+    // A full output holds the rest of the input back; grow and go again
+    var offset = 0;
+    var frames = 0;
+    while (offset < samples.length) {
+      _ensureMelCapacity((frames + maxFrames) * numBands, keep: frames * numBands);
+      final consumed = _processAudioFrames!(_sampleBuffer + offset, samples.length - offset,
+                                            _melBuffer + frames * numBands, maxFrames * numBands,
+                                            _framesProduced);
+      if (consumed < 0) return Float32List(0);
+      // Frames straddling carried-over samples can fill the output before any input is consumed
+      final produced = _framesProduced.value;
+      frames += produced;
+      offset += consumed;
+      if (consumed == 0 && produced == 0) break;
+    }
+    
+    final output = _melBuffer.asTypedList(frames * numBands);
+    if (frames > 0) _lastMel = output.sublist((frames - 1) * numBands);
+    return output;
+  }
+  
+  /// Enables the shared mel ring and returns a view over it (null on failure).
+  /// Call again after re-initializing the mel processor with a new band count.
+  static MelRingView? openMelRing({int capacity = 64}) {
+    if (!_initialized) return null;
+    if (_enableMelRing!(capacity) != 0) return null;
+    
+    final base = _getMelRing!(nullptr);
+    return base == nullptr ? null : MelRingView._(base);
+  }
+  
+  /// Runs audio input -> mel -> texture on a native DSP thread. The UI then only
+  /// calls [pollPipeline] once per frame; direct processing calls fail meanwhile.
+  static bool startPipeline({int columnCapacity = 256}) {
+    if (!_initialized) return false;
+    return _startPipeline!(columnCapacity) == 0;
+  }
+  
+  static void stopPipeline() {
+    if (!_initialized) return;
+    _stopPipeline!();
+  }
+  
+  /// Uploads columns produced since the last call; returns how many, or -1.
+  static int pollPipeline() {
+    if (!_initialized) return -1;
+    return _pollPipeline!();
+  }
+  
   static Float32List getMelData() {
     if (!_initialized) return Float32List(0);
     
     final size = _getMelDataSize!();
     if (size <= 0) return Float32List(0);
+    if (_lastMel.length == size) return _lastMel;
     
-    // For now, return mock data until we implement proper data retrieval
+    // Nothing processed yet: return mock data
     final mockData = Float32List(size);
     for (int i = 0; i < size; i++) {
       mockData[i] = math.Random().nextDouble();
@@ -242,15 +444,10 @@ class NativeBridgeReal {
   static int updateTextureColumn(Float32List melData) {
     if (!_initialized) return -1;
     
-    final dataPtr = malloc<Float>(melData.length);
-    for (int i = 0; i < melData.length; i++) {
-      dataPtr[i] = melData[i];
-    }
-    
-    final result = _updateTextureColumn!(dataPtr, melData.length);
-    malloc.free(dataPtr);
+    _ensureMelCapacity(melData.length);
+    _melBuffer.asTypedList(melData.length).setAll(0, melData);
     
-    return result;
+    return _updateTextureColumn!(_melBuffer, melData.length);
   }
   
   static int getTextureId() {
@@ -0,0 +1,66 @@
+#ifndef ACTIVITY_GATE_H
+#define ACTIVITY_GATE_H
+
+#include <cstdint>
+
+namespace melspectrogram {
+
+/**
+ * @brief When a frame counts as quiet enough to skip the spectral stages
+ *
+ * The gate opens as soon as a frame's level reaches thresholdDb and closes
+ * once hangoverFrames consecutive frames have stayed below
+ * thresholdDb - hysteresisDb, so speech pauses and level jitter around the
+ * threshold do not make it chatter. With maxFlatness below 1, frames whose
+ * flatness exceeds it (steady hiss, fan noise) are treated as quiet however
+ * loud they are.
+ */
+struct ActivityGateConfig {
+    bool enabled = false;
+    float thresholdDb = -50.0f;   // Frame RMS in dB relative to int16 full scale
+    float hysteresisDb = 6.0f;
+    int hangoverFrames = 8;
+    float maxFlatness = 1.0f;     // 1 turns the flatness test off; ~0.8 gates broadband noise
+};
+
+// Time-domain measurements of one frame
+struct FrameActivity {
+    float levelDb = -200.0f;      // RMS of the frame with its mean removed, in dBFS
+    /**
+     * 1 - r1^2, where r1 is the normalized lag-1 autocorrelation: the
+     * spectral flatness of the first-order all-pole fit to the frame. Close
+     * to 1 for white noise, close to 0 for tonal or low-pass signals such as
+     * voiced speech.
+     */
+    float flatness = 1.0f;
+};
+
+// One integer pass over the samples: sum, sum of squares and lag-1 products
+FrameActivity measureActivity(const int16_t* input, int frameSize);
+
+/**
+ * @brief Hysteresis state machine over per-frame measurements
+ *
+ * Feed one FrameActivity per hop; update() returns whether the frame is
+ * active and should be fully processed. A new gate starts closed.
+ */
+class ActivityGate {
+public:
+    explicit ActivityGate(const ActivityGateConfig& config = ActivityGateConfig()) : config_(config) {}
+
+    void setConfig(const ActivityGateConfig& config);
+    const ActivityGateConfig& getConfig() const { return config_; }
+
+    bool update(const FrameActivity& activity);
+    bool isOpen() const { return open_; }
+    void reset();
+
+private:
+    ActivityGateConfig config_;
+    bool open_ = false;
+    int quietFrames_ = 0;
+};
+
+} // namespace melspectrogram
+
+#endif // ACTIVITY_GATE_H
@@ -0,0 +1,63 @@
+#ifndef ALIGNED_ARENA_H
+#define ALIGNED_ARENA_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace melspectrogram {
+
+/**
+ * @brief One cache-line-aligned allocation carved into buffers
+ *
+ * Buffers are laid out in the order they are reserved, each starting on a
+ * 64-byte boundary and padded to a whole number of cache lines, which also
+ * covers every SIMD width in use. Reserve everything first, then allocate();
+ * the pointers stay valid until the next allocate() or clear().
+ */
+class AlignedArena {
+public:
+    static constexpr size_t ALIGNMENT = 64;
+
+    // Offset of a new block of count T; pass it to at() after allocate()
+    template <class T>
+    size_t reserve(size_t count) {
+        const size_t offset = size_;
+        size_ += padded(count * sizeof(T));
+        return offset;
+    }
+
+    // Allocate the reserved size, zero-filled
+    void allocate() {
+        storage_.assign(size_ + ALIGNMENT - 1, 0);
+        const uintptr_t address = reinterpret_cast<uintptr_t>(storage_.data());
+        base_ = storage_.data() + ((ALIGNMENT - address % ALIGNMENT) % ALIGNMENT);
+    }
+
+    template <class T>
+    T* at(size_t offset) const {
+        return reinterpret_cast<T*>(base_ + offset);
+    }
+
+    // Reserved bytes, padding included
+    size_t size() const { return size_; }
+
+    void clear() {
+        storage_.clear();
+        base_ = nullptr;
+        size_ = 0;
+    }
+
+    static size_t padded(size_t bytes) {
+        return (bytes + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    }
+
+private:
+    std::vector<uint8_t> storage_;
+    uint8_t* base_ = nullptr;
+    size_t size_ = 0;
+};
+
+} // namespace melspectrogram
+
+#endif // ALIGNED_ARENA_H
@@ -0,0 +1,157 @@
+#ifndef CONSTANT_Q_H
+#define CONSTANT_Q_H
+
+#include <vector>
+#include <complex>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+namespace melspectrogram {
+
+struct CqtConfig {
+    int sampleRate = 32000;
+    int hopSize = 512;           // A multiple of 2^(numOctaves - 1), so every octave keeps whole hops
+    float minFreq = 32.7032f;    // C1, the centre of the lowest bin
+    int binsPerOctave = 12;
+    int numOctaves = 7;
+    float sparsity = 0.0054f;    // Kernel weights below this fraction of a bin's peak are dropped
+};
+
+/**
+ * @brief Immutable constant-Q tables: a sparse spectral kernel for one octave and a halfband decimator
+ *
+ * Bins sit at minFreq * 2^(b / binsPerOctave), each the inner product of
+ * the signal with a Hann-windowed complex exponential of Q cycles,
+ * Q = 1 / (2^(1 / binsPerOctave) - 1), scaled by 1 / atom length.
+ *
+ * Brown-Puckette: the atoms of the top octave are taken to the frequency
+ * domain once, thresholded, and kept as [start, end) bin ranges of complex
+ * weights, the same row-and-range layout as the mel filters, so a bin
+ * costs a few dozen multiply-adds on an FFT of getFftSize() samples.
+ * Lower octaves reuse the same kernel and FFT size on the signal
+ * decimated by 2 per octave, so the lowest octave, whose atoms span
+ * 2^(numOctaves - 1) times as many input samples, still costs one small FFT.
+ *
+ * Plans are shared through acquire() like MelPlan; all methods are const.
+ */
+class CqtPlan {
+public:
+    explicit CqtPlan(const CqtConfig& config);
+    ~CqtPlan();
+
+    CqtPlan(const CqtPlan&) = delete;
+    CqtPlan& operator=(const CqtPlan&) = delete;
+
+    // Shared plan for config; null when validate() rejects it
+    static std::shared_ptr<const CqtPlan> acquire(const CqtConfig& config);
+    // The top octave must lie below a quarter of the sample rate, and hopSize must divide evenly
+    static bool validate(const CqtConfig& config);
+
+    // hopSize is that of the config that built the plan; plans are shared across hop sizes
+    const CqtConfig& getConfig() const { return config_; }
+    int getNumBins() const { return config_.binsPerOctave * config_.numOctaves; }
+    float getQ() const { return q_; }
+    float getBinFrequency(int bin) const;
+    int getFftSize() const { return fftSize_; }
+
+    // Kernel of bin k of an octave: weights for FFT bins [start, end), conjugated and divided by N
+    int getKernelStart(int k) const { return kernelStart_[k]; }
+    int getKernelEnd(int k) const { return kernelEnd_[k]; }
+    const std::complex<float>* getKernel(int k) const { return kernel_.data() + kernelOffset_[k]; }
+    size_t getKernelNonZeros() const { return kernel_.size(); }
+
+    // Odd-length linear-phase lowpass at a quarter of its input rate
+    const std::vector<float>& getDecimatorTaps() const { return decimatorTaps_; }
+
+    // In-order complex FFT of getFftSize() points
+    void fft(const std::complex<float>* input, std::complex<float>* output) const;
+    // binsPerOctave powers |X|^2 of one octave from its spectrum
+    void applyKernel(const std::complex<float>* spectrum, float* power) const;
+
+private:
+    void createKernel();
+    void createDecimator();
+
+    CqtConfig config_;
+    float q_;
+    int fftSize_;
+    std::vector<std::complex<float>> kernel_;  // Packed rows
+    std::vector<int> kernelStart_;
+    std::vector<int> kernelEnd_;
+    std::vector<size_t> kernelOffset_;
+    std::vector<float> decimatorTaps_;
+    void* kissFFTConfig_;
+};
+
+/**
+ * @brief Streaming constant-Q columns, one per hop, ready for TextureRenderer
+ *
+ * Samples are framed by hop like MelSpectrogramProcessor::processAudioSamples.
+ * Octave o runs at sampleRate / 2^o, fed by a chain of decimators as the
+ * input arrives. Each octave's frame is taken far enough back that all
+ * atoms share one centre, getLatencySamples() before the newest input.
+ * A column is the power of every bin, lowest first, through
+ * MelPlan::logScale: dB, then normalized to 0-1 like a mel frame, so it
+ * goes to TextureRenderer::updateColumn / enqueueColumn with
+ * numMelBands = getNumBins().
+ */
+class ConstantQProcessor {
+public:
+    explicit ConstantQProcessor(const CqtConfig& config);
+    ~ConstantQProcessor();
+
+    // False when the config was rejected; processing then fails
+    bool isValid() const { return plan_ != nullptr; }
+
+    /**
+     * @brief Stream any number of samples, writing a column per completed hop
+     *
+     * Columns of getNumBins() floats go to output back to back. When
+     * maxFrames is reached the remaining input is left unconsumed; a null
+     * output only keeps the latest column (getOutputData()).
+     *
+     * @return Number of input samples consumed, or -1 on invalid arguments
+     */
+    long processAudioSamples(const int16_t* input, size_t numSamples,
+                             float* output, size_t maxFrames, size_t* framesProduced);
+    // Drop all history so the next call starts a new stream
+    void reset();
+
+    int getNumBins() const { return plan_ ? plan_->getNumBins() : 0; }
+    int getHopSize() const { return hopSize_; }
+    const CqtPlan& getPlan() const { return *plan_; }
+    // Latest column, normalized 0-1
+    const float* getOutputData() const { return output_.data(); }
+    // Latest column before the log stage, |X|^2 per bin
+    const float* getPowerData() const { return power_.data(); }
+    // Input samples between the shared atom centre and the end of the latest hop
+    int getLatencySamples() const { return latency_; }
+
+private:
+    // Run a piece of full-rate input through the octave chain
+    void feed(const int16_t* input, size_t count);
+    void computeColumn();
+
+    struct Octave {
+        std::vector<float> history;         // Newest samples at this octave's rate: a frame plus lag
+        size_t lag = 0;                     // Samples between the frame's end and the newest sample
+        std::vector<float> incoming;        // This octave's samples from the current piece of input
+        std::vector<float> decimatorInput;  // Samples the next octave's decimator still reads
+        size_t decimatorPosition = 0;       // Newest sample of the next decimated output's window
+    };
+
+    std::shared_ptr<const CqtPlan> plan_;
+    int hopSize_;
+    std::vector<Octave> octaves_;
+    std::vector<std::complex<float>> fftInput_;
+    std::vector<std::complex<float>> fftOutput_;
+    std::vector<float> power_;
+    std::vector<float> output_;
+    size_t pendingSamples_ = 0;       // Input since the last column
+    int latency_ = 0;
+};
+
+} // namespace melspectrogram
+
+#endif // CONSTANT_Q_H
@@ -0,0 +1,77 @@
+#ifndef DELTA_STREAM_H
+#define DELTA_STREAM_H
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace melspectrogram {
+
+struct DeltaConfig {
+    bool enabled = false;
+    int window = 2;  // N: deltas regress over frames t - N ... t + N
+};
+
+/**
+ * @brief Streaming delta and delta-delta features
+ *
+ * Regression deltas over +-N frames (HTK / Kaldi add-deltas):
+ *
+ *   d[t] = sum_{n=1..N} n * (x[t + n] - x[t - n]) / (2 * sum_{n=1..N} n^2)
+ *
+ * and delta-deltas the same regression over d. Frame indices are clamped to
+ * the stream, so the first frame stands in for earlier ones and, on
+ * drain(), the last for later ones. d[t] needs x up to t + N and dd[t]
+ * needs d up to t + N, so frame t comes out 2N frames after it went in;
+ * getLatencyFrames() is that lookahead.
+ *
+ * Frames live in a ring of 3N + 1 slots, each holding [x | d | dd]
+ * contiguously. A push writes x into the newest slot, d into the slot N
+ * frames back and dd into the slot 2N frames back, which is then the
+ * output: getOutput() points into the ring and nothing is copied. Each
+ * push costs 2N passes of numFeatures, vectorized across features.
+ */
+class DeltaStream {
+public:
+    DeltaStream(int numFeatures, int window = 2);
+
+    // Add the next frame; true when getOutput() holds a newly completed frame
+    bool push(const float* frame);
+    // Complete the oldest frame still waiting for lookahead, as if the last frame repeated.
+    // False once every pushed frame has been output
+    bool drain();
+    // Forget the stream; the next push starts a new one
+    void reset();
+
+    // [x | d | dd] of frame getOutputIndex(); null before the first output. Valid until the next push
+    const float* getOutput() const { return output_; }
+    int64_t getOutputIndex() const { return emitted_ - 1; }
+    int getLatencyFrames() const { return 2 * window_; }
+    int getNumFeatures() const { return numFeatures_; }
+    int getWindow() const { return window_; }
+    size_t getFrameSize() const { return static_cast<size_t>(numFeatures_) * 3; }
+    size_t getBytes() const { return ring_.size() * sizeof(float); }
+
+private:
+    // frame null repeats the newest frame
+    bool step(const float* frame);
+    float* slot(int64_t index) {
+        const int64_t slots = 3 * window_ + 1;
+        return ring_.data() + static_cast<size_t>(((index % slots) + slots) % slots) * getFrameSize();
+    }
+
+    int numFeatures_;
+    int window_;
+    float normalizer_;            // 1 / (2 * sum n^2)
+    std::vector<float> ring_;
+    std::vector<const float*> later_;     // Rows t + 1 ... t + N for the regression
+    std::vector<const float*> earlier_;   // Rows t - 1 ... t - N
+    int64_t pushed_ = 0;          // Frames given to push()
+    int64_t steps_ = 0;           // Frames entered into the ring, including drain() repeats
+    int64_t emitted_ = 0;
+    const float* output_ = nullptr;
+};
+
+} // namespace melspectrogram
+
+#endif // DELTA_STREAM_H
@@ -0,0 +1,219 @@
+#ifndef FEATURE_GRAPH_H
+#define FEATURE_GRAPH_H
+
+#include <vector>
+#include <complex>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+#include "mel_spectrogram.h"
+#include "aligned_arena.h"
+#include "mfcc.h"
+
+namespace melspectrogram {
+
+class MelPlan;
+
+/**
+ * @brief Intermediate buffers of one hop, in dependency order
+ *
+ * Each node is computed from the one before it by the MelPlan stage the
+ * processor's runtime path uses, so needing a node means computing every
+ * node up to it.
+ */
+enum class FeatureNode {
+    WINDOWED_FRAME,  // windowFrame(): int16 to windowed complex samples
+    SPECTRUM,        // fft()
+    POWER_SPECTRUM,  // powerSpectrum(), numBins values
+    MEL_ENERGIES,    // applyFilterBank(), linear power per mel band
+    LOG_MEL,         // logScale() of a copy: dB values and the normalized 0-1 mel frame
+    COUNT
+};
+
+// Intermediates of the current hop; nodes past the graph's deepest one are null
+struct FeatureFrame {
+    const MelPlan* plan = nullptr;
+    const std::complex<float>* windowed = nullptr;
+    const std::complex<float>* spectrum = nullptr;
+    const float* power = nullptr;
+    const float* melEnergies = nullptr;
+    const float* decibels = nullptr;  // Log-mel before normalization
+    const float* logMel = nullptr;    // Normalized 0-1, as MelSpectrogramProcessor emits it
+};
+
+/**
+ * @brief One feature computed from a hop's shared intermediates
+ *
+ * Extractors only read the FeatureFrame; they never run a stage themselves.
+ * State kept across hops (e.g. the previous spectrum for flux) is cleared by
+ * reset().
+ */
+class FeatureExtractor {
+public:
+    virtual ~FeatureExtractor() = default;
+
+    // Deepest intermediate the extractor reads; shallower ones are available too
+    virtual FeatureNode getInput() const = 0;
+    // Build tables for the graph's plan; called once, before getSize() and compute()
+    virtual void prepare(const MelPlan& plan) { (void)plan; }
+    // Values written per hop
+    virtual int getSize() const = 0;
+    virtual void compute(const FeatureFrame& frame, float* output) = 0;
+    virtual void reset() {}
+};
+
+/**
+ * @brief Several features from one FFT per hop
+ *
+ * Extractors register against the intermediates they read. Per hop the
+ * graph runs the stages up to the deepest node any extractor needs, once
+ * each, then every extractor's kernel on the shared buffers; a node no
+ * extractor needs is never computed. All intermediates and outputs live in
+ * one aligned arena, outputs back to back in registration order.
+ */
+class FeatureGraph {
+public:
+    explicit FeatureGraph(const AudioConfig& config);
+    ~FeatureGraph();
+
+    FeatureGraph(const FeatureGraph&) = delete;
+    FeatureGraph& operator=(const FeatureGraph&) = delete;
+
+    // Returns the extractor's index for getOutput()
+    int addExtractor(std::unique_ptr<FeatureExtractor> extractor);
+
+    // One frame of frameSize samples; false if the size is wrong or nothing is registered
+    bool processFrame(const int16_t* input, size_t inputSize);
+    // Clear extractor state so the next frame starts a new stream
+    void reset();
+
+    const float* getOutput(int index) const { return outputs_ + outputOffsets_[index]; }
+    int getOutputSize(int index) const { return extractors_[index]->getSize(); }
+    // Every extractor's output for the hop, back to back in registration order
+    const float* getOutputs() const { return outputs_; }
+    size_t getTotalOutputSize() const { return totalOutputSize_; }
+    int getNumExtractors() const { return static_cast<int>(extractors_.size()); }
+
+    const MelPlan& getPlan() const { return *plan_; }
+    // Deepest node computed per hop; COUNT while no extractor is registered
+    FeatureNode getDeepestNode() const { return deepest_; }
+    // Times a node was computed since construction
+    uint64_t getNodeEvaluations(FeatureNode node) const { return evaluations_[static_cast<int>(node)]; }
+    size_t getMemoryFootprint() const { return arena_.size(); }
+
+private:
+    bool needs(FeatureNode node) const {
+        return deepest_ != FeatureNode::COUNT && static_cast<int>(node) <= static_cast<int>(deepest_);
+    }
+    void evaluate(FeatureNode node, const int16_t* input);
+    void allocateBuffers();
+
+    std::shared_ptr<const MelPlan> plan_;
+    std::vector<std::unique_ptr<FeatureExtractor>> extractors_;
+    std::vector<size_t> outputOffsets_;
+    size_t totalOutputSize_ = 0;
+    FeatureNode deepest_ = FeatureNode::COUNT;
+    uint64_t evaluations_[static_cast<int>(FeatureNode::COUNT)] = {};
+
+    AlignedArena arena_;
+    std::complex<float>* windowed_ = nullptr;
+    std::complex<float>* spectrum_ = nullptr;
+    float* power_ = nullptr;
+    float* melEnergies_ = nullptr;
+    float* decibels_ = nullptr;
+    float* logMel_ = nullptr;
+    float* outputs_ = nullptr;
+    FeatureFrame frame_;
+};
+
+// Normalized 0-1 mel frame, numMelBands values
+class MelExtractor : public FeatureExtractor {
+public:
+    FeatureNode getInput() const override { return FeatureNode::LOG_MEL; }
+    void prepare(const MelPlan& plan) override;
+    int getSize() const override { return numBands_; }
+    void compute(const FeatureFrame& frame, float* output) override;
+
+private:
+    int numBands_ = 0;
+};
+
+// MFCCs of the dB log-mel (see MfccPlan), numCoefficients values
+class MfccExtractor : public FeatureExtractor {
+public:
+    explicit MfccExtractor(const MfccConfig& config = MfccConfig()) : config_(config) {}
+    FeatureNode getInput() const override { return FeatureNode::LOG_MEL; }
+    void prepare(const MelPlan& plan) override;
+    int getSize() const override { return mfcc_ ? mfcc_->getNumCoefficients() : 0; }
+    void compute(const FeatureFrame& frame, float* output) override;
+
+private:
+    MfccConfig config_;
+    std::unique_ptr<MfccPlan> mfcc_;
+};
+
+// Power-weighted mean frequency in Hz; 0 for a silent frame
+class SpectralCentroidExtractor : public FeatureExtractor {
+public:
+    FeatureNode getInput() const override { return FeatureNode::POWER_SPECTRUM; }
+    void prepare(const MelPlan& plan) override;
+    int getSize() const override { return 1; }
+    void compute(const FeatureFrame& frame, float* output) override;
+
+private:
+    std::vector<float> binFrequencies_;
+};
+
+// L2 norm of the rise in magnitude since the previous hop (half-wave rectified); 0 on the first hop
+class SpectralFluxExtractor : public FeatureExtractor {
+public:
+    FeatureNode getInput() const override { return FeatureNode::POWER_SPECTRUM; }
+    void prepare(const MelPlan& plan) override;
+    int getSize() const override { return 1; }
+    void compute(const FeatureFrame& frame, float* output) override;
+    void reset() override { hasPrevious_ = false; }
+
+private:
+    std::vector<float> previous_;  // Magnitudes of the last hop
+    bool hasPrevious_ = false;
+};
+
+// Energy in dB within each [edges[i], edges[i + 1]) Hz band, edges.size() - 1 values
+class BandEnergyExtractor : public FeatureExtractor {
+public:
+    explicit BandEnergyExtractor(const std::vector<float>& edges) : edges_(edges) {}
+    // lowHz, 2 lowHz, 4 lowHz, ... and highHz
+    static std::vector<float> octaveEdges(float lowHz, float highHz);
+
+    FeatureNode getInput() const override { return FeatureNode::POWER_SPECTRUM; }
+    void prepare(const MelPlan& plan) override;
+    int getSize() const override { return static_cast<int>(edges_.size()) - 1; }
+    void compute(const FeatureFrame& frame, float* output) override;
+
+private:
+    std::vector<float> edges_;
+    std::vector<int> binEdges_;  // First bin of each band, then the end of the last
+};
+
+/**
+ * @brief Energy per pitch class, C = 0 ... B = 11, scaled so the strongest is 1
+ *
+ * Each bin in the config's minFreq-maxFreq range adds its power to the
+ * class of its nearest equal-tempered pitch (A4 = 440 Hz). Bins too coarse
+ * to resolve a semitone still count, so small FFTs give a blurred summary.
+ */
+class ChromaExtractor : public FeatureExtractor {
+public:
+    FeatureNode getInput() const override { return FeatureNode::POWER_SPECTRUM; }
+    void prepare(const MelPlan& plan) override;
+    int getSize() const override { return 12; }
+    void compute(const FeatureFrame& frame, float* output) override;
+
+private:
+    std::vector<int> binClasses_;  // Pitch class per bin, -1 outside the range
+};
+
+} // namespace melspectrogram
+
+#endif // FEATURE_GRAPH_H
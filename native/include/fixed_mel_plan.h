@@ -0,0 +1,91 @@
+#ifndef FIXED_MEL_PLAN_H
+#define FIXED_MEL_PLAN_H
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+#include "mel_spectrogram.h"
+#include "kiss_fft_fixed.h"
+
+namespace melspectrogram {
+
+class FixedMelPlan;
+
+// Per-thread working buffers for a FixedMelPlan (FixedMelPlan::Scratch; declared here so it can be forward-declared)
+struct FixedMelScratch {
+    std::vector<kiss_fft_fixed_cpx> fftInput;
+    std::vector<kiss_fft_fixed_cpx> fftOutput;
+    std::vector<uint32_t> power;
+    std::vector<uint64_t> mel;
+
+    void resize(const FixedMelPlan& plan);
+    size_t getBytes() const;
+};
+
+/**
+ * @brief Integer-only counterpart of MelPlan for devices with a weak FPU
+ *
+ * The tables are MelPlan's, quantized once: a Q15 Hann window and Q15 filter
+ * weights. Each frame runs without floating point up to the final dB values:
+ *
+ *  - the windowed frame is block-scaled so its peak sits just below 2^30,
+ *  - a 32-bit fixed-point kiss_fft (scaled by 1/N) transforms it,
+ *  - |X|^2 is taken in 64 bits and shifted down so the loudest bin fits 32 bits,
+ *  - the filter bank multiplies those by the Q15 weights into 64-bit sums,
+ *  - log2 comes from a 257-entry table with linear interpolation, and the
+ *    block exponents are added back before converting to dB in Q16.
+ *
+ * The dB values are then normalized exactly like MelPlan::logScale(), so the
+ * two plans are interchangeable; results agree to well under one uint8 step
+ * on ordinary audio. Shared and thread-safe in the same way as MelPlan.
+ */
+class FixedMelPlan {
+public:
+    using Scratch = FixedMelScratch;
+
+    explicit FixedMelPlan(const AudioConfig& config);
+    ~FixedMelPlan();
+
+    FixedMelPlan(const FixedMelPlan&) = delete;
+    FixedMelPlan& operator=(const FixedMelPlan&) = delete;
+
+    static std::shared_ptr<const FixedMelPlan> acquire(const AudioConfig& config);
+
+    // hopSize is that of the config that built the plan; plans are shared across hop sizes
+    const AudioConfig& getConfig() const { return config_; }
+    int getNumBins() const { return config_.frameSize / 2 + 1; }
+    const std::vector<int16_t>& getWindow() const { return window_; }  // Q15
+
+    // Pipeline steps, in order. The returned shifts feed logScale()'s exponent: pshift - 2 * blockShift
+    int windowFrame(const int16_t* input, kiss_fft_fixed_cpx* fftInput) const;  // Returns the block shift
+    void fft(const kiss_fft_fixed_cpx* input, kiss_fft_fixed_cpx* output) const;
+    int powerSpectrum(const kiss_fft_fixed_cpx* fftOutput, uint32_t* power) const;  // Returns pshift
+    void applyFilterBank(const uint32_t* power, uint64_t* mel) const;
+    // dB into out, normalized to 0-1 as MelPlan::logScale() does (quantized and decibels may be null)
+    void logScale(const uint64_t* mel, int exponent, float* out,
+                  MelOutputFormat format = MelOutputFormat::FLOAT32, void* quantized = nullptr,
+                  float* decibels = nullptr) const;
+
+    // log2(value) in Q16 for value > 0, from the interpolated table
+    static int32_t log2Q16(uint64_t value);
+
+    // Whole pipeline for one frame of frameSize samples into numMelBands floats
+    void computeFrame(const int16_t* input, float* mel, Scratch& scratch,
+                      MelOutputFormat format = MelOutputFormat::FLOAT32, void* quantized = nullptr,
+                      float* decibels = nullptr) const;
+
+private:
+    AudioConfig config_;
+    std::vector<int16_t> window_;
+    std::vector<uint16_t> filters_;  // numMelBands rows of numBins Q15 weights (1.0 is 32768)
+    std::vector<int> filterStart_;
+    std::vector<int> filterEnd_;
+    int32_t log2OffsetQ16_;          // log2(frameSize) minus the Q-format scale of a mel sum
+    kiss_fft_fixed_cfg kissFFTConfig_;
+};
+
+} // namespace melspectrogram
+
+#endif // FIXED_MEL_PLAN_H
@@ -3,11 +3,99 @@
 
 #include "audio_input.h"
 #include "mel_spectrogram.h"
+#include "pipeline_runner.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+// Session API: each handle owns an independent pipeline (audio input, mel
+// processor, renderer, exporter). Calls on different handles run in parallel
+// without sharing any lock; calls on one handle are serialized. Errors are
+// kept per calling thread, so read fsp_get_error_message() on the thread
+// whose call failed.
+typedef struct FspSession FspSession;
+
+FspSession* fsp_session_create();
+void fsp_session_destroy(FspSession* session);
+const char* fsp_get_error_message();
+// Analysis rate for audio arriving at inputRate: 16 or 32 kHz when maxFreq fits the
+// resampler's passband there, otherwise inputRate. -1 on an invalid rate.
+int fsp_canonical_analysis_rate(int inputRate, float maxFreq);
+
+int fsp_init_audio_input(FspSession* session, const audio::AudioConfig* config);
+int fsp_start_recording(FspSession* session);
+int fsp_stop_recording(FspSession* session);
+
+int fsp_init_mel_processor(FspSession* session, const melspectrogram::AudioConfig* config);
+int fsp_process_audio_frame(FspSession* session, const int16_t* inputBuffer, int bufferSize,
+                            float* outputBuffer, int outputSize);
+int fsp_process_audio_frames(FspSession* session, const int16_t* input, int numSamples,
+                             float* output, int outputCapacity, int* framesProduced);
+int fsp_set_mel_output_format(FspSession* session, int format);
+int fsp_set_front_end(FspSession* session, int dcBlock, float preEmphasis);
+int fsp_set_mfcc(FspSession* session, int numCoefficients, int lifter);
+int fsp_process_audio_frames_mfcc(FspSession* session, const int16_t* input, int numSamples,
+                                  float* output, int outputCapacity, int* framesProduced);
+int fsp_set_deltas(FspSession* session, int window);
+int fsp_process_audio_frames_deltas(FspSession* session, const int16_t* input, int numSamples,
+                                    float* output, int outputCapacity, int* framesProduced);
+int fsp_flush_deltas(FspSession* session, float* output, int outputCapacity);
+int fsp_set_activity_gate(FspSession* session, int enabled, float thresholdDb, float hysteresisDb,
+                          int hangoverFrames, float maxFlatness);
+int fsp_set_adaptive_quality(FspSession* session, int enabled, float budget);
+int fsp_process_audio_frames_quantized(FspSession* session, const int16_t* input, int numSamples,
+                                       void* output, int outputBytes, int* framesProduced);
+int fsp_enable_mel_ring(FspSession* session, int capacity);
+const void* fsp_get_mel_ring(FspSession* session, int* sizeBytes);
+int fsp_start_pipeline(FspSession* session, int columnCapacity);
+int fsp_stop_pipeline(FspSession* session);
+int fsp_set_pipeline_input_rate(FspSession* session, int sampleRate);
+int fsp_push_pipeline_audio(FspSession* session, const int16_t* samples, int numSamples);
+int fsp_poll_pipeline(FspSession* session);
+int fsp_read_pipeline_columns(FspSession* session, float* output, int maxColumns);
+int fsp_get_pipeline_stats(FspSession* session, melspectrogram::PipelineStats* stats);
+int fsp_get_mel_data_size(FspSession* session);
+int fsp_init_feature_graph(FspSession* session, const melspectrogram::AudioConfig* config, int features);
+int fsp_process_feature_frame(FspSession* session, const int16_t* inputBuffer, int bufferSize,
+                              float* output, int outputCapacity);
+int fsp_init_cqt(FspSession* session, int sampleRate, int hopSize, float minFreq,
+                 int binsPerOctave, int numOctaves);
+int fsp_process_cqt_frames(FspSession* session, const int16_t* input, int numSamples,
+                           float* output, int outputCapacity, int* framesProduced);
+
+int fsp_init_texture_renderer(FspSession* session, int width, int height, int numMelBands);
+int fsp_init_texture_renderer_with_backend(FspSession* session, int width, int height,
+                                           int numMelBands, int backendType);
+int fsp_update_texture_column(FspSession* session, const float* melData, int dataSize);
+int fsp_enqueue_texture_column(FspSession* session, const float* melData, int dataSize);
+int fsp_update_texture_column_quantized(FspSession* session, const void* melData, int dataSize, int format);
+int fsp_enqueue_texture_column_quantized(FspSession* session, const void* melData, int dataSize, int format);
+int fsp_flush_texture_columns(FspSession* session);
+unsigned int fsp_get_texture_id(FspSession* session);
+int fsp_get_texture_data(FspSession* session, uint8_t* buffer, int bufferSize);
+int fsp_request_texture_readback(FspSession* session);
+int fsp_poll_texture_readback(FspSession* session, uint8_t* buffer, int bufferSize);
+const uint8_t* fsp_get_texture_pixels(FspSession* session);
+int fsp_get_texture_stride(FspSession* session);
+int fsp_get_texture_backend(FspSession* session);
+int fsp_set_texture_color_map(FspSession* session, int colorMapType);
+int fsp_set_texture_min_max(FspSession* session, float minValue, float maxValue);
+int fsp_enable_texture_history(FspSession* session, int levelCapacity, int numLevels, int pooling);
+int64_t fsp_get_texture_history_total_columns(FspSession* session);
+int fsp_select_texture_history_level(FspSession* session, int64_t spanColumns, int maxColumns);
+int fsp_render_texture_history(FspSession* session, int level, int64_t startColumn, int64_t endColumn,
+                               int maxColumns, uint8_t* buffer, int bufferSize);
+int fsp_export_texture(FspSession* session, const char* path, int format, int compressionLevel);
+int fsp_get_texture_export_pending(FspSession* session);
+int fsp_get_texture_width(FspSession* session);
+int fsp_get_texture_height(FspSession* session);
+int fsp_get_texture_num_mel_bands(FspSession* session);
+int fsp_get_texture_current_column(FspSession* session);
+float fsp_get_texture_last_update_time_ms(FspSession* session);
+
+// Single-pipeline API below operates on a process-wide default session
+
 // Audio Input Functions
 int init_audio_input(const audio::AudioConfig* config);
 int start_recording();
@@ -17,15 +105,118 @@ int stop_recording();
 int init_mel_processor(const melspectrogram::AudioConfig* config);
 int process_audio_frame(const int16_t* inputBuffer, int bufferSize, 
                        float* outputBuffer, int outputSize);
+// Streams any number of samples through hop-based framing; partial frames carry
+// over to the next call. Mel frames are written back to back into output
+// (outputCapacity in floats). Returns the samples consumed, which is less than
+// numSamples only when output filled up; resubmit the rest.
+int process_audio_frames(const int16_t* input, int numSamples,
+                         float* output, int outputCapacity, int* framesProduced);
+// Quantized mel output: format 0 = float32, 1 = uint8 (q / 255), 2 = IEEE half.
+// Returns the bytes per frame. process_audio_frames_quantized then writes frames
+// in that format back to back (outputBytes in bytes); the float calls are unchanged.
+int set_mel_output_format(int format);
+int process_audio_frames_quantized(const int16_t* input, int numSamples,
+                                   void* output, int outputBytes, int* framesProduced);
+// MFCCs from the un-normalized log-mel of every frame (numCoefficients 0 = off; lifter 0 =
+// no liftering, 22 is usual). Returns the coefficients per frame; kept across re-inits.
+// process_audio_frames_mfcc works like process_audio_frames (outputCapacity in floats).
+int set_mfcc(int numCoefficients, int lifter);
+int process_audio_frames_mfcc(const int16_t* input, int numSamples,
+                              float* output, int outputCapacity, int* framesProduced);
+// Delta and delta-delta of the log-mel over +-window frames (2 is usual; 0 = off). Returns
+// the floats per frame, [log-mel dB | delta | delta-delta], in dB before the per-frame
+// normalization of the plain mel output; kept across re-inits. Frames come out
+// 2 * window hops late, so process_audio_frames_deltas produces nothing for the first ones;
+// flush_deltas returns the frames still waiting at the end of a stream.
+int set_deltas(int window);
+int process_audio_frames_deltas(const int16_t* input, int numSamples,
+                                float* output, int outputCapacity, int* framesProduced);
+int flush_deltas(float* output, int outputCapacity);
+// DC blocking (dcBlock != 0) and pre-emphasis (e.g. 0.97; 0 = off) on the input stream.
+// Kept across re-inits; not available with fixedPoint.
+int set_front_end(int dcBlock, float preEmphasis);
+// Skip spectral work on quiet hops and repeat a cached floor frame (see ActivityGateConfig;
+// maxFlatness 1 = level only). Skipped frames show up in PipelineStats::framesSkipped.
+int set_activity_gate(int enabled, float thresholdDb, float hysteresisDb, int hangoverFrames,
+                      float maxFlatness);
+// Step quality down (decimation, fewer bands, smaller FFT, no colormap) while frames take more
+// than budget (e.g. 0.5) of the hop duration, and back up once calm; see PipelineStats::qualityLevel.
+int set_adaptive_quality(int enabled, float budget);
+// Shared mel frame ring (layout in mel_frame_ring.h). Once enabled, every processed
+// frame is published into it; pass output = nullptr above to skip the copy-out.
+// The block stays valid until cleanup or a re-init with a different band count.
+int enable_mel_ring(int capacity);
+const void* get_mel_ring(int* sizeBytes);
+int get_mel_data_size();
+// Several features from one FFT per frame (see FeatureGraph), independent of the mel processor.
+// features is a mask: 1 = mel (numMelBands), 2 = 13 MFCCs, 4 = spectral centroid (Hz),
+// 8 = spectral flux, 16 = octave band energies (dB, minFreq to maxFreq), 32 = chroma (12).
+// Returns the floats per frame; process_feature_frame writes them in that order.
+int init_feature_graph(const melspectrogram::AudioConfig* config, int features);
+int process_feature_frame(const int16_t* inputBuffer, int bufferSize, float* output, int outputCapacity);
+// Constant-Q spectrogram (see ConstantQProcessor), independent of the mel processor: bins from
+// minFreq, binsPerOctave per octave over numOctaves; hopSize must be a multiple of
+// 2^(numOctaves - 1). Returns the bin count. process_cqt_frames works like
+// process_audio_frames: it writes a normalized 0-1 column per completed hop, lowest bin
+// first, and returns the samples consumed. Columns go to enqueue_texture_column with a
+// renderer initialized for numMelBands = the bin count.
+int init_cqt(int sampleRate, int hopSize, float minFreq, int binsPerOctave, int numOctaves);
+int process_cqt_frames(const int16_t* input, int numSamples, float* output, int outputCapacity,
+                       int* framesProduced);
+
+// Native pipeline: a DSP thread runs audio input -> mel processor as audio arrives,
+// publishing to the mel ring (if enabled) and queueing columns for the renderer.
+// The UI only calls poll_pipeline() once per display frame. Audio comes from the
+// initialized audio input, or from push_pipeline_audio() for file streams.
+// Direct processing calls are rejected while it runs.
+// Audio at another rate than the mel config's (the audio input's, or the one given to
+// set_pipeline_input_rate for pushed audio; 0 = same) is resampled to it first.
+int start_pipeline(int columnCapacity);
+int stop_pipeline();
+int set_pipeline_input_rate(int sampleRate);
+int canonical_analysis_rate(int inputRate, float maxFreq);
+int push_pipeline_audio(const int16_t* samples, int numSamples);
+// Moves queued columns into the texture renderer and flushes; returns the count
+int poll_pipeline();
+int read_pipeline_columns(float* output, int maxColumns);
+// Returns 1 while running, 0 when stopped, -1 if never started
+int get_pipeline_stats(melspectrogram::PipelineStats* stats);
 
 // Texture Renderer Functions
 int init_texture_renderer(int width, int height, int numMelBands);
+// backendType: 0 = auto, 1 = OpenGL, 2 = CPU rasterizer (headless)
+int init_texture_renderer_with_backend(int width, int height, int numMelBands, int backendType);
 int update_texture_column(const float* melData, int dataSize);
+// Batched updates: enqueue at the analysis rate, flush once per display frame
+int enqueue_texture_column(const float* melData, int dataSize);
+// Columns in a mel output format (see set_mel_output_format); dataSize is in bands
+int update_texture_column_quantized(const void* melData, int dataSize, int format);
+int enqueue_texture_column_quantized(const void* melData, int dataSize, int format);
+int flush_texture_columns();
 unsigned int get_texture_id();
 int get_texture_data(uint8_t* buffer, int bufferSize);
+// Non-blocking export: request once, then poll each frame until it returns the byte count (0 = pending)
+int request_texture_readback();
+int poll_texture_readback(uint8_t* buffer, int bufferSize);
+const uint8_t* get_texture_pixels();
+int get_texture_stride();
+int get_texture_backend();
 int set_texture_color_map(int colorMapType);
 int set_texture_min_max(float minValue, float maxValue);
 
+// Zoomable history (pooling: 0 = max, 1 = mean). Columns are counted from the first update.
+int enable_texture_history(int levelCapacity, int numLevels, int pooling);
+int64_t get_texture_history_total_columns();
+int select_texture_history_level(int64_t spanColumns, int maxColumns);
+// Writes a row-major RGBA image of the range; returns its width in columns
+int render_texture_history(int level, int64_t startColumn, int64_t endColumn, int maxColumns,
+                           uint8_t* buffer, int bufferSize);
+
+// Background export (format: 0 = PNG, 1 = raw uint8, 2 = raw float32; compressionLevel 0-9).
+// Returns 0 once queued; the file appears under path when the job finishes.
+int export_texture(const char* path, int format, int compressionLevel);
+int get_texture_export_pending();
+
 // Utility Functions
 const char* get_error_message();
 int get_texture_width();
@@ -0,0 +1,57 @@
+#ifndef FRAME_CONDITIONER_H
+#define FRAME_CONDITIONER_H
+
+#include <complex>
+#include <cstdint>
+#include <cstddef>
+
+namespace melspectrogram {
+
+/**
+ * @brief Optional filtering applied to the sample stream ahead of the FFT
+ *
+ * The DC blocker is y[n] = x[n] - x[n-1] + dcPole * y[n-1]; pre-emphasis then
+ * gives z[n] = y[n] - preEmphasis * y[n-1]. Both run on the continuous stream,
+ * not per frame, so overlapping frames see the same filtered samples.
+ */
+struct FrontEndConfig {
+    bool dcBlock = false;
+    float dcPole = 0.995f;
+    float preEmphasis = 0.0f;   // Typically 0.97; 0 turns it off
+
+    bool enabled() const { return dcBlock || preEmphasis != 0.0f; }
+};
+
+// Filter memory at the start of the next frame: x[n-1] and the DC blocker's y[n-1]
+struct FrontEndState {
+    float previousInput = 0.0f;
+    float previousOutput = 0.0f;
+
+    void reset() { *this = FrontEndState(); }
+};
+
+/**
+ * @brief Convert, filter and window one frame in a single vectorized pass
+ *
+ * Reads frameSize int16 samples and writes frameSize complex values (imaginary
+ * part 0) straight into the FFT input: filtered sample times scaledWindow,
+ * which already includes the 1/32768 int16 scale, so that is one multiply.
+ *
+ * With filtering enabled, state holds the filter memory for input[0] and is
+ * advanced by advance samples (the hop), ready for the next frame. It may be
+ * null when config is disabled.
+ */
+void conditionFrame(const int16_t* input, int frameSize, const float* scaledWindow,
+                    const FrontEndConfig& config, FrontEndState* state, int advance,
+                    std::complex<float>* output);
+
+// Same, into frameSize real values: the input of a real-input FFT
+void conditionFrame(const int16_t* input, int frameSize, const float* scaledWindow,
+                    const FrontEndConfig& config, FrontEndState* state, int advance, float* output);
+
+// Advance the filter memory over count samples without producing output, for frames that are skipped
+void advanceFrontEnd(const int16_t* input, int count, const FrontEndConfig& config, FrontEndState* state);
+
+} // namespace melspectrogram
+
+#endif // FRAME_CONDITIONER_H
@@ -0,0 +1,37 @@
+#ifndef KISS_FFT_FIXED_H
+#define KISS_FFT_FIXED_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * kiss_fft built a second time with FIXED_POINT=32 (src/kiss_fft_fixed.c), so
+ * the float and fixed-point transforms can live in one library. Every stage
+ * divides by its radix, so the output is the DFT scaled by 1/nfft and cannot
+ * overflow for inputs below 2^30 in magnitude.
+ *
+ * The layout matches kiss_fft_cpx and kiss_fft_cfg from a FIXED_POINT=32
+ * build of kiss_fft.h; include one header or the other in a C file, not both.
+ */
+typedef struct {
+    int32_t r;
+    int32_t i;
+} kiss_fft_fixed_cpx;
+
+typedef struct kiss_fft_fixed_state* kiss_fft_fixed_cfg;
+
+kiss_fft_fixed_cfg kiss_fft_fixed_alloc(int nfft, int inverse_fft, void* mem, size_t* lenmem);
+void kiss_fft_fixed(kiss_fft_fixed_cfg cfg, const kiss_fft_fixed_cpx* fin, kiss_fft_fixed_cpx* fout);
+
+/* Allocated in one block, like kiss_fft_alloc */
+#define kiss_fft_fixed_free free
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KISS_FFT_FIXED_H */
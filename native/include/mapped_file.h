@@ -0,0 +1,41 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+namespace melspectrogram {
+
+/**
+ * @brief Read-only memory mapping of a whole file
+ *
+ * Uses mmap where available and falls back to reading the file into an owned
+ * buffer (Windows), so callers always see one contiguous block.
+ */
+class MappedFile {
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // sequential hints the kernel that the file is read front to back
+    bool open(const std::string& path, bool sequential = false);
+    void close();
+    bool isOpen() const { return data_ != nullptr; }
+
+    const uint8_t* data() const { return data_; }
+    size_t size() const { return size_; }
+    const std::string& getError() const { return error_; }
+
+private:
+    uint8_t* data_;
+    size_t size_;
+    std::string error_;
+};
+
+} // namespace melspectrogram
+
+#endif // MAPPED_FILE_H
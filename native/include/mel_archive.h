@@ -0,0 +1,166 @@
+#ifndef MEL_ARCHIVE_H
+#define MEL_ARCHIVE_H
+
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstdint>
+#include <cstddef>
+
+#include "mapped_file.h"
+
+namespace melspectrogram {
+
+/**
+ * On-disk layout (all integers little-endian, every section 8-byte aligned):
+ *
+ *   File header, 64 bytes
+ *     0  char[4] "MELA"          4  uint32 version
+ *     8  uint32 numMelBands     12  uint32 chunkFrames
+ *    16  uint32 bitDepth        20  uint32 sampleRate
+ *    24  uint32 hopSize         28  uint32 reserved
+ *    32  int64  startTimeUs     40  reserved
+ *
+ *   Chunks, each one independently decodable
+ *     0  char[4] "MCHK"          4  uint32 numFrames
+ *     8  uint64 firstFrame      16  float  minValue
+ *    20  float  step            24  uint32 payloadBytes
+ *    28  uint32 reserved
+ *    32  uint8  coding[numMelBands], then the bit stream, padded to 8 bytes
+ *              (bits 0-4 Rice parameter, bits 5-7 time predictor)
+ *
+ *   Index: one {uint64 firstFrame, uint64 offset} per chunk
+ *
+ *   Trailer, 32 bytes
+ *     0  char[4] "MIDX"          4  uint32 numChunks
+ *     8  uint64 indexOffset     16  uint64 totalFrames
+ *    24  reserved
+ *
+ * Values are quantized to bitDepth bits over the chunk's [minValue, minValue +
+ * step * (2^bitDepth - 1)] range and delta-coded along time against a
+ * predictor picked per band and chunk: the previous frame, a linear
+ * extrapolation of the last two, or their mean. The first frame of a chunk is
+ * coded against zero. Residuals are zigzag-mapped and Rice-coded with a
+ * per-band parameter.
+ *
+ * Frames are meant to be the processor's dB log-mel (getDecibelData()):
+ * per-frame normalized 0-1 output jitters by several levels between hops and
+ * only shrinks about 5x. With dynamicRangeDb set, values further than that
+ * below the chunk's peak are raised to it before quantizing, so the noise
+ * floor stops spending the range. Processor dB at 8 bits over 70 dB shrinks
+ * better than 10x against float32.
+ */
+struct MelArchiveConfig {
+    int numMelBands = 64;
+    int chunkFrames = 256;
+    int bitDepth = 8;       // 1-16; 8 or 12 are the usual choices
+    float dynamicRangeDb = 0.0f;  // Range kept below each chunk's peak, like top_db; 0 keeps everything
+    int sampleRate = 32000;
+    int hopSize = 512;
+    int64_t startTimeUs = 0;
+};
+
+constexpr uint32_t MEL_ARCHIVE_VERSION = 1;
+
+/**
+ * @brief Streams frames into an archive file, one encoded chunk at a time
+ *
+ * Only the current chunk is held in memory. The index and trailer are written
+ * by close(); a file that was never closed can still be read by scanning its
+ * chunks.
+ */
+class MelArchiveWriter {
+public:
+    MelArchiveWriter();
+    ~MelArchiveWriter();
+
+    MelArchiveWriter(const MelArchiveWriter&) = delete;
+    MelArchiveWriter& operator=(const MelArchiveWriter&) = delete;
+
+    bool open(const std::string& path, const MelArchiveConfig& config);
+
+    // numFrames frames of numMelBands floats each
+    bool append(const float* frames, size_t numFrames);
+
+    // Encode the partial chunk, then write the index and trailer
+    bool close();
+
+    bool isOpen() const { return file_ != nullptr; }
+    uint64_t getFramesWritten() const { return framesWritten_; }
+    uint64_t getBytesWritten() const { return offset_; }
+    const std::string& getError() const { return error_; }
+
+private:
+    bool flushChunk();
+    bool write(const void* data, size_t size);
+    bool fail(const std::string& message);
+
+    FILE* file_;
+    MelArchiveConfig config_;
+    std::vector<float> pending_;
+    size_t pendingFrames_;
+    uint64_t framesWritten_;
+    uint64_t offset_;
+    std::vector<uint64_t> indexFrames_;
+    std::vector<uint64_t> indexOffsets_;
+    std::vector<uint8_t> encodeBuffer_;
+    std::vector<int32_t> levels_;
+    std::string error_;
+};
+
+/**
+ * @brief Random access to an archive through a read-only mapping
+ *
+ * Reads decode only the chunks overlapping the requested range. The most
+ * recently decoded chunk is cached, so a reader is not thread-safe; open one
+ * reader per thread.
+ */
+class MelArchiveReader {
+public:
+    MelArchiveReader();
+
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const { return file_.isOpen(); }
+
+    const MelArchiveConfig& getConfig() const { return config_; }
+    uint64_t getNumFrames() const { return numFrames_; }
+    size_t getNumChunks() const { return chunkFrames_.size(); }
+    // True if the trailer was missing or disagreed with the chunks, which were then found by scanning
+    bool wasRecovered() const { return recovered_; }
+
+    // Frame index covering a time in seconds from the start of the archive
+    uint64_t frameAtTime(double seconds) const;
+
+    /**
+     * @brief Decode frames [firstFrame, firstFrame + count) into output
+     * @return Frames written (fewer at the end of the archive), or -1 on a corrupt chunk
+     */
+    long readFrames(uint64_t firstFrame, size_t count, float* output);
+
+    // Frames covering [startSeconds, endSeconds)
+    long readTimeRange(double startSeconds, double endSeconds, std::vector<float>& output);
+
+    const std::string& getError() const { return error_; }
+
+private:
+    bool fail(const std::string& message);
+    bool readIndex(size_t indexOffset, uint64_t numChunks, uint64_t totalFrames);
+    bool scanChunks(size_t dataStart);
+    bool decodeChunk(size_t chunk);
+
+    MappedFile file_;
+    MelArchiveConfig config_;
+    uint64_t numFrames_;
+    bool recovered_;
+    std::vector<uint64_t> chunkFrames_;   // First frame of each chunk
+    std::vector<uint64_t> chunkOffsets_;
+    size_t cachedChunk_;
+    std::vector<float> cache_;
+    std::vector<int32_t> levels_;
+    std::string error_;
+};
+
+} // namespace melspectrogram
+
+#endif // MEL_ARCHIVE_H
@@ -0,0 +1,111 @@
+#ifndef MEL_FRAME_RING_H
+#define MEL_FRAME_RING_H
+
+#include <vector>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+namespace melspectrogram {
+
+/**
+ * @brief Fixed header at the start of a MelFrameRing block
+ *
+ * The layout is part of the FFI contract: readers locate every field by byte
+ * offset, so fields are only ever appended (bump version when doing so).
+ *
+ *   offset  0  uint32 magic          MEL_FRAME_RING_MAGIC
+ *   offset  4  uint32 version
+ *   offset  8  uint32 capacity       Frame slots in the ring
+ *   offset 12  uint32 numMelBands    Floats per frame
+ *   offset 16  uint32 frameStride    Bytes between consecutive slots
+ *   offset 20  uint32 dataOffset     Bytes from the block start to slot 0
+ *   offset 24  uint64 sequence       Frames published so far
+ *   offset 32  uint64 writeSequence  Frames whose write has started
+ *   offset 40  uint32 writeIndex     Slot the next frame goes into
+ */
+struct MelFrameRingHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t capacity;
+    uint32_t numMelBands;
+    uint32_t frameStride;
+    uint32_t dataOffset;
+    std::atomic<uint64_t> sequence;
+    std::atomic<uint64_t> writeSequence;
+    std::atomic<uint32_t> writeIndex;
+    uint32_t reserved[5];
+};
+
+constexpr uint32_t MEL_FRAME_RING_MAGIC = 0x524C454D;  // "MELR" in little-endian memory order
+constexpr uint32_t MEL_FRAME_RING_VERSION = 1;
+
+/**
+ * @brief Single-producer ring of mel frames in one block of shared memory
+ *
+ * The block (header followed by capacity frame slots, all 64-byte aligned) is
+ * allocated once, so its base pointer can be handed to another runtime, e.g.
+ * wrapped in a Dart Float32List, and read without any per-frame calls.
+ *
+ * Reader protocol, for frame index f (frame f lives in slot f % capacity):
+ *   1. s = sequence (acquire). Frames [max(0, s - capacity), s) are published.
+ *   2. Read the slot.
+ *   3. Acquire fence, then w = writeSequence. The copy is intact iff
+ *      w <= f + capacity; otherwise the writer has started overwriting the slot
+ *      and the frame is lost, so skip ahead to s - capacity + 1 or later.
+ *
+ * The newest frame, f = s - 1, can only be torn if the reader falls a whole
+ * ring behind between steps 1 and 3.
+ */
+class MelFrameRing {
+public:
+    MelFrameRing(int numMelBands, int capacity);
+
+    MelFrameRing(const MelFrameRing&) = delete;
+    MelFrameRing& operator=(const MelFrameRing&) = delete;
+
+    // Writer side (one thread)
+
+    // Copy numMelBands floats into the next slot and publish it
+    void publish(const float* frame);
+
+    // Zero-copy variant: fill the returned slot, then commitWrite()
+    float* beginWrite();
+    void commitWrite();
+
+    // Reader side (any thread)
+
+    uint64_t getSequence() const;
+
+    /**
+     * @brief Copy frame `index` out of the ring following the reader protocol
+     * @return false if the frame is not published yet or was overwritten
+     */
+    bool readFrame(uint64_t index, float* output) const;
+
+    /**
+     * @brief Copy the newest frame
+     * @return Index of the frame copied, or -1 if none was available intact
+     */
+    int64_t readLatest(float* output) const;
+
+    // Block layout
+    const uint8_t* data() const { return base_; }
+    size_t size() const { return size_; }
+    const MelFrameRingHeader* header() const { return header_; }
+    int getCapacity() const { return static_cast<int>(header_->capacity); }
+    int getNumMelBands() const { return static_cast<int>(header_->numMelBands); }
+
+private:
+    float* slot(uint64_t index) const;
+
+    std::vector<uint8_t> storage_;
+    uint8_t* base_;
+    size_t size_;
+    MelFrameRingHeader* header_;
+    uint64_t nextFrame_;  // Writer-private copy of writeSequence
+};
+
+} // namespace melspectrogram
+
+#endif // MEL_FRAME_RING_H
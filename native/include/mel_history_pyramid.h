@@ -0,0 +1,102 @@
+#ifndef MEL_HISTORY_PYRAMID_H
+#define MEL_HISTORY_PYRAMID_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace melspectrogram {
+
+enum class PoolingMode {
+    MAX,
+    MEAN
+};
+
+/**
+ * @brief Level-of-detail history of mel columns for zoomed-out waterfall views
+ *
+ * Level 0 holds the most recent columns at full time resolution. Each further
+ * level pools pairs of columns from the level below, so level L column k covers
+ * base columns [k * 2^L, (k + 1) * 2^L). Every level is a fixed-capacity ring,
+ * which bounds memory at numLevels * levelCapacity * numMelBands floats while
+ * the covered time span doubles with each level.
+ *
+ * Time is expressed in base (level 0) column indices, counted from the first
+ * pushed column. A level L column becomes visible once all 2^L base columns it
+ * covers have arrived.
+ */
+class MelHistoryPyramid {
+public:
+    /**
+     * @param numMelBands Values per column
+     * @param levelCapacity Columns retained per level
+     * @param numLevels Number of levels (1 = no decimation)
+     * @param pooling How pairs of columns are combined
+     */
+    MelHistoryPyramid(int numMelBands, int levelCapacity, int numLevels,
+                      PoolingMode pooling = PoolingMode::MAX);
+
+    /**
+     * @brief Append one column and propagate it up the pyramid (amortized O(bands))
+     * @return false if numBands does not match
+     */
+    bool pushColumn(const float* melData, int numBands);
+
+    /**
+     * @brief Copy a time range at a given level, oldest column first
+     * @param level Pyramid level
+     * @param startColumn First base column of the range (inclusive)
+     * @param endColumn Last base column of the range (exclusive)
+     * @param output Receives columns of numMelBands values
+     * @param maxColumns Capacity of output in columns
+     * @param fillValue Value written for columns that are not (or no longer) retained
+     * @return Number of columns written, or -1 on invalid arguments
+     */
+    int extractRange(int level, int64_t startColumn, int64_t endColumn,
+                     float* output, int maxColumns, float fillValue = 0.0f) const;
+
+    /**
+     * @brief Smallest level at which a span fits into maxColumns columns
+     */
+    int selectLevel(int64_t spanColumns, int maxColumns) const;
+
+    // Base columns pushed so far
+    int64_t getTotalColumns() const { return totalColumns_; }
+
+    // Oldest base column still retained at a level
+    int64_t getOldestColumn(int level) const;
+
+    // Columns completed at a level (in that level's units)
+    int64_t getLevelColumns(int level) const;
+
+    int getNumMelBands() const { return numMelBands_; }
+    int getLevelCapacity() const { return levelCapacity_; }
+    int getNumLevels() const { return numLevels_; }
+    PoolingMode getPooling() const { return pooling_; }
+
+    // Bytes held by the column storage
+    size_t getMemoryFootprint() const;
+
+    void clear();
+
+private:
+    void appendToLevel(int level, const float* column);
+
+    struct Level {
+        std::vector<float> columns;   // levelCapacity * numMelBands, ring order
+        int64_t count = 0;            // Columns ever written to this level
+        std::vector<float> pending;   // Pool accumulator feeding the next level
+        int pendingCount = 0;
+    };
+
+    int numMelBands_;
+    int levelCapacity_;
+    int numLevels_;
+    PoolingMode pooling_;
+    int64_t totalColumns_;
+    std::vector<Level> levels_;
+};
+
+} // namespace melspectrogram
+
+#endif // MEL_HISTORY_PYRAMID_H
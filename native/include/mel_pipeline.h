@@ -0,0 +1,440 @@
+#ifndef MEL_PIPELINE_H
+#define MEL_PIPELINE_H
+
+#include <memory>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+
+#include "mel_spectrogram.h"
+#include "frame_conditioner.h"
+
+namespace melspectrogram {
+
+/**
+ * @brief A complete mel pipeline for one configuration, chosen at runtime through createMelPipeline()
+ *
+ * Implementations own their working buffers, so an instance is used by one
+ * thread at a time; computeFrame() never allocates.
+ */
+class MelPipelineBase {
+public:
+    virtual ~MelPipelineBase() = default;
+
+    // True if this pipeline computes exactly config's spectrum (hopSize does not matter)
+    virtual bool matches(const AudioConfig& config) const = 0;
+
+    // Same contract and results as MelPlan's steps: frameSize samples in, normalized numMelBands floats out.
+    // decibels, if set, also receives the log-mel values before normalization
+    void computeFrame(const int16_t* input, float* mel,
+                      MelOutputFormat format = MelOutputFormat::FLOAT32, void* quantized = nullptr,
+                      float* decibels = nullptr) {
+        computeFrame(input, FrontEndConfig(), nullptr, 0, mel, format, quantized, decibels);
+    }
+
+    // Same, with the front end applied while conditioning the frame: state holds the filter memory
+    // for input[0] and is advanced by advance samples, as in conditionFrame()
+    virtual void computeFrame(const int16_t* input, const FrontEndConfig& frontEnd, FrontEndState* state,
+                              int advance, float* mel, MelOutputFormat format = MelOutputFormat::FLOAT32,
+                              void* quantized = nullptr, float* decibels = nullptr) = 0;
+
+    // computeFrame() on count frames into count * numMelBands floats, each filter row applied to every
+    // frame in turn; power is caller scratch of count * (frameSize / 2 + 1) floats
+    virtual void computeBatch(const int16_t* const* frames, size_t count, float* output, float* power) = 0;
+
+    // Size of the object, working buffers included
+    virtual size_t getWorkingSetBytes() const = 0;
+};
+
+/**
+ * @brief The specialized pipeline registered for config, or null when there is none
+ *
+ * Registered: 32 kHz/1024/64, 16 kHz/512/40 and 48 kHz/2048/128, each with
+ * the default 20-8000 Hz range.
+ */
+std::unique_ptr<MelPipelineBase> createMelPipeline(const AudioConfig& config);
+bool hasMelPipeline(const AudioConfig& config);
+
+// Bytes the pipeline for config occupies (0 when there is none), for building it in place
+size_t getMelPipelineSize(const AudioConfig& config);
+// Construct it in storage of getMelPipelineSize(config) bytes, 16-byte aligned; null when there is none.
+// The caller owns storage and ends the pipeline's life with ~MelPipelineBase()
+MelPipelineBase* createMelPipeline(const AudioConfig& config, void* storage);
+
+namespace detail {
+    // C++14 has no constexpr <cmath>; these are accurate to a few ulps of double, plenty for float tables
+    constexpr double PI = 3.14159265358979323846;
+    constexpr double LN2 = 0.69314718055994530942;
+    constexpr double LN10 = 2.30258509299404568402;
+
+    constexpr double cosine(double x) {
+        // Reduce to [-pi, pi], then to [-pi/2, pi/2] with cos(x) = -cos(pi - |x|)
+        while (x > PI) x -= 2.0 * PI;
+        while (x < -PI) x += 2.0 * PI;
+        double sign = 1.0;
+        if (x < 0.0) x = -x;
+        if (x > PI / 2.0) {
+            x = PI - x;
+            sign = -1.0;
+        }
+        const double x2 = x * x;
+        double term = 1.0;
+        double sum = 1.0;
+        for (int n = 1; n <= 12; ++n) {
+            term *= -x2 / ((2 * n - 1) * (2 * n));
+            sum += term;
+        }
+        return sign * sum;
+    }
+
+    constexpr double sine(double x) {
+        return cosine(x - PI / 2.0);
+    }
+
+    constexpr double exponential(double x) {
+        // x = k ln2 + r with |r| <= ln2 / 2
+        int k = static_cast<int>(x / LN2 + (x < 0.0 ? -0.5 : 0.5));
+        const double r = x - k * LN2;
+        double term = 1.0;
+        double sum = 1.0;
+        for (int n = 1; n <= 20; ++n) {
+            term *= r / n;
+            sum += term;
+        }
+        for (; k > 0; --k) sum *= 2.0;
+        for (; k < 0; ++k) sum *= 0.5;
+        return sum;
+    }
+
+    constexpr double logarithm(double x) {
+        // x = m 2^k with m in [1, 2), then ln m = 2 atanh((m - 1) / (m + 1))
+        int k = 0;
+        while (x >= 2.0) {
+            x *= 0.5;
+            ++k;
+        }
+        while (x < 1.0) {
+            x *= 2.0;
+            --k;
+        }
+        const double y = (x - 1.0) / (x + 1.0);
+        const double y2 = y * y;
+        double power = y;
+        double sum = 0.0;
+        for (int n = 0; n < 30; ++n) {
+            sum += power / (2 * n + 1);
+            power *= y2;
+        }
+        return 2.0 * sum + k * LN2;
+    }
+
+    constexpr double freqToMel(double freq) {
+        return 2595.0 * logarithm(1.0 + freq / 700.0) / LN10;
+    }
+
+    constexpr double melToFreq(double mel) {
+        return 700.0 * (exponential(mel / 2595.0 * LN10) - 1.0);
+    }
+
+    // Hann window (same definition as MelPlan) with the int16 scale folded in
+    template <int N>
+    struct HannTable {
+        float values[N];
+
+        constexpr HannTable() : values{} {
+            for (int i = 0; i < N; ++i) {
+                values[i] = static_cast<float>(0.5 * (1.0 - cosine(2.0 * PI * i / (N - 1))) / 32768.0);
+            }
+        }
+    };
+
+    // W_N^k = exp(-2 pi i k / N) for k < N / 2; the half-size FFT uses every other one
+    template <int N>
+    struct TwiddleTable {
+        float re[N / 2];
+        float im[N / 2];
+
+        constexpr TwiddleTable() : re{}, im{} {
+            for (int k = 0; k < N / 2; ++k) {
+                re[k] = static_cast<float>(cosine(2.0 * PI * k / N));
+                im[k] = static_cast<float>(-sine(2.0 * PI * k / N));
+            }
+        }
+    };
+
+    template <int M>
+    struct BitReverseTable {
+        int values[M];
+
+        constexpr BitReverseTable() : values{} {
+            for (int i = 0; i < M; ++i) {
+                int reversed = 0;
+                for (int bit = 1, mirror = M >> 1; bit < M; bit <<= 1, mirror >>= 1) {
+                    if (i & bit) reversed |= mirror;
+                }
+                values[i] = reversed;
+            }
+        }
+    };
+
+    /**
+     * Triangular mel filters, as MelPlan builds them, stored sparsely: band b
+     * covers bins [start[b], start[b] + length[b]) with weights from
+     * weights[offset[b]]. Each bin lies in at most two triangles, so
+     * 2 * bins + bands weights always suffice.
+     */
+    template <int SampleRate, int FrameSize, int NumBands, int MinFreq, int MaxFreq>
+    struct MelWeightTable {
+        static constexpr int BINS = FrameSize / 2 + 1;
+        static constexpr int CAPACITY = 2 * BINS + NumBands;
+
+        int start[NumBands];
+        int length[NumBands];
+        int offset[NumBands];
+        float weights[CAPACITY];
+        int count;
+
+        constexpr MelWeightTable() : start{}, length{}, offset{}, weights{}, count(0) {
+            const double minMel = freqToMel(MinFreq);
+            const double maxMel = freqToMel(MaxFreq);
+            const double binHz = static_cast<double>(SampleRate) / FrameSize;
+
+            for (int band = 0; band < NumBands; ++band) {
+                const double left = melToFreq(minMel + (maxMel - minMel) * band / (NumBands + 1));
+                const double center = melToFreq(minMel + (maxMel - minMel) * (band + 1) / (NumBands + 1));
+                const double right = melToFreq(minMel + (maxMel - minMel) * (band + 2) / (NumBands + 1));
+
+                // Only bins inside [left, right] can be non-zero; the weights there have no interior zeros
+                int first = BINS;
+                int end = 0;
+                const int lo = static_cast<int>(left / binHz);
+                const int hi = std::min(static_cast<int>(right / binHz) + 1, BINS - 1);
+                for (int bin = lo; bin <= hi; ++bin) {
+                    const float weight = weightAt(bin * binHz, left, center, right);
+                    if (weight != 0.0f) {
+                        first = std::min(first, bin);
+                        end = bin + 1;
+                    }
+                }
+                start[band] = std::min(first, end);
+                length[band] = end - start[band];
+                offset[band] = count;
+                for (int bin = start[band]; bin < end; ++bin) {
+                    weights[count++] = weightAt(bin * binHz, left, center, right);
+                }
+            }
+        }
+
+        static constexpr float weightAt(double freq, double left, double center, double right) {
+            if (freq >= left && freq <= center) {
+                return static_cast<float>((freq - left) / (center - left));
+            }
+            if (freq >= center && freq <= right) {
+                return static_cast<float>((right - freq) / (right - center));
+            }
+            return 0.0f;
+        }
+    };
+}
+
+/**
+ * @brief Mel pipeline with every size fixed at compile time
+ *
+ * The Hann window, FFT twiddles, bit-reversal order and sparse filter weights
+ * are constexpr tables built by the compiler, so creating a pipeline builds
+ * nothing and all loops have constant trip counts. The frame is transformed as
+ * a FrameSize / 2 point complex FFT of even/odd sample pairs, split into the
+ * real spectrum afterwards. With a front end, the frame is first conditioned
+ * into a real input buffer, since the filters run sample by sample in stream
+ * order. Working buffers are members: no heap allocation.
+ *
+ * Results match MelPlan for the same configuration to float rounding; the
+ * tables are computed in double rather than float.
+ */
+template <int SampleRate, int FrameSize, int NumBands, int MinFreq = 20, int MaxFreq = 8000>
+class MelPipeline final : public MelPipelineBase {
+    static_assert(FrameSize >= 8 && (FrameSize & (FrameSize - 1)) == 0, "FrameSize must be a power of two");
+    static_assert(NumBands > 0 && MinFreq >= 0 && MaxFreq > MinFreq, "Invalid mel range");
+
+public:
+    static constexpr int NUM_BINS = FrameSize / 2 + 1;
+
+    bool matches(const AudioConfig& config) const override {
+        return config.sampleRate == SampleRate && config.frameSize == FrameSize &&
+               config.numMelBands == NumBands && config.minFreq == static_cast<float>(MinFreq) &&
+               config.maxFreq == static_cast<float>(MaxFreq);
+    }
+
+    using MelPipelineBase::computeFrame;
+
+    void computeFrame(const int16_t* input, const FrontEndConfig& frontEnd, FrontEndState* state,
+                      int advance, float* mel, MelOutputFormat format = MelOutputFormat::FLOAT32,
+                      void* quantized = nullptr, float* decibels = nullptr) override {
+        if (frontEnd.enabled() && state != nullptr) {
+            conditionFrame(input, FrameSize, window_.values, frontEnd, state, advance, frame_);
+            pack(frame_);
+        } else {
+            windowAndPack(input);
+        }
+        transform();
+        powerSpectrum(power_);
+        for (int band = 0; band < NumBands; ++band) {
+            mel[band] = filterBand(band, power_);
+        }
+        logScale(mel, format, quantized, decibels);
+    }
+
+    void computeBatch(const int16_t* const* frames, size_t count, float* output, float* power) override {
+        for (size_t f = 0; f < count; ++f) {
+            windowAndPack(frames[f]);
+            transform();
+            powerSpectrum(power + f * NUM_BINS);
+        }
+        // Each band's weights are loaded once and applied to every spectrum in the batch
+        for (int band = 0; band < NumBands; ++band) {
+            for (size_t f = 0; f < count; ++f) {
+                output[f * NumBands + band] = filterBand(band, power + f * NUM_BINS);
+            }
+        }
+        for (size_t f = 0; f < count; ++f) {
+            logScale(output + f * NumBands, MelOutputFormat::FLOAT32, nullptr, nullptr);
+        }
+    }
+
+    size_t getWorkingSetBytes() const override { return sizeof(*this); }
+
+    static constexpr int getFilterStart(int band) { return weights_.start[band]; }
+    static constexpr int getFilterEnd(int band) { return weights_.start[band] + weights_.length[band]; }
+    static constexpr float getFilterWeight(int band, int bin) {
+        return bin >= getFilterStart(band) && bin < getFilterEnd(band)
+            ? weights_.weights[weights_.offset[band] + bin - weights_.start[band]] : 0.0f;
+    }
+    static constexpr float getWindow(int i) { return window_.values[i] * 32768.0f; }
+
+private:
+    static constexpr int HALF = FrameSize / 2;
+    static constexpr float MIN_LOG_VALUE = 1e-10f;
+
+    // Even samples become the real parts and odd samples the imaginary parts, in bit-reversed order
+    void windowAndPack(const int16_t* input) {
+        for (int n = 0; n < HALF; ++n) {
+            const int slot = bitReverse_.values[n];
+            re_[slot] = input[2 * n] * window_.values[2 * n];
+            im_[slot] = input[2 * n + 1] * window_.values[2 * n + 1];
+        }
+    }
+
+    // windowAndPack() for an already windowed real frame
+    void pack(const float* frame) {
+        for (int n = 0; n < HALF; ++n) {
+            const int slot = bitReverse_.values[n];
+            re_[slot] = frame[2 * n];
+            im_[slot] = frame[2 * n + 1];
+        }
+    }
+
+    // In-place radix-2 decimation in time over HALF points
+    void transform() {
+        // First stage: twiddle is 1
+        for (int i = 0; i < HALF; i += 2) {
+            const float ar = re_[i], ai = im_[i];
+            const float br = re_[i + 1], bi = im_[i + 1];
+            re_[i] = ar + br;
+            im_[i] = ai + bi;
+            re_[i + 1] = ar - br;
+            im_[i + 1] = ai - bi;
+        }
+        for (int length = 4; length <= HALF; length <<= 1) {
+            const int half = length / 2;
+            const int stride = FrameSize / length;  // W_length^j = W_FrameSize^(j * stride)
+            for (int start = 0; start < HALF; start += length) {
+                for (int j = 0; j < half; ++j) {
+                    const float wr = twiddles_.re[j * stride];
+                    const float wi = twiddles_.im[j * stride];
+                    const int a = start + j;
+                    const int b = a + half;
+                    const float br = re_[b] * wr - im_[b] * wi;
+                    const float bi = re_[b] * wi + im_[b] * wr;
+                    re_[b] = re_[a] - br;
+                    im_[b] = im_[a] - bi;
+                    re_[a] += br;
+                    im_[a] += bi;
+                }
+            }
+        }
+    }
+
+    // X[k] = E[k] + W^k O[k], with E and O the spectra of the even and odd samples recovered from Z
+    void powerSpectrum(float* power) const {
+        constexpr float scale = 1.0f / FrameSize;
+        const float dc = re_[0] + im_[0];
+        const float nyquist = re_[0] - im_[0];
+        power[0] = dc * dc * scale;
+        power[HALF] = nyquist * nyquist * scale;
+        for (int k = 1; k < HALF; ++k) {
+            const float zr = re_[k], zi = im_[k];
+            const float cr = re_[HALF - k], ci = -im_[HALF - k];  // conj(Z[HALF - k])
+            const float er = 0.5f * (zr + cr);
+            const float ei = 0.5f * (zi + ci);
+            const float orr = 0.5f * (zi - ci);
+            const float oi = -0.5f * (zr - cr);
+            const float wr = twiddles_.re[k], wi = twiddles_.im[k];
+            const float xr = er + wr * orr - wi * oi;
+            const float xi = ei + wr * oi + wi * orr;
+            power[k] = (xr * xr + xi * xi) * scale;
+        }
+    }
+
+    static float filterBand(int band, const float* power) {
+        const float* weights = weights_.weights + weights_.offset[band];
+        const float* bins = power + weights_.start[band];
+        float sum = 0.0f;
+        for (int i = 0; i < weights_.length[band]; ++i) {
+            sum += bins[i] * weights[i];
+        }
+        return sum;
+    }
+
+    // MelPlan::logScale
+    static void logScale(float* mel, MelOutputFormat format, void* quantized, float* decibels) {
+        for (int i = 0; i < NumBands; ++i) {
+            mel[i] = 10.0f * std::log10(std::max(mel[i], MIN_LOG_VALUE));
+        }
+        if (decibels != nullptr) {
+            std::copy(mel, mel + NumBands, decibels);
+        }
+        const float minValue = *std::min_element(mel, mel + NumBands);
+        const float maxValue = *std::max_element(mel, mel + NumBands);
+        normalizeAndQuantize(mel, static_cast<size_t>(NumBands), minValue, maxValue - minValue, format, quantized);
+    }
+
+    static constexpr detail::HannTable<FrameSize> window_{};
+    static constexpr detail::TwiddleTable<FrameSize> twiddles_{};
+    static constexpr detail::BitReverseTable<FrameSize / 2> bitReverse_{};
+    static constexpr detail::MelWeightTable<SampleRate, FrameSize, NumBands, MinFreq, MaxFreq> weights_{};
+
+    alignas(16) float frame_[FrameSize];  // Real FFT input, only used with a front end
+    alignas(16) float re_[HALF];
+    alignas(16) float im_[HALF];
+    alignas(16) float power_[NUM_BINS];
+};
+
+template <int SR, int N, int B, int MinF, int MaxF>
+constexpr detail::HannTable<N> MelPipeline<SR, N, B, MinF, MaxF>::window_;
+template <int SR, int N, int B, int MinF, int MaxF>
+constexpr detail::TwiddleTable<N> MelPipeline<SR, N, B, MinF, MaxF>::twiddles_;
+template <int SR, int N, int B, int MinF, int MaxF>
+constexpr detail::BitReverseTable<N / 2> MelPipeline<SR, N, B, MinF, MaxF>::bitReverse_;
+template <int SR, int N, int B, int MinF, int MaxF>
+constexpr detail::MelWeightTable<SR, N, B, MinF, MaxF> MelPipeline<SR, N, B, MinF, MaxF>::weights_;
+template <int SR, int N, int B, int MinF, int MaxF>
+constexpr int MelPipeline<SR, N, B, MinF, MaxF>::NUM_BINS;
+template <int SR, int N, int B, int MinF, int MaxF>
+constexpr int MelPipeline<SR, N, B, MinF, MaxF>::HALF;
+template <int SR, int N, int B, int MinF, int MaxF>
+constexpr float MelPipeline<SR, N, B, MinF, MaxF>::MIN_LOG_VALUE;
+
+} // namespace melspectrogram
+
+#endif // MEL_PIPELINE_H
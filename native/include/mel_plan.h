@@ -0,0 +1,113 @@
+#ifndef MEL_PLAN_H
+#define MEL_PLAN_H
+
+#include <vector>
+#include <complex>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+#include <mutex>
+
+#include "mel_spectrogram.h"
+#include "mel_pipeline.h"
+#include "frame_conditioner.h"
+
+namespace melspectrogram {
+
+/**
+ * @brief Immutable DSP tables for one configuration: Hann window, FFT plan and mel filter weights
+ *
+ * Plans are shared through acquire(), so every processor and batch worker
+ * using the same configuration reads one copy of the tables. All methods are
+ * const and may be called from several threads at once; callers bring their
+ * own scratch buffers. A specialized plan runs on the pipeline's constexpr
+ * tables and only builds its runtime ones when a step below first needs them.
+ */
+class MelPlan {
+public:
+    // Per-thread working buffers, sized for a plan and a batch length
+    struct Scratch {
+        std::vector<std::complex<float>> fftInput;   // Empty for specialized plans
+        std::vector<std::complex<float>> fftOutput;
+        std::vector<float> power;  // batchFrames * numBins
+        std::unique_ptr<MelPipelineBase> pipeline;  // Only for plans with a compile-time pipeline
+
+        void resize(const MelPlan& plan, size_t batchFrames = 1);
+    };
+
+    explicit MelPlan(const AudioConfig& config);
+    ~MelPlan();
+
+    MelPlan(const MelPlan&) = delete;
+    MelPlan& operator=(const MelPlan&) = delete;
+
+    // Shared plan for config, built on first use and released with its last user
+    static std::shared_ptr<const MelPlan> acquire(const AudioConfig& config);
+
+    // hopSize is that of the config that built the plan; plans are shared across hop sizes
+    const AudioConfig& getConfig() const { return config_; }
+    int getNumBins() const { return config_.frameSize / 2 + 1; }
+    const std::vector<float>& getWindow() const { ensureTables(); return window_; }
+    // Window times 1/32768, the per-sample factor conditionFrame() applies to int16 input
+    const float* getScaledWindow() const { ensureTables(); return scaledWindow_.data(); }
+    // computeFrame() and computeBatch() run the registered MelPipeline for this config (see createMelPipeline)
+    bool isSpecialized() const { return specialized_; }
+    // Build the runtime tables now, for callers whose first use of the steps below must not allocate
+    void prepareRuntimeTables() const { ensureTables(); }
+
+    // Dense filter row (getNumBins() weights) and its non-zero bin range [start, end)
+    const float* getFilter(int band) const {
+        ensureTables();
+        return filters_.data() + static_cast<size_t>(band) * getNumBins();
+    }
+    int getFilterStart(int band) const { ensureTables(); return filterStart_[band]; }
+    int getFilterEnd(int band) const { ensureTables(); return filterEnd_[band]; }
+
+    // Pipeline steps, in order; always the runtime-table versions, even when isSpecialized()
+    void windowFrame(const int16_t* input, std::complex<float>* fftInput) const;
+    void fft(const std::complex<float>* input, std::complex<float>* output) const;
+    void powerSpectrum(const std::complex<float>* fftOutput, float* power) const;
+    void applyFilterBank(const float* power, float* mel) const;
+    static void logScale(float* mel, int numBands);  // dB, then normalized to 0-1
+    // Same, also writing the normalized values in format to quantized during the normalize pass,
+    // and the dB values before normalization to decibels if it is set
+    static void logScale(float* mel, int numBands, MelOutputFormat format, void* quantized,
+                         float* decibels = nullptr);
+
+    // Whole pipeline for one frame of frameSize samples into numMelBands floats
+    void computeFrame(const int16_t* input, float* mel, Scratch& scratch) const;
+
+    /**
+     * @brief Process several frames with the filter weights kept cache-hot
+     *
+     * Results are identical to computeFrame() on each frame; only the loop
+     * order differs (every frame's spectrum first, then each filter row
+     * applied to all of them). Specialized plans batch over the pipeline's tables.
+     *
+     * @param frames count pointers to frameSize samples each
+     * @param output count * numMelBands floats
+     * @param scratch Resized for count frames if needed
+     */
+    void computeBatch(const int16_t* const* frames, size_t count, float* output, Scratch& scratch) const;
+
+private:
+    // Builds the runtime tables and FFT plan once; a no-op after the first call
+    void ensureTables() const { std::call_once(tablesBuilt_, &MelPlan::buildTables, this); }
+    void buildTables() const;
+    void createWindow() const;
+    void createFilterBank() const;
+
+    AudioConfig config_;
+    bool specialized_;
+    mutable std::once_flag tablesBuilt_;
+    mutable std::vector<float> window_;
+    mutable std::vector<float> scaledWindow_;
+    mutable std::vector<float> filters_;  // numMelBands rows of numBins weights
+    mutable std::vector<int> filterStart_;
+    mutable std::vector<int> filterEnd_;
+    mutable void* kissFFTConfig_ = nullptr;
+};
+
+} // namespace melspectrogram
+
+#endif // MEL_PLAN_H
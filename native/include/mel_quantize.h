@@ -0,0 +1,49 @@
+#ifndef MEL_QUANTIZE_H
+#define MEL_QUANTIZE_H
+
+#include <cstdint>
+#include <cstddef>
+
+namespace melspectrogram {
+
+/**
+ * @brief Per-band storage of a normalized (0-1) mel frame
+ *
+ * UINT8 stores round(clamp(v, 0, 1) * 255) with ties rounded up, so it
+ * decodes as q / 255. FLOAT16 stores clamp(v, 0, 1) as an IEEE 754 binary16
+ * value rounded to nearest, ties to even. NaN quantizes to 0 in both.
+ */
+enum class MelOutputFormat {
+    FLOAT32 = 0,
+    UINT8 = 1,
+    FLOAT16 = 2
+};
+
+inline size_t melOutputBytesPerBand(MelOutputFormat format) {
+    return format == MelOutputFormat::UINT8 ? 1 : format == MelOutputFormat::FLOAT16 ? 2 : 4;
+}
+
+/**
+ * @brief Normalize values to (v - minValue) / range in place and quantize them in the same pass
+ *
+ * This is the tail of the log stage: the normalized floats are written back
+ * exactly as the float path computes them, and output receives count
+ * quantized values (uint8_t or uint16_t half bits). With range <= 0 the values
+ * are left alone and output is zero. FLOAT32 only normalizes.
+ */
+void normalizeAndQuantize(float* values, size_t count, float minValue, float range,
+                          MelOutputFormat format, void* output);
+
+// Quantize values already in 0-1
+void quantizeUnit(const float* values, size_t count, MelOutputFormat format, void* output);
+
+// Back to floats in 0-1
+void dequantize(const void* input, size_t count, MelOutputFormat format, float* output);
+
+// IEEE binary16 conversions for single values (round to nearest even; inf and NaN kept)
+uint16_t floatToHalf(float value);
+float halfToFloat(uint16_t half);
+
+} // namespace melspectrogram
+
+#endif // MEL_QUANTIZE_H
@@ -4,9 +4,26 @@
 #include <vector>
 #include <complex>
 #include <memory>
+#include <chrono>
+#include <tuple>
+#include <cstdint>
+
+#include "mel_quantize.h"
+#include "aligned_arena.h"
+#include "frame_conditioner.h"
+#include "activity_gate.h"
+#include "quality_controller.h"
+#include "kiss_fft_fixed.h"
+#include "mfcc.h"
+#include "delta_stream.h"
 
 namespace melspectrogram {
 
+class MelFrameRing;
+class MelPlan;
+class FixedMelPlan;
+class MelPipelineBase;
+
 struct AudioConfig {
     int sampleRate = 32000;
     int frameSize = 1024;
@@ -14,13 +31,19 @@ struct AudioConfig {
     int numMelBands = 64;
     float minFreq = 20.0f;
     float maxFreq = 8000.0f;
+    // Non-zero runs processors on the integer pipeline (FixedMelPlan) instead of the float one
+    int fixedPoint = 0;
 };
 
 struct ProcessingStats {
     float processingTimeMs = 0.0f;
     float fps = 0.0f;
-    float cpuUsage = 0.0f;
+    float cpuUsage = 0.0f;            // Smoothed frame time over the hop duration
     int droppedFrames = 0;
+    float deadlineMissRate = 0.0f;    // Smoothed share of frames over the quality budget
+    int qualityLevel = 0;             // Current rung of the degradation ladder (see QualityLevel)
+    int skippedFrames = 0;        // Gated as inactive since resetStats(); the floor frame was emitted instead
+    float skipRatio = 0.0f;       // skippedFrames over all frames since resetStats()
 };
 
 class MelSpectrogramProcessor {
@@ -31,55 +54,256 @@ public:
     // Main processing function
     bool processAudioFrame(const int16_t* input, size_t inputSize);
     
+    /**
+     * @brief Stream any number of samples through hop-based framing
+     *
+     * Frames start every hopSize samples; samples that do not yet complete a
+     * frame are carried over to the next call. Each finished frame's mel
+     * vector is written to output (numMelBands floats per frame, contiguous).
+     * When maxFrames is reached, the remaining input is left unconsumed.
+     * Pass a null output to only publish frames to the attached frame ring;
+     * maxFrames is then ignored and all input is consumed. A non-null
+     * decibels receives each frame's log-mel in dB before normalization
+     * (getDecibelData()) alongside, numMelBands floats per frame.
+     *
+     * @return Number of input samples consumed, or -1 on invalid arguments
+     */
+    long processAudioSamples(const int16_t* input, size_t numSamples,
+                             float* output, size_t maxFrames, size_t* framesProduced,
+                             float* decibels = nullptr);
+    
+    // As above, but frames are written in the output format (getOutputBytesPerFrame() each)
+    long processAudioSamplesQuantized(const int16_t* input, size_t numSamples,
+                                      void* output, size_t maxFrames, size_t* framesProduced);
+    
+    // As above, writing getNumMfcc() coefficients per frame; requires setMfcc()
+    long processAudioSamplesMfcc(const int16_t* input, size_t numSamples,
+                                 float* output, size_t maxFrames, size_t* framesProduced);
+    
+    /**
+     * @brief As above, writing [log-mel dB | delta | delta-delta] frames (getDeltaFrameSize() floats each)
+     *
+     * Requires setDeltas(). Output lags the input by getDeltaLatencyFrames()
+     * hops, so the first frames of a stream produce nothing; flushDeltas()
+     * completes the ones still waiting when the stream ends.
+     */
+    long processAudioSamplesDeltas(const int16_t* input, size_t numSamples,
+                                   float* output, size_t maxFrames, size_t* framesProduced);
+    // Write the frames still waiting for lookahead, the last frame standing in for later ones
+    size_t flushDeltas(float* output, size_t maxFrames);
+    
+    // Drop carried-over samples and filter memory so the next call starts a new stream
+    void resetStream();
+    
+    /**
+     * @brief DC blocking and pre-emphasis ahead of the FFT
+     *
+     * The filters run on the sample stream, their memory advancing one hop
+     * per frame, so feed frames at hopSize spacing (processAudioSamples does).
+     * Conversion, filtering and windowing are one pass (conditionFrame), on
+     * the runtime MelPlan path and in a compile-time pipeline alike. Resets
+     * the stream. Returns false on the fixed-point pipeline, which has no
+     * front end.
+     */
+    bool setFrontEnd(const FrontEndConfig& frontEnd);
+    const FrontEndConfig& getFrontEnd() const { return frontEnd_; }
+    
+    /**
+     * @brief Skip the spectral stages on quiet input
+     *
+     * Each frame is first measured in the time domain (measureActivity, one
+     * integer pass). While the gate is closed, the first quiet frame is
+     * processed as usual and cached as the floor frame; later ones emit that
+     * frame again without any conversion, FFT, filter bank or log work. The
+     * front-end filters still advance over skipped hops. Resets the stream.
+     */
+    void setActivityGate(const ActivityGateConfig& config);
+    const ActivityGateConfig& getActivityGate() const { return activityGate_.getConfig(); }
+    bool isActive() const { return activityGate_.isOpen(); }
+    
+    /**
+     * @brief Degrade gracefully instead of falling behind
+     *
+     * After every frame the controller sees its processing time against the
+     * hop duration and may pick another QualityLevel, which takes effect
+     * from the next frame on; a frame is never reconfigured while it is
+     * being computed. Output keeps numMelBands per frame at every level.
+     * Band and FFT reduction use the float plan, so the fixed-point pipeline
+     * only decimates and drops colormapping.
+     */
+    void setQualityController(const QualityControllerConfig& config);
+    const QualityControllerConfig& getQualityController() const { return qualityController_.getConfig(); }
+    /**
+     * @brief Also compute MFCCs from every frame's log-mel values
+     *
+     * The log stage hands its dB values to an MfccPlan before normalizing,
+     * on every pipeline, so the mel output is unchanged. The coefficient
+     * buffer lives with the other frame buffers. Resets the stream.
+     */
+    void setMfcc(const MfccConfig& config);
+    const MfccConfig& getMfccConfig() const { return mfccConfig_; }
+    int getNumMfcc() const { return mfccPlan_ ? mfccPlan_->getNumCoefficients() : 0; }
+    const float* getMfccData() const { return mfcc_; }  // Latest frame; null when MFCCs are off
+    // Latest log-mel in dB before normalization
+    const float* getDecibelData() const { return decibels_; }
+    
+    /**
+     * @brief Also produce delta and delta-delta features of the log-mel
+     *
+     * Every emitted frame, skipped and repeated ones included, goes into a
+     * DeltaStream as its dB values before normalization (getDecibelData()),
+     * so deltas follow loudness changes and compare across frames; the
+     * per-frame normalized 0-1 output would hide both. A hop then completes
+     * the frame getDeltaLatencyFrames() hops back: getDeltaData() points at
+     * its [log-mel dB | delta | delta-delta] values in the stream's ring, or
+     * is null while the lookahead fills.
+     * The last frame's audio ended getDeltaLatencyFrames() * hopSize samples
+     * before the newest input. Resets the stream.
+     */
+    void setDeltas(const DeltaConfig& config);
+    const DeltaConfig& getDeltaConfig() const { return deltaConfig_; }
+    size_t getDeltaFrameSize() const { return deltas_ ? deltas_->getFrameSize() : 0; }
+    int getDeltaLatencyFrames() const { return deltas_ ? deltas_->getLatencyFrames() : 0; }
+    const float* getDeltaData() const { return deltaFrame_; }
+    // Stream index of the frame getDeltaData() belongs to
+    int64_t getDeltaFrameIndex() const { return deltas_ ? deltas_->getOutputIndex() : -1; }
+    
+    // Force a level (0 = full quality); an enabled controller carries on from there
+    void setQualityLevel(int level);
+    int getQualityLevel() const { return qualityLevel_; }
+    // Real time between two frames, the deadline each frame is measured against
+    float getFrameDeadlineMs() const { return config_.hopSize * 1000.0f / config_.sampleRate; }
+    size_t getBufferedSamples() const { return pendingSamples_; }
+    
+    // Publish every processed frame to a shared ring (not owned; nullptr detaches)
+    void setFrameRing(MelFrameRing* ring) { frameRing_ = ring; }
+    
+    /**
+     * @brief Also produce each frame as uint8 or IEEE half values
+     *
+     * The quantized frame is written by the log stage while it normalizes, so
+     * no second pass over the floats is needed. The float results stay
+     * available as before. FLOAT32 turns quantized output off.
+     */
+    void setOutputFormat(MelOutputFormat format);
+    MelOutputFormat getOutputFormat() const { return outputFormat_; }
+    size_t getOutputBytesPerFrame() const { return melOutputBytesPerBand(outputFormat_) * config_.numMelBands; }
+    
     // Get processing results
     std::vector<float> getMelSpectrum() const;
+    const float* getMelData() const { return melSpectrum_; }
+    // Latest frame in the output format: uint8_t or uint16_t half bits (the floats for FLOAT32)
+    const void* getOutputData() const;
     std::vector<uint8_t> getColorMappedData() const;
     ProcessingStats getStats() const { return stats_; }
     
+    /**
+     * @brief Bytes of working memory this processor owns
+     *
+     * All working memory is one 64-byte-aligned arena, laid out in processing
+     * order: per-frame buffers, a compile-time pipeline (built in place) or
+     * fixed-point scratch, then the reduced quality levels' buffers. Only a
+     * delta stage adds its own ring. Window, FFT and filter tables are shared between
+     * processors through the plan cache and are not counted.
+     */
+    size_t getMemoryFootprint() const;
+    
     // Configuration updates
     void updateConfig(const AudioConfig& config);
     void setColorMap(const std::vector<std::tuple<uint8_t, uint8_t, uint8_t>>& colormap);
     
     // Performance monitoring
     void resetStats();
+    // The last frame missed its deadline, or the smoothed load is over the quality budget
     bool isOverloaded() const;
 
 private:
     // Internal processing steps
+    void processFrame(const int16_t* input);
+    // Emit the frame still in the output buffers again for this hop
+    void repeatFrame(const int16_t* input, std::chrono::high_resolution_clock::time_point startTime);
+    void computeReducedFrame(const int16_t* input, void* quantized);
+    void applyQualityLevel(int level);
+    // Ring publish and timing for a frame that is now in the output buffers
+    void finishFrame(std::chrono::high_resolution_clock::time_point startTime);
     void applyWindowFunction();
     void performFFT();
     void computePowerSpectrum();
     void applyMelFilterBank();
     void convertToLogScale();
     void applyColorMapping();
-    
-    // Helper functions
-    void createMelFilterBank();
-    float freqToMel(float freq) const;
-    float melToFreq(float mel) const;
-    void createWindowFunction();
+    void selectPlan();
+    void allocateBuffers();
+    void destroyPipeline();
+    // Frame loop shared by the processAudioSamples variants; frameSource holds each finished frame.
+    // A null frameSource takes the delta stage's frame and skips hops that complete none
+    long streamSamples(const int16_t* input, size_t numSamples, uint8_t* output,
+                       const void* frameSource, size_t frameBytes, size_t maxFrames, size_t* framesProduced,
+                       float* decibels = nullptr);
     
     // Member variables
     AudioConfig config_;
     ProcessingStats stats_;
     
-    // Processing buffers
-    std::vector<float> windowFunction_;
-    std::vector<std::complex<float>> fftInput_;
-    std::vector<std::complex<float>> fftOutput_;
-    std::vector<float> powerSpectrum_;
-    std::vector<float> melSpectrum_;
-    std::vector<uint8_t> colorMappedData_;
+    // Window, FFT plan and filter bank, shared with other users of this config. Only one of
+    // plan_, pipeline_ (a compile-time specialization) and fixedPlan_ is set
+    std::shared_ptr<const MelPlan> plan_;
+    // Set when config_.fixedPoint selects the integer pipeline
+    std::shared_ptr<const FixedMelPlan> fixedPlan_;
+    
+    // Processing buffers, all in arena_ in this order. The FFT and power buffers are
+    // only needed by plan_, the fixed* ones by fixedPlan_, and are null otherwise
+    AlignedArena arena_;
+    int16_t* pendingInput_ = nullptr;        // Streaming carry-over between processAudioSamples calls
+    int16_t* straddleFrame_ = nullptr;       // A frame assembled from carry-over and new input
+    MelPipelineBase* pipeline_ = nullptr;    // Constructed in place; see destroyPipeline()
+    std::complex<float>* fftInput_ = nullptr;
+    std::complex<float>* fftOutput_ = nullptr;
+    float* powerSpectrum_ = nullptr;
+    kiss_fft_fixed_cpx* fixedInput_ = nullptr;
+    kiss_fft_fixed_cpx* fixedOutput_ = nullptr;
+    uint32_t* fixedPower_ = nullptr;
+    uint64_t* fixedMel_ = nullptr;
+    float* melSpectrum_ = nullptr;
+    uint8_t* quantizedSpectrum_ = nullptr;   // Latest frame in outputFormat_, room for the widest format
+    uint8_t* colorMappedData_ = nullptr;     // RGBA per band
+    float* decibels_ = nullptr;              // Log-mel before normalization, for MFCC, deltas and archiving
+    float* mfcc_ = nullptr;
+    MelOutputFormat outputFormat_ = MelOutputFormat::FLOAT32;
+    
+    size_t pendingSamples_ = 0;
+    MelFrameRing* frameRing_ = nullptr;
     
-    // Mel filter bank
-    std::vector<std::vector<float>> melFilterBank_;
+    FrontEndConfig frontEnd_;
+    FrontEndState frontEndState_;
+    
+    ActivityGate activityGate_;
+    bool floorCached_ = false;     // The output buffers hold the floor frame for the closed gate
+    
+    QualityController qualityController_;
+    int qualityLevel_ = 0;
+    QualityLevel quality_;
+    int decimationPhase_ = 0;
+    // Plans for the levels with fewer bands or a smaller FFT (null for the others), acquired with the
+    // main plan; a level change only repoints reducedPlan_. The buffers are in arena_, sized for the largest
+    std::shared_ptr<const MelPlan> reducedPlans_[MAX_QUALITY_LEVEL + 1];
+    const MelPlan* reducedPlan_ = nullptr;
+    std::complex<float>* reducedInput_ = nullptr;
+    std::complex<float>* reducedOutput_ = nullptr;
+    float* reducedPower_ = nullptr;
+    float* reducedMel_ = nullptr;
+    float* reducedDecibels_ = nullptr;
+    
+    MfccConfig mfccConfig_;
+    std::unique_ptr<MfccPlan> mfccPlan_;
+    
+    DeltaConfig deltaConfig_;
+    std::unique_ptr<DeltaStream> deltas_;
+    const float* deltaFrame_ = nullptr;  // Completed by the latest hop, in deltas_'s ring
     
     // Color mapping
     std::vector<std::tuple<uint8_t, uint8_t, uint8_t>> colorMap_;
     
-    // FFT implementation (KissFFT)
-    void* kissFFTConfig_;
-    
     // Performance tracking
     std::chrono::high_resolution_clock::time_point lastFrameTime_;
     int frameCount_ = 0;
@@ -0,0 +1,58 @@
+#ifndef MFCC_H
+#define MFCC_H
+
+#include <vector>
+#include <cstddef>
+
+namespace melspectrogram {
+
+struct MfccConfig {
+    bool enabled = false;
+    int numCoefficients = 13;  // K, counting c0
+    int lifter = 22;           // Sinusoidal lifter length L (HTK); 0 turns liftering off
+};
+
+/**
+ * @brief Log-mel to MFCC: a truncated DCT-II with the lifter folded in
+ *
+ * The input is un-normalized log-mel in dB (10 * log10 of mel power), the
+ * values the log stage produces before normalizing to 0-1. The transform is
+ * the orthonormal DCT-II (scipy's norm="ortho"), so results match librosa's
+ * mfcc() on the same dB values:
+ *
+ *   c[k] = s(k) * sum_n x[n] * cos(pi * k * (2n + 1) / (2N)),
+ *   s(0) = sqrt(1 / N), s(k) = sqrt(2 / N),
+ *
+ * times 1 + (L / 2) * sin(pi * k / L) when liftering. Only the K rows that
+ * are kept are precomputed, so a frame costs K * N multiply-adds and no
+ * coefficient beyond K is ever computed. For the usual K of 13 to 20 and
+ * N up to 128 that is cheaper than an FFT-based DCT.
+ *
+ * Immutable after construction; compute() and computeBatch() may be called
+ * from several threads at once and never allocate.
+ */
+class MfccPlan {
+public:
+    MfccPlan(int numMelBands, const MfccConfig& config);
+
+    int getNumBands() const { return numBands_; }
+    int getNumCoefficients() const { return numCoefficients_; }
+    // numCoefficients rows of numBands weights, lifter included
+    const float* getMatrix() const { return matrix_.data(); }
+
+    // numBands dB values in, numCoefficients out
+    void compute(const float* logMel, float* mfcc) const;
+
+    // frames rows of numBands in, frames rows of numCoefficients out; each matrix row is
+    // applied to the whole batch while it is in cache
+    void computeBatch(const float* logMel, size_t frames, float* mfcc) const;
+
+private:
+    int numBands_;
+    int numCoefficients_;
+    std::vector<float> matrix_;
+};
+
+} // namespace melspectrogram
+
+#endif // MFCC_H
@@ -0,0 +1,138 @@
+#ifndef MULTI_STREAM_ENGINE_H
+#define MULTI_STREAM_ENGINE_H
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <unordered_map>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <cstdint>
+#include <cstddef>
+
+#include "mel_spectrogram.h"
+#include "mel_plan.h"
+
+namespace melspectrogram {
+
+struct MultiStreamStats {
+    uint64_t framesProcessed = 0;
+    uint64_t batchesProcessed = 0;
+    uint64_t samplesDropped = 0;     // A stream's input buffer was full
+    float averageBatchFrames = 0.0f;
+    int activeStreams = 0;
+    int configGroups = 0;
+    int numWorkers = 0;
+};
+
+/**
+ * @brief Computes mel frames for many independent streams on a fixed worker pool
+ *
+ * Each stream is framed by hop like MelSpectrogramProcessor::processAudioSamples
+ * and produces the same values. Streams with the same AudioConfig, hopSize
+ * aside, form a group sharing one MelPlan, and a worker always batches frames from a single group,
+ * so the FFT plan and filter weights stay in cache across the batch.
+ *
+ * Scheduling: groups are served round-robin, and within a group ready streams
+ * wait in FIFO order and each gets an equal share of the batch. A stream is in
+ * at most one batch at a time, so its frames are delivered in order.
+ */
+class MultiStreamEngine {
+public:
+    // Called on a worker thread with consecutive frames of one stream
+    using FrameCallback = std::function<void(int streamId, const float* frames, size_t numFrames)>;
+
+    /**
+     * @param numWorkers Worker threads; 0 uses the hardware concurrency
+     * @param maxBatchFrames Most frames computed per batch
+     */
+    explicit MultiStreamEngine(int numWorkers = 0, int maxBatchFrames = 32);
+    ~MultiStreamEngine();
+
+    MultiStreamEngine(const MultiStreamEngine&) = delete;
+    MultiStreamEngine& operator=(const MultiStreamEngine&) = delete;
+
+    // Launch / join the workers. Samples pushed while stopped are kept.
+    bool start();
+    void stop();
+    bool isRunning() const { return running_; }
+
+    /**
+     * @brief Register a stream
+     * @param maxBufferedSamples Input kept ahead of processing; 0 means two seconds
+     * @return Stream id, or -1 if the framing is invalid
+     */
+    int addStream(const AudioConfig& config, FrameCallback callback, size_t maxBufferedSamples = 0);
+
+    // Waits for the stream's in-flight batch; must not be called from a callback
+    bool removeStream(int streamId);
+
+    // Returns samples accepted; the rest are counted as dropped
+    size_t pushSamples(int streamId, const int16_t* samples, size_t count);
+
+    // Block until every complete frame has been delivered
+    bool waitIdle(int timeoutMs);
+
+    MultiStreamStats getStats() const;
+    int getNumWorkers() const { return numWorkers_; }
+
+private:
+    struct ConfigGroup;
+
+    struct Stream {
+        int id;
+        ConfigGroup* group;
+        FrameCallback callback;
+        std::vector<int16_t> samples;
+        size_t readPos = 0;
+        size_t hopSize = 0;  // Per stream: the group's plan may have been built for another hop
+        size_t maxBuffered = 0;
+        bool queued = false;
+        bool inFlight = false;
+    };
+
+    struct ConfigGroup {
+        std::shared_ptr<const MelPlan> plan;
+        std::deque<Stream*> ready;
+        int numStreams = 0;
+    };
+
+    struct BatchEntry {
+        Stream* stream;
+        size_t firstFrame;
+        size_t numFrames;
+    };
+
+    void workerThread();
+    size_t availableFrames(const Stream& stream) const;
+    void enqueueIfReady(Stream& stream);
+    ConfigGroup* nextReadyGroup();
+
+    int numWorkers_;
+    size_t maxBatchFrames_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable workCV_;
+    std::condition_variable idleCV_;
+
+    std::unordered_map<int, std::unique_ptr<Stream>> streams_;
+    std::vector<std::unique_ptr<ConfigGroup>> groups_;
+    size_t nextGroup_;
+    int nextStreamId_;
+    size_t readyStreams_;
+    int busyWorkers_;
+
+    bool running_;
+    bool shouldStop_;
+    std::vector<std::thread> workers_;
+
+    uint64_t framesProcessed_;
+    uint64_t batchesProcessed_;
+    uint64_t samplesDropped_;
+};
+
+} // namespace melspectrogram
+
+#endif // MULTI_STREAM_ENGINE_H
@@ -0,0 +1,101 @@
+#ifndef OFFLINE_SPECTROGRAM_H
+#define OFFLINE_SPECTROGRAM_H
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+#include "mel_spectrogram.h"
+#include "mapped_file.h"
+
+namespace melspectrogram {
+
+/**
+ * @brief Read-only memory mapping of a 16-bit PCM WAV file
+ *
+ * Samples are used in place; nothing is copied unless a single channel is
+ * extracted from interleaved multi-channel data.
+ */
+class MappedWav {
+public:
+    MappedWav();
+
+    MappedWav(const MappedWav&) = delete;
+    MappedWav& operator=(const MappedWav&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const { return samples_ != nullptr; }
+
+    // Interleaved samples, numFrames() * getNumChannels() of them
+    const int16_t* samples() const { return samples_; }
+    size_t numFrames() const { return numFrames_; }
+    int getSampleRate() const { return sampleRate_; }
+    int getNumChannels() const { return numChannels_; }
+
+    // De-interleave one channel (mono files can use samples() directly)
+    bool extractChannel(int channel, std::vector<int16_t>& output) const;
+
+    const std::string& getError() const { return error_; }
+
+private:
+    bool fail(const std::string& message);
+
+    MappedFile file_;
+    const int16_t* samples_;
+    size_t numFrames_;
+    int sampleRate_;
+    int numChannels_;
+    std::string error_;
+};
+
+struct OfflineStats {
+    size_t framesProcessed = 0;
+    size_t chunks = 0;
+    size_t steals = 0;     // Chunk ranges taken over from another worker
+    int numThreads = 0;
+    float elapsedMs = 0.0f;
+};
+
+/**
+ * @brief Mel spectrogram of a whole recording on a work-stealing thread pool
+ *
+ * Frames are split into chunks of consecutive hops. A chunk reads its frames'
+ * full windows, including the frameSize - hopSize samples it shares with the
+ * next chunk, straight from the input, so no carry-over is needed and every
+ * frame is computed exactly as processAudioSamples() would compute it on the
+ * whole input in one call.
+ *
+ * Each worker owns a MelSpectrogramProcessor and starts with an even slice of
+ * the chunks. An idle worker steals the upper half of the largest remaining slice.
+ */
+class OfflineSpectrogram {
+public:
+    /**
+     * @param numThreads Workers; 0 uses the hardware concurrency
+     * @param chunkFrames Frames per chunk; 0 picks about eight chunks per worker
+     */
+    explicit OfflineSpectrogram(const AudioConfig& config, int numThreads = 0, size_t chunkFrames = 0);
+
+    // Frames a recording of numSamples produces with this framing
+    static size_t frameCount(size_t numSamples, const AudioConfig& config);
+
+    /**
+     * @brief Compute up to maxFrames frames (numMelBands floats each) into output
+     * @return Frames written, or -1 on invalid arguments
+     */
+    long process(const int16_t* samples, size_t numSamples, float* output, size_t maxFrames);
+
+    OfflineStats getStats() const { return stats_; }
+
+private:
+    AudioConfig config_;
+    int numThreads_;
+    size_t chunkFrames_;
+    OfflineStats stats_;
+};
+
+} // namespace melspectrogram
+
+#endif // OFFLINE_SPECTROGRAM_H
@@ -0,0 +1,148 @@
+#ifndef PIPELINE_RUNNER_H
+#define PIPELINE_RUNNER_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <memory>
+
+#include "audio_input.h"
+#include "mel_spectrogram.h"
+
+namespace melspectrogram {
+
+class TextureRenderer;
+class SessionRecorder;
+class Resampler;
+
+struct PipelineStats {
+    uint64_t samplesReceived = 0;
+    uint64_t samplesDropped = 0;     // Input FIFO was full
+    uint64_t framesProcessed = 0;
+    uint64_t framesSkipped = 0;      // Of framesProcessed, gated as inactive (see setActivityGate)
+    uint64_t columnsDelivered = 0;   // Handed to the consumer by pollColumns/readColumns
+    uint64_t columnsDropped = 0;     // Consumer fell more than columnCapacity behind
+    int queuedColumns = 0;
+    int qualityLevel = 0;            // The processor's adaptive quality level after the last block
+    float averageBlockTimeMs = 0.0f; // DSP time per wake-up
+    float maxBlockTimeMs = 0.0f;
+};
+
+/**
+ * @brief Runs AudioInput -> MelSpectrogramProcessor on a dedicated DSP thread
+ *
+ * Audio callbacks (or pushSamples() for file streams) append to a bounded
+ * sample FIFO and wake the DSP thread, so processing follows audio arrival
+ * rather than a UI timer. Finished mel columns go to the processor's frame
+ * ring, if one is attached, and to a bounded column queue that the UI thread
+ * drains with pollColumns() once per display frame. Rendering stays on the
+ * caller's thread, which is what GL needs.
+ *
+ * While running, the DSP thread owns the processor exclusively.
+ *
+ * An attached SessionRecorder receives the raw input on the producer thread
+ * and each finished frame's dB log-mel, before normalization, on the DSP
+ * thread, through its lock-free hand-off.
+ * Its config has to describe both: numMelBands, hopSize and sampleRate as in
+ * config when it records mel, and a PCM rate equal to the input rate when it
+ * records PCM (RecorderConfig::pcmSampleRate once input is resampled).
+ * setRecorder() and start() reject a recorder that does not match.
+ *
+ * Input at another rate than config.sampleRate (an AudioInput's rate, or
+ * setInputRate() for pushed samples) is resampled on the DSP thread before
+ * framing, so the FFT runs at the analysis rate (see canonicalAnalysisRate).
+ */
+class PipelineRunner {
+public:
+    /**
+     * @param processor Processor configured with config; must outlive the runner
+     * @param config Framing parameters the processor was built with
+     * @param columnCapacity Columns kept for the consumer before the oldest are dropped
+     * @param sampleCapacity Samples buffered between audio arrival and the DSP thread
+     */
+    PipelineRunner(MelSpectrogramProcessor& processor, const AudioConfig& config,
+                   int columnCapacity = 256, size_t sampleCapacity = 0);
+    ~PipelineRunner();
+
+    PipelineRunner(const PipelineRunner&) = delete;
+    PipelineRunner& operator=(const PipelineRunner&) = delete;
+
+    /**
+     * @brief Start the DSP thread
+     * @param input Optional audio source; its callback is redirected to the runner
+     *              and recording is started. Pass nullptr to feed pushSamples().
+     */
+    bool start(audio::AudioInput* input = nullptr);
+    void stop();
+    bool isRunning() const { return running_; }
+
+    // Tee input samples and dB mel frames to a started recorder; only while stopped (nullptr detaches).
+    // False if its config does not match (see above). pushSamples() must then be called from one
+    // thread at a time.
+    bool setRecorder(SessionRecorder* recorder);
+
+    // Rate of pushed samples when it differs from config.sampleRate; only while stopped (0 = same)
+    bool setInputRate(int inputRate);
+    int getInputRate() const { return inputRate_; }
+
+    // Producer side; returns samples accepted (the rest are counted as dropped)
+    size_t pushSamples(const int16_t* samples, size_t count);
+
+    /**
+     * @brief Move queued columns into a renderer and flush them (UI/GL thread)
+     * @return Columns delivered
+     */
+    int pollColumns(TextureRenderer& renderer);
+
+    // Copy up to maxColumns queued columns, oldest first; returns the count
+    int readColumns(float* output, int maxColumns);
+
+    PipelineStats getStats() const;
+
+    // Block until the input FIFO is drained (for tests and offline feeds)
+    bool waitIdle(int timeoutMs);
+
+private:
+    void dspThread();
+    void queueColumns(const float* columns, size_t count);
+    bool recorderMatches(const SessionRecorder& recorder) const;
+
+    MelSpectrogramProcessor& processor_;
+    AudioConfig config_;
+    audio::AudioInput* input_;
+    bool startedRecording_;
+    SessionRecorder* recorder_;
+    int inputRate_;
+    std::unique_ptr<Resampler> resampler_;  // Set while running when inputRate_ differs
+
+    // Input FIFO
+    std::vector<int16_t> samples_;
+    size_t sampleHead_;
+    size_t sampleCount_;
+    bool busy_;
+    mutable std::mutex sampleMutex_;
+    std::condition_variable sampleCV_;
+    std::condition_variable idleCV_;
+
+    // Output column queue
+    std::vector<float> columns_;
+    int columnCapacity_;
+    int columnHead_;
+    int columnCount_;
+    mutable std::mutex columnMutex_;
+
+    std::atomic<bool> running_{false};
+    std::atomic<bool> shouldStop_{false};
+    std::thread thread_;
+
+    mutable std::mutex statsMutex_;
+    PipelineStats stats_;
+};
+
+} // namespace melspectrogram
+
+#endif // PIPELINE_RUNNER_H
@@ -0,0 +1,38 @@
+#ifndef PLAN_CACHE_H
+#define PLAN_CACHE_H
+
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace melspectrogram {
+
+/**
+ * @brief Shared immutable plan for key, built from config on first use
+ *
+ * Each Plan type has its own process-wide cache. Entries hold weak
+ * references, so a plan is released with its last user; expired entries
+ * are dropped whenever a new plan is added. Building a plan may acquire
+ * plans of other types (each cache has its own lock), not of its own.
+ */
+template <class Plan, class Key, class Config>
+std::shared_ptr<const Plan> acquireCachedPlan(const Key& key, const Config& config) {
+    static std::mutex cacheMutex;
+    static std::map<Key, std::weak_ptr<const Plan>> cache;
+
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    std::shared_ptr<const Plan> plan = cache[key].lock();
+    if (!plan) {
+        // Drop plans nobody holds any more before adding a new one
+        for (auto it = cache.begin(); it != cache.end();) {
+            it = it->second.expired() ? cache.erase(it) : std::next(it);
+        }
+        plan = std::make_shared<const Plan>(config);
+        cache[key] = plan;
+    }
+    return plan;
+}
+
+} // namespace melspectrogram
+
+#endif // PLAN_CACHE_H
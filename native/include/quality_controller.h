@@ -0,0 +1,73 @@
+#ifndef QUALITY_CONTROLLER_H
+#define QUALITY_CONTROLLER_H
+
+namespace melspectrogram {
+
+/**
+ * @brief One rung of the degradation ladder
+ *
+ * Output keeps its shape at every level: decimated hops repeat the last
+ * frame, and reduced bands are interpolated back up to numMelBands.
+ */
+struct QualityLevel {
+    int decimation = 1;        // Compute every Nth hop
+    int bandDivisor = 1;       // Compute numMelBands / N bands
+    int fftDivisor = 1;        // Transform only the newest frameSize / N samples
+    bool colorMapping = true;  // Off leaves the color data at the last mapped frame
+};
+
+// Level 0 is full quality; each level adds one step to the one before it:
+// decimation, fewer bands, a smaller FFT, then no colormapping
+constexpr int MAX_QUALITY_LEVEL = 4;
+QualityLevel qualityLevelFor(int level);
+
+struct QualityControllerConfig {
+    bool enabled = false;
+    float budget = 0.5f;        // Share of the hop duration a frame may take
+    float maxMissRate = 0.05f;  // Smoothed share of frames over budget that triggers a step down
+    float smoothing = 0.05f;    // Weight of each new frame in the moving averages
+    int holdFrames = 64;        // Frames after any change before the next step down
+    int recoverFrames = 256;    // Consecutive calm frames needed to step back up
+};
+
+/**
+ * @brief Picks a quality level from per-frame processing times
+ *
+ * Tracks exponential moving averages of the deadline-miss rate (frames
+ * taking more than budget * deadline) and of the load (frame time over
+ * deadline). It steps down when either exceeds its limit, at most once per
+ * holdFrames, and steps up only after recoverFrames consecutive frames with
+ * the miss rate under a quarter of its limit and the load under half the
+ * budget. The averages are kept even when disabled, for reporting.
+ */
+class QualityController {
+public:
+    explicit QualityController(const QualityControllerConfig& config = QualityControllerConfig())
+        : config_(config) {}
+
+    void setConfig(const QualityControllerConfig& config);
+    const QualityControllerConfig& getConfig() const { return config_; }
+
+    // Record one frame; returns the level the next frame should use
+    int update(float frameTimeMs, float deadlineMs);
+    // Move to level now, as if the controller had chosen it (clamped to 0..MAX_QUALITY_LEVEL)
+    void setLevel(int level);
+
+    int getLevel() const { return level_; }
+    float getMissRate() const { return missRate_; }
+    float getLoad() const { return load_; }
+    bool isOverBudget() const { return missRate_ > config_.maxMissRate || load_ > config_.budget; }
+    void reset();
+
+private:
+    QualityControllerConfig config_;
+    int level_ = 0;
+    float missRate_ = 0.0f;
+    float load_ = 0.0f;
+    int framesSinceChange_ = 0;
+    int calmFrames_ = 0;
+};
+
+} // namespace melspectrogram
+
+#endif // QUALITY_CONTROLLER_H
@@ -0,0 +1,144 @@
+#ifndef RENDER_BACKEND_H
+#define RENDER_BACKEND_H
+
+#include <vector>
+#include <cstdint>
+#include <memory>
+
+namespace melspectrogram {
+
+enum class RenderBackendType {
+    AUTO,    // OpenGL when a context is current, CPU otherwise
+    OPENGL,
+    CPU
+};
+
+/**
+ * @brief Destination surface for the waterfall columns produced by TextureRenderer
+ *
+ * Columns are written at their ring position; the oldest column sits at the
+ * renderer's ring offset, so consumers scroll by sampling with that offset
+ * instead of re-uploading the whole image every frame.
+ */
+class RenderBackend {
+public:
+    virtual ~RenderBackend() = default;
+
+    virtual RenderBackendType getType() const = 0;
+
+    /**
+     * @brief Allocate the surface, cleared to opaque black
+     * @return false if the backend is unavailable (e.g. no GL context)
+     */
+    virtual bool initialize(int width, int height) = 0;
+    virtual void shutdown() = 0;
+
+    /**
+     * @brief Write one column of packed RGBA pixels
+     * @param x Ring position of the column
+     * @param column height pixels, top row first
+     */
+    virtual void writeColumn(int x, const uint32_t* column) = 0;
+
+    /**
+     * @brief Write a block of adjacent columns in one upload
+     * @param x Ring position of the first column
+     * @param count Number of columns
+     * @param pixels Top-left pixel of the block (row-major, top row first)
+     * @param rowStride Pixels between the starts of consecutive rows
+     */
+    virtual void writeColumns(int x, int count, const uint32_t* pixels, int rowStride) = 0;
+
+    // GL texture name, 0 when the backend has no GPU texture
+    virtual unsigned int getTextureId() const { return 0; }
+
+    // Row-major RGBA pixels, nullptr when not CPU-addressable
+    virtual const uint8_t* getPixels() const { return nullptr; }
+    virtual int getStride() const { return 0; }
+
+    /**
+     * @brief Start an asynchronous copy of the surface (ring order) to client memory
+     * @return false if unsupported or a readback is already in flight
+     */
+    virtual bool requestReadback() { return false; }
+
+    /**
+     * @brief Non-blocking completion check for requestReadback()
+     * @param pixels Receives width * height RGBA pixels, top row first
+     * @return true once the copy has completed and pixels was filled
+     */
+    virtual bool pollReadback(std::vector<uint8_t>& pixels) { (void)pixels; return false; }
+    virtual bool isReadbackPending() const { return false; }
+};
+
+/**
+ * @brief Software rasterizer writing into a row-major RGBA framebuffer
+ */
+class CpuRasterBackend : public RenderBackend {
+public:
+    CpuRasterBackend();
+
+    RenderBackendType getType() const override { return RenderBackendType::CPU; }
+    bool initialize(int width, int height) override;
+    void shutdown() override;
+    void writeColumn(int x, const uint32_t* column) override;
+    void writeColumns(int x, int count, const uint32_t* pixels, int rowStride) override;
+
+    const uint8_t* getPixels() const override;
+    int getStride() const override { return width_ * 4; }
+
+private:
+    int width_;
+    int height_;
+    std::vector<uint32_t> framebuffer_;
+};
+
+/**
+ * @brief OpenGL (ES) texture backend; requires a current context
+ */
+class OpenGLBackend : public RenderBackend {
+public:
+    OpenGLBackend();
+    ~OpenGLBackend() override;
+
+    // True if the calling thread has a current context; makes no GL call
+    static bool hasCurrentContext();
+
+    RenderBackendType getType() const override { return RenderBackendType::OPENGL; }
+    bool initialize(int width, int height) override;
+    void shutdown() override;
+    void writeColumn(int x, const uint32_t* column) override;
+    void writeColumns(int x, int count, const uint32_t* pixels, int rowStride) override;
+
+    unsigned int getTextureId() const override { return textureId_; }
+
+    // Pixel-pack buffer readback guarded by a fence; never stalls the render thread
+    bool requestReadback() override;
+    bool pollReadback(std::vector<uint8_t>& pixels) override;
+    bool isReadbackPending() const override { return readbackFence_ != nullptr; }
+
+private:
+    bool setupOpenGL();
+    bool createTexture();
+    void releaseReadback();
+
+    int width_;
+    int height_;
+    unsigned int textureId_;
+
+    // Readback resources, created on first request
+    unsigned int readFramebuffer_;
+    unsigned int packBuffer_;
+    void* readbackFence_;  // GLsync
+};
+
+/**
+ * @brief Create and initialize a backend
+ * @param type AUTO tries OpenGL first and falls back to the CPU rasterizer
+ * @return nullptr if the requested backend cannot be initialized
+ */
+std::unique_ptr<RenderBackend> createRenderBackend(RenderBackendType type, int width, int height);
+
+} // namespace melspectrogram
+
+#endif // RENDER_BACKEND_H
@@ -0,0 +1,94 @@
+#ifndef RESAMPLER_H
+#define RESAMPLER_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace melspectrogram {
+
+/**
+ * @brief Analysis rate for a device rate: 16 or 32 kHz when maxFreq fits in the resampler's passband
+ *
+ * The anti-aliasing filter rolls off well before the new Nyquist frequency
+ * (see Resampler::getPassbandEdge), so a candidate is taken only when maxFreq
+ * lies in its flat passband: 8 kHz from 48 kHz goes to 32 kHz, not 16 kHz.
+ * Never upsamples; rates already at or below the candidates are returned unchanged.
+ */
+int canonicalAnalysisRate(int inputRate, float maxFreq);
+
+/**
+ * @brief Streaming rational-ratio polyphase resampler for int16 audio
+ *
+ * The ratio outputRate / inputRate is reduced to L / M. A Kaiser-windowed
+ * sinc low-pass is designed once at L times the input rate, with its cutoff
+ * at rolloff times the lower Nyquist frequency, and split into L phase
+ * tables. Each output sample is then one dot product of a phase table with
+ * the newest input samples (SSE2 or NEON). 48 kHz to 16 kHz is a single
+ * phase; 44.1 kHz to 16 kHz uses 160.
+ *
+ * Input is consumed in any chunk size and the output matches a single call
+ * over the whole stream. The filter is linear-phase, so output lags the
+ * input by getDelay() output samples.
+ */
+class Resampler {
+public:
+    /**
+     * @param zeroCrossings Sinc zero crossings kept on each side; sets the transition width
+     * @param rolloff Passband edge as a fraction of the lower Nyquist frequency
+     */
+    Resampler(int inputRate, int outputRate, int zeroCrossings = 12, float rolloff = 0.9f);
+
+    /**
+     * @brief Highest frequency the filter for these parameters passes flat
+     *
+     * The Kaiser transition band is centred on the cutoff (rolloff times the
+     * lower Nyquist frequency); this is its lower edge, about 0.75 of the new
+     * Nyquist frequency with the defaults.
+     */
+    static float getPassbandEdge(int inputRate, int outputRate, int zeroCrossings = 12, float rolloff = 0.9f);
+
+    Resampler(const Resampler&) = delete;
+    Resampler& operator=(const Resampler&) = delete;
+
+    int getInputRate() const { return inputRate_; }
+    int getOutputRate() const { return outputRate_; }
+    int getNumPhases() const { return upFactor_; }
+    int getTapsPerPhase() const { return taps_; }
+    double getDelay() const;
+
+    // Upper bound on the samples process() produces for count more input samples
+    size_t getMaxOutput(size_t count) const;
+
+    /**
+     * @brief Resample count samples into output
+     *
+     * All input is taken. If capacity is below getMaxOutput(count), the
+     * samples that did not fit are produced by the next call instead.
+     *
+     * @return Samples written
+     */
+    size_t process(const int16_t* input, size_t count, int16_t* output, size_t capacity);
+
+    // Forget all input, as for a new stream
+    void reset();
+
+private:
+    void designFilter(int zeroCrossings, float rolloff);
+
+    int inputRate_;
+    int outputRate_;
+    int upFactor_;    // L
+    int downFactor_;  // M
+    int taps_;        // Per phase, a multiple of 4
+    std::vector<float> phases_;  // upFactor_ rows of taps_, oldest input sample first
+
+    // Input not yet fully used, after taps_ - 1 samples of history
+    std::vector<float> buffer_;
+    size_t position_;  // Buffer index of the newest sample the next output needs
+    int phase_;
+};
+
+} // namespace melspectrogram
+
+#endif // RESAMPLER_H
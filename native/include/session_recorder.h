@@ -0,0 +1,176 @@
+#ifndef SESSION_RECORDER_H
+#define SESSION_RECORDER_H
+
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <memory>
+
+#include "mel_archive.h"
+
+namespace melspectrogram {
+
+struct RecorderConfig {
+    // Segments are written as <pathPrefix>_NNNN.wav and <pathPrefix>_NNNN.mela
+    std::string pathPrefix;
+    int sampleRate = 32000;         // Analysis rate the mel frames were computed at
+    int pcmSampleRate = 0;          // Rate of pushPcm() audio when it differs (e.g. before resampling); 0 = sampleRate
+    int numMelBands = 64;
+    int hopSize = 512;
+    bool recordPcm = true;
+    bool recordMel = true;
+    int melBitDepth = 8;
+    float melDynamicRangeDb = 70.0f;  // dB kept below each archive chunk's peak (see MelArchiveConfig)
+
+    size_t blockBytes = 64 * 1024;  // Hand-off and write unit, rounded to whole samples/frames
+    int backlogBlocks = 8;          // Blocks per stream; data arriving with none free is dropped
+    double rotateSeconds = 0.0;     // Start a new segment after this much audio; 0 keeps one file
+    // Sample bytes per WAV before a segment is forced to rotate, whatever rotateSeconds says;
+    // 0 or anything larger means SessionRecorder::MAX_WAV_DATA_BYTES
+    uint64_t maxWavBytes = 0;
+    int pollIntervalMs = 20;        // How often the I/O thread looks for full blocks
+};
+
+struct RecorderStats {
+    uint64_t pcmSamplesWritten = 0;
+    uint64_t pcmSamplesDropped = 0;   // No free block when they arrived
+    uint64_t melFramesWritten = 0;
+    uint64_t melFramesDropped = 0;
+    uint64_t bytesWritten = 0;
+    int segments = 0;                 // Segments opened so far
+    int writeErrors = 0;
+    int backlogBlocks = 0;            // Full blocks waiting for the I/O thread
+    int maxBacklogBlocks = 0;
+    float averageWriteMs = 0.0f;      // Per block written
+    float maxWriteMs = 0.0f;
+};
+
+/**
+ * @brief Tees raw PCM and mel frames to disk from a background I/O thread
+ *
+ * Each stream owns a fixed pool of page-aligned blocks, allocated by start().
+ * The producer fills one block at a time and hands full blocks to the I/O
+ * thread through a single-producer/single-consumer index queue; the I/O
+ * thread writes each block in one call and hands it back. With two or more
+ * blocks the producer keeps filling while the previous block is written.
+ *
+ * pushPcm() and pushMel() are safe on real-time threads: they only copy into
+ * the current block and exchange indices with atomics. They never lock,
+ * allocate or touch the filesystem, and when every block is still waiting to
+ * be written they drop the data and count it instead of blocking. Each may be
+ * called from one thread at a time, e.g. pushPcm() from the audio callback and
+ * pushMel() from the DSP thread.
+ *
+ * PCM goes to 16-bit mono WAV files whose sample data starts 4 KiB into the
+ * file, so block writes stay aligned. WAV sizes are 32-bit, so when
+ * rotateSeconds is 0 or longer than a WAV can hold (about 18.6 hours at
+ * 32 kHz), both streams rotate at the WAV limit instead; mel frames, the processor's dB log-mel
+ * (PipelineRunner pushes getDecibelData() values), go to MelArchiveWriter files.
+ */
+class SessionRecorder {
+public:
+    // Most sample data a WAV with this header can describe: RIFF size = 4088 + data bytes
+    static constexpr uint64_t MAX_WAV_DATA_BYTES = (0xFFFFFFFFull - 4088) & ~1ull;
+
+    explicit SessionRecorder(const RecorderConfig& config);
+    ~SessionRecorder();
+
+    SessionRecorder(const SessionRecorder&) = delete;
+    SessionRecorder& operator=(const SessionRecorder&) = delete;
+
+    bool start();
+
+    // Stop after the producers have: hands over partial blocks, drains the backlog and closes the files
+    void stop();
+    bool isRunning() const { return running_; }
+
+    // Real-time producer side; return false if any of the data was dropped
+    bool pushPcm(const int16_t* samples, size_t count);
+    bool pushMel(const float* frames, size_t numFrames);
+
+    RecorderStats getStats() const;
+    const RecorderConfig& getConfig() const { return config_; }
+    int getPcmSampleRate() const { return config_.pcmSampleRate > 0 ? config_.pcmSampleRate : config_.sampleRate; }
+    std::string getError() const;
+
+private:
+    // Lock-free block pool for one stream
+    struct BlockChannel {
+        std::vector<uint8_t> storage;
+        uint8_t* base = nullptr;
+        size_t blockBytes = 0;    // Usable bytes, a whole number of items
+        size_t blockStride = 0;   // blockBytes rounded up to the alignment
+        size_t itemBytes = 0;
+        int numBlocks = 0;
+
+        // Queues of block indices; capacity numBlocks + 1 so they never fill
+        std::vector<uint32_t> fullSlots;    // Producer -> I/O thread
+        std::vector<uint32_t> fullLengths;  // Bytes used in each full block
+        std::atomic<size_t> fullHead{0};
+        std::atomic<size_t> fullTail{0};
+        std::vector<uint32_t> freeSlots;    // I/O thread -> producer
+        std::atomic<size_t> freeHead{0};
+        std::atomic<size_t> freeTail{0};
+
+        // Producer-only state
+        int fillBlock = -1;
+        size_t fillBytes = 0;
+
+        std::atomic<uint64_t> itemsDropped{0};
+
+        void allocate(size_t blockSize, size_t itemSize, int blocks);
+        uint8_t* block(uint32_t index) const { return base + static_cast<size_t>(index) * blockStride; }
+        size_t push(const uint8_t* data, size_t bytes);   // Returns bytes accepted
+        void handOver();                                   // Queue the partial block
+        bool popFull(uint32_t& index, uint32_t& length);
+        void release(uint32_t index);
+        int backlog() const;
+    };
+
+    void ioThread();
+    void drain();
+    bool writePcm(const uint8_t* data, size_t bytes);
+    bool writeMel(const float* frames, size_t numFrames);
+    bool openPcmSegment();
+    void closePcmSegment();
+    bool openMelSegment();
+    void closeMelSegment();
+    std::string segmentPath(int segment, const char* extension) const;
+    void recordWrite(float ms, size_t bytes);
+    void setError(const std::string& message);
+
+    RecorderConfig config_;
+    BlockChannel pcm_;
+    BlockChannel mel_;
+
+    // I/O thread state
+    FILE* pcmFile_;
+    int pcmSegment_;
+    uint64_t pcmSegmentSamples_;
+    uint64_t segmentSamples_;        // Rotation length, 0 for none
+    std::unique_ptr<MelArchiveWriter> melWriter_;
+    int melSegment_;
+    uint64_t melSegmentFrames_;
+    uint64_t melTotalFrames_;
+    uint64_t segmentFrames_;
+
+    std::atomic<bool> running_{false};
+    bool shouldStop_;
+    std::mutex wakeMutex_;
+    std::condition_variable wakeCV_;
+    std::thread thread_;
+
+    mutable std::mutex statsMutex_;
+    RecorderStats stats_;
+    std::string error_;
+};
+
+} // namespace melspectrogram
+
+#endif // SESSION_RECORDER_H
@@ -0,0 +1,107 @@
+#ifndef SPECTROGRAM_EXPORTER_H
+#define SPECTROGRAM_EXPORTER_H
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+
+#include "texture_renderer.h"
+
+namespace melspectrogram {
+
+enum class ExportFormat {
+    PNG,          // RGBA image, time on the x axis, highest band on the top row
+    RAW_UINT8,    // Frames in time order, numMelBands bytes each, quantized over [min, max]
+    RAW_FLOAT32   // Frames in time order, numMelBands native-endian floats each
+};
+
+struct ExportOptions {
+    ExportFormat format = ExportFormat::PNG;
+    // PNG only: 0 writes stored (uncompressed) deflate blocks, 1-9 are zlib levels
+    int compressionLevel = 1;
+    // PNG only: apply the Sub row filter, which helps smooth colormaps compress
+    bool subFilter = true;
+};
+
+/**
+ * @brief Encodes waterfall snapshots to files on a background worker thread
+ *
+ * exportAsync() only copies the compact ring (width * numMelBands values) on the
+ * calling thread and never waits on encoding or file I/O. The worker expands and
+ * encodes one row at a time, so peak memory per job stays at the snapshot plus a
+ * row and a fixed-size output buffer. Files are written under "<path>.part" and
+ * renamed into place once complete.
+ */
+class SpectrogramExporter {
+public:
+    using CompletionCallback = std::function<void(const std::string& path, bool success)>;
+
+    struct Stats {
+        size_t jobsCompleted = 0;
+        size_t jobsFailed = 0;
+        size_t jobsRejected = 0;   // Queue was full
+        size_t bytesWritten = 0;
+        float lastEncodeTimeMs = 0.0f;
+    };
+
+    explicit SpectrogramExporter(size_t maxQueuedJobs = 4);
+    ~SpectrogramExporter();
+
+    SpectrogramExporter(const SpectrogramExporter&) = delete;
+    SpectrogramExporter& operator=(const SpectrogramExporter&) = delete;
+
+    /**
+     * @brief Snapshot the renderer and queue an export
+     * @return false if the renderer is not initialized or the queue is full
+     */
+    bool exportAsync(const TextureRenderer& renderer, const std::string& path,
+                     const ExportOptions& options = ExportOptions(),
+                     CompletionCallback callback = nullptr);
+
+    // Queue an already taken snapshot
+    bool exportAsync(RingSnapshot snapshot, const std::string& path,
+                     const ExportOptions& options = ExportOptions(),
+                     CompletionCallback callback = nullptr);
+
+    // Block until all queued jobs are done (not for real-time threads)
+    bool waitIdle(int timeoutMs);
+
+    size_t getPendingJobs() const;
+    Stats getStats() const;
+
+    // Encode synchronously on the calling thread
+    static bool encodeToFile(const RingSnapshot& snapshot, const std::string& path,
+                             const ExportOptions& options, size_t* bytesWritten = nullptr);
+
+private:
+    struct Job {
+        RingSnapshot snapshot;
+        std::string path;
+        ExportOptions options;
+        CompletionCallback callback;
+    };
+
+    void workerThread();
+
+    size_t maxQueuedJobs_;
+    std::deque<Job> queue_;
+    size_t activeJobs_;
+    mutable std::mutex queueMutex_;
+    std::condition_variable queueCV_;
+    std::condition_variable idleCV_;
+    std::atomic<bool> shouldStop_{false};
+    std::thread worker_;
+
+    mutable std::mutex statsMutex_;
+    Stats stats_;
+};
+
+} // namespace melspectrogram
+
+#endif // SPECTROGRAM_EXPORTER_H
@@ -4,13 +4,13 @@
 #include <vector>
 #include <cstdint>
 #include <memory>
+#include <tuple>
+#include <functional>
+#include <chrono>
 
-#ifdef __APPLE__
-#include <OpenGL/gl.h>
-#include <OpenGL/glext.h>
-#else
-#include <GLES3/gl3.h>
-#endif
+#include "render_backend.h"
+#include "mel_quantize.h"
+#include "mel_history_pyramid.h"
 
 namespace melspectrogram {
 
@@ -20,22 +20,88 @@ enum class ColorMapType {
     PLASMA
 };
 
+/**
+ * Compact copy of the waterfall ring, cheap enough to take on the render thread.
+ * Column c of the image (time order) is ring slot (ringOffset + c) % width.
+ */
+struct RingSnapshot {
+    int width = 0;
+    int height = 0;
+    int numMelBands = 0;
+    int ringOffset = 0;
+    float minValue = 0.0f;
+    float maxValue = 1.0f;
+    std::vector<uint32_t> bandColors;  // width * numMelBands packed RGBA, ring order
+    std::vector<float> melValues;      // width * numMelBands input values, ring order
+    std::vector<int> rowBand;          // Mel band shown on each row, top row first
+};
+
 class TextureRenderer {
 public:
-    TextureRenderer(int width, int height, int numMelBands);
+    TextureRenderer(int width, int height, int numMelBands,
+                    RenderBackendType backendType = RenderBackendType::AUTO);
     ~TextureRenderer();
 
     // Main functionality
     bool initialize();
+    // Use a caller-provided backend; it is initialized with the renderer's size
+    bool initialize(std::unique_ptr<RenderBackend> backend);
     bool updateColumn(const std::vector<float>& melData);
+    bool updateColumn(const float* melData, int numBands);
+    // Quantized columns (MelOutputFormat::UINT8, or FLOAT16 as raw half bits), rendered like
+    // the equivalent floats; uint8 columns are colorized through a 256-entry table
+    bool updateColumn(const uint8_t* melData, int numBands);
+    bool updateColumn(const uint16_t* melData, int numBands);
+    
+    // Column batching: enqueue columns as they arrive and flush once per frame (e.g. on vsync).
+    // A flush uploads every pending column with at most two sub-image writes, split at the
+    // ring wraparound. CPU-addressable backends are written immediately and flush is a no-op.
+    bool enqueueColumn(const float* melData, int numBands);
+    bool enqueueColumn(const uint8_t* melData, int numBands);
+    bool enqueueColumn(const uint16_t* melData, int numBands);
+    int flush();  // Returns the number of uploads issued
+    int getPendingColumns() const { return pendingColumns_; }
+    int64_t getUploadCount() const { return uploadCount_; }
     
     // Configuration
     void setColorMap(ColorMapType type);
     void setMinMaxValues(float minValue, float maxValue);
     
     // Data access
+    // Current waterfall in time order (oldest column at x = 0), assembled on the CPU
     std::vector<uint8_t> getTextureData() const;
-    unsigned int getTextureId() const { return textureId_; }
+    void assembleTimeOrdered(std::vector<uint8_t>& rgba) const;
+    void snapshotRing(RingSnapshot& snapshot) const;
+    
+    // Asynchronous export. The GL backend copies through a pixel-pack buffer and a fence;
+    // other backends complete from the ring buffer. Call pollReadback once per frame on
+    // the render thread: it never blocks and returns true when the snapshot was delivered
+    // (time-ordered RGBA, to the callback and/or rgba).
+    using ReadbackCallback = std::function<void(const std::vector<uint8_t>& rgba, int width, int height)>;
+    bool requestReadback(ReadbackCallback callback = nullptr);
+    bool pollReadback(std::vector<uint8_t>* rgba = nullptr);
+    bool isReadbackPending() const { return readbackPending_; }
+    unsigned int getTextureId() const;
+    
+    // Zero-copy access to the CPU framebuffer (row-major RGBA, columns in ring order).
+    // Returns nullptr when the active backend is not CPU-addressable.
+    const uint8_t* getPixels() const;
+    int getPixelStride() const;
+    // Column holding the oldest data; sample with this horizontal offset to scroll
+    int getRingOffset() const { return currentColumn_; }
+    RenderBackendType getBackendType() const;
+    
+    // Zoomable history: every updateColumn is also appended to a level-of-detail pyramid
+    bool enableHistory(int levelCapacity, int numLevels, PoolingMode pooling = PoolingMode::MAX);
+    const MelHistoryPyramid* getHistory() const { return history_.get(); }
+    
+    /**
+     * Colorize a history range as a row-major RGBA image (oldest column at x = 0),
+     * ready for glTexImage2D. Columns no longer retained are opaque black.
+     * Returns the image width in columns, or -1 if history is disabled or arguments are invalid.
+     */
+    int renderHistory(int level, int64_t startColumn, int64_t endColumn, int maxColumns,
+                      std::vector<uint8_t>& rgba) const;
     
     // Status
     bool isInitialized() const { return initialized_; }
@@ -48,22 +114,22 @@ public:
     int getCurrentColumn() const { return currentColumn_; }
 
 private:
-    // OpenGL setup
-    bool setupOpenGL();
-    void cleanupOpenGL();
-    
     // Color mapping
-    void applyColorMap(float value, uint8_t* r, uint8_t* g, uint8_t* b);
     void createColorMaps();
     std::tuple<uint8_t, uint8_t, uint8_t> interpolateColor(float value, 
         const std::vector<std::tuple<float, uint8_t, uint8_t, uint8_t>>& colorMap);
     
-    // Texture management
-    bool createTexture();
-    void updateTextureSubImage();
+    bool attachBackend(std::unique_ptr<RenderBackend> backend);
+    
+    // Column intake shared by all input formats; the ring slot's colors are already set
+    void storeColumn(const float* melData);
+    void finishUpdate(std::chrono::high_resolution_clock::time_point startTime);
+    void updateByteColors();
     
     // Ring buffer management
     void advanceColumn();
+    void rotateToTimeOrder(const std::vector<uint8_t>& ringOrder, int ringOffset,
+                           std::vector<uint8_t>& rgba) const;
     
     // Member variables
     int width_;
@@ -71,24 +137,47 @@ private:
     int numMelBands_;
     bool initialized_;
     
-    // OpenGL resources
-    unsigned int textureId_;
-    std::vector<uint8_t> textureData_;
+    // Rendering backend
+    RenderBackendType backendType_;
+    std::unique_ptr<RenderBackend> backend_;
     
     // Color mapping
     ColorMapType currentColorMap_;
     std::vector<std::vector<std::tuple<float, uint8_t, uint8_t, uint8_t>>> colorMaps_;
+    std::vector<std::vector<uint32_t>> colorLuts_;  // Packed RGBA, one per ColorMapType
+    std::vector<uint32_t> byteColors_;              // Color of each uint8 input for the current map and range
+    bool byteColorsDirty_;
     float minValue_;
     float maxValue_;
     
-    // Ring buffer for waterfall effect
+    // Ring buffer for waterfall effect (packed RGBA, one column of numMelBands_ per slot)
     int currentColumn_;
-    std::vector<uint8_t> ringBuffer_;
+    std::vector<uint32_t> ringBuffer_;
+    std::vector<float> melRing_;  // Input values behind ringBuffer_, for data export
+    
+    // Column scratch (height_ pixels, top row first) and the mel band shown on each row
+    std::vector<uint32_t> columnPixels_;
+    std::vector<int> rowBand_;
+    std::vector<float> columnValues_;  // Dequantized input column
+    
+    // Staging image in ring order for batched uploads; pending columns start at pendingStart_
+    std::vector<uint32_t> stagingPixels_;
+    int pendingStart_;
+    int pendingColumns_;
+    int64_t uploadCount_;
+    
+    // Readback state
+    bool readbackPending_;
+    bool readbackOnGpu_;
+    int readbackOffset_;
+    ReadbackCallback readbackCallback_;
+    std::vector<uint8_t> readbackPixels_;
+    
+    // Level-of-detail history (optional)
+    std::unique_ptr<MelHistoryPyramid> history_;
     
     // Performance metrics
     mutable float lastUpdateTimeMs_;
-    bool mockMode_;  // For testing without OpenGL context
-    std::vector<uint8_t> mockTextureData_;  // For testing
     
     // Color map data
     static const std::vector<std::tuple<float, uint8_t, uint8_t, uint8_t>> viridisColors_;
@@ -0,0 +1,69 @@
+#include "activity_gate.h"
+#include <algorithm>
+#include <cmath>
+
+namespace melspectrogram {
+
+FrameActivity measureActivity(const int16_t* input, int frameSize) {
+    FrameActivity activity;
+    if (frameSize < 2) {
+        return activity;
+    }
+
+    // Exact in 64 bits for any frame up to 2^33 samples; the compiler vectorizes the loop
+    int64_t sum = 0;
+    int64_t sumSquares = 0;
+    int64_t sumLag = 0;
+    int32_t previous = input[0];
+    sum += previous;
+    sumSquares += previous * previous;
+    for (int i = 1; i < frameSize; ++i) {
+        const int32_t sample = input[i];
+        sum += sample;
+        sumSquares += sample * sample;
+        sumLag += static_cast<int64_t>(sample) * previous;
+        previous = sample;
+    }
+
+    const double count = static_cast<double>(frameSize);
+    const double mean = static_cast<double>(sum) / count;
+    const double variance = static_cast<double>(sumSquares) / count - mean * mean;
+    if (variance <= 1e-9) {
+        return activity;
+    }
+
+    activity.levelDb = static_cast<float>(10.0 * std::log10(variance / (32768.0 * 32768.0)));
+    const double covariance = static_cast<double>(sumLag) / (count - 1.0) - mean * mean;
+    const double correlation = std::max(-1.0, std::min(1.0, covariance / variance));
+    activity.flatness = static_cast<float>(1.0 - correlation * correlation);
+    return activity;
+}
+
+void ActivityGate::setConfig(const ActivityGateConfig& config) {
+    config_ = config;
+    reset();
+}
+
+bool ActivityGate::update(const FrameActivity& activity) {
+    if (!config_.enabled) {
+        return true;
+    }
+
+    const bool noiseLike = activity.flatness > config_.maxFlatness;
+    const float threshold = open_ ? config_.thresholdDb - config_.hysteresisDb : config_.thresholdDb;
+    if (activity.levelDb >= threshold && !noiseLike) {
+        open_ = true;
+        quietFrames_ = 0;
+    } else if (open_ && ++quietFrames_ > config_.hangoverFrames) {
+        open_ = false;
+        quietFrames_ = 0;
+    }
+    return open_;
+}
+
+void ActivityGate::reset() {
+    open_ = false;
+    quietFrames_ = 0;
+}
+
+} // namespace melspectrogram
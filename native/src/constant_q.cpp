@@ -0,0 +1,339 @@
+#include "constant_q.h"
+#include "mel_plan.h"
+#include "plan_cache.h"
+#include "kiss_fft.h"
+#include <algorithm>
+#include <cmath>
+#include <tuple>
+
+namespace melspectrogram {
+
+namespace {
+    constexpr double PI = 3.14159265358979323846;
+    constexpr double KAISER_BETA = 8.0;           // About 80 dB of stopband attenuation
+    constexpr double STOPBAND_DB = 80.0;
+
+    using PlanKey = std::tuple<int, float, int, int, float>;
+
+    // The kernel and decimator do not depend on hopSize, so streams that differ in it share a plan
+    PlanKey keyFor(const CqtConfig& config) {
+        return PlanKey(config.sampleRate, config.minFreq,
+                       config.binsPerOctave, config.numOctaves, config.sparsity);
+    }
+
+    double topOctaveFreq(const CqtConfig& config) {
+        return config.minFreq * std::pow(2.0, config.numOctaves - 1);
+    }
+
+    // Zeroth-order modified Bessel function of the first kind, by its power series
+    double besselI0(double x) {
+        double sum = 1.0;
+        double term = 1.0;
+        const double quarterSquare = x * x / 4.0;
+        for (int k = 1; k < 50 && term > sum * 1e-12; ++k) {
+            term *= quarterSquare / (static_cast<double>(k) * k);
+            sum += term;
+        }
+        return sum;
+    }
+
+    // Four partial sums so the loop pipelines without reassociating float adds
+    inline float dot(const float* a, const float* b, int count) {
+        float s0 = 0.0f, s1 = 0.0f, s2 = 0.0f, s3 = 0.0f;
+        int i = 0;
+        for (; i + 4 <= count; i += 4) {
+            s0 += a[i] * b[i];
+            s1 += a[i + 1] * b[i + 1];
+            s2 += a[i + 2] * b[i + 2];
+            s3 += a[i + 3] * b[i + 3];
+        }
+        for (; i < count; ++i) {
+            s0 += a[i] * b[i];
+        }
+        return (s0 + s1) + (s2 + s3);
+    }
+}
+
+CqtPlan::CqtPlan(const CqtConfig& config) : config_(config) {
+    q_ = static_cast<float>(1.0 / (std::pow(2.0, 1.0 / config_.binsPerOctave) - 1.0));
+    // The longest atom of the top octave is its lowest bin's
+    const double longest = q_ * config_.sampleRate / topOctaveFreq(config_);
+    fftSize_ = 2;
+    while (fftSize_ < longest + 1.0) {
+        fftSize_ *= 2;
+    }
+    kissFFTConfig_ = kiss_fft_alloc(fftSize_, 0, nullptr, nullptr);
+    createKernel();
+    createDecimator();
+}
+
+CqtPlan::~CqtPlan() {
+    if (kissFFTConfig_) {
+        kiss_fft_free(kissFFTConfig_);
+    }
+}
+
+bool CqtPlan::validate(const CqtConfig& config) {
+    if (config.sampleRate <= 0 || config.hopSize <= 0 || config.minFreq <= 0.0f ||
+        config.binsPerOctave < 1 || config.numOctaves < 1 || config.numOctaves > 12 ||
+        config.sparsity < 0.0f || config.sparsity >= 1.0f) {
+        return false;
+    }
+    // The top octave's upper edge must stay in the decimators' passband
+    return 4.0 * topOctaveFreq(config) <= config.sampleRate &&
+           config.hopSize % (1 << (config.numOctaves - 1)) == 0;
+}
+
+std::shared_ptr<const CqtPlan> CqtPlan::acquire(const CqtConfig& config) {
+    if (!validate(config)) {
+        return nullptr;
+    }
+    return acquireCachedPlan<CqtPlan>(keyFor(config), config);
+}
+
+float CqtPlan::getBinFrequency(int bin) const {
+    return static_cast<float>(config_.minFreq * std::pow(2.0, static_cast<double>(bin) / config_.binsPerOctave));
+}
+
+void CqtPlan::fft(const std::complex<float>* input, std::complex<float>* output) const {
+    // Out-of-place kiss_fft only reads the plan, so concurrent calls are safe
+    kiss_fft(reinterpret_cast<kiss_fft_cfg>(kissFFTConfig_),
+             reinterpret_cast<const kiss_fft_cpx*>(input),
+             reinterpret_cast<kiss_fft_cpx*>(output));
+}
+
+void CqtPlan::applyKernel(const std::complex<float>* spectrum, float* power) const {
+    for (int k = 0; k < config_.binsPerOctave; ++k) {
+        // Bins outside [start, end) were below the sparsity threshold
+        const std::complex<float>* weights = getKernel(k);
+        const int start = kernelStart_[k];
+        float real = 0.0f;
+        float imag = 0.0f;
+        for (int bin = start; bin < kernelEnd_[k]; ++bin) {
+            const std::complex<float> x = spectrum[bin];
+            const std::complex<float> w = weights[bin - start];
+            real += x.real() * w.real() - x.imag() * w.imag();
+            imag += x.real() * w.imag() + x.imag() * w.real();
+        }
+        power[k] = real * real + imag * imag;
+    }
+}
+
+void CqtPlan::createKernel() {
+    const int n = fftSize_;
+    const int bins = config_.binsPerOctave;
+    const double fTop = topOctaveFreq(config_);
+    std::vector<std::complex<float>> atom(n);
+    std::vector<std::complex<float>> spectrum(n);
+    kernelStart_.resize(bins);
+    kernelEnd_.resize(bins);
+    kernelOffset_.resize(bins);
+    kernel_.clear();
+
+    for (int k = 0; k < bins; ++k) {
+        // Hann-windowed exponential of Q cycles, centred in the frame, unit mean window weight / length
+        const double frequency = fTop * std::pow(2.0, static_cast<double>(k) / bins);
+        const double length = q_ * config_.sampleRate / frequency;
+        for (int i = 0; i < n; ++i) {
+            const double t = i - n / 2;
+            if (std::abs(t) > length / 2.0) {
+                atom[i] = 0.0f;
+                continue;
+            }
+            const double window = 0.5 * (1.0 + std::cos(2.0 * PI * t / length)) / length;
+            const double phase = 2.0 * PI * frequency * t / config_.sampleRate;
+            atom[i] = std::complex<float>(static_cast<float>(window * std::cos(phase)),
+                                          static_cast<float>(window * std::sin(phase)));
+        }
+        fft(atom.data(), spectrum.data());
+
+        float peak = 0.0f;
+        for (const auto& value : spectrum) {
+            peak = std::max(peak, std::abs(value));
+        }
+        const float threshold = config_.sparsity * peak;
+        int start = 0;
+        int end = n;
+        while (start < n && std::abs(spectrum[start]) < threshold) {
+            ++start;
+        }
+        while (end > start && std::abs(spectrum[end - 1]) < threshold) {
+            --end;
+        }
+
+        // sum_n x[n] conj(a[n]) = (1 / N) sum_j X[j] conj(A[j])
+        kernelStart_[k] = start;
+        kernelEnd_[k] = end;
+        kernelOffset_[k] = kernel_.size();
+        for (int j = start; j < end; ++j) {
+            kernel_.push_back(std::conj(spectrum[j]) / static_cast<float>(n));
+        }
+    }
+}
+
+void CqtPlan::createDecimator() {
+    // Cutoff at half the output Nyquist. Content in the transition band aliases above the
+    // top octave's upper edge (2 fTop, fTop / sampleRate at the decimator's input rate)
+    const double passEdge = topOctaveFreq(config_) / config_.sampleRate;
+    const double transition = std::max(0.02, 2.0 * (0.25 - passEdge));
+    int taps = static_cast<int>(std::ceil((STOPBAND_DB - 8.0) / (2.285 * 2.0 * PI * transition))) + 1;
+    taps |= 1;
+
+    const double centre = (taps - 1) / 2.0;
+    const double norm = besselI0(KAISER_BETA);
+    decimatorTaps_.resize(taps);
+    double sum = 0.0;
+    std::vector<double> prototype(taps);
+    for (int i = 0; i < taps; ++i) {
+        const double x = 0.5 * (i - centre);  // 2 * cutoff * t with a cutoff of 0.25
+        const double sinc = std::abs(x) < 1e-12 ? 1.0 : std::sin(PI * x) / (PI * x);
+        const double r = (i - centre) / (centre + 0.5);
+        prototype[i] = sinc * besselI0(KAISER_BETA * std::sqrt(std::max(0.0, 1.0 - r * r))) / norm;
+        sum += prototype[i];
+    }
+    for (int i = 0; i < taps; ++i) {
+        decimatorTaps_[i] = static_cast<float>(prototype[i] / sum);
+    }
+}
+
+ConstantQProcessor::ConstantQProcessor(const CqtConfig& config)
+    : plan_(CqtPlan::acquire(config)), hopSize_(config.hopSize) {
+    if (!plan_) {
+        return;
+    }
+    const int numOctaves = config.numOctaves;
+    const size_t fftSize = static_cast<size_t>(plan_->getFftSize());
+    const size_t delay = (plan_->getDecimatorTaps().size() - 1) / 2;
+
+    // Octave o's samples are delayed by delay * (2^o - 1) input samples through the decimators
+    // and its frame spans 2^o * fftSize of them. Lags line every frame's centre up with the
+    // lowest octave's
+    octaves_.resize(numOctaves);
+    for (int o = 0; o < numOctaves; ++o) {
+        Octave& octave = octaves_[o];
+        octave.lag = (delay + fftSize / 2) * ((size_t(1) << (numOctaves - 1 - o)) - 1);
+        const size_t hop = static_cast<size_t>(hopSize_) >> o;
+        octave.history.reserve(fftSize + octave.lag + hop);
+        octave.incoming.reserve(hop);
+        octave.decimatorInput.reserve(plan_->getDecimatorTaps().size() + hop);
+    }
+    latency_ = static_cast<int>(delay * ((size_t(1) << (numOctaves - 1)) - 1) +
+                                (fftSize / 2 << (numOctaves - 1)));
+
+    fftInput_.resize(fftSize);
+    fftOutput_.resize(fftSize);
+    power_.resize(plan_->getNumBins());
+    output_.resize(plan_->getNumBins());
+    reset();
+}
+
+ConstantQProcessor::~ConstantQProcessor() = default;
+
+long ConstantQProcessor::processAudioSamples(const int16_t* input, size_t numSamples,
+                                             float* output, size_t maxFrames, size_t* framesProduced) {
+    if (framesProduced) {
+        *framesProduced = 0;
+    }
+    if (!plan_ || (input == nullptr && numSamples > 0)) {
+        return -1;
+    }
+
+    const size_t hop = static_cast<size_t>(hopSize_);
+    const size_t bins = static_cast<size_t>(plan_->getNumBins());
+    size_t consumed = 0;
+    size_t frames = 0;
+    while (consumed < numSamples) {
+        // Columns complete on hop boundaries, so stopping here leaves a whole hop for the caller
+        if (output != nullptr && frames >= maxFrames) {
+            break;
+        }
+        const size_t piece = std::min(numSamples - consumed, hop - pendingSamples_);
+        feed(input + consumed, piece);
+        consumed += piece;
+        pendingSamples_ += piece;
+        if (pendingSamples_ == hop) {
+            pendingSamples_ = 0;
+            computeColumn();
+            if (output != nullptr) {
+                std::copy(output_.begin(), output_.end(), output + frames * bins);
+            }
+            frames++;
+        }
+    }
+
+    if (framesProduced) {
+        *framesProduced = frames;
+    }
+    return static_cast<long>(consumed);
+}
+
+void ConstantQProcessor::reset() {
+    if (!plan_) {
+        return;
+    }
+    const size_t fftSize = static_cast<size_t>(plan_->getFftSize());
+    const size_t taps = plan_->getDecimatorTaps().size();
+    for (Octave& octave : octaves_) {
+        octave.history.assign(fftSize + octave.lag, 0.0f);
+        octave.incoming.clear();
+        octave.decimatorInput.assign(taps - 1, 0.0f);
+        octave.decimatorPosition = taps - 1;
+    }
+    std::fill(power_.begin(), power_.end(), 0.0f);
+    std::fill(output_.begin(), output_.end(), 0.0f);
+    pendingSamples_ = 0;
+}
+
+void ConstantQProcessor::feed(const int16_t* input, size_t count) {
+    const std::vector<float>& taps = plan_->getDecimatorTaps();
+    const size_t numTaps = taps.size();
+
+    octaves_[0].incoming.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        octaves_[0].incoming[i] = input[i] / 32768.0f;
+    }
+
+    for (size_t o = 0; o < octaves_.size(); ++o) {
+        Octave& octave = octaves_[o];
+        const size_t keep = static_cast<size_t>(plan_->getFftSize()) + octave.lag;
+        octave.history.insert(octave.history.end(), octave.incoming.begin(), octave.incoming.end());
+        octave.history.erase(octave.history.begin(), octave.history.end() - keep);
+        if (o + 1 == octaves_.size()) {
+            break;
+        }
+
+        // Every other output of the lowpass; the window ends on the newest sample it reads
+        std::vector<float>& buffer = octave.decimatorInput;
+        std::vector<float>& next = octaves_[o + 1].incoming;
+        buffer.insert(buffer.end(), octave.incoming.begin(), octave.incoming.end());
+        next.clear();
+        size_t& position = octave.decimatorPosition;
+        while (position < buffer.size()) {
+            next.push_back(dot(taps.data(), buffer.data() + (position + 1 - numTaps), static_cast<int>(numTaps)));
+            position += 2;
+        }
+        const size_t drop = std::min(position + 1 - numTaps, buffer.size());
+        buffer.erase(buffer.begin(), buffer.begin() + drop);
+        position -= drop;
+    }
+}
+
+void ConstantQProcessor::computeColumn() {
+    const size_t fftSize = static_cast<size_t>(plan_->getFftSize());
+    const int binsPerOctave = plan_->getConfig().binsPerOctave;
+    const int numOctaves = static_cast<int>(octaves_.size());
+    for (int o = 0; o < numOctaves; ++o) {
+        const Octave& octave = octaves_[o];
+        const float* frame = octave.history.data() + (octave.history.size() - octave.lag - fftSize);
+        for (size_t i = 0; i < fftSize; ++i) {
+            fftInput_[i] = std::complex<float>(frame[i], 0.0f);
+        }
+        plan_->fft(fftInput_.data(), fftOutput_.data());
+        // Octave 0 holds the highest bins
+        plan_->applyKernel(fftOutput_.data(), power_.data() + (numOctaves - 1 - o) * binsPerOctave);
+    }
+    std::copy(power_.begin(), power_.end(), output_.begin());
+    MelPlan::logScale(output_.data(), plan_->getNumBins());
+}
+
+} // namespace melspectrogram
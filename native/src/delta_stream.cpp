@@ -0,0 +1,132 @@
+#include "delta_stream.h"
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace melspectrogram {
+
+namespace {
+    // out[i] = normalizer * sum_n n * (later[n - 1][i] - earlier[n - 1][i])
+    void regress(const float* const* later, const float* const* earlier, int window,
+                 float normalizer, float* out, int count) {
+        int i = 0;
+#if defined(__SSE2__)
+        const __m128 scale = _mm_set1_ps(normalizer);
+        for (; i + 4 <= count; i += 4) {
+            __m128 sum = _mm_setzero_ps();
+            for (int n = 0; n < window; ++n) {
+                const __m128 difference = _mm_sub_ps(_mm_loadu_ps(later[n] + i), _mm_loadu_ps(earlier[n] + i));
+                sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(static_cast<float>(n + 1)), difference));
+            }
+            _mm_storeu_ps(out + i, _mm_mul_ps(sum, scale));
+        }
+#elif defined(__ARM_NEON)
+        for (; i + 4 <= count; i += 4) {
+            float32x4_t sum = vdupq_n_f32(0.0f);
+            for (int n = 0; n < window; ++n) {
+                const float32x4_t difference = vsubq_f32(vld1q_f32(later[n] + i), vld1q_f32(earlier[n] + i));
+                sum = vmlaq_n_f32(sum, difference, static_cast<float>(n + 1));
+            }
+            vst1q_f32(out + i, vmulq_n_f32(sum, normalizer));
+        }
+#endif
+        for (; i < count; ++i) {
+            float sum = 0.0f;
+            for (int n = 0; n < window; ++n) {
+                sum += static_cast<float>(n + 1) * (later[n][i] - earlier[n][i]);
+            }
+            out[i] = sum * normalizer;
+        }
+    }
+}
+
+DeltaStream::DeltaStream(int numFeatures, int window)
+    : numFeatures_(std::max(numFeatures, 1)), window_(std::max(window, 1)) {
+    int squares = 0;
+    for (int n = 1; n <= window_; ++n) {
+        squares += n * n;
+    }
+    normalizer_ = 1.0f / (2.0f * squares);
+    ring_.assign(static_cast<size_t>(3 * window_ + 1) * getFrameSize(), 0.0f);
+    later_.resize(window_);
+    earlier_.resize(window_);
+}
+
+bool DeltaStream::push(const float* frame) {
+    pushed_++;
+    return step(frame);
+}
+
+bool DeltaStream::drain() {
+    if (emitted_ >= pushed_) {
+        return false;
+    }
+    // A stream shorter than the lookahead needs several repeats before its first frame completes
+    while (!step(nullptr)) {
+    }
+    return true;
+}
+
+void DeltaStream::reset() {
+    pushed_ = 0;
+    steps_ = 0;
+    emitted_ = 0;
+    output_ = nullptr;
+}
+
+bool DeltaStream::step(const float* frame) {
+    const int64_t s = steps_++;
+    const int features = numFeatures_;
+    float* newest = slot(s);
+    const float* source = frame ? frame : slot(s - 1);
+    std::copy(source, source + features, newest);
+    if (s == 0) {
+        // The first frame stands in for the ones before it
+        for (int n = 1; n <= window_; ++n) {
+            std::copy(newest, newest + features, slot(-n));
+        }
+    }
+
+    // Delta of the frame N back, now that its lookahead is in
+    const int64_t t = s - window_;
+    if (t < 0) {
+        return false;
+    }
+    float* delta = slot(t) + features;
+    if (t < pushed_) {
+        for (int n = 1; n <= window_; ++n) {
+            later_[n - 1] = slot(t + n);
+            earlier_[n - 1] = slot(t - n);
+        }
+        regress(later_.data(), earlier_.data(), window_, normalizer_, delta, features);
+    } else {
+        // Past the end: the last delta stands in for later ones
+        std::copy(slot(t - 1) + features, slot(t - 1) + 2 * features, delta);
+    }
+    if (t == 0) {
+        for (int n = 1; n <= window_; ++n) {
+            std::copy(delta, delta + features, slot(-n) + features);
+        }
+    }
+
+    // Delta-delta of the frame 2N back, which completes it
+    const int64_t u = s - 2 * window_;
+    if (u < 0) {
+        return false;
+    }
+    for (int n = 1; n <= window_; ++n) {
+        later_[n - 1] = slot(u + n) + features;
+        earlier_[n - 1] = slot(u - n) + features;
+    }
+    float* completed = slot(u);
+    regress(later_.data(), earlier_.data(), window_, normalizer_, completed + 2 * features, features);
+    output_ = completed;
+    emitted_ = u + 1;
+    return true;
+}
+
+} // namespace melspectrogram
@@ -0,0 +1,225 @@
+#include "feature_graph.h"
+#include "mel_plan.h"
+#include <algorithm>
+#include <cmath>
+
+namespace melspectrogram {
+
+FeatureGraph::FeatureGraph(const AudioConfig& config)
+    : plan_(MelPlan::acquire(config)) {
+    allocateBuffers();
+}
+
+FeatureGraph::~FeatureGraph() = default;
+
+int FeatureGraph::addExtractor(std::unique_ptr<FeatureExtractor> extractor) {
+    extractor->prepare(*plan_);
+    const FeatureNode input = extractor->getInput();
+    if (deepest_ == FeatureNode::COUNT || static_cast<int>(input) > static_cast<int>(deepest_)) {
+        deepest_ = input;
+    }
+    outputOffsets_.push_back(totalOutputSize_);
+    totalOutputSize_ += static_cast<size_t>(std::max(extractor->getSize(), 0));
+    extractors_.push_back(std::move(extractor));
+    allocateBuffers();
+    return static_cast<int>(extractors_.size()) - 1;
+}
+
+bool FeatureGraph::processFrame(const int16_t* input, size_t inputSize) {
+    if (input == nullptr || inputSize != static_cast<size_t>(plan_->getConfig().frameSize) ||
+        extractors_.empty()) {
+        return false;
+    }
+
+    // Each needed stage once, in order, on the previous one's buffer
+    for (int node = 0; node <= static_cast<int>(deepest_); ++node) {
+        evaluate(static_cast<FeatureNode>(node), input);
+        evaluations_[node]++;
+    }
+
+    for (size_t i = 0; i < extractors_.size(); ++i) {
+        extractors_[i]->compute(frame_, outputs_ + outputOffsets_[i]);
+    }
+    return true;
+}
+
+void FeatureGraph::evaluate(FeatureNode node, const int16_t* input) {
+    const int bands = plan_->getConfig().numMelBands;
+    switch (node) {
+        case FeatureNode::WINDOWED_FRAME:
+            plan_->windowFrame(input, windowed_);
+            break;
+        case FeatureNode::SPECTRUM:
+            plan_->fft(windowed_, spectrum_);
+            break;
+        case FeatureNode::POWER_SPECTRUM:
+            plan_->powerSpectrum(spectrum_, power_);
+            break;
+        case FeatureNode::MEL_ENERGIES:
+            plan_->applyFilterBank(power_, melEnergies_);
+            break;
+        case FeatureNode::LOG_MEL:
+            // On a copy, so extractors still see the linear energies
+            std::copy(melEnergies_, melEnergies_ + bands, logMel_);
+            MelPlan::logScale(logMel_, bands, MelOutputFormat::FLOAT32, nullptr, decibels_);
+            break;
+        default:
+            break;
+    }
+}
+
+void FeatureGraph::reset() {
+    for (auto& extractor : extractors_) {
+        extractor->reset();
+    }
+}
+
+void FeatureGraph::allocateBuffers() {
+    const size_t frameSize = static_cast<size_t>(plan_->getConfig().frameSize);
+    const size_t bins = static_cast<size_t>(plan_->getNumBins());
+    const size_t bands = static_cast<size_t>(plan_->getConfig().numMelBands);
+
+    // Only the nodes some extractor needs, in processing order
+    arena_.clear();
+    const size_t windowed = arena_.reserve<std::complex<float>>(needs(FeatureNode::WINDOWED_FRAME) ? frameSize : 0);
+    const size_t spectrum = arena_.reserve<std::complex<float>>(needs(FeatureNode::SPECTRUM) ? frameSize : 0);
+    const size_t power = arena_.reserve<float>(needs(FeatureNode::POWER_SPECTRUM) ? bins : 0);
+    const size_t mel = arena_.reserve<float>(needs(FeatureNode::MEL_ENERGIES) ? bands : 0);
+    const size_t decibels = arena_.reserve<float>(needs(FeatureNode::LOG_MEL) ? bands : 0);
+    const size_t logMel = arena_.reserve<float>(needs(FeatureNode::LOG_MEL) ? bands : 0);
+    const size_t outputs = arena_.reserve<float>(totalOutputSize_);
+    arena_.allocate();
+
+    windowed_ = needs(FeatureNode::WINDOWED_FRAME) ? arena_.at<std::complex<float>>(windowed) : nullptr;
+    spectrum_ = needs(FeatureNode::SPECTRUM) ? arena_.at<std::complex<float>>(spectrum) : nullptr;
+    power_ = needs(FeatureNode::POWER_SPECTRUM) ? arena_.at<float>(power) : nullptr;
+    melEnergies_ = needs(FeatureNode::MEL_ENERGIES) ? arena_.at<float>(mel) : nullptr;
+    decibels_ = needs(FeatureNode::LOG_MEL) ? arena_.at<float>(decibels) : nullptr;
+    logMel_ = needs(FeatureNode::LOG_MEL) ? arena_.at<float>(logMel) : nullptr;
+    outputs_ = arena_.at<float>(outputs);
+
+    frame_.plan = plan_.get();
+    frame_.windowed = windowed_;
+    frame_.spectrum = spectrum_;
+    frame_.power = power_;
+    frame_.melEnergies = melEnergies_;
+    frame_.decibels = decibels_;
+    frame_.logMel = logMel_;
+}
+
+void MelExtractor::prepare(const MelPlan& plan) {
+    numBands_ = plan.getConfig().numMelBands;
+}
+
+void MelExtractor::compute(const FeatureFrame& frame, float* output) {
+    std::copy(frame.logMel, frame.logMel + numBands_, output);
+}
+
+void MfccExtractor::prepare(const MelPlan& plan) {
+    mfcc_.reset(new MfccPlan(plan.getConfig().numMelBands, config_));
+}
+
+void MfccExtractor::compute(const FeatureFrame& frame, float* output) {
+    mfcc_->compute(frame.decibels, output);
+}
+
+void SpectralCentroidExtractor::prepare(const MelPlan& plan) {
+    const AudioConfig& config = plan.getConfig();
+    binFrequencies_.resize(plan.getNumBins());
+    for (size_t k = 0; k < binFrequencies_.size(); ++k) {
+        binFrequencies_[k] = static_cast<float>(k) * config.sampleRate / config.frameSize;
+    }
+}
+
+void SpectralCentroidExtractor::compute(const FeatureFrame& frame, float* output) {
+    float weighted = 0.0f;
+    float total = 0.0f;
+    for (size_t k = 0; k < binFrequencies_.size(); ++k) {
+        weighted += binFrequencies_[k] * frame.power[k];
+        total += frame.power[k];
+    }
+    output[0] = total > 0.0f ? weighted / total : 0.0f;
+}
+
+void SpectralFluxExtractor::prepare(const MelPlan& plan) {
+    previous_.assign(plan.getNumBins(), 0.0f);
+    hasPrevious_ = false;
+}
+
+void SpectralFluxExtractor::compute(const FeatureFrame& frame, float* output) {
+    float sum = 0.0f;
+    for (size_t k = 0; k < previous_.size(); ++k) {
+        const float magnitude = std::sqrt(frame.power[k]);
+        const float rise = std::max(magnitude - previous_[k], 0.0f);
+        sum += rise * rise;
+        previous_[k] = magnitude;
+    }
+    output[0] = hasPrevious_ ? std::sqrt(sum) : 0.0f;
+    hasPrevious_ = true;
+}
+
+std::vector<float> BandEnergyExtractor::octaveEdges(float lowHz, float highHz) {
+    std::vector<float> edges;
+    for (float edge = std::max(lowHz, 1.0f); edge < highHz; edge *= 2.0f) {
+        edges.push_back(edge);
+    }
+    edges.push_back(highHz);
+    return edges;
+}
+
+void BandEnergyExtractor::prepare(const MelPlan& plan) {
+    const AudioConfig& config = plan.getConfig();
+    const int bins = plan.getNumBins();
+    if (edges_.size() < 2) {
+        edges_.assign({0.0f, config.sampleRate / 2.0f});
+    }
+    binEdges_.resize(edges_.size());
+    for (size_t i = 0; i < edges_.size(); ++i) {
+        const int bin = static_cast<int>(std::ceil(edges_[i] * config.frameSize / config.sampleRate));
+        binEdges_[i] = std::max(0, std::min(bin, bins));
+    }
+    // The top edge includes the bin at exactly that frequency (e.g. Nyquist)
+    const int top = static_cast<int>(std::floor(edges_.back() * config.frameSize / config.sampleRate)) + 1;
+    binEdges_.back() = std::max(binEdges_.back(), std::min(top, bins));
+}
+
+void BandEnergyExtractor::compute(const FeatureFrame& frame, float* output) {
+    for (size_t band = 0; band + 1 < binEdges_.size(); ++band) {
+        float energy = 0.0f;
+        for (int k = binEdges_[band]; k < binEdges_[band + 1]; ++k) {
+            energy += frame.power[k];
+        }
+        output[band] = 10.0f * std::log10(std::max(energy, 1e-10f));
+    }
+}
+
+void ChromaExtractor::prepare(const MelPlan& plan) {
+    const AudioConfig& config = plan.getConfig();
+    binClasses_.assign(plan.getNumBins(), -1);
+    for (size_t k = 1; k < binClasses_.size(); ++k) {
+        const float frequency = static_cast<float>(k) * config.sampleRate / config.frameSize;
+        if (frequency < config.minFreq || frequency > config.maxFreq) {
+            continue;
+        }
+        // Semitones from A4, shifted so C is class 0
+        const int semitone = static_cast<int>(std::lround(12.0 * std::log2(frequency / 440.0))) + 9;
+        binClasses_[k] = ((semitone % 12) + 12) % 12;
+    }
+}
+
+void ChromaExtractor::compute(const FeatureFrame& frame, float* output) {
+    std::fill(output, output + 12, 0.0f);
+    for (size_t k = 0; k < binClasses_.size(); ++k) {
+        if (binClasses_[k] >= 0) {
+            output[binClasses_[k]] += frame.power[k];
+        }
+    }
+    const float peak = *std::max_element(output, output + 12);
+    if (peak > 0.0f) {
+        for (int i = 0; i < 12; ++i) {
+            output[i] /= peak;
+        }
+    }
+}
+
+} // namespace melspectrogram
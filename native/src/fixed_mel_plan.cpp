@@ -0,0 +1,224 @@
+#include "fixed_mel_plan.h"
+#include "mel_plan.h"
+#include "plan_cache.h"
+#include <cmath>
+#include <algorithm>
+#include <tuple>
+
+namespace melspectrogram {
+
+namespace {
+    using PlanKey = std::tuple<int, int, int, float, float>;
+
+    // As for MelPlan, hopSize is not part of the tables
+    PlanKey keyFor(const AudioConfig& config) {
+        return PlanKey(config.sampleRate, config.frameSize, config.numMelBands, config.minFreq, config.maxFreq);
+    }
+
+    // Windowed samples are block-scaled to a peak below 2^FFT_HEADROOM_BITS
+    constexpr int FFT_HEADROOM_BITS = 30;
+    // Mel sums are x * 2^-15 (filter) * 2^-60 (squared Q30 input), times N for the 1/N power scale
+    constexpr int MEL_SCALE_BITS = 75;
+
+    constexpr int LOG_TABLE_BITS = 8;
+    constexpr int32_t DB_PER_LOG2_Q16 = 197283;         // 10 * log10(2) in Q16
+    constexpr int32_t MIN_DB_Q16 = -100 * 65536;         // MelPlan's 1e-10 floor
+
+    // Position of the highest set bit plus one; 0 for 0
+    int bitLength(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+        return value == 0 ? 0 : 64 - __builtin_clzll(value);
+#else
+        int bits = 0;
+        while (value != 0) {
+            value >>= 1;
+            ++bits;
+        }
+        return bits;
+#endif
+    }
+
+    // log2(1 + i / 256) in Q16 for i = 0..256
+    struct Log2Table {
+        int32_t values[(1 << LOG_TABLE_BITS) + 1];
+
+        Log2Table() {
+            for (int i = 0; i <= (1 << LOG_TABLE_BITS); ++i) {
+                const double x = 1.0 + static_cast<double>(i) / (1 << LOG_TABLE_BITS);
+                values[i] = static_cast<int32_t>(std::lround(std::log2(x) * 65536.0));
+            }
+        }
+    };
+
+    const Log2Table& log2Table() {
+        static const Log2Table table;
+        return table;
+    }
+}
+
+void FixedMelScratch::resize(const FixedMelPlan& plan) {
+    const size_t frameSize = static_cast<size_t>(plan.getConfig().frameSize);
+    if (fftInput.size() != frameSize) {
+        fftInput.resize(frameSize);
+        fftOutput.resize(frameSize);
+        power.resize(plan.getNumBins());
+    }
+    mel.resize(plan.getConfig().numMelBands);
+}
+
+size_t FixedMelScratch::getBytes() const {
+    return (fftInput.size() + fftOutput.size()) * sizeof(kiss_fft_fixed_cpx) +
+           power.size() * sizeof(uint32_t) + mel.size() * sizeof(uint64_t);
+}
+
+FixedMelPlan::FixedMelPlan(const AudioConfig& config) : config_(config) {
+    kissFFTConfig_ = kiss_fft_fixed_alloc(config_.frameSize, 0, nullptr, nullptr);
+
+    // Quantize the float plan's tables rather than deriving them a second time
+    std::shared_ptr<const MelPlan> source = MelPlan::acquire(config_);
+    const std::vector<float>& window = source->getWindow();
+    window_.resize(window.size());
+    for (size_t i = 0; i < window.size(); ++i) {
+        window_[i] = static_cast<int16_t>(std::min(std::lround(window[i] * 32768.0f), 32767L));
+    }
+
+    const int bins = getNumBins();
+    filters_.assign(static_cast<size_t>(config_.numMelBands) * bins, 0);
+    filterStart_.resize(config_.numMelBands);
+    filterEnd_.resize(config_.numMelBands);
+    for (int band = 0; band < config_.numMelBands; ++band) {
+        const float* filter = source->getFilter(band);
+        uint16_t* row = filters_.data() + static_cast<size_t>(band) * bins;
+        filterStart_[band] = source->getFilterStart(band);
+        filterEnd_[band] = source->getFilterEnd(band);
+        for (int bin = filterStart_[band]; bin < filterEnd_[band]; ++bin) {
+            row[bin] = static_cast<uint16_t>(std::lround(filter[bin] * 32768.0f));
+        }
+    }
+
+    log2OffsetQ16_ = static_cast<int32_t>(std::lround(
+        (std::log2(static_cast<double>(config_.frameSize)) - MEL_SCALE_BITS) * 65536.0));
+}
+
+FixedMelPlan::~FixedMelPlan() {
+    if (kissFFTConfig_) {
+        kiss_fft_fixed_free(kissFFTConfig_);
+    }
+}
+
+std::shared_ptr<const FixedMelPlan> FixedMelPlan::acquire(const AudioConfig& config) {
+    return acquireCachedPlan<FixedMelPlan>(keyFor(config), config);
+}
+
+int FixedMelPlan::windowFrame(const int16_t* input, kiss_fft_fixed_cpx* fftInput) const {
+    // int16 * Q15 fits in 31 bits, so the products need no scaling yet
+    uint32_t peak = 0;
+    for (int i = 0; i < config_.frameSize; ++i) {
+        const int32_t value = static_cast<int32_t>(input[i]) * window_[i];
+        fftInput[i].r = value;
+        fftInput[i].i = 0;
+        const uint32_t magnitude = static_cast<uint32_t>(value < 0 ? -value : value);
+        peak = std::max(peak, magnitude);
+    }
+    if (peak == 0) {
+        return 0;
+    }
+
+    // Use the FFT's full headroom: quiet frames keep their resolution through the per-stage 1/radix scaling
+    const int shift = FFT_HEADROOM_BITS - bitLength(peak);
+    if (shift > 0) {
+        for (int i = 0; i < config_.frameSize; ++i) {
+            fftInput[i].r = static_cast<int32_t>(static_cast<uint32_t>(fftInput[i].r) << shift);
+        }
+    } else if (shift < 0) {
+        for (int i = 0; i < config_.frameSize; ++i) {
+            fftInput[i].r >>= -shift;
+        }
+    }
+    return shift;
+}
+
+void FixedMelPlan::fft(const kiss_fft_fixed_cpx* input, kiss_fft_fixed_cpx* output) const {
+    kiss_fft_fixed(kissFFTConfig_, input, output);
+}
+
+int FixedMelPlan::powerSpectrum(const kiss_fft_fixed_cpx* fftOutput, uint32_t* power) const {
+    const int bins = getNumBins();
+    uint64_t peak = 0;
+    for (int i = 0; i < bins; ++i) {
+        const int64_t real = fftOutput[i].r;
+        const int64_t imag = fftOutput[i].i;
+        peak = std::max(peak, static_cast<uint64_t>(real * real + imag * imag));
+    }
+
+    // Keep the loudest bin's top 32 bits; the shift goes back into the log exponent
+    const int shift = std::max(bitLength(peak) - 32, 0);
+    for (int i = 0; i < bins; ++i) {
+        const int64_t real = fftOutput[i].r;
+        const int64_t imag = fftOutput[i].i;
+        power[i] = static_cast<uint32_t>(static_cast<uint64_t>(real * real + imag * imag) >> shift);
+    }
+    return shift;
+}
+
+void FixedMelPlan::applyFilterBank(const uint32_t* power, uint64_t* mel) const {
+    const int bins = getNumBins();
+    for (int band = 0; band < config_.numMelBands; ++band) {
+        // 32 x 16-bit products; a full-scale row of 513 bins still fits in 58 bits
+        const uint16_t* filter = filters_.data() + static_cast<size_t>(band) * bins;
+        uint64_t sum = 0;
+        for (int bin = filterStart_[band]; bin < filterEnd_[band]; ++bin) {
+            sum += static_cast<uint64_t>(power[bin]) * filter[bin];
+        }
+        mel[band] = sum;
+    }
+}
+
+int32_t FixedMelPlan::log2Q16(uint64_t value) {
+    // value = 2^exponent * (1 + fraction), with the fraction's top 24 bits split into index and remainder
+    const int exponent = bitLength(value) - 1;
+    const uint64_t mantissa = exponent >= 24 ? value >> (exponent - 24) : value << (24 - exponent);
+    const uint32_t fraction = static_cast<uint32_t>(mantissa) & 0xffffffu;
+    const uint32_t index = fraction >> 16;
+    const int32_t remainder = static_cast<int32_t>(fraction & 0xffffu);
+
+    const int32_t* table = log2Table().values;
+    const int32_t interpolated = table[index] +
+        static_cast<int32_t>((static_cast<int64_t>(table[index + 1] - table[index]) * remainder) >> 16);
+    return exponent * 65536 + interpolated;
+}
+
+void FixedMelPlan::logScale(const uint64_t* mel, int exponent, float* out,
+                            MelOutputFormat format, void* quantized, float* decibels) const {
+    const int32_t offset = log2OffsetQ16_ + exponent * 65536;
+    int32_t minDb = INT32_MAX;
+    int32_t maxDb = INT32_MIN;
+    for (int i = 0; i < config_.numMelBands; ++i) {
+        int32_t db = MIN_DB_Q16;
+        if (mel[i] != 0) {
+            const int64_t log2Value = static_cast<int64_t>(log2Q16(mel[i])) + offset;
+            db = static_cast<int32_t>(std::max<int64_t>((log2Value * DB_PER_LOG2_Q16) >> 16, MIN_DB_Q16));
+        }
+        minDb = std::min(minDb, db);
+        maxDb = std::max(maxDb, db);
+        out[i] = db * (1.0f / 65536.0f);
+    }
+    if (decibels != nullptr) {
+        std::copy(out, out + config_.numMelBands, decibels);
+    }
+
+    normalizeAndQuantize(out, static_cast<size_t>(config_.numMelBands), minDb * (1.0f / 65536.0f),
+                         (maxDb - minDb) * (1.0f / 65536.0f), format, quantized);
+}
+
+void FixedMelPlan::computeFrame(const int16_t* input, float* mel, Scratch& scratch,
+                                MelOutputFormat format, void* quantized, float* decibels) const {
+    scratch.resize(*this);
+    const int blockShift = windowFrame(input, scratch.fftInput.data());
+    fft(scratch.fftInput.data(), scratch.fftOutput.data());
+    const int powerShift = powerSpectrum(scratch.fftOutput.data(), scratch.power.data());
+    applyFilterBank(scratch.power.data(), scratch.mel.data());
+    logScale(scratch.mel.data(), powerShift - 2 * blockShift, mel, format, quantized, decibels);
+}
+
+} // namespace melspectrogram
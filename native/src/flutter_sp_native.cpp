@@ -1,246 +1,1447 @@
+#include "flutter_sp_native.h"
 #include "audio_input.h"
 #include "mel_spectrogram.h"
 #include "texture_renderer.h"
+#include "spectrogram_exporter.h"
+#include "mel_frame_ring.h"
+#include "pipeline_runner.h"
+#include "feature_graph.h"
+#include "constant_q.h"
+#include "resampler.h"
 #include <memory>
 #include <cstring>
 #include <cstdlib>
 #include <vector>
 #include <mutex>
 
-// Global instances
-static std::unique_ptr<audio::AudioInput> g_audioInput;
-static std::unique_ptr<melspectrogram::MelSpectrogramProcessor> g_melProcessor;
-static std::unique_ptr<melspectrogram::TextureRenderer> g_textureRenderer;
+// Everything one pipeline owns. Sessions share no mutable state, so calls on
+// different handles never contend; the mutex only orders calls on one handle.
+struct FspSession {
+    std::unique_ptr<audio::AudioInput> audioInput;
+    // Declared before the processor, which publishes into it, so it outlives it
+    std::unique_ptr<melspectrogram::MelFrameRing> melRing;
+    std::unique_ptr<melspectrogram::MelSpectrogramProcessor> melProcessor;
+    melspectrogram::AudioConfig melConfig;
+    melspectrogram::MelOutputFormat melOutputFormat = melspectrogram::MelOutputFormat::FLOAT32;
+    melspectrogram::FrontEndConfig frontEnd;
+    melspectrogram::ActivityGateConfig activityGate;
+    melspectrogram::QualityControllerConfig quality;
+    melspectrogram::MfccConfig mfcc;
+    melspectrogram::DeltaConfig deltas;
+    int pipelineInputRate = 0;  // Rate of pushed pipeline audio; 0 = the mel config's rate
+    std::unique_ptr<melspectrogram::TextureRenderer> textureRenderer;
+    std::unique_ptr<melspectrogram::FeatureGraph> featureGraph;
+    std::unique_ptr<melspectrogram::ConstantQProcessor> cqt;
+    std::unique_ptr<melspectrogram::SpectrogramExporter> exporter;
+    // Declared last: it drives the audio input and processor, so it goes first
+    std::unique_ptr<melspectrogram::PipelineRunner> pipeline;
+    std::mutex mutex;
+};
 
-// Error handling
-static char g_lastError[256] = {0};
-static std::mutex g_mutex;
+namespace {
+    // Error handling: one buffer per calling thread, read back on the same thread
+    thread_local char t_lastError[256] = {0};
+
+    void setError(const char* message) {
+        strncpy(t_lastError, message, sizeof(t_lastError) - 1);
+        t_lastError[sizeof(t_lastError) - 1] = '\0';
+    }
+
+    // Backs the original single-pipeline functions
+    FspSession* defaultSession() {
+        static FspSession session;
+        return &session;
+    }
+
+    bool checkSession(FspSession* session) {
+        if (!session) {
+            setError("Invalid session handle");
+            return false;
+        }
+        return true;
+    }
+
+    // Call with the session mutex held. The DSP thread owns the processor while running.
+    bool checkPipelineIdle(FspSession* session) {
+        if (session->pipeline && session->pipeline->isRunning()) {
+            setError("Not allowed while the pipeline is running");
+            return false;
+        }
+        return true;
+    }
+
+    // Call with the session mutex held
+    bool checkRenderer(FspSession* session) {
+        if (!session->textureRenderer) {
+            setError("Texture renderer not initialized");
+            return false;
+        }
+        return true;
+    }
+
+    void resetSession(FspSession* session) {
+        std::lock_guard<std::mutex> lock(session->mutex);
+        session->pipeline.reset();
+        // Finishes any queued exports before the renderer goes away
+        session->exporter.reset();
+        session->audioInput.reset();
+        session->melProcessor.reset();
+        session->melOutputFormat = melspectrogram::MelOutputFormat::FLOAT32;
+        session->frontEnd = melspectrogram::FrontEndConfig();
+        session->activityGate = melspectrogram::ActivityGateConfig();
+        session->quality = melspectrogram::QualityControllerConfig();
+        session->mfcc = melspectrogram::MfccConfig();
+        session->deltas = melspectrogram::DeltaConfig();
+        session->pipelineInputRate = 0;
+        session->melRing.reset();
+        session->textureRenderer.reset();
+        session->featureGraph.reset();
+        session->cqt.reset();
+    }
+
+    // Routes a column in any MelOutputFormat to the matching renderer overload
+    bool enqueueQuantizedColumn(melspectrogram::TextureRenderer& renderer, const void* melData,
+                                int dataSize, int format) {
+        switch (static_cast<melspectrogram::MelOutputFormat>(format)) {
+            case melspectrogram::MelOutputFormat::FLOAT32:
+                return renderer.enqueueColumn(static_cast<const float*>(melData), dataSize);
+            case melspectrogram::MelOutputFormat::UINT8:
+                return renderer.enqueueColumn(static_cast<const uint8_t*>(melData), dataSize);
+            case melspectrogram::MelOutputFormat::FLOAT16:
+                return renderer.enqueueColumn(static_cast<const uint16_t*>(melData), dataSize);
+        }
+        return false;
+    }
+}
 
 extern "C" {
 
+// Session Functions
+FspSession* fsp_session_create() {
+    try {
+        return new FspSession();
+    } catch (const std::exception& e) {
+        setError(e.what());
+        return nullptr;
+    }
+}
+
+void fsp_session_destroy(FspSession* session) {
+    if (!session) return;
+    resetSession(session);
+    delete session;
+}
+
+const char* fsp_get_error_message() {
+    return t_lastError;
+}
+
+int fsp_canonical_analysis_rate(int inputRate, float maxFreq) {
+    if (inputRate <= 0) {
+        setError("Invalid sample rate");
+        return -1;
+    }
+    return melspectrogram::canonicalAnalysisRate(inputRate, maxFreq);
+}
+
 // Audio Input Functions
-int init_audio_input(const audio::AudioConfig* config) {
+int fsp_init_audio_input(FspSession* session, const audio::AudioConfig* config) {
+    if (!checkSession(session)) return -1;
+    if (!config) {
+        setError("Invalid audio config");
+        return -1;
+    }
+
     try {
-        g_audioInput = std::make_unique<audio::AudioInput>(*config);
-        return g_audioInput->initialize() ? 0 : -1;
+        std::lock_guard<std::mutex> lock(session->mutex);
+        if (!checkPipelineIdle(session)) return -1;
+        session->audioInput = std::make_unique<audio::AudioInput>(*config);
+        return session->audioInput->initialize() ? 0 : -1;
     } catch (const std::exception& e) {
-        strncpy(g_lastError, e.what(), sizeof(g_lastError) - 1);
+        setError(e.what());
         return -1;
     }
 }
 
-int start_recording() {
-    if (!g_audioInput) {
-        strncpy(g_lastError, "Audio input not initialized", sizeof(g_lastError) - 1);
+int fsp_start_recording(FspSession* session) {
+    if (!checkSession(session)) return -1;
+    std::lock_guard<std::mutex> lock(session->mutex);
+    if (!session->audioInput) {
+        setError("Audio input not initialized");
         return -1;
     }
-    
+
     try {
-        return g_audioInput->startRecording() ? 0 : -1;
+        return session->audioInput->startRecording() ? 0 : -1;
     } catch (const std::exception& e) {
-        strncpy(g_lastError, e.what(), sizeof(g_lastError) - 1);
+        setError(e.what());
         return -1;
     }
 }
 
-int stop_recording() {
-    if (!g_audioInput) {
-        strncpy(g_lastError, "Audio input not initialized", sizeof(g_lastError) - 1);
+int fsp_stop_recording(FspSession* session) {
+    if (!checkSession(session)) return -1;
+    std::lock_guard<std::mutex> lock(session->mutex);
+    if (!session->audioInput) {
+        setError("Audio input not initialized");
         return -1;
     }
-    
+
     try {
-        return g_audioInput->stopRecording() ? 0 : -1;
+        return session->audioInput->stopRecording() ? 0 : -1;
     } catch (const std::exception& e) {
-        strncpy(g_lastError, e.what(), sizeof(g_lastError) - 1);
+        setError(e.what());
         return -1;
     }
 }
 
 // Mel Processor Functions
-int init_mel_processor(const melspectrogram::AudioConfig* config) {
+int fsp_init_mel_processor(FspSession* session, const melspectrogram::AudioConfig* config) {
+    if (!checkSession(session)) return -1;
+    if (!config || config->frameSize <= 0 || config->numMelBands <= 0) {
+        setError("Invalid mel processor config");
+        return -1;
+    }
+
     try {
-        g_melProcessor = std::make_unique<melspectrogram::MelSpectrogramProcessor>(*config);
-        return g_melProcessor->processAudioFrame(nullptr, 0) ? 0 : -1;
+        std::lock_guard<std::mutex> lock(session->mutex);
+        if (!checkPipelineIdle(session)) return -1;
+        session->melProcessor = std::make_unique<melspectrogram::MelSpectrogramProcessor>(*config);
+        session->melProcessor->setOutputFormat(session->melOutputFormat);
+        session->melProcessor->setFrontEnd(session->frontEnd);
+        session->melProcessor->setActivityGate(session->activityGate);
+        session->melProcessor->setQualityController(session->quality);
+        session->melProcessor->setMfcc(session->mfcc);
+        session->melProcessor->setDeltas(session->deltas);
+        session->melConfig = *config;
+        
+        // Keep an existing ring (and the pointer readers hold) if the frame shape still fits
+        if (session->melRing && session->melRing->getNumMelBands() != config->numMelBands) {
+            session->melRing.reset();
+        }
+        session->melProcessor->setFrameRing(session->melRing.get());
+        return 0;
     } catch (const std::exception& e) {
-        strncpy(g_lastError, e.what(), sizeof(g_lastError) - 1);
+        setError(e.what());
         return -1;
     }
 }
 
-int process_audio_frame(const int16_t* inputBuffer, int bufferSize, 
-                       float* outputBuffer, int outputSize) {
-    if (!g_melProcessor) {
-        strncpy(g_lastError, "Mel processor not initialized", sizeof(g_lastError) - 1);
+int fsp_process_audio_frame(FspSession* session, const int16_t* inputBuffer, int bufferSize,
+                            float* outputBuffer, int outputSize) {
+    if (!checkSession(session)) return -1;
+    std::lock_guard<std::mutex> lock(session->mutex);
+    if (!session->melProcessor) {
+        setError("Mel processor not initialized");
         return -1;
     }
-    
+    if (!checkPipelineIdle(session)) return -1;
+
+    // Checked first: processing advances the stream, so a frame without room would be lost
+    const int numBands = session->melConfig.numMelBands;
+    if (!outputBuffer) {
+        setError("Invalid output buffer");
+        return -1;
+    }
+    if (numBands > outputSize) {
+        setError("Output buffer too small");
+        return -1;
+    }
+
     try {
-        if (!g_melProcessor->processAudioFrame(inputBuffer, bufferSize)) {
-            strncpy(g_lastError, "Failed to process audio frame", sizeof(g_lastError) - 1);
+        if (!session->melProcessor->processAudioFrame(inputBuffer, bufferSize)) {
+            setError("Failed to process audio frame");
             return -1;
         }
-        
-        auto melSpectrum = g_melProcessor->getMelSpectrum();
-        
-        if (static_cast<int>(melSpectrum.size()) > outputSize) {
-            strncpy(g_lastError, "Output buffer too small", sizeof(g_lastError) - 1);
+
+        const float* melData = session->melProcessor->getMelData();
+        std::copy(melData, melData + numBands, outputBuffer);
+        return numBands;
+    } catch (const std::exception& e) {
+        setError(e.what());
+        return -1;
+    }
+}
+
+int fsp_process_audio_frames(FspSession* session, const int16_t* input, int numSamples,
+                             float* output, int outputCapacity, int* framesProduced) {
+    if (framesProduced) *framesProduced = 0;
+    if (!checkSession(session)) return -1;
+    if (numSamples < 0 || outputCapacity < 0) {
+        setError("Invalid buffer size");
+        return -1;
+    }
+    std::lock_guard<std::mutex> lock(session->mutex);
+    if (!session->melProcessor) {
+        setError("Mel processor not initialized");
+        return -1;
+    }
+
+    if (!checkPipelineIdle(session)) return -1;
+    if (!output && !session->melRing) {
+        setError("No output buffer and no mel ring enabled");
+        return -1;
+    }
+
+    try {
+        const size_t maxFrames = static_cast<size_t>(outputCapacity / session->melConfig.numMelBands);
+        size_t frames = 0;
+        const long consumed = session->melProcessor->processAudioSamples(
+            input, static_cast<size_t>(numSamples), output, maxFrames, &frames);
+        if (consumed < 0) {
+            setError("Invalid audio buffer or hop size");
             return -1;
         }
-        
-        std::copy(melSpectrum.begin(), melSpectrum.end(), outputBuffer);
-        return static_cast<int>(melSpectrum.size());
+
+        if (framesProduced) *framesProduced = static_cast<int>(frames);
+        return static_cast<int>(consumed);
     } catch (const std::exception& e) {
-        strncpy(g_lastError, e.what(), sizeof(g_lastError) - 1);
+        setError(e.what());
         return -1;
     }
 }
 
-// Texture Renderer Functions
-int init_texture_renderer(int width, int height, int numMelBands) {
+int fsp_set_mfcc(FspSession* session, int numCoefficients, int lifter) {
+    if (!checkSession(session)) return -1;
+    if (numCoefficients < 0 || lifter < 0) {
+        setError("Invalid MFCC parameters");
+        return -1;
+    }
+    std::lock_guard<std::mutex> lock(session->mutex);
+    if (!session->melProcessor) {
+        setError("Mel processor not initialized");
+        return -1;
+    }
+    if (!checkPipelineIdle(session)) return -1;
+
+    session->mfcc.enabled = numCoefficients > 0;
+    session->mfcc.numCoefficients = numCoefficients > 0 ? numCoefficients : session->mfcc.numCoefficients;
+    session->mfcc.lifter = lifter;
+    session->melProcessor->setMfcc(session->mfcc);
+    return session->melProcessor->getNumMfcc();
+}
+
+int fsp_process_audio_frames_mfcc(FspSession* session, const int16_t* input, int numSamples,
+                                  float* output, int outputCapacity, int* framesProduced) {
+    if (framesProduced) *framesProduced = 0;
+    if (!checkSession(session)) return -1;
+    if (numSamples < 0 || outputCapacity < 0 || !output) {
+        setError("Invalid buffer size");
+        return -1;
+    }
+    std::lock_guard<std::mutex> lock(session->mutex);
+    if (!session->melProcessor) {
+        setError("Mel processor not initialized");
+        return -1;
+    }
+    if (!checkPipelineIdle(session)) return -1;
+    const int coefficients = session->melProcessor->getNumMfcc();
+    if (coefficients == 0) {
+        setError("MFCCs not enabled");
+        return -1;
+    }
+
     try {
-        std::lock_guard<std::mutex> lock(g_mutex);
-        g_textureRenderer = std::make_unique<melspectrogram::TextureRenderer>(width, height, numMelBands);
-        
-        const bool ok = g_textureRenderer->initialize();
-        if (!ok) {
-#ifdef __APPLE__
-            strncpy(g_lastError, "OpenGL context not available on macOS. Flutter owns the GL context; using software rendering (fallback).", sizeof(g_lastError) - 1);
-#else
-            strncpy(g_lastError, "OpenGL context not available or texture creation failed.", sizeof(g_lastError) - 1);
-#endif
-            g_textureRenderer.reset();
+        size_t frames = 0;
+        const long consumed = session->melProcessor->processAudioSamplesMfcc(
+            input, static_cast<size_t>(numSamples), output,
+            static_cast<size_t>(outputCapacity / coefficients), &frames);
+        if (consumed < 0) {
+            setError("Invalid audio buffer or hop size");
             return -1;
         }
-        return 0;
+        if (framesProduced) *framesProduced = static_cast<int>(frames);
+        return static_cast<int>(consumed);
     } catch (const std::exception& e) {
-        strncpy(g_lastError, e.what(), sizeof(g_lastError) - 1);
+        setError(e.what());
         return -1;
     }
 }
 
-int update_texture_column(const float* melData, int dataSize) {
-    if (!g_textureRenderer) {
-        strncpy(g_lastError, "Texture renderer not initialized", sizeof(g_lastError) - 1);
+int fsp_set_deltas(FspSession* session, int window) {
+    if (!checkSession(session)) return -1;
+    if (window < 0) {
+        setError("Invalid delta window");
         return -1;
     }
-    
+    std::lock_guard<std::mutex> lock(session->mutex);
+    if (!session->melProcessor) {
+        setError("Mel processor not initialized");
+        return -1;
+    }
+    if (!checkPipelineIdle(session)) return -1;
+
+    session->deltas.enabled = window > 0;
+    session->deltas.window = window > 0 ? window : session->deltas.window;
+    session->melProcessor->setDeltas(session->deltas);
+    return static_cast<int>(session->melProcessor->getDeltaFrameSize());
+}
+
+int fsp_process_audio_frames_deltas(FspSession* session, const int16_t* input, int numSamples,
+                                    float* output, int outputCapacity, int* framesProduced) {
+    if (framesProduced) *framesProduced = 0;
+    if (!checkSession(session)) return -1;
+    if (numSamples < 0 || outputCapacity < 0 || !output) {
+        setError("Invalid buffer size");
+        return -1;
+    }
+    std::lock_guard<std::mutex> lock(session->mutex);
+    if (!session->melProcessor) {
+        setError("Mel processor not initialized");
+        return -1;
+    }
+    if (!checkPipelineIdle(session)) return -1;
+    const size_t frameSize = session->melProcessor->getDeltaFrameSize();
+    if (frameSize == 0) {
+        setError("Deltas not enabled");
+        return -1;
+    }
+
     try {
-        std::lock_guard<std::mutex> lock(g_mutex);
-        std::vector<float> melDataVec(melData, melData + dataSize);
-        const bool ok = g_textureRenderer->updateColumn(melDataVec);
-        if (!ok) {
-            strncpy(g_lastError, "Failed to update texture column (invalid data size or not initialized).", sizeof(g_lastError) - 1);
+        size_t frames = 0;
+        const long consumed = session->melProcessor->processAudioSamplesDeltas(
+            input, static_cast<size_t>(numSamples), output,
+            static_cast<size_t>(outputCapacity) / frameSize, &frames);
+        if (consumed < 0) {
+            setError("Invalid audio buffer or hop size");
             return -1;
         }
-        return 0;
+        if (framesProduced) *framesProduced = static_cast<int>(frames);
+        return static_cast<int>(consumed);
     } catch (const std::exception& e) {
-        strncpy(g_lastError, e.what(), sizeof(g_lastError) - 1);
+        setError(e.what());
         return -1;
     }
 }
 
-unsigned int get_texture_id() {
-    if (!g_textureRenderer) {
-        strncpy(g_lastError, "Texture renderer not initialized", sizeof(g_lastError) - 1);
-        return 0;
+int fsp_flush_deltas(FspSession* session, float* output, int outputCapacity) {
+    if (!checkSession(session)) return -1;
+    if (outputCapacity < 0 || !output) {
+        setError("Invalid buffer size");
+        return -1;
+    }
+    std::lock_guard<std::mutex> lock(session->mutex);
+    if (!session->melProcessor) {
+        setError("Mel processor not initialized");
+        return -1;
+    }
+    if (!checkPipelineIdle(session)) return -1;
+    const size_t frameSize = session->melProcessor->getDeltaFrameSize();
+    if (frameSize == 0) {
+        setError("Deltas not enabled");
+        return -1;
     }
-    
-    std::lock_guard<std::mutex> lock(g_mutex);
-    return g_textureRenderer->getTextureId();
+    return static_cast<int>(session->melProcessor->flushDeltas(
+        output, static_cast<size_t>(outputCapacity) / frameSize));
 }
 
-int get_texture_data(uint8_t* buffer, int bufferSize) {
-    if (!g_textureRenderer) {
-        strncpy(g_lastError, "Texture renderer not initialized", sizeof(g_lastError) - 1);
+int fsp_set_mel_output_format(FspSession* session, int format) {
+    if (!checkSession(session)) return -1;
+    if (format < 0 || format > static_cast<int>(melspectrogram::MelOutputFormat::FLOAT16)) {
+        setError("Invalid mel output format");
+        return -1;
+    }
+    std::lock_guard<std::mutex> lock(session->mutex);
+    if (!session->melProcessor) {
+        setError("Mel processor not initialized");
+        return -1;
+    }
+    if (!checkPipelineIdle(session)) return -1;
+
+    session->melOutputFormat = static_cast<melspectrogram::MelOutputFormat>(format);
+    session->melProcessor->setOutputFormat(session->melOutputFormat);
+    return static_cast<int>(session->melProcessor->getOutputBytesPerFrame());
+}
+
+int fsp_set_front_end(FspSession* session, int dcBlock, float preEmphasis) {
+    if (!checkSession(session)) return -1;
+    if (!(preEmphasis >= 0.0f && preEmphasis < 1.0f)) {
+        setError("Invalid pre-emphasis coefficient");
+        return -1;
+    }
+    std::lock_guard<std::mutex> lock(session->mutex);
+    if (!session->melProcessor) {
+        setError("Mel processor not initialized");
+        return -1;
+    }
+    if (!checkPipelineIdle(session)) return -1;
+
+    melspectrogram::FrontEndConfig frontEnd;
+    frontEnd.dcBlock = dcBlock != 0;
+    frontEnd.preEmphasis = preEmphasis;
+    if (!session->melProcessor->setFrontEnd(frontEnd)) {
+        setError("Front end not available on the fixed-point pipeline");
+        return -1;
+    }
+    session->frontEnd = frontEnd;
+    return 0;
+}
+
+int fsp_set_activity_gate(FspSession* session, int enabled, float thresholdDb, float hysteresisDb,
+                          int hangoverFrames, float maxFlatness) {
+    if (!checkSession(session)) return -1;
+    if (!(hysteresisDb >= 0.0f) || hangoverFrames < 0 || !(maxFlatness >= 0.0f)) {
+        setError("Invalid activity gate parameters");
+        return -1;
+    }
+    std::lock_guard<std::mutex> lock(session->mutex);
+    if (!session->melProcessor) {
+        setError("Mel processor not initialized");
+        return -1;
+    }
+    if (!checkPipelineIdle(session)) return -1;
+
+    melspectrogram::ActivityGateConfig gate;
+    gate.enabled = enabled != 0;
+    gate.thresholdDb = thresholdDb;
+    gate.hysteresisDb = hysteresisDb;
+    gate.hangoverFrames = hangoverFrames;
+    gate.maxFlatness = maxFlatness;
+    session->activityGate = gate;
+    session->melProcessor->setActivityGate(gate);
+    return 0;
+}
+
+int fsp_set_adaptive_quality(FspSession* session, int enabled, float budget) {
+    if (!checkSession(session)) return -1;
+    if (!(budget > 0.0f)) {
+        setError("Invalid quality budget");
+        return -1;
+    }
+    std::lock_guard<std::mutex> lock(session->mutex);
+    if (!session->melProcessor) {
+        setError("Mel processor not initialized");
+        return -1;
+    }
+    if (!checkPipelineIdle(session)) return -1;
+
+    session->quality.enabled = enabled != 0;
+    session->quality.budget = budget;
+    session->melProcessor->setQualityController(session->quality);
+    return 0;
+}
+
+int fsp_process_audio_frames_quantized(FspSession* session, const int16_t* input, int numSamples,
+                                       void* output, int outputBytes, int* framesProduced) {
+    if (framesProduced) *framesProduced = 0;
+    if (!checkSession(session)) return -1;
+    if (numSamples < 0 || outputBytes < 0) {
+        setError("Invalid buffer size");
+        return -1;
+    }
+    std::lock_guard<std::mutex> lock(session->mutex);
+    if (!session->melProcessor) {
+        setError("Mel processor not initialized");
+        return -1;
+    }
+
+    if (!checkPipelineIdle(session)) return -1;
+    if (!output && !session->melRing) {
+        setError("No output buffer and no mel ring enabled");
         return -1;
     }
-    
+
     try {
-        std::lock_guard<std::mutex> lock(g_mutex);
-        auto data = g_textureRenderer->getTextureData();
-        
-        if (static_cast<int>(data.size()) > bufferSize) {
-            strncpy(g_lastError, "Buffer too small", sizeof(g_lastError) - 1);
+        const size_t maxFrames = static_cast<size_t>(outputBytes) / session->melProcessor->getOutputBytesPerFrame();
+        size_t frames = 0;
+        const long consumed = session->melProcessor->processAudioSamplesQuantized(
+            input, static_cast<size_t>(numSamples), output, maxFrames, &frames);
+        if (consumed < 0) {
+            setError("Invalid audio buffer or hop size");
             return -1;
         }
-        
-        std::copy(data.begin(), data.end(), buffer);
-        return static_cast<int>(data.size());
+
+        if (framesProduced) *framesProduced = static_cast<int>(frames);
+        return static_cast<int>(consumed);
     } catch (const std::exception& e) {
-        strncpy(g_lastError, e.what(), sizeof(g_lastError) - 1);
+        setError(e.what());
         return -1;
     }
 }
 
-int set_texture_color_map(int colorMapType) {
-    if (!g_textureRenderer) {
-        strncpy(g_lastError, "Texture renderer not initialized", sizeof(g_lastError) - 1);
+int fsp_enable_mel_ring(FspSession* session, int capacity) {
+    if (!checkSession(session)) return -1;
+    if (capacity < 2) {
+        setError("Mel ring needs at least two slots");
+        return -1;
+    }
+    std::lock_guard<std::mutex> lock(session->mutex);
+    if (!session->melProcessor) {
+        setError("Mel processor not initialized");
         return -1;
     }
-    
+    if (!checkPipelineIdle(session)) return -1;
+
     try {
-        std::lock_guard<std::mutex> lock(g_mutex);
-        g_textureRenderer->setColorMap(static_cast<melspectrogram::ColorMapType>(colorMapType));
+        auto ring = std::make_unique<melspectrogram::MelFrameRing>(session->melConfig.numMelBands, capacity);
+        session->melProcessor->setFrameRing(ring.get());
+        session->melRing = std::move(ring);
         return 0;
     } catch (const std::exception& e) {
-        strncpy(g_lastError, e.what(), sizeof(g_lastError) - 1);
+        setError(e.what());
         return -1;
     }
 }
 
-int set_texture_min_max(float minValue, float maxValue) {
-    if (!g_textureRenderer) {
-        strncpy(g_lastError, "Texture renderer not initialized", sizeof(g_lastError) - 1);
+const void* fsp_get_mel_ring(FspSession* session, int* sizeBytes) {
+    if (sizeBytes) *sizeBytes = 0;
+    if (!checkSession(session)) return nullptr;
+    std::lock_guard<std::mutex> lock(session->mutex);
+    if (!session->melRing) {
+        setError("Mel ring not enabled");
+        return nullptr;
+    }
+
+    if (sizeBytes) *sizeBytes = static_cast<int>(session->melRing->size());
+    return session->melRing->data();
+}
+
+// Pipeline Functions
+int fsp_start_pipeline(FspSession* session, int columnCapacity) {
+    if (!checkSession(session)) return -1;
+    std::lock_guard<std::mutex> lock(session->mutex);
+    if (!session->melProcessor) {
+        setError("Mel processor not initialized");
         return -1;
     }
-    
+    if (!checkPipelineIdle(session)) return -1;
+
     try {
-        std::lock_guard<std::mutex> lock(g_mutex);
-        g_textureRenderer->setMinMaxValues(minValue, maxValue);
+        session->pipeline = std::make_unique<melspectrogram::PipelineRunner>(
+            *session->melProcessor, session->melConfig, columnCapacity > 0 ? columnCapacity : 256);
+        session->pipeline->setInputRate(session->pipelineInputRate);
+        if (!session->pipeline->start(session->audioInput.get())) {
+            setError("Failed to start pipeline (invalid hop size or audio input not ready)");
+            session->pipeline.reset();
+            return -1;
+        }
         return 0;
     } catch (const std::exception& e) {
-        strncpy(g_lastError, e.what(), sizeof(g_lastError) - 1);
+        setError(e.what());
+        return -1;
+    }
+}
+
+int fsp_set_pipeline_input_rate(FspSession* session, int sampleRate) {
+    if (!checkSession(session)) return -1;
+    if (sampleRate < 0) {
+        setError("Invalid sample rate");
+        return -1;
+    }
+    std::lock_guard<std::mutex> lock(session->mutex);
+    if (!checkPipelineIdle(session)) return -1;
+    session->pipelineInputRate = sampleRate;
+    return 0;
+}
+
+int fsp_stop_pipeline(FspSession* session) {
+    if (!checkSession(session)) return -1;
+    std::lock_guard<std::mutex> lock(session->mutex);
+    if (session->pipeline) {
+        session->pipeline->stop();
+    }
+    return 0;
+}
+
+int fsp_push_pipeline_audio(FspSession* session, const int16_t* samples, int numSamples) {
+    if (!checkSession(session)) return -1;
+    std::lock_guard<std::mutex> lock(session->mutex);
+    if (!session->pipeline || !session->pipeline->isRunning()) {
+        setError("Pipeline not running");
+        return -1;
+    }
+    if (numSamples < 0) {
+        setError("Invalid buffer size");
+        return -1;
+    }
+    return static_cast<int>(session->pipeline->pushSamples(samples, static_cast<size_t>(numSamples)));
+}
+
+int fsp_poll_pipeline(FspSession* session) {
+    if (!checkSession(session)) return -1;
+    std::lock_guard<std::mutex> lock(session->mutex);
+    if (!session->pipeline) {
+        setError("Pipeline not started");
+        return -1;
+    }
+    if (!checkRenderer(session)) return -1;
+
+    try {
+        return session->pipeline->pollColumns(*session->textureRenderer);
+    } catch (const std::exception& e) {
+        setError(e.what());
+        return -1;
+    }
+}
+
+int fsp_read_pipeline_columns(FspSession* session, float* output, int maxColumns) {
+    if (!checkSession(session)) return -1;
+    std::lock_guard<std::mutex> lock(session->mutex);
+    if (!session->pipeline) {
+        setError("Pipeline not started");
+        return -1;
+    }
+    return session->pipeline->readColumns(output, maxColumns);
+}
+
+int fsp_get_pipeline_stats(FspSession* session, melspectrogram::PipelineStats* stats) {
+    if (!checkSession(session)) return -1;
+    if (!stats) {
+        setError("Invalid stats pointer");
+        return -1;
+    }
+    std::lock_guard<std::mutex> lock(session->mutex);
+    if (!session->pipeline) {
+        setError("Pipeline not started");
+        return -1;
+    }
+    *stats = session->pipeline->getStats();
+    return session->pipeline->isRunning() ? 1 : 0;
+}
+
+int fsp_get_mel_data_size(FspSession* session) {
+    if (!session) return 0;
+    std::lock_guard<std::mutex> lock(session->mutex);
+    return session->melProcessor ? session->melConfig.numMelBands : 0;
+}
+
+int fsp_init_feature_graph(FspSession* session, const melspectrogram::AudioConfig* config, int features) {
+    if (!checkSession(session)) return -1;
+    if (!config || config->frameSize <= 0 || config->numMelBands <= 0 || config->sampleRate <= 0 ||
+        features <= 0 || features > 63) {
+        setError("Invalid feature graph config");
+        return -1;
+    }
+
+    try {
+        using namespace melspectrogram;
+        std::unique_ptr<FeatureGraph> graph(new FeatureGraph(*config));
+        if (features & 1) graph->addExtractor(std::unique_ptr<FeatureExtractor>(new MelExtractor()));
+        if (features & 2) graph->addExtractor(std::unique_ptr<FeatureExtractor>(new MfccExtractor()));
+        if (features & 4) graph->addExtractor(std::unique_ptr<FeatureExtractor>(new SpectralCentroidExtractor()));
+        if (features & 8) graph->addExtractor(std::unique_ptr<FeatureExtractor>(new SpectralFluxExtractor()));
+        if (features & 16) {
+            graph->addExtractor(std::unique_ptr<FeatureExtractor>(new BandEnergyExtractor(
+                BandEnergyExtractor::octaveEdges(config->minFreq, config->maxFreq))));
+        }
+        if (features & 32) graph->addExtractor(std::unique_ptr<FeatureExtractor>(new ChromaExtractor()));
+
+        std::lock_guard<std::mutex> lock(session->mutex);
+        session->featureGraph = std::move(graph);
+        return static_cast<int>(session->featureGraph->getTotalOutputSize());
+    } catch (const std::exception& e) {
+        setError(e.what());
+        return -1;
+    }
+}
+
+int fsp_process_feature_frame(FspSession* session, const int16_t* inputBuffer, int bufferSize,
+                              float* output, int outputCapacity) {
+    if (!checkSession(session)) return -1;
+    if (!inputBuffer || !output || bufferSize < 0 || outputCapacity < 0) {
+        setError("Invalid buffer size");
+        return -1;
+    }
+    std::lock_guard<std::mutex> lock(session->mutex);
+    if (!session->featureGraph) {
+        setError("Feature graph not initialized");
+        return -1;
+    }
+    const size_t size = session->featureGraph->getTotalOutputSize();
+    if (static_cast<size_t>(outputCapacity) < size) {
+        setError("Output buffer too small");
+        return -1;
+    }
+    if (!session->featureGraph->processFrame(inputBuffer, static_cast<size_t>(bufferSize))) {
+        setError("Failed to process audio frame");
+        return -1;
+    }
+    const float* values = session->featureGraph->getOutputs();
+    std::copy(values, values + size, output);
+    return static_cast<int>(size);
+}
+
+int fsp_init_cqt(FspSession* session, int sampleRate, int hopSize, float minFreq,
+                 int binsPerOctave, int numOctaves) {
+    if (!checkSession(session)) return -1;
+    melspectrogram::CqtConfig config;
+    config.sampleRate = sampleRate;
+    config.hopSize = hopSize;
+    config.minFreq = minFreq;
+    config.binsPerOctave = binsPerOctave;
+    config.numOctaves = numOctaves;
+    if (!melspectrogram::CqtPlan::validate(config)) {
+        setError("Invalid constant-Q config");
+        return -1;
+    }
+
+    try {
+        std::unique_ptr<melspectrogram::ConstantQProcessor> cqt(new melspectrogram::ConstantQProcessor(config));
+        std::lock_guard<std::mutex> lock(session->mutex);
+        session->cqt = std::move(cqt);
+        return session->cqt->getNumBins();
+    } catch (const std::exception& e) {
+        setError(e.what());
+        return -1;
+    }
+}
+
+int fsp_process_cqt_frames(FspSession* session, const int16_t* input, int numSamples,
+                           float* output, int outputCapacity, int* framesProduced) {
+    if (!checkSession(session)) return -1;
+    if (framesProduced) {
+        *framesProduced = 0;
+    }
+    if (!input || numSamples < 0 || outputCapacity < 0 || (!output && outputCapacity > 0)) {
+        setError("Invalid buffer size");
+        return -1;
+    }
+    std::lock_guard<std::mutex> lock(session->mutex);
+    if (!session->cqt) {
+        setError("Constant-Q transform not initialized");
+        return -1;
+    }
+
+    try {
+        const size_t maxFrames = static_cast<size_t>(outputCapacity / session->cqt->getNumBins());
+        size_t frames = 0;
+        const long consumed = session->cqt->processAudioSamples(input, static_cast<size_t>(numSamples),
+                                                                output, maxFrames, &frames);
+        if (consumed < 0) {
+            setError("Failed to process audio samples");
+            return -1;
+        }
+        if (framesProduced) {
+            *framesProduced = static_cast<int>(frames);
+        }
+        return static_cast<int>(consumed);
+    } catch (const std::exception& e) {
+        setError(e.what());
         return -1;
     }
 }
 
+// Texture Renderer Functions
+int fsp_init_texture_renderer(FspSession* session, int width, int height, int numMelBands) {
+    return fsp_init_texture_renderer_with_backend(session, width, height, numMelBands,
+        static_cast<int>(melspectrogram::RenderBackendType::AUTO));
+}
+
+int fsp_init_texture_renderer_with_backend(FspSession* session, int width, int height,
+                                           int numMelBands, int backendType) {
+    if (!checkSession(session)) return -1;
+    if (backendType < static_cast<int>(melspectrogram::RenderBackendType::AUTO) ||
+        backendType > static_cast<int>(melspectrogram::RenderBackendType::CPU)) {
+        setError("Invalid render backend type");
+        return -1;
+    }
+
+    try {
+        std::lock_guard<std::mutex> lock(session->mutex);
+        session->textureRenderer = std::make_unique<melspectrogram::TextureRenderer>(
+            width, height, numMelBands, static_cast<melspectrogram::RenderBackendType>(backendType));
+
+        const bool ok = session->textureRenderer->initialize();
+        if (!ok) {
+#ifdef __APPLE__
+            setError("OpenGL context not available on macOS. Flutter owns the GL context; using software rendering (fallback).");
+#else
+            setError("OpenGL context not available or texture creation failed.");
+#endif
+            session->textureRenderer.reset();
+            return -1;
+        }
+        return 0;
+    } catch (const std::exception& e) {
+        setError(e.what());
+        return -1;
+    }
+}
+
+int fsp_update_texture_column(FspSession* session, const float* melData, int dataSize) {
+    if (!checkSession(session)) return -1;
+    std::lock_guard<std::mutex> lock(session->mutex);
+    if (!checkRenderer(session)) return -1;
+
+    try {
+        const bool ok = session->textureRenderer->updateColumn(melData, dataSize);
+        if (!ok) {
+            setError("Failed to update texture column (invalid data size or not initialized).");
+            return -1;
+        }
+        return 0;
+    } catch (const std::exception& e) {
+        setError(e.what());
+        return -1;
+    }
+}
+
+int fsp_enqueue_texture_column(FspSession* session, const float* melData, int dataSize) {
+    if (!checkSession(session)) return -1;
+    std::lock_guard<std::mutex> lock(session->mutex);
+    if (!checkRenderer(session)) return -1;
+
+    try {
+        if (!session->textureRenderer->enqueueColumn(melData, dataSize)) {
+            setError("Failed to enqueue texture column (invalid data size or not initialized).");
+            return -1;
+        }
+        return session->textureRenderer->getPendingColumns();
+    } catch (const std::exception& e) {
+        setError(e.what());
+        return -1;
+    }
+}
+
+int fsp_update_texture_column_quantized(FspSession* session, const void* melData, int dataSize, int format) {
+    if (!checkSession(session)) return -1;
+    std::lock_guard<std::mutex> lock(session->mutex);
+    if (!checkRenderer(session)) return -1;
+
+    try {
+        if (!enqueueQuantizedColumn(*session->textureRenderer, melData, dataSize, format)) {
+            setError("Failed to update texture column (invalid data size, format or not initialized).");
+            return -1;
+        }
+        session->textureRenderer->flush();
+        return 0;
+    } catch (const std::exception& e) {
+        setError(e.what());
+        return -1;
+    }
+}
+
+int fsp_enqueue_texture_column_quantized(FspSession* session, const void* melData, int dataSize, int format) {
+    if (!checkSession(session)) return -1;
+    std::lock_guard<std::mutex> lock(session->mutex);
+    if (!checkRenderer(session)) return -1;
+
+    try {
+        if (!enqueueQuantizedColumn(*session->textureRenderer, melData, dataSize, format)) {
+            setError("Failed to enqueue texture column (invalid data size, format or not initialized).");
+            return -1;
+        }
+        return session->textureRenderer->getPendingColumns();
+    } catch (const std::exception& e) {
+        setError(e.what());
+        return -1;
+    }
+}
+
+int fsp_flush_texture_columns(FspSession* session) {
+    if (!checkSession(session)) return -1;
+    std::lock_guard<std::mutex> lock(session->mutex);
+    if (!checkRenderer(session)) return -1;
+
+    try {
+        return session->textureRenderer->flush();
+    } catch (const std::exception& e) {
+        setError(e.what());
+        return -1;
+    }
+}
+
+unsigned int fsp_get_texture_id(FspSession* session) {
+    if (!checkSession(session)) return 0;
+    std::lock_guard<std::mutex> lock(session->mutex);
+    if (!checkRenderer(session)) return 0;
+    return session->textureRenderer->getTextureId();
+}
+
+int fsp_get_texture_data(FspSession* session, uint8_t* buffer, int bufferSize) {
+    if (!checkSession(session)) return -1;
+    std::lock_guard<std::mutex> lock(session->mutex);
+    if (!checkRenderer(session)) return -1;
+
+    try {
+        auto data = session->textureRenderer->getTextureData();
+
+        if (static_cast<int>(data.size()) > bufferSize) {
+            setError("Buffer too small");
+            return -1;
+        }
+
+        std::copy(data.begin(), data.end(), buffer);
+        return static_cast<int>(data.size());
+    } catch (const std::exception& e) {
+        setError(e.what());
+        return -1;
+    }
+}
+
+int fsp_request_texture_readback(FspSession* session) {
+    if (!checkSession(session)) return -1;
+    std::lock_guard<std::mutex> lock(session->mutex);
+    if (!checkRenderer(session)) return -1;
+
+    try {
+        if (!session->textureRenderer->requestReadback()) {
+            setError("Readback already pending or renderer not initialized");
+            return -1;
+        }
+        return 0;
+    } catch (const std::exception& e) {
+        setError(e.what());
+        return -1;
+    }
+}
+
+int fsp_poll_texture_readback(FspSession* session, uint8_t* buffer, int bufferSize) {
+    if (!checkSession(session)) return -1;
+    std::lock_guard<std::mutex> lock(session->mutex);
+    if (!checkRenderer(session)) return -1;
+
+    try {
+        const int required = session->textureRenderer->getWidth() * session->textureRenderer->getHeight() * 4;
+        if (bufferSize < required) {
+            setError("Buffer too small");
+            return -1;
+        }
+
+        std::vector<uint8_t> data;
+        if (!session->textureRenderer->pollReadback(&data)) {
+            return 0;
+        }
+
+        std::copy(data.begin(), data.end(), buffer);
+        return static_cast<int>(data.size());
+    } catch (const std::exception& e) {
+        setError(e.what());
+        return -1;
+    }
+}
+
+const uint8_t* fsp_get_texture_pixels(FspSession* session) {
+    if (!checkSession(session)) return nullptr;
+    std::lock_guard<std::mutex> lock(session->mutex);
+    if (!checkRenderer(session)) return nullptr;
+    return session->textureRenderer->getPixels();
+}
+
+int fsp_get_texture_stride(FspSession* session) {
+    if (!session) return 0;
+    std::lock_guard<std::mutex> lock(session->mutex);
+    return session->textureRenderer ? session->textureRenderer->getPixelStride() : 0;
+}
+
+int fsp_get_texture_backend(FspSession* session) {
+    if (!session) return -1;
+    std::lock_guard<std::mutex> lock(session->mutex);
+    return session->textureRenderer ? static_cast<int>(session->textureRenderer->getBackendType()) : -1;
+}
+
+int fsp_set_texture_color_map(FspSession* session, int colorMapType) {
+    if (!checkSession(session)) return -1;
+    // The type indexes the renderer's lookup tables
+    if (colorMapType < static_cast<int>(melspectrogram::ColorMapType::VIRIDIS) ||
+        colorMapType > static_cast<int>(melspectrogram::ColorMapType::PLASMA)) {
+        setError("Invalid color map type");
+        return -1;
+    }
+    std::lock_guard<std::mutex> lock(session->mutex);
+    if (!checkRenderer(session)) return -1;
+
+    try {
+        session->textureRenderer->setColorMap(static_cast<melspectrogram::ColorMapType>(colorMapType));
+        return 0;
+    } catch (const std::exception& e) {
+        setError(e.what());
+        return -1;
+    }
+}
+
+int fsp_set_texture_min_max(FspSession* session, float minValue, float maxValue) {
+    if (!checkSession(session)) return -1;
+    std::lock_guard<std::mutex> lock(session->mutex);
+    if (!checkRenderer(session)) return -1;
+
+    try {
+        session->textureRenderer->setMinMaxValues(minValue, maxValue);
+        return 0;
+    } catch (const std::exception& e) {
+        setError(e.what());
+        return -1;
+    }
+}
+
+int fsp_enable_texture_history(FspSession* session, int levelCapacity, int numLevels, int pooling) {
+    if (!checkSession(session)) return -1;
+    std::lock_guard<std::mutex> lock(session->mutex);
+    if (!checkRenderer(session)) return -1;
+
+    try {
+        const auto mode = pooling == 1 ? melspectrogram::PoolingMode::MEAN : melspectrogram::PoolingMode::MAX;
+        if (!session->textureRenderer->enableHistory(levelCapacity, numLevels, mode)) {
+            setError("Invalid history configuration");
+            return -1;
+        }
+        return 0;
+    } catch (const std::exception& e) {
+        setError(e.what());
+        return -1;
+    }
+}
+
+int64_t fsp_get_texture_history_total_columns(FspSession* session) {
+    if (!session) return 0;
+    std::lock_guard<std::mutex> lock(session->mutex);
+    if (!session->textureRenderer || !session->textureRenderer->getHistory()) return 0;
+    return session->textureRenderer->getHistory()->getTotalColumns();
+}
+
+int fsp_select_texture_history_level(FspSession* session, int64_t spanColumns, int maxColumns) {
+    if (!session) return 0;
+    std::lock_guard<std::mutex> lock(session->mutex);
+    if (!session->textureRenderer || !session->textureRenderer->getHistory()) return 0;
+    return session->textureRenderer->getHistory()->selectLevel(spanColumns, maxColumns);
+}
+
+int fsp_render_texture_history(FspSession* session, int level, int64_t startColumn, int64_t endColumn,
+                               int maxColumns, uint8_t* buffer, int bufferSize) {
+    if (!checkSession(session)) return -1;
+    std::lock_guard<std::mutex> lock(session->mutex);
+    if (!checkRenderer(session)) return -1;
+
+    try {
+        std::vector<uint8_t> image;
+        const int width = session->textureRenderer->renderHistory(level, startColumn, endColumn, maxColumns, image);
+        if (width < 0) {
+            setError("History not enabled or invalid range");
+            return -1;
+        }
+
+        if (static_cast<int>(image.size()) > bufferSize) {
+            setError("Buffer too small");
+            return -1;
+        }
+
+        std::copy(image.begin(), image.end(), buffer);
+        return width;
+    } catch (const std::exception& e) {
+        setError(e.what());
+        return -1;
+    }
+}
+
+int fsp_export_texture(FspSession* session, const char* path, int format, int compressionLevel) {
+    if (!checkSession(session)) return -1;
+    if (path == nullptr || format < 0 || format > 2 || compressionLevel < 0 || compressionLevel > 9) {
+        setError("Invalid export parameters");
+        return -1;
+    }
+    std::lock_guard<std::mutex> lock(session->mutex);
+    if (!checkRenderer(session)) return -1;
+
+    try {
+        if (!session->exporter) {
+            session->exporter = std::make_unique<melspectrogram::SpectrogramExporter>();
+        }
+
+        melspectrogram::ExportOptions options;
+        options.format = static_cast<melspectrogram::ExportFormat>(format);
+        options.compressionLevel = compressionLevel;
+        if (!session->exporter->exportAsync(*session->textureRenderer, path, options)) {
+            setError("Export queue full");
+            return -1;
+        }
+        return 0;
+    } catch (const std::exception& e) {
+        setError(e.what());
+        return -1;
+    }
+}
+
+int fsp_get_texture_export_pending(FspSession* session) {
+    if (!session) return 0;
+    std::lock_guard<std::mutex> lock(session->mutex);
+    return session->exporter ? static_cast<int>(session->exporter->getPendingJobs()) : 0;
+}
+
+int fsp_get_texture_width(FspSession* session) {
+    if (!session) return 0;
+    std::lock_guard<std::mutex> lock(session->mutex);
+    return session->textureRenderer ? session->textureRenderer->getWidth() : 0;
+}
+
+int fsp_get_texture_height(FspSession* session) {
+    if (!session) return 0;
+    std::lock_guard<std::mutex> lock(session->mutex);
+    return session->textureRenderer ? session->textureRenderer->getHeight() : 0;
+}
+
+int fsp_get_texture_num_mel_bands(FspSession* session) {
+    if (!session) return 0;
+    std::lock_guard<std::mutex> lock(session->mutex);
+    return session->textureRenderer ? session->textureRenderer->getNumMelBands() : 0;
+}
+
+int fsp_get_texture_current_column(FspSession* session) {
+    if (!session) return 0;
+    std::lock_guard<std::mutex> lock(session->mutex);
+    return session->textureRenderer ? session->textureRenderer->getCurrentColumn() : 0;
+}
+
+float fsp_get_texture_last_update_time_ms(FspSession* session) {
+    if (!session) return 0.0f;
+    std::lock_guard<std::mutex> lock(session->mutex);
+    return session->textureRenderer ? session->textureRenderer->getLastUpdateTimeMs() : 0.0f;
+}
+
+// Single-pipeline API, backed by a process-wide default session
+
+int init_audio_input(const audio::AudioConfig* config) {
+    return fsp_init_audio_input(defaultSession(), config);
+}
+
+int start_recording() {
+    return fsp_start_recording(defaultSession());
+}
+
+int stop_recording() {
+    return fsp_stop_recording(defaultSession());
+}
+
+int init_mel_processor(const melspectrogram::AudioConfig* config) {
+    return fsp_init_mel_processor(defaultSession(), config);
+}
+
+int process_audio_frame(const int16_t* inputBuffer, int bufferSize,
+                       float* outputBuffer, int outputSize) {
+    return fsp_process_audio_frame(defaultSession(), inputBuffer, bufferSize, outputBuffer, outputSize);
+}
+
+int process_audio_frames(const int16_t* input, int numSamples,
+                         float* output, int outputCapacity, int* framesProduced) {
+    return fsp_process_audio_frames(defaultSession(), input, numSamples, output, outputCapacity, framesProduced);
+}
+
+int set_mel_output_format(int format) {
+    return fsp_set_mel_output_format(defaultSession(), format);
+}
+
+int set_mfcc(int numCoefficients, int lifter) {
+    return fsp_set_mfcc(defaultSession(), numCoefficients, lifter);
+}
+
+int process_audio_frames_mfcc(const int16_t* input, int numSamples,
+                              float* output, int outputCapacity, int* framesProduced) {
+    return fsp_process_audio_frames_mfcc(defaultSession(), input, numSamples, output, outputCapacity,
+                                         framesProduced);
+}
+
+int set_deltas(int window) {
+    return fsp_set_deltas(defaultSession(), window);
+}
+
+int process_audio_frames_deltas(const int16_t* input, int numSamples,
+                                float* output, int outputCapacity, int* framesProduced) {
+    return fsp_process_audio_frames_deltas(defaultSession(), input, numSamples, output, outputCapacity,
+                                           framesProduced);
+}
+
+int flush_deltas(float* output, int outputCapacity) {
+    return fsp_flush_deltas(defaultSession(), output, outputCapacity);
+}
+
+int set_front_end(int dcBlock, float preEmphasis) {
+    return fsp_set_front_end(defaultSession(), dcBlock, preEmphasis);
+}
+
+int set_activity_gate(int enabled, float thresholdDb, float hysteresisDb, int hangoverFrames,
+                      float maxFlatness) {
+    return fsp_set_activity_gate(defaultSession(), enabled, thresholdDb, hysteresisDb, hangoverFrames,
+                                 maxFlatness);
+}
+
+int set_adaptive_quality(int enabled, float budget) {
+    return fsp_set_adaptive_quality(defaultSession(), enabled, budget);
+}
+
+int process_audio_frames_quantized(const int16_t* input, int numSamples,
+                                   void* output, int outputBytes, int* framesProduced) {
+    return fsp_process_audio_frames_quantized(defaultSession(), input, numSamples, output, outputBytes,
+                                              framesProduced);
+}
+
+int enable_mel_ring(int capacity) {
+    return fsp_enable_mel_ring(defaultSession(), capacity);
+}
+
+const void* get_mel_ring(int* sizeBytes) {
+    return fsp_get_mel_ring(defaultSession(), sizeBytes);
+}
+
+int start_pipeline(int columnCapacity) {
+    return fsp_start_pipeline(defaultSession(), columnCapacity);
+}
+
+int set_pipeline_input_rate(int sampleRate) {
+    return fsp_set_pipeline_input_rate(defaultSession(), sampleRate);
+}
+
+int canonical_analysis_rate(int inputRate, float maxFreq) {
+    return fsp_canonical_analysis_rate(inputRate, maxFreq);
+}
+
+int stop_pipeline() {
+    return fsp_stop_pipeline(defaultSession());
+}
+
+int push_pipeline_audio(const int16_t* samples, int numSamples) {
+    return fsp_push_pipeline_audio(defaultSession(), samples, numSamples);
+}
+
+int poll_pipeline() {
+    return fsp_poll_pipeline(defaultSession());
+}
+
+int read_pipeline_columns(float* output, int maxColumns) {
+    return fsp_read_pipeline_columns(defaultSession(), output, maxColumns);
+}
+
+int get_pipeline_stats(melspectrogram::PipelineStats* stats) {
+    return fsp_get_pipeline_stats(defaultSession(), stats);
+}
+
+int get_mel_data_size() {
+    return fsp_get_mel_data_size(defaultSession());
+}
+
+int init_feature_graph(const melspectrogram::AudioConfig* config, int features) {
+    return fsp_init_feature_graph(defaultSession(), config, features);
+}
+
+int process_feature_frame(const int16_t* inputBuffer, int bufferSize, float* output, int outputCapacity) {
+    return fsp_process_feature_frame(defaultSession(), inputBuffer, bufferSize, output, outputCapacity);
+}
+
+int init_cqt(int sampleRate, int hopSize, float minFreq, int binsPerOctave, int numOctaves) {
+    return fsp_init_cqt(defaultSession(), sampleRate, hopSize, minFreq, binsPerOctave, numOctaves);
+}
+
+int process_cqt_frames(const int16_t* input, int numSamples, float* output, int outputCapacity,
+                       int* framesProduced) {
+    return fsp_process_cqt_frames(defaultSession(), input, numSamples, output, outputCapacity, framesProduced);
+}
+
+int init_texture_renderer(int width, int height, int numMelBands) {
+    return fsp_init_texture_renderer(defaultSession(), width, height, numMelBands);
+}
+
+int init_texture_renderer_with_backend(int width, int height, int numMelBands, int backendType) {
+    return fsp_init_texture_renderer_with_backend(defaultSession(), width, height, numMelBands, backendType);
+}
+
+int update_texture_column(const float* melData, int dataSize) {
+    return fsp_update_texture_column(defaultSession(), melData, dataSize);
+}
+
+int enqueue_texture_column(const float* melData, int dataSize) {
+    return fsp_enqueue_texture_column(defaultSession(), melData, dataSize);
+}
+
+int update_texture_column_quantized(const void* melData, int dataSize, int format) {
+    return fsp_update_texture_column_quantized(defaultSession(), melData, dataSize, format);
+}
+
+int enqueue_texture_column_quantized(const void* melData, int dataSize, int format) {
+    return fsp_enqueue_texture_column_quantized(defaultSession(), melData, dataSize, format);
+}
+
+int flush_texture_columns() {
+    return fsp_flush_texture_columns(defaultSession());
+}
+
+unsigned int get_texture_id() {
+    return fsp_get_texture_id(defaultSession());
+}
+
+int get_texture_data(uint8_t* buffer, int bufferSize) {
+    return fsp_get_texture_data(defaultSession(), buffer, bufferSize);
+}
+
+int request_texture_readback() {
+    return fsp_request_texture_readback(defaultSession());
+}
+
+int poll_texture_readback(uint8_t* buffer, int bufferSize) {
+    return fsp_poll_texture_readback(defaultSession(), buffer, bufferSize);
+}
+
+const uint8_t* get_texture_pixels() {
+    return fsp_get_texture_pixels(defaultSession());
+}
+
+int get_texture_stride() {
+    return fsp_get_texture_stride(defaultSession());
+}
+
+int get_texture_backend() {
+    return fsp_get_texture_backend(defaultSession());
+}
+
+int set_texture_color_map(int colorMapType) {
+    return fsp_set_texture_color_map(defaultSession(), colorMapType);
+}
+
+int set_texture_min_max(float minValue, float maxValue) {
+    return fsp_set_texture_min_max(defaultSession(), minValue, maxValue);
+}
+
+int enable_texture_history(int levelCapacity, int numLevels, int pooling) {
+    return fsp_enable_texture_history(defaultSession(), levelCapacity, numLevels, pooling);
+}
+
+int64_t get_texture_history_total_columns() {
+    return fsp_get_texture_history_total_columns(defaultSession());
+}
+
+int select_texture_history_level(int64_t spanColumns, int maxColumns) {
+    return fsp_select_texture_history_level(defaultSession(), spanColumns, maxColumns);
+}
+
+int render_texture_history(int level, int64_t startColumn, int64_t endColumn, int maxColumns,
+                           uint8_t* buffer, int bufferSize) {
+    return fsp_render_texture_history(defaultSession(), level, startColumn, endColumn,
+                                      maxColumns, buffer, bufferSize);
+}
+
+int export_texture(const char* path, int format, int compressionLevel) {
+    return fsp_export_texture(defaultSession(), path, format, compressionLevel);
+}
+
+int get_texture_export_pending() {
+    return fsp_get_texture_export_pending(defaultSession());
+}
+
 // Utility Functions
 const char* get_error_message() {
-    return g_lastError;
+    return fsp_get_error_message();
 }
 
 int get_texture_width() {
-    if (!g_textureRenderer) return 0;
-    return g_textureRenderer->getWidth();
+    return fsp_get_texture_width(defaultSession());
 }
 
 int get_texture_height() {
-    if (!g_textureRenderer) return 0;
-    return g_textureRenderer->getHeight();
+    return fsp_get_texture_height(defaultSession());
 }
 
 int get_texture_num_mel_bands() {
-    if (!g_textureRenderer) return 0;
-    return g_textureRenderer->getNumMelBands();
+    return fsp_get_texture_num_mel_bands(defaultSession());
 }
 
 int get_texture_current_column() {
-    if (!g_textureRenderer) return 0;
-    return g_textureRenderer->getCurrentColumn();
+    return fsp_get_texture_current_column(defaultSession());
 }
 
 float get_texture_last_update_time_ms() {
-    if (!g_textureRenderer) return 0.0f;
-    return g_textureRenderer->getLastUpdateTimeMs();
+    return fsp_get_texture_last_update_time_ms(defaultSession());
 }
 
 void cleanup() {
-    std::lock_guard<std::mutex> lock(g_mutex);
-    g_audioInput.reset();
-    g_melProcessor.reset();
-    g_textureRenderer.reset();
-    g_lastError[0] = '\0';
+    resetSession(defaultSession());
+    t_lastError[0] = '\0';
 }
 
-} // extern "C"
\ No newline at end of file
+} // extern "C"
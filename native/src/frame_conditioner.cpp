@@ -0,0 +1,156 @@
+#include "frame_conditioner.h"
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace melspectrogram {
+
+namespace {
+    struct Filter {
+        bool dcBlock;
+        float pole;
+        float emphasis;
+        float previousInput;
+        float previousOutput;
+    };
+
+    // One sample; returns the pre-emphasized value and advances the filter memory
+    inline float step(Filter& filter, float x) {
+        float y = x;
+        if (filter.dcBlock) {
+            y = x - filter.previousInput + filter.pole * filter.previousOutput;
+        }
+        const float z = y - filter.emphasis * filter.previousOutput;
+        filter.previousInput = x;
+        filter.previousOutput = y;
+        return z;
+    }
+
+    // output[i] = filtered(input[i]) * window[i] for i in [begin, end); Complex interleaves a zero imaginary part
+    template <bool Complex>
+    void conditionRange(const int16_t* input, const float* window, int begin, int end,
+                        Filter& filter, float* out) {
+        int i = begin;
+#if defined(__SSE2__)
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 emphasis = _mm_set1_ps(filter.emphasis);
+        const __m128 pole = _mm_set1_ps(filter.pole);
+        const __m128 pole2 = _mm_set1_ps(filter.pole * filter.pole);
+        const __m128 polePowers = _mm_setr_ps(filter.pole, filter.pole * filter.pole,
+                                              filter.pole * filter.pole * filter.pole,
+                                              filter.pole * filter.pole * filter.pole * filter.pole);
+        for (; i + 4 <= end; i += 4) {
+            const __m128i raw = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(input + i));
+            const __m128 x = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(raw, raw), 16));
+            __m128 y = x;
+            if (filter.dcBlock) {
+                // d[k] = x[k] - x[k-1], then the recurrence y[k] = d[k] + pole * y[k-1] as a two-step scan
+                const __m128 previousX = _mm_move_ss(_mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(x), 4)),
+                                                     _mm_set_ss(filter.previousInput));
+                __m128 t = _mm_sub_ps(x, previousX);
+                t = _mm_add_ps(t, _mm_mul_ps(pole, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(t), 4))));
+                t = _mm_add_ps(t, _mm_mul_ps(pole2, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(t), 8))));
+                y = _mm_add_ps(t, _mm_mul_ps(polePowers, _mm_set1_ps(filter.previousOutput)));
+            }
+            const __m128 previousY = _mm_move_ss(_mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(y), 4)),
+                                                 _mm_set_ss(filter.previousOutput));
+            const __m128 z = _mm_mul_ps(_mm_sub_ps(y, _mm_mul_ps(emphasis, previousY)), _mm_loadu_ps(window + i));
+            if (Complex) {
+                _mm_storeu_ps(out + 2 * i, _mm_unpacklo_ps(z, zero));
+                _mm_storeu_ps(out + 2 * i + 4, _mm_unpackhi_ps(z, zero));
+            } else {
+                _mm_storeu_ps(out + i, z);
+            }
+
+            filter.previousInput = _mm_cvtss_f32(_mm_shuffle_ps(x, x, _MM_SHUFFLE(3, 3, 3, 3)));
+            filter.previousOutput = _mm_cvtss_f32(_mm_shuffle_ps(y, y, _MM_SHUFFLE(3, 3, 3, 3)));
+        }
+#elif defined(__ARM_NEON)
+        const float32x4_t zero = vdupq_n_f32(0.0f);
+        const float32x4_t polePowers = {filter.pole, filter.pole * filter.pole,
+                                        filter.pole * filter.pole * filter.pole,
+                                        filter.pole * filter.pole * filter.pole * filter.pole};
+        for (; i + 4 <= end; i += 4) {
+            const float32x4_t x = vcvtq_f32_s32(vmovl_s16(vld1_s16(input + i)));
+            float32x4_t y = x;
+            if (filter.dcBlock) {
+                float32x4_t t = vsubq_f32(x, vextq_f32(vdupq_n_f32(filter.previousInput), x, 3));
+                t = vmlaq_n_f32(t, vextq_f32(zero, t, 3), filter.pole);
+                t = vmlaq_n_f32(t, vextq_f32(zero, t, 2), filter.pole * filter.pole);
+                y = vmlaq_n_f32(t, polePowers, filter.previousOutput);
+            }
+            const float32x4_t previousY = vextq_f32(vdupq_n_f32(filter.previousOutput), y, 3);
+            float32x4x2_t z;
+            z.val[0] = vmulq_f32(vmlsq_n_f32(y, previousY, filter.emphasis), vld1q_f32(window + i));
+            z.val[1] = zero;
+            if (Complex) {
+                vst2q_f32(out + 2 * i, z);
+            } else {
+                vst1q_f32(out + i, z.val[0]);
+            }
+
+            filter.previousInput = vgetq_lane_f32(x, 3);
+            filter.previousOutput = vgetq_lane_f32(y, 3);
+        }
+#endif
+        for (; i < end; ++i) {
+            const float z = step(filter, static_cast<float>(input[i])) * window[i];
+            if (Complex) {
+                out[2 * i] = z;
+                out[2 * i + 1] = 0.0f;
+            } else {
+                out[i] = z;
+            }
+        }
+    }
+
+    template <bool Complex>
+    void conditionFrameInto(const int16_t* input, int frameSize, const float* scaledWindow,
+                            const FrontEndConfig& config, FrontEndState* state, int advance, float* output) {
+        const bool filtering = config.enabled() && state != nullptr;
+        Filter filter = {filtering && config.dcBlock, config.dcPole, filtering ? config.preEmphasis : 0.0f,
+                         filtering ? state->previousInput : 0.0f, filtering ? state->previousOutput : 0.0f};
+        if (!filtering) {
+            conditionRange<Complex>(input, scaledWindow, 0, frameSize, filter, output);
+            return;
+        }
+
+        // The memory after the first hop is where the next frame starts
+        const int split = std::max(0, std::min(advance, frameSize));
+        conditionRange<Complex>(input, scaledWindow, 0, split, filter, output);
+        state->previousInput = filter.previousInput;
+        state->previousOutput = filter.previousOutput;
+        conditionRange<Complex>(input, scaledWindow, split, frameSize, filter, output);
+    }
+}
+
+void conditionFrame(const int16_t* input, int frameSize, const float* scaledWindow,
+                    const FrontEndConfig& config, FrontEndState* state, int advance,
+                    std::complex<float>* output) {
+    conditionFrameInto<true>(input, frameSize, scaledWindow, config, state, advance,
+                             reinterpret_cast<float*>(output));
+}
+
+void conditionFrame(const int16_t* input, int frameSize, const float* scaledWindow,
+                    const FrontEndConfig& config, FrontEndState* state, int advance, float* output) {
+    conditionFrameInto<false>(input, frameSize, scaledWindow, config, state, advance, output);
+}
+
+void advanceFrontEnd(const int16_t* input, int count, const FrontEndConfig& config, FrontEndState* state) {
+    if (!config.enabled() || state == nullptr) {
+        return;
+    }
+    Filter filter = {config.dcBlock, config.dcPole, config.preEmphasis,
+                     state->previousInput, state->previousOutput};
+    for (int i = 0; i < count; ++i) {
+        step(filter, static_cast<float>(input[i]));
+    }
+    state->previousInput = filter.previousInput;
+    state->previousOutput = filter.previousOutput;
+}
+
+} // namespace melspectrogram
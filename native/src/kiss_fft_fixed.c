@@ -0,0 +1,20 @@
+/*
+ * Fixed-point build of kiss_fft with 32-bit scalars and 64-bit products,
+ * exported under kiss_fft_fixed_* names (see kiss_fft_fixed.h). 16-bit
+ * scalars lose one bit per radix-2 step to the per-stage scaling, leaving too
+ * little resolution for the quiet bins of a 1024-point transform.
+ */
+#define FIXED_POINT 32
+
+#define kiss_fft_state kiss_fft_fixed_state
+#define kiss_fft_cpx kiss_fft_fixed_cpx
+#define kiss_fft_cfg kiss_fft_fixed_cfg
+#define kiss_fft_alloc kiss_fft_fixed_alloc
+#define kiss_fft_stride kiss_fft_fixed_stride
+#define kiss_fft kiss_fft_fixed
+#define kiss_fft_cleanup kiss_fft_fixed_cleanup
+#define kiss_fft_next_fast_size kiss_fft_fixed_next_fast_size
+#define kf_work kf_fixed_work
+#define kf_factor kf_fixed_factor
+
+#include "kiss_fft.c"
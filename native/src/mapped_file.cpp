@@ -0,0 +1,82 @@
+#include "mapped_file.h"
+
+#ifdef _WIN32
+#include <fstream>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace melspectrogram {
+
+MappedFile::MappedFile() : data_(nullptr), size_(0) {
+}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open(const std::string& path, bool sequential) {
+    close();
+    error_.clear();
+
+#ifdef _WIN32
+    (void)sequential;
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        error_ = "Cannot open " + path;
+        return false;
+    }
+    const std::streamoff length = file.tellg();
+    if (length <= 0) {
+        error_ = "Empty or unreadable file " + path;
+        return false;
+    }
+    size_ = static_cast<size_t>(length);
+    data_ = new uint8_t[size_];
+    file.seekg(0);
+    if (!file.read(reinterpret_cast<char*>(data_), length)) {
+        close();
+        error_ = "Cannot read " + path;
+        return false;
+    }
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error_ = "Cannot open " + path;
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+        ::close(fd);
+        error_ = "Empty or unreadable file " + path;
+        return false;
+    }
+    void* mapping = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        error_ = "mmap failed for " + path;
+        return false;
+    }
+    data_ = static_cast<uint8_t*>(mapping);
+    size_ = static_cast<size_t>(info.st_size);
+    madvise(mapping, size_, sequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+#endif
+    return true;
+}
+
+void MappedFile::close() {
+    if (data_) {
+#ifdef _WIN32
+        delete[] data_;
+#else
+        munmap(data_, size_);
+#endif
+    }
+    data_ = nullptr;
+    size_ = 0;
+}
+
+} // namespace melspectrogram
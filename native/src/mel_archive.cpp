@@ -0,0 +1,600 @@
+#include "mel_archive.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace melspectrogram {
+
+namespace {
+    constexpr size_t FILE_HEADER_SIZE = 64;
+    constexpr size_t CHUNK_HEADER_SIZE = 32;
+    constexpr size_t INDEX_ENTRY_SIZE = 16;
+    constexpr size_t TRAILER_SIZE = 32;
+    // Quotients this large are sent as raw zigzag values instead of in unary
+    constexpr uint32_t RICE_ESCAPE = 16;
+
+    // Time predictors, chosen per band and chunk
+    constexpr uint32_t PREDICT_PREVIOUS = 1;  // x[t-1]
+    constexpr uint32_t PREDICT_LINEAR = 2;    // 2x[t-1] - x[t-2], for smooth trends
+    constexpr uint32_t PREDICT_MEAN = 3;      // (x[t-1] + x[t-2]) / 2, for a jittery noise floor
+
+    // levels points at the band's value in frame 0; frames are stride apart.
+    // The first frame of a chunk is predicted from zero so chunks decode on their own.
+    int32_t predict(const int32_t* levels, size_t stride, size_t frame, uint32_t predictor) {
+        if (frame == 0) return 0;
+        const int32_t previous = levels[(frame - 1) * stride];
+        if (frame == 1 || predictor == PREDICT_PREVIOUS) return previous;
+        const int32_t before = levels[(frame - 2) * stride];
+        return predictor == PREDICT_LINEAR ? 2 * previous - before : (previous + before) >> 1;
+    }
+
+    uint32_t zigzag(int32_t value) {
+        return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+    }
+
+    size_t align8(size_t value) {
+        return (value + 7) & ~static_cast<size_t>(7);
+    }
+
+    void putU32(uint8_t* p, uint32_t value) {
+        for (int i = 0; i < 4; ++i) p[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+
+    void putU64(uint8_t* p, uint64_t value) {
+        for (int i = 0; i < 8; ++i) p[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+
+    void putF32(uint8_t* p, float value) {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        putU32(p, bits);
+    }
+
+    uint32_t getU32(const uint8_t* p) {
+        return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+               (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+    }
+
+    uint64_t getU64(const uint8_t* p) {
+        return static_cast<uint64_t>(getU32(p)) | (static_cast<uint64_t>(getU32(p + 4)) << 32);
+    }
+
+    float getF32(const uint8_t* p) {
+        const uint32_t bits = getU32(p);
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    // MSB-first bit packing
+    class BitWriter {
+    public:
+        explicit BitWriter(std::vector<uint8_t>& out) : out_(out), acc_(0), bits_(0) {}
+
+        void put(uint32_t value, int count) {
+            if (count == 0) return;
+            acc_ = (acc_ << count) | (value & ((1ull << count) - 1));
+            bits_ += count;
+            while (bits_ >= 8) {
+                bits_ -= 8;
+                out_.push_back(static_cast<uint8_t>(acc_ >> bits_));
+            }
+        }
+
+        void putOnes(uint32_t count) {
+            while (count >= 16) {
+                put(0xFFFF, 16);
+                count -= 16;
+            }
+            put((1u << count) - 1, static_cast<int>(count));
+        }
+
+        void finish() {
+            if (bits_ > 0) {
+                out_.push_back(static_cast<uint8_t>(acc_ << (8 - bits_)));
+                bits_ = 0;
+            }
+        }
+
+    private:
+        std::vector<uint8_t>& out_;
+        uint64_t acc_;
+        int bits_;
+    };
+
+    class BitReader {
+    public:
+        BitReader(const uint8_t* data, size_t size)
+            : p_(data), end_(data + size), acc_(0), bits_(0), consumed_(0), available_(size * 8) {}
+
+        uint32_t get(int count) {
+            if (count == 0) return 0;
+            if (bits_ < count) refill();
+            const uint32_t value = static_cast<uint32_t>(acc_ >> (64 - count));
+            acc_ <<= count;
+            bits_ -= count;
+            consumed_ += count;
+            return value;
+        }
+
+        // Number of 1 bits before the next 0, up to limit (the 0 is consumed too)
+        uint32_t unary(uint32_t limit) {
+            uint32_t count = 0;
+            while (count < limit) {
+                if (bits_ == 0) refill();
+                const bool one = (acc_ >> 63) != 0;
+                acc_ <<= 1;
+                bits_--;
+                consumed_++;
+                if (!one) break;
+                count++;
+            }
+            return count;
+        }
+
+        bool overrun() const { return consumed_ > available_; }
+
+    private:
+        void refill() {
+            // Past the end, zeros are shifted in and overrun() reports it
+            while (bits_ <= 56) {
+                const uint64_t byte = p_ < end_ ? *p_++ : 0;
+                acc_ |= byte << (56 - bits_);
+                bits_ += 8;
+            }
+        }
+
+        const uint8_t* p_;
+        const uint8_t* end_;
+        uint64_t acc_;
+        int bits_;
+        uint64_t consumed_;
+        uint64_t available_;
+    };
+}
+
+// MelArchiveWriter
+
+MelArchiveWriter::MelArchiveWriter()
+    : file_(nullptr), pendingFrames_(0), framesWritten_(0), offset_(0) {
+}
+
+MelArchiveWriter::~MelArchiveWriter() {
+    close();
+}
+
+bool MelArchiveWriter::fail(const std::string& message) {
+    error_ = message;
+    return false;
+}
+
+bool MelArchiveWriter::write(const void* data, size_t size) {
+    if (std::fwrite(data, 1, size, file_) != size) {
+        return fail("Write failed");
+    }
+    offset_ += size;
+    return true;
+}
+
+bool MelArchiveWriter::open(const std::string& path, const MelArchiveConfig& config) {
+    close();
+    error_.clear();
+    if (config.numMelBands <= 0 || config.chunkFrames <= 0 || config.bitDepth < 1 || config.bitDepth > 16 ||
+        config.sampleRate <= 0 || config.hopSize <= 0 || !(config.dynamicRangeDb >= 0.0f) ||
+        !std::isfinite(config.dynamicRangeDb)) {
+        return fail("Invalid archive configuration");
+    }
+
+    file_ = std::fopen(path.c_str(), "wb");
+    if (!file_) {
+        return fail("Cannot create " + path);
+    }
+
+    config_ = config;
+    pending_.assign(static_cast<size_t>(config_.numMelBands) * config_.chunkFrames, 0.0f);
+    levels_.resize(pending_.size());
+    pendingFrames_ = 0;
+    framesWritten_ = 0;
+    offset_ = 0;
+    indexFrames_.clear();
+    indexOffsets_.clear();
+
+    uint8_t header[FILE_HEADER_SIZE] = {};
+    std::memcpy(header, "MELA", 4);
+    putU32(header + 4, MEL_ARCHIVE_VERSION);
+    putU32(header + 8, static_cast<uint32_t>(config_.numMelBands));
+    putU32(header + 12, static_cast<uint32_t>(config_.chunkFrames));
+    putU32(header + 16, static_cast<uint32_t>(config_.bitDepth));
+    putU32(header + 20, static_cast<uint32_t>(config_.sampleRate));
+    putU32(header + 24, static_cast<uint32_t>(config_.hopSize));
+    putU64(header + 32, static_cast<uint64_t>(config_.startTimeUs));
+    if (!write(header, sizeof(header))) {
+        std::fclose(file_);
+        file_ = nullptr;
+        return false;
+    }
+    return true;
+}
+
+bool MelArchiveWriter::append(const float* frames, size_t numFrames) {
+    if (!file_) {
+        return fail("Archive not open");
+    }
+    if (frames == nullptr && numFrames > 0) {
+        return fail("Invalid frame pointer");
+    }
+
+    const size_t bands = static_cast<size_t>(config_.numMelBands);
+    while (numFrames > 0) {
+        const size_t take = std::min(numFrames, static_cast<size_t>(config_.chunkFrames) - pendingFrames_);
+        std::memcpy(pending_.data() + pendingFrames_ * bands, frames, take * bands * sizeof(float));
+        pendingFrames_ += take;
+        frames += take * bands;
+        numFrames -= take;
+        if (pendingFrames_ == static_cast<size_t>(config_.chunkFrames) && !flushChunk()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool MelArchiveWriter::flushChunk() {
+    if (pendingFrames_ == 0) {
+        return true;
+    }
+
+    const size_t bands = static_cast<size_t>(config_.numMelBands);
+    const size_t frames = pendingFrames_;
+    const size_t count = frames * bands;
+    const uint32_t maxLevel = (1u << config_.bitDepth) - 1;
+
+    // Per-chunk range; non-finite values are pinned to the ends of it
+    float minValue = INFINITY;
+    float maxValue = -INFINITY;
+    for (size_t i = 0; i < count; ++i) {
+        if (std::isfinite(pending_[i])) {
+            minValue = std::min(minValue, pending_[i]);
+            maxValue = std::max(maxValue, pending_[i]);
+        }
+    }
+    if (minValue > maxValue) {
+        minValue = maxValue = 0.0f;
+    }
+    // Anything below the floor quantizes to level 0, i.e. to the floor
+    if (config_.dynamicRangeDb > 0.0f) {
+        minValue = std::max(minValue, maxValue - config_.dynamicRangeDb);
+    }
+    float step = (maxValue - minValue) / maxLevel;
+    if (!(step > 0.0f) || !std::isfinite(step)) {
+        step = 0.0f;
+    }
+
+    // Quantize; levels_ is frame-major like the bit stream
+    for (size_t i = 0; i < count; ++i) {
+        int32_t level = 0;
+        if (step > 0.0f) {
+            float scaled = std::isnan(pending_[i]) ? 0.0f : (pending_[i] - minValue) / step;
+            scaled = std::min(std::max(scaled, 0.0f), static_cast<float>(maxLevel));
+            level = static_cast<int32_t>(std::lround(scaled));
+        }
+        levels_[i] = level;
+    }
+
+    // Per band, keep the time predictor with the smallest residuals, then size its Rice parameter
+    encodeBuffer_.assign(CHUNK_HEADER_SIZE, 0);
+    for (size_t b = 0; b < bands; ++b) {
+        uint64_t bestSum = UINT64_MAX;
+        uint32_t bestPredictor = PREDICT_PREVIOUS;
+        for (uint32_t predictor = PREDICT_PREVIOUS; predictor <= PREDICT_MEAN; ++predictor) {
+            uint64_t sum = 0;
+            for (size_t f = 0; f < frames; ++f) {
+                sum += zigzag(levels_[f * bands + b] - predict(levels_.data() + b, bands, f, predictor));
+            }
+            if (sum < bestSum) {
+                bestSum = sum;
+                bestPredictor = predictor;
+            }
+        }
+
+        uint32_t k = 0;
+        while (k < 16 && (static_cast<uint64_t>(frames) << (k + 1)) <= bestSum) {
+            k++;
+        }
+        encodeBuffer_.push_back(static_cast<uint8_t>(k | (bestPredictor << 5)));
+    }
+
+    BitWriter bits(encodeBuffer_);
+    const int rawBits = config_.bitDepth + 2;
+    for (size_t f = 0; f < frames; ++f) {
+        for (size_t b = 0; b < bands; ++b) {
+            const uint8_t coding = encodeBuffer_[CHUNK_HEADER_SIZE + b];
+            const uint32_t k = coding & 0x1F;
+            const uint32_t symbol = zigzag(levels_[f * bands + b] -
+                                           predict(levels_.data() + b, bands, f, coding >> 5));
+            const uint32_t quotient = symbol >> k;
+            if (quotient < RICE_ESCAPE) {
+                bits.putOnes(quotient);
+                bits.put(0, 1);
+                bits.put(symbol, static_cast<int>(k));
+            } else {
+                bits.putOnes(RICE_ESCAPE);
+                bits.put(symbol, rawBits);
+            }
+        }
+    }
+    bits.finish();
+
+    const size_t payloadBytes = encodeBuffer_.size() - CHUNK_HEADER_SIZE;
+    encodeBuffer_.resize(align8(encodeBuffer_.size()), 0);
+
+    uint8_t* header = encodeBuffer_.data();
+    std::memcpy(header, "MCHK", 4);
+    putU32(header + 4, static_cast<uint32_t>(frames));
+    putU64(header + 8, framesWritten_);
+    putF32(header + 16, minValue);
+    putF32(header + 20, step);
+    putU32(header + 24, static_cast<uint32_t>(payloadBytes));
+
+    indexFrames_.push_back(framesWritten_);
+    indexOffsets_.push_back(offset_);
+    if (!write(encodeBuffer_.data(), encodeBuffer_.size())) {
+        return false;
+    }
+    // Each completed chunk reaches the OS, so an unclosed file is still recoverable
+    std::fflush(file_);
+
+    framesWritten_ += frames;
+    pendingFrames_ = 0;
+    return true;
+}
+
+bool MelArchiveWriter::close() {
+    if (!file_) {
+        return false;
+    }
+
+    bool ok = flushChunk();
+    if (ok) {
+        const uint64_t indexOffset = offset_;
+        std::vector<uint8_t> footer(indexFrames_.size() * INDEX_ENTRY_SIZE + TRAILER_SIZE, 0);
+        for (size_t i = 0; i < indexFrames_.size(); ++i) {
+            putU64(footer.data() + i * INDEX_ENTRY_SIZE, indexFrames_[i]);
+            putU64(footer.data() + i * INDEX_ENTRY_SIZE + 8, indexOffsets_[i]);
+        }
+        uint8_t* trailer = footer.data() + indexFrames_.size() * INDEX_ENTRY_SIZE;
+        std::memcpy(trailer, "MIDX", 4);
+        putU32(trailer + 4, static_cast<uint32_t>(indexFrames_.size()));
+        putU64(trailer + 8, indexOffset);
+        putU64(trailer + 16, framesWritten_);
+        ok = write(footer.data(), footer.size());
+    }
+
+    if (std::fclose(file_) != 0 && ok) {
+        ok = fail("Close failed");
+    }
+    file_ = nullptr;
+    return ok;
+}
+
+// MelArchiveReader
+
+MelArchiveReader::MelArchiveReader()
+    : numFrames_(0), recovered_(false), cachedChunk_(static_cast<size_t>(-1)) {
+}
+
+bool MelArchiveReader::fail(const std::string& message) {
+    close();
+    error_ = message;
+    return false;
+}
+
+void MelArchiveReader::close() {
+    file_.close();
+    config_ = MelArchiveConfig{};
+    numFrames_ = 0;
+    recovered_ = false;
+    chunkFrames_.clear();
+    chunkOffsets_.clear();
+    cachedChunk_ = static_cast<size_t>(-1);
+}
+
+bool MelArchiveReader::open(const std::string& path) {
+    close();
+    error_.clear();
+    if (!file_.open(path)) {
+        return fail(file_.getError());
+    }
+
+    const uint8_t* data = file_.data();
+    const size_t size = file_.size();
+    if (size < FILE_HEADER_SIZE || std::memcmp(data, "MELA", 4) != 0) {
+        return fail("Not a mel archive");
+    }
+    if (getU32(data + 4) != MEL_ARCHIVE_VERSION) {
+        return fail("Unsupported archive version");
+    }
+    config_.numMelBands = static_cast<int>(getU32(data + 8));
+    config_.chunkFrames = static_cast<int>(getU32(data + 12));
+    config_.bitDepth = static_cast<int>(getU32(data + 16));
+    config_.sampleRate = static_cast<int>(getU32(data + 20));
+    config_.hopSize = static_cast<int>(getU32(data + 24));
+    config_.startTimeUs = static_cast<int64_t>(getU64(data + 32));
+    if (config_.numMelBands <= 0 || config_.chunkFrames <= 0 || config_.bitDepth < 1 || config_.bitDepth > 16 ||
+        config_.sampleRate <= 0 || config_.hopSize <= 0) {
+        return fail("Corrupt archive header");
+    }
+
+    if (size >= FILE_HEADER_SIZE + TRAILER_SIZE) {
+        const uint8_t* trailer = data + size - TRAILER_SIZE;
+        const uint64_t numChunks = getU32(trailer + 4);
+        const uint64_t indexOffset = getU64(trailer + 8);
+        if (std::memcmp(trailer, "MIDX", 4) == 0 && indexOffset >= FILE_HEADER_SIZE &&
+            indexOffset + numChunks * INDEX_ENTRY_SIZE == size - TRAILER_SIZE &&
+            readIndex(static_cast<size_t>(indexOffset), numChunks, getU64(trailer + 16))) {
+            return true;
+        }
+        chunkFrames_.clear();
+        chunkOffsets_.clear();
+        numFrames_ = 0;
+    }
+
+    // No usable trailer: the writer did not close, or the index is damaged, so
+    // rebuild the index from the chunk headers
+    recovered_ = true;
+    return scanChunks(FILE_HEADER_SIZE);
+}
+
+bool MelArchiveReader::readIndex(size_t indexOffset, uint64_t numChunks, uint64_t totalFrames) {
+    // Every entry has to name a whole chunk in the data section whose header agrees
+    // with it, the chunks following on from frame 0, so reads can trust the index
+    const uint8_t* data = file_.data();
+    for (uint64_t i = 0; i < numChunks; ++i) {
+        const uint64_t firstFrame = getU64(data + indexOffset + i * INDEX_ENTRY_SIZE);
+        const uint64_t offset = getU64(data + indexOffset + i * INDEX_ENTRY_SIZE + 8);
+        if (firstFrame != numFrames_ || offset < FILE_HEADER_SIZE || offset > indexOffset ||
+            indexOffset - offset < CHUNK_HEADER_SIZE) {
+            return false;
+        }
+        const uint8_t* header = data + offset;
+        const uint64_t frames = getU32(header + 4);
+        if (std::memcmp(header, "MCHK", 4) != 0 || getU64(header + 8) != firstFrame || frames == 0 ||
+            frames > static_cast<uint64_t>(config_.chunkFrames) ||
+            align8(CHUNK_HEADER_SIZE + getU32(header + 24)) > indexOffset - offset) {
+            return false;
+        }
+        chunkFrames_.push_back(firstFrame);
+        chunkOffsets_.push_back(offset);
+        numFrames_ += frames;
+    }
+    return numFrames_ == totalFrames;
+}
+
+bool MelArchiveReader::scanChunks(size_t offset) {
+    const uint8_t* data = file_.data();
+    const size_t size = file_.size();
+    while (offset + CHUNK_HEADER_SIZE <= size && std::memcmp(data + offset, "MCHK", 4) == 0) {
+        const uint64_t frames = getU32(data + offset + 4);
+        const uint64_t firstFrame = getU64(data + offset + 8);
+        const size_t chunkSize = align8(CHUNK_HEADER_SIZE + getU32(data + offset + 24));
+        if (offset + chunkSize > size || frames == 0 || firstFrame != numFrames_) {
+            break;  // Torn final chunk
+        }
+        chunkFrames_.push_back(firstFrame);
+        chunkOffsets_.push_back(offset);
+        numFrames_ = firstFrame + frames;
+        offset += chunkSize;
+    }
+    return true;
+}
+
+bool MelArchiveReader::decodeChunk(size_t chunk) {
+    if (chunk == cachedChunk_) {
+        return true;
+    }
+
+    const uint8_t* data = file_.data();
+    const size_t size = file_.size();
+    const size_t offset = static_cast<size_t>(chunkOffsets_[chunk]);
+    const size_t bands = static_cast<size_t>(config_.numMelBands);
+    if (offset + CHUNK_HEADER_SIZE > size || std::memcmp(data + offset, "MCHK", 4) != 0) {
+        error_ = "Corrupt chunk header";
+        return false;
+    }
+
+    const uint8_t* header = data + offset;
+    const size_t frames = getU32(header + 4);
+    const float minValue = getF32(header + 16);
+    const float step = getF32(header + 20);
+    const size_t payloadBytes = getU32(header + 24);
+    if (frames == 0 || frames > static_cast<size_t>(config_.chunkFrames) ||
+        payloadBytes < bands || offset + CHUNK_HEADER_SIZE + payloadBytes > size) {
+        error_ = "Corrupt chunk header";
+        return false;
+    }
+
+    const uint8_t* riceK = header + CHUNK_HEADER_SIZE;
+    BitReader bits(riceK + bands, payloadBytes - bands);
+    const int rawBits = config_.bitDepth + 2;
+
+    // The cache is overwritten from here on, so it holds no chunk until this one decodes
+    cachedChunk_ = static_cast<size_t>(-1);
+    cache_.resize(frames * bands);
+    levels_.resize(frames * bands);
+    for (size_t b = 0; b < bands; ++b) {
+        const uint32_t predictor = riceK[b] >> 5;
+        if ((riceK[b] & 0x1F) > 16 || predictor < PREDICT_PREVIOUS || predictor > PREDICT_MEAN) {
+            error_ = "Corrupt chunk coding parameters";
+            return false;
+        }
+    }
+    for (size_t f = 0; f < frames; ++f) {
+        for (size_t b = 0; b < bands; ++b) {
+            const uint32_t k = riceK[b] & 0x1F;
+            const uint32_t quotient = bits.unary(RICE_ESCAPE);
+            const uint32_t symbol = quotient < RICE_ESCAPE
+                ? (quotient << k) | bits.get(static_cast<int>(k))
+                : bits.get(rawBits);
+            const int32_t residual = static_cast<int32_t>(symbol >> 1) ^ -static_cast<int32_t>(symbol & 1);
+            const int32_t level = predict(levels_.data() + b, bands, f, riceK[b] >> 5) + residual;
+            levels_[f * bands + b] = level;
+            cache_[f * bands + b] = minValue + step * level;
+        }
+    }
+    if (bits.overrun()) {
+        error_ = "Truncated chunk payload";
+        return false;
+    }
+
+    cachedChunk_ = chunk;
+    return true;
+}
+
+uint64_t MelArchiveReader::frameAtTime(double seconds) const {
+    if (seconds <= 0.0) {
+        return 0;
+    }
+    return static_cast<uint64_t>(seconds * config_.sampleRate / config_.hopSize);
+}
+
+long MelArchiveReader::readFrames(uint64_t firstFrame, size_t count, float* output) {
+    if (!isOpen() || output == nullptr || firstFrame >= numFrames_) {
+        return 0;
+    }
+
+    const size_t bands = static_cast<size_t>(config_.numMelBands);
+    const uint64_t endFrame = std::min<uint64_t>(firstFrame + count, numFrames_);
+
+    // Last chunk starting at or before firstFrame
+    size_t chunk = static_cast<size_t>(
+        std::upper_bound(chunkFrames_.begin(), chunkFrames_.end(), firstFrame) - chunkFrames_.begin()) - 1;
+    uint64_t frame = firstFrame;
+    while (frame < endFrame) {
+        if (!decodeChunk(chunk)) {
+            return -1;
+        }
+        const uint64_t chunkStart = chunkFrames_[chunk];
+        const uint64_t chunkEnd = chunkStart + cache_.size() / bands;
+        const uint64_t copyEnd = std::min(chunkEnd, endFrame);
+        std::memcpy(output + (frame - firstFrame) * bands, cache_.data() + (frame - chunkStart) * bands,
+                    static_cast<size_t>(copyEnd - frame) * bands * sizeof(float));
+        frame = copyEnd;
+        chunk++;
+    }
+    return static_cast<long>(endFrame - firstFrame);
+}
+
+long MelArchiveReader::readTimeRange(double startSeconds, double endSeconds, std::vector<float>& output) {
+    const uint64_t first = frameAtTime(startSeconds);
+    const uint64_t end = std::min<uint64_t>(
+        static_cast<uint64_t>(std::ceil(std::max(endSeconds, 0.0) * config_.sampleRate / config_.hopSize)), numFrames_);
+    if (end <= first) {
+        output.clear();
+        return 0;
+    }
+    output.resize(static_cast<size_t>(end - first) * config_.numMelBands);
+    const long frames = readFrames(first, static_cast<size_t>(end - first), output.data());
+    output.resize(frames > 0 ? static_cast<size_t>(frames) * config_.numMelBands : 0);
+    return frames;
+}
+
+} // namespace melspectrogram
@@ -0,0 +1,98 @@
+#include "mel_frame_ring.h"
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+namespace melspectrogram {
+
+static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t) &&
+              sizeof(std::atomic<uint32_t>) == sizeof(uint32_t),
+              "Ring header atomics must have plain integer layout");
+static_assert(sizeof(MelFrameRingHeader) == 64, "Ring header layout changed");
+
+namespace {
+    constexpr size_t ALIGNMENT = 64;
+
+    size_t alignUp(size_t value) {
+        return (value + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+    }
+}
+
+MelFrameRing::MelFrameRing(int numMelBands, int capacity) : nextFrame_(0) {
+    const uint32_t bands = static_cast<uint32_t>(std::max(1, numMelBands));
+    const uint32_t slots = static_cast<uint32_t>(std::max(2, capacity));
+    const size_t frameStride = alignUp(bands * sizeof(float));
+    const size_t dataOffset = alignUp(sizeof(MelFrameRingHeader));
+
+    size_ = dataOffset + frameStride * slots;
+    storage_.assign(size_ + ALIGNMENT - 1, 0);
+    const uintptr_t raw = reinterpret_cast<uintptr_t>(storage_.data());
+    base_ = storage_.data() + (alignUp(raw) - raw);
+
+    header_ = new (base_) MelFrameRingHeader();
+    header_->magic = MEL_FRAME_RING_MAGIC;
+    header_->version = MEL_FRAME_RING_VERSION;
+    header_->capacity = slots;
+    header_->numMelBands = bands;
+    header_->frameStride = static_cast<uint32_t>(frameStride);
+    header_->dataOffset = static_cast<uint32_t>(dataOffset);
+    header_->sequence.store(0, std::memory_order_relaxed);
+    header_->writeSequence.store(0, std::memory_order_relaxed);
+    header_->writeIndex.store(0, std::memory_order_release);
+}
+
+float* MelFrameRing::slot(uint64_t index) const {
+    const size_t offset = header_->dataOffset + (index % header_->capacity) * header_->frameStride;
+    return reinterpret_cast<float*>(base_ + offset);
+}
+
+void MelFrameRing::publish(const float* frame) {
+    std::memcpy(beginWrite(), frame, header_->numMelBands * sizeof(float));
+    commitWrite();
+}
+
+float* MelFrameRing::beginWrite() {
+    // Announce the overwrite before touching the slot, so a reader that sees
+    // any of the new data also sees the bumped writeSequence after its fence
+    header_->writeSequence.store(nextFrame_ + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    return slot(nextFrame_);
+}
+
+void MelFrameRing::commitWrite() {
+    nextFrame_++;
+    header_->writeIndex.store(static_cast<uint32_t>(nextFrame_ % header_->capacity), std::memory_order_relaxed);
+    header_->sequence.store(nextFrame_, std::memory_order_release);
+}
+
+uint64_t MelFrameRing::getSequence() const {
+    return header_->sequence.load(std::memory_order_acquire);
+}
+
+bool MelFrameRing::readFrame(uint64_t index, float* output) const {
+    const uint64_t published = header_->sequence.load(std::memory_order_acquire);
+    if (index >= published || published - index > header_->capacity) {
+        return false;
+    }
+
+    std::memcpy(output, slot(index), header_->numMelBands * sizeof(float));
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return header_->writeSequence.load(std::memory_order_relaxed) <= index + header_->capacity;
+}
+
+int64_t MelFrameRing::readLatest(float* output) const {
+    // Only fails if the writer laps the reader mid-copy, so a couple of retries suffice
+    for (int attempt = 0; attempt < 3; ++attempt) {
+        const uint64_t published = getSequence();
+        if (published == 0) {
+            return -1;
+        }
+        if (readFrame(published - 1, output)) {
+            return static_cast<int64_t>(published - 1);
+        }
+    }
+    return -1;
+}
+
+} // namespace melspectrogram
@@ -0,0 +1,145 @@
+#include "mel_history_pyramid.h"
+#include <algorithm>
+#include <cstring>
+
+namespace melspectrogram {
+
+namespace {
+    int64_t floorShift(int64_t value, int shift) {
+        // Right-shifting negative values is implementation-defined, so floor explicitly
+        return value >= 0 ? (value >> shift) : -((-value + (int64_t(1) << shift) - 1) >> shift);
+    }
+
+    int64_t ceilShift(int64_t value, int shift) {
+        return -floorShift(-value, shift);
+    }
+}
+
+MelHistoryPyramid::MelHistoryPyramid(int numMelBands, int levelCapacity, int numLevels,
+                                     PoolingMode pooling)
+    : numMelBands_(std::max(1, numMelBands)), levelCapacity_(std::max(1, levelCapacity)),
+      numLevels_(std::max(1, std::min(numLevels, 62))), pooling_(pooling), totalColumns_(0) {
+
+    levels_.resize(numLevels_);
+    for (auto& level : levels_) {
+        level.columns.resize(static_cast<size_t>(levelCapacity_) * numMelBands_, 0.0f);
+        level.pending.resize(numMelBands_, 0.0f);
+    }
+}
+
+bool MelHistoryPyramid::pushColumn(const float* melData, int numBands) {
+    if (melData == nullptr || numBands != numMelBands_) {
+        return false;
+    }
+
+    appendToLevel(0, melData);
+    totalColumns_++;
+    return true;
+}
+
+void MelHistoryPyramid::appendToLevel(int levelIndex, const float* column) {
+    Level& level = levels_[levelIndex];
+
+    const size_t slot = static_cast<size_t>(level.count % levelCapacity_);
+    std::memcpy(level.columns.data() + slot * numMelBands_, column, numMelBands_ * sizeof(float));
+    level.count++;
+
+    if (levelIndex + 1 >= numLevels_) {
+        return;
+    }
+
+    // Pool pairs of columns into the next level
+    float* pending = level.pending.data();
+    if (level.pendingCount == 0) {
+        std::memcpy(pending, column, numMelBands_ * sizeof(float));
+        level.pendingCount = 1;
+        return;
+    }
+
+    if (pooling_ == PoolingMode::MAX) {
+        for (int band = 0; band < numMelBands_; ++band) {
+            pending[band] = std::max(pending[band], column[band]);
+        }
+    } else {
+        for (int band = 0; band < numMelBands_; ++band) {
+            pending[band] = 0.5f * (pending[band] + column[band]);
+        }
+    }
+    level.pendingCount = 0;
+
+    appendToLevel(levelIndex + 1, pending);
+}
+
+int MelHistoryPyramid::extractRange(int level, int64_t startColumn, int64_t endColumn,
+                                    float* output, int maxColumns, float fillValue) const {
+    if (level < 0 || level >= numLevels_ || output == nullptr || maxColumns < 0 ||
+        endColumn < startColumn) {
+        return -1;
+    }
+
+    const Level& lod = levels_[level];
+    const int64_t first = floorShift(startColumn, level);
+    const int64_t last = ceilShift(endColumn, level);
+    const int count = static_cast<int>(std::min<int64_t>(last - first, maxColumns));
+    const int64_t oldest = std::max<int64_t>(0, lod.count - levelCapacity_);
+
+    for (int i = 0; i < count; ++i) {
+        const int64_t k = first + i;
+        float* dst = output + static_cast<size_t>(i) * numMelBands_;
+        if (k >= oldest && k < lod.count) {
+            const size_t slot = static_cast<size_t>(k % levelCapacity_);
+            std::memcpy(dst, lod.columns.data() + slot * numMelBands_, numMelBands_ * sizeof(float));
+        } else {
+            std::fill(dst, dst + numMelBands_, fillValue);
+        }
+    }
+
+    return count;
+}
+
+int MelHistoryPyramid::selectLevel(int64_t spanColumns, int maxColumns) const {
+    if (maxColumns <= 0) {
+        return numLevels_ - 1;
+    }
+
+    for (int level = 0; level < numLevels_; ++level) {
+        if (ceilShift(spanColumns, level) <= maxColumns) {
+            return level;
+        }
+    }
+    return numLevels_ - 1;
+}
+
+int64_t MelHistoryPyramid::getOldestColumn(int level) const {
+    if (level < 0 || level >= numLevels_) {
+        return 0;
+    }
+    const int64_t oldest = std::max<int64_t>(0, levels_[level].count - levelCapacity_);
+    return oldest << level;
+}
+
+int64_t MelHistoryPyramid::getLevelColumns(int level) const {
+    if (level < 0 || level >= numLevels_) {
+        return 0;
+    }
+    return levels_[level].count;
+}
+
+size_t MelHistoryPyramid::getMemoryFootprint() const {
+    size_t bytes = 0;
+    for (const auto& level : levels_) {
+        bytes += level.columns.size() * sizeof(float) + level.pending.size() * sizeof(float);
+    }
+    return bytes;
+}
+
+void MelHistoryPyramid::clear() {
+    totalColumns_ = 0;
+    for (auto& level : levels_) {
+        std::fill(level.columns.begin(), level.columns.end(), 0.0f);
+        level.count = 0;
+        level.pendingCount = 0;
+    }
+}
+
+} // namespace melspectrogram
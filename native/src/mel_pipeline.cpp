@@ -0,0 +1,69 @@
+#include "mel_pipeline.h"
+#include <new>
+
+namespace melspectrogram {
+
+namespace {
+    template <class Pipeline>
+    std::unique_ptr<MelPipelineBase> makePipeline() {
+        return std::unique_ptr<MelPipelineBase>(new Pipeline());
+    }
+
+    template <class Pipeline>
+    MelPipelineBase* constructPipeline(void* storage) {
+        return new (storage) Pipeline();
+    }
+
+    struct PipelineRegistration {
+        int sampleRate;
+        int frameSize;
+        int numMelBands;
+        float minFreq;
+        float maxFreq;
+        std::unique_ptr<MelPipelineBase> (*create)();
+        size_t size;
+        MelPipelineBase* (*construct)(void*);
+    };
+
+    // Configurations with a compile-time pipeline; everything else runs on MelPlan
+    const PipelineRegistration PIPELINES[] = {
+        {32000, 1024, 64, 20.0f, 8000.0f, &makePipeline<MelPipeline<32000, 1024, 64>>,
+         sizeof(MelPipeline<32000, 1024, 64>), &constructPipeline<MelPipeline<32000, 1024, 64>>},
+        {16000, 512, 40, 20.0f, 8000.0f, &makePipeline<MelPipeline<16000, 512, 40>>,
+         sizeof(MelPipeline<16000, 512, 40>), &constructPipeline<MelPipeline<16000, 512, 40>>},
+        {48000, 2048, 128, 20.0f, 8000.0f, &makePipeline<MelPipeline<48000, 2048, 128>>,
+         sizeof(MelPipeline<48000, 2048, 128>), &constructPipeline<MelPipeline<48000, 2048, 128>>},
+    };
+
+    const PipelineRegistration* findPipeline(const AudioConfig& config) {
+        for (const PipelineRegistration& entry : PIPELINES) {
+            if (entry.sampleRate == config.sampleRate && entry.frameSize == config.frameSize &&
+                entry.numMelBands == config.numMelBands && entry.minFreq == config.minFreq &&
+                entry.maxFreq == config.maxFreq) {
+                return &entry;
+            }
+        }
+        return nullptr;
+    }
+}
+
+std::unique_ptr<MelPipelineBase> createMelPipeline(const AudioConfig& config) {
+    const PipelineRegistration* entry = findPipeline(config);
+    return entry ? entry->create() : nullptr;
+}
+
+bool hasMelPipeline(const AudioConfig& config) {
+    return findPipeline(config) != nullptr;
+}
+
+size_t getMelPipelineSize(const AudioConfig& config) {
+    const PipelineRegistration* entry = findPipeline(config);
+    return entry ? entry->size : 0;
+}
+
+MelPipelineBase* createMelPipeline(const AudioConfig& config, void* storage) {
+    const PipelineRegistration* entry = findPipeline(config);
+    return entry ? entry->construct(storage) : nullptr;
+}
+
+} // namespace melspectrogram
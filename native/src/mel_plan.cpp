@@ -0,0 +1,222 @@
+#include "mel_plan.h"
+#include "plan_cache.h"
+#include "kiss_fft.h"
+#include <cmath>
+#include <algorithm>
+#include <tuple>
+
+namespace melspectrogram {
+
+namespace {
+    constexpr float PI = 3.14159265359f;
+    constexpr float MIN_LOG_VALUE = 1e-10f;
+
+    using PlanKey = std::tuple<int, int, int, float, float>;
+
+    // hopSize only frames the input, so streams that differ in it share a plan
+    PlanKey keyFor(const AudioConfig& config) {
+        return PlanKey(config.sampleRate, config.frameSize, config.numMelBands, config.minFreq, config.maxFreq);
+    }
+
+    float freqToMel(float freq) {
+        return 2595.0f * std::log10(1.0f + freq / 700.0f);
+    }
+
+    float melToFreq(float mel) {
+        return 700.0f * (std::pow(10.0f, mel / 2595.0f) - 1.0f);
+    }
+}
+
+void MelPlan::Scratch::resize(const MelPlan& plan, size_t batchFrames) {
+    const size_t frameSize = static_cast<size_t>(plan.getConfig().frameSize);
+    const size_t power = std::max<size_t>(batchFrames, 1) * plan.getNumBins();
+    if (!plan.isSpecialized() && fftInput.size() != frameSize) {
+        fftInput.resize(frameSize);
+        fftOutput.resize(frameSize);
+    }
+    if (this->power.size() < power) {
+        this->power.resize(power);
+    }
+    if (plan.isSpecialized() && (!pipeline || !pipeline->matches(plan.getConfig()))) {
+        pipeline = createMelPipeline(plan.getConfig());
+    }
+}
+
+MelPlan::MelPlan(const AudioConfig& config) : config_(config), specialized_(hasMelPipeline(config)) {
+    // computeFrame() and computeBatch() never touch the runtime tables of a specialized plan
+    if (!specialized_) {
+        ensureTables();
+    }
+}
+
+MelPlan::~MelPlan() {
+    if (kissFFTConfig_) {
+        kiss_fft_free(kissFFTConfig_);
+    }
+}
+
+std::shared_ptr<const MelPlan> MelPlan::acquire(const AudioConfig& config) {
+    return acquireCachedPlan<MelPlan>(keyFor(config), config);
+}
+
+void MelPlan::buildTables() const {
+    kissFFTConfig_ = kiss_fft_alloc(config_.frameSize, 0, nullptr, nullptr);
+    createWindow();
+    createFilterBank();
+}
+
+void MelPlan::windowFrame(const int16_t* input, std::complex<float>* fftInput) const {
+    conditionFrame(input, config_.frameSize, getScaledWindow(), FrontEndConfig(), nullptr, 0, fftInput);
+}
+
+void MelPlan::fft(const std::complex<float>* input, std::complex<float>* output) const {
+    ensureTables();
+    // Out-of-place kiss_fft only reads the plan, so concurrent calls are safe
+    kiss_fft(reinterpret_cast<kiss_fft_cfg>(kissFFTConfig_),
+             reinterpret_cast<const kiss_fft_cpx*>(input),
+             reinterpret_cast<kiss_fft_cpx*>(output));
+}
+
+void MelPlan::powerSpectrum(const std::complex<float>* fftOutput, float* power) const {
+    for (int i = 0; i <= config_.frameSize / 2; ++i) {
+        float real = fftOutput[i].real();
+        float imag = fftOutput[i].imag();
+        power[i] = (real * real + imag * imag) / config_.frameSize;
+    }
+}
+
+void MelPlan::applyFilterBank(const float* power, float* mel) const {
+    ensureTables();
+    for (int band = 0; band < config_.numMelBands; ++band) {
+        // Bins outside [start, end) have zero weight and would add exactly 0
+        const float* filter = getFilter(band);
+        float sum = 0.0f;
+        for (int bin = filterStart_[band]; bin < filterEnd_[band]; ++bin) {
+            sum += power[bin] * filter[bin];
+        }
+        mel[band] = sum;
+    }
+}
+
+void MelPlan::logScale(float* mel, int numBands) {
+    logScale(mel, numBands, MelOutputFormat::FLOAT32, nullptr);
+}
+
+void MelPlan::logScale(float* mel, int numBands, MelOutputFormat format, void* quantized, float* decibels) {
+    for (int i = 0; i < numBands; ++i) {
+        mel[i] = 10.0f * std::log10(std::max(mel[i], MIN_LOG_VALUE));
+    }
+    if (decibels != nullptr) {
+        std::copy(mel, mel + numBands, decibels);
+    }
+
+    // Normalize to 0-1 range
+    float minValue = *std::min_element(mel, mel + numBands);
+    float maxValue = *std::max_element(mel, mel + numBands);
+    normalizeAndQuantize(mel, static_cast<size_t>(numBands), minValue, maxValue - minValue, format, quantized);
+}
+
+void MelPlan::computeFrame(const int16_t* input, float* mel, Scratch& scratch) const {
+    scratch.resize(*this);
+    if (specialized_) {
+        // Same pipeline the processor runs for this config, so every path agrees bit for bit
+        scratch.pipeline->computeFrame(input, mel);
+        return;
+    }
+    windowFrame(input, scratch.fftInput.data());
+    fft(scratch.fftInput.data(), scratch.fftOutput.data());
+    powerSpectrum(scratch.fftOutput.data(), scratch.power.data());
+    applyFilterBank(scratch.power.data(), mel);
+    logScale(mel, config_.numMelBands);
+}
+
+void MelPlan::computeBatch(const int16_t* const* frames, size_t count, float* output, Scratch& scratch) const {
+    scratch.resize(*this, count);
+    const size_t bins = static_cast<size_t>(getNumBins());
+    const size_t bands = static_cast<size_t>(config_.numMelBands);
+
+    if (specialized_) {
+        scratch.pipeline->computeBatch(frames, count, output, scratch.power.data());
+        return;
+    }
+
+    for (size_t f = 0; f < count; ++f) {
+        windowFrame(frames[f], scratch.fftInput.data());
+        fft(scratch.fftInput.data(), scratch.fftOutput.data());
+        powerSpectrum(scratch.fftOutput.data(), scratch.power.data() + f * bins);
+    }
+
+    // Each filter row is loaded once and applied to every spectrum in the batch
+    for (size_t band = 0; band < bands; ++band) {
+        const float* filter = getFilter(static_cast<int>(band));
+        const int start = filterStart_[band];
+        const int end = filterEnd_[band];
+        for (size_t f = 0; f < count; ++f) {
+            const float* power = scratch.power.data() + f * bins;
+            float sum = 0.0f;
+            for (int bin = start; bin < end; ++bin) {
+                sum += power[bin] * filter[bin];
+            }
+            output[f * bands + band] = sum;
+        }
+    }
+
+    for (size_t f = 0; f < count; ++f) {
+        logScale(output + f * bands, config_.numMelBands);
+    }
+}
+
+void MelPlan::createWindow() const {
+    // Hann window
+    window_.resize(config_.frameSize);
+    for (int i = 0; i < config_.frameSize; ++i) {
+        window_[i] = 0.5f * (1.0f - std::cos(2.0f * PI * i / (config_.frameSize - 1)));
+    }
+    scaledWindow_.resize(config_.frameSize);
+    for (int i = 0; i < config_.frameSize; ++i) {
+        scaledWindow_[i] = window_[i] / 32768.0f;
+    }
+}
+
+void MelPlan::createFilterBank() const {
+    const int bins = getNumBins();
+    filters_.assign(static_cast<size_t>(config_.numMelBands) * bins, 0.0f);
+    filterStart_.assign(config_.numMelBands, 0);
+    filterEnd_.assign(config_.numMelBands, 0);
+
+    float minMel = freqToMel(config_.minFreq);
+    float maxMel = freqToMel(config_.maxFreq);
+
+    std::vector<float> freqPoints(config_.numMelBands + 2);
+    for (int i = 0; i < config_.numMelBands + 2; ++i) {
+        freqPoints[i] = melToFreq(minMel + (maxMel - minMel) * i / (config_.numMelBands + 1));
+    }
+
+    for (int melBand = 0; melBand < config_.numMelBands; ++melBand) {
+        float* filter = filters_.data() + static_cast<size_t>(melBand) * bins;
+        float leftFreq = freqPoints[melBand];
+        float centerFreq = freqPoints[melBand + 1];
+        float rightFreq = freqPoints[melBand + 2];
+
+        int start = bins;
+        int end = 0;
+        for (int freqBin = 0; freqBin < bins; ++freqBin) {
+            float freq = static_cast<float>(freqBin) * config_.sampleRate / config_.frameSize;
+
+            if (freq >= leftFreq && freq <= centerFreq) {
+                filter[freqBin] = (freq - leftFreq) / (centerFreq - leftFreq);
+            } else if (freq >= centerFreq && freq <= rightFreq) {
+                filter[freqBin] = (rightFreq - freq) / (rightFreq - centerFreq);
+            }
+
+            if (filter[freqBin] != 0.0f) {
+                start = std::min(start, freqBin);
+                end = freqBin + 1;
+            }
+        }
+        filterStart_[melBand] = std::min(start, end);
+        filterEnd_[melBand] = end;
+    }
+}
+
+} // namespace melspectrogram
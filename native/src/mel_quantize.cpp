@@ -0,0 +1,215 @@
+#include "mel_quantize.h"
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace melspectrogram {
+
+namespace {
+    // Smallest float that is a normal half (2^-14), as bits
+    constexpr uint32_t HALF_NORMAL_MIN = 113u << 23;
+    // 0.5f: adding it to a value below 2^-14 leaves the half subnormal mantissa in the low bits
+    constexpr uint32_t HALF_DENORM_MAGIC = ((127 - 15) + (23 - 10) + 1) << 23;
+    constexpr uint32_t HALF_REBIAS = static_cast<uint32_t>(15 - 127) << 23;
+
+    uint32_t floatBits(float value) {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+
+    float bitsFloat(uint32_t bits) {
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    // NaN and negatives to 0, above 1 to 1
+    float clampUnit(float x) {
+        x = x > 0.0f ? x : 0.0f;
+        return x < 1.0f ? x : 1.0f;
+    }
+
+    uint8_t unitToByte(float x) {
+        return static_cast<uint8_t>(clampUnit(x) * 255.0f + 0.5f);
+    }
+
+#if defined(__SSE2__)
+    // x already clamped to 0-1, so only the normal and subnormal half cases remain
+    __m128i unitToHalf(__m128 x) {
+        const __m128i bits = _mm_castps_si128(x);
+        const __m128i magic = _mm_set1_epi32(static_cast<int>(HALF_DENORM_MAGIC));
+        const __m128i subnormal = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(x, _mm_castsi128_ps(magic))), magic);
+
+        const __m128i odd = _mm_and_si128(_mm_srli_epi32(bits, 13), _mm_set1_epi32(1));
+        __m128i normal = _mm_add_epi32(bits, _mm_set1_epi32(static_cast<int>(HALF_REBIAS + 0xfff)));
+        normal = _mm_srli_epi32(_mm_add_epi32(normal, odd), 13);
+
+        const __m128i isSubnormal = _mm_cmplt_epi32(bits, _mm_set1_epi32(static_cast<int>(HALF_NORMAL_MIN)));
+        return _mm_or_si128(_mm_and_si128(isSubnormal, subnormal), _mm_andnot_si128(isSubnormal, normal));
+    }
+
+    // Quantize four normalized lanes to the output; x is clamped here
+    void storeQuantized(__m128 x, MelOutputFormat format, void* output, size_t i) {
+        x = _mm_min_ps(_mm_max_ps(x, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+        if (format == MelOutputFormat::UINT8) {
+            const __m128i q = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(255.0f)), _mm_set1_ps(0.5f)));
+            const __m128i packed = _mm_packus_epi16(_mm_packs_epi32(q, q), _mm_setzero_si128());
+            const int32_t bytes = _mm_cvtsi128_si32(packed);
+            std::memcpy(static_cast<uint8_t*>(output) + i, &bytes, 4);
+        } else {
+            const __m128i h = unitToHalf(x);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(static_cast<uint16_t*>(output) + i), _mm_packs_epi32(h, h));
+        }
+    }
+#elif defined(__ARM_NEON)
+    void storeQuantized(float32x4_t x, MelOutputFormat format, void* output, size_t i) {
+        const float32x4_t zero = vdupq_n_f32(0.0f);
+        // vmaxq would keep NaN; select against a compare instead
+        x = vminq_f32(vbslq_f32(vcgtq_f32(x, zero), x, zero), vdupq_n_f32(1.0f));
+        if (format == MelOutputFormat::UINT8) {
+            const uint32x4_t q = vcvtq_u32_f32(vmlaq_f32(vdupq_n_f32(0.5f), x, vdupq_n_f32(255.0f)));
+            const uint16x4_t narrow = vmovn_u32(q);
+            const uint8x8_t bytes = vmovn_u16(vcombine_u16(narrow, narrow));
+            vst1_lane_u32(reinterpret_cast<uint32_t*>(static_cast<uint8_t*>(output) + i),
+                          vreinterpret_u32_u8(bytes), 0);
+        } else {
+#if defined(__aarch64__)
+            vst1_u16(static_cast<uint16_t*>(output) + i, vreinterpret_u16_f16(vcvt_f16_f32(x)));
+#else
+            float lanes[4];
+            vst1q_f32(lanes, x);
+            for (int k = 0; k < 4; ++k) {
+                static_cast<uint16_t*>(output)[i + k] = floatToHalf(lanes[k]);
+            }
+#endif
+        }
+    }
+#endif
+
+    void storeQuantized(float x, MelOutputFormat format, void* output, size_t i) {
+        if (format == MelOutputFormat::UINT8) {
+            static_cast<uint8_t*>(output)[i] = unitToByte(x);
+        } else {
+            static_cast<uint16_t*>(output)[i] = floatToHalf(clampUnit(x));
+        }
+    }
+}
+
+uint16_t floatToHalf(float value) {
+    uint32_t bits = floatBits(value);
+    const uint32_t sign = bits & 0x80000000u;
+    bits ^= sign;
+
+    uint32_t half;
+    if (bits >= (127u + 16u) << 23) {
+        // Too large for a half: infinity, or a quiet NaN
+        half = bits > (255u << 23) ? 0x7e00u : 0x7c00u;
+    } else if (bits < HALF_NORMAL_MIN) {
+        half = floatBits(bitsFloat(bits) + bitsFloat(HALF_DENORM_MAGIC)) - HALF_DENORM_MAGIC;
+    } else {
+        const uint32_t odd = (bits >> 13) & 1u;
+        bits += HALF_REBIAS + 0xfffu;
+        bits += odd;
+        half = bits >> 13;
+    }
+    return static_cast<uint16_t>(half | (sign >> 16));
+}
+
+float halfToFloat(uint16_t half) {
+    const uint32_t sign = static_cast<uint32_t>(half & 0x8000u) << 16;
+    const uint32_t exponent = (half >> 10) & 0x1fu;
+    const uint32_t mantissa = half & 0x3ffu;
+
+    if (exponent == 0) {
+        const float magnitude = static_cast<float>(mantissa) * 5.9604645e-8f;  // 2^-24
+        return sign ? -magnitude : magnitude;
+    }
+    if (exponent == 31) {
+        return bitsFloat(sign | 0x7f800000u | (mantissa << 13));
+    }
+    return bitsFloat(sign | ((exponent + 112u) << 23) | (mantissa << 13));
+}
+
+void normalizeAndQuantize(float* values, size_t count, float minValue, float range,
+                          MelOutputFormat format, void* output) {
+    const bool quantize = format != MelOutputFormat::FLOAT32 && output != nullptr;
+    if (!(range > 0.0f)) {
+        if (quantize) {
+            std::memset(output, 0, count * melOutputBytesPerBand(format));
+        }
+        return;
+    }
+
+    size_t i = 0;
+#if defined(__SSE2__)
+    const __m128 vMin = _mm_set1_ps(minValue);
+    const __m128 vRange = _mm_set1_ps(range);
+    for (; i + 4 <= count; i += 4) {
+        const __m128 x = _mm_div_ps(_mm_sub_ps(_mm_loadu_ps(values + i), vMin), vRange);
+        _mm_storeu_ps(values + i, x);
+        if (quantize) {
+            storeQuantized(x, format, output, i);
+        }
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    const float32x4_t vMin = vdupq_n_f32(minValue);
+    const float32x4_t vRange = vdupq_n_f32(range);
+    for (; i + 4 <= count; i += 4) {
+        const float32x4_t x = vdivq_f32(vsubq_f32(vld1q_f32(values + i), vMin), vRange);
+        vst1q_f32(values + i, x);
+        if (quantize) {
+            storeQuantized(x, format, output, i);
+        }
+    }
+#endif
+    for (; i < count; ++i) {
+        values[i] = (values[i] - minValue) / range;
+        if (quantize) {
+            storeQuantized(values[i], format, output, i);
+        }
+    }
+}
+
+void quantizeUnit(const float* values, size_t count, MelOutputFormat format, void* output) {
+    if (format == MelOutputFormat::FLOAT32) {
+        std::memcpy(output, values, count * sizeof(float));
+        return;
+    }
+
+    size_t i = 0;
+#if defined(__SSE2__)
+    for (; i + 4 <= count; i += 4) {
+        storeQuantized(_mm_loadu_ps(values + i), format, output, i);
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 4 <= count; i += 4) {
+        storeQuantized(vld1q_f32(values + i), format, output, i);
+    }
+#endif
+    for (; i < count; ++i) {
+        storeQuantized(values[i], format, output, i);
+    }
+}
+
+void dequantize(const void* input, size_t count, MelOutputFormat format, float* output) {
+    if (format == MelOutputFormat::UINT8) {
+        const uint8_t* bytes = static_cast<const uint8_t*>(input);
+        for (size_t i = 0; i < count; ++i) {
+            output[i] = bytes[i] / 255.0f;
+        }
+    } else if (format == MelOutputFormat::FLOAT16) {
+        const uint16_t* halves = static_cast<const uint16_t*>(input);
+        for (size_t i = 0; i < count; ++i) {
+            output[i] = halfToFloat(halves[i]);
+        }
+    } else {
+        std::memcpy(output, input, count * sizeof(float));
+    }
+}
+
+} // namespace melspectrogram
@@ -1,5 +1,8 @@
 #include "mel_spectrogram.h"
-#include "kiss_fft.h"
+#include "mel_frame_ring.h"
+#include "mel_plan.h"
+#include "fixed_mel_plan.h"
+#include "mel_pipeline.h"
 #include <cmath>
 #include <algorithm>
 #include <chrono>
@@ -8,27 +11,24 @@
 namespace melspectrogram {
 
 namespace {
-    constexpr float PI = 3.14159265359f;
-    constexpr float MIN_LOG_VALUE = 1e-10f;
+    // Linear interpolation between band centres, from count bands to targetCount
+    void interpolateBands(const float* from, int count, float* to, int targetCount) {
+        const float scale = static_cast<float>(count) / targetCount;
+        for (int i = 0; i < targetCount; ++i) {
+            const float position = std::max(0.0f, std::min((i + 0.5f) * scale - 0.5f, static_cast<float>(count - 1)));
+            const int lower = static_cast<int>(position);
+            const int upper = std::min(lower + 1, count - 1);
+            to[i] = from[lower] + (position - lower) * (from[upper] - from[lower]);
+        }
+    }
 }
 
 MelSpectrogramProcessor::MelSpectrogramProcessor(const AudioConfig& config) 
     : config_(config) {
     
-    // Initialize buffers
-    windowFunction_.resize(config_.frameSize);
-    fftInput_.resize(config_.frameSize);
-    fftOutput_.resize(config_.frameSize);
-    powerSpectrum_.resize(config_.frameSize / 2 + 1);
-    melSpectrum_.resize(config_.numMelBands);
-    colorMappedData_.resize(config_.numMelBands * 4); // RGBA
-    
-    // Initialize FFT
-    kissFFTConfig_ = kiss_fft_alloc(config_.frameSize, 0, nullptr, nullptr);
-    
-    // Create window function and filter bank
-    createWindowFunction();
-    createMelFilterBank();
+    // Window, FFT plan and filter bank, then the buffers that plan needs
+    selectPlan();
+    allocateBuffers();
     
     // Default color map (viridis)
     colorMap_ = createViridisColorMap();
@@ -37,9 +37,7 @@ MelSpectrogramProcessor::MelSpectrogramProcessor(const AudioConfig& config)
 }
 
 MelSpectrogramProcessor::~MelSpectrogramProcessor() {
-    if (kissFFTConfig_) {
-        kiss_fft_free(kissFFTConfig_);
-    }
+    destroyPipeline();
 }
 
 bool MelSpectrogramProcessor::processAudioFrame(const int16_t* input, size_t inputSize) {
@@ -47,75 +45,445 @@ bool MelSpectrogramProcessor::processAudioFrame(const int16_t* input, size_t inp
         return false;
     }
     
+    processFrame(input);
+    return true;
+}
+
+long MelSpectrogramProcessor::processAudioSamples(const int16_t* input, size_t numSamples,
+                                                  float* output, size_t maxFrames, size_t* framesProduced,
+                                                  float* decibels) {
+    return streamSamples(input, numSamples, reinterpret_cast<uint8_t*>(output), melSpectrum_,
+                         config_.numMelBands * sizeof(float), maxFrames, framesProduced, decibels);
+}
+
+long MelSpectrogramProcessor::processAudioSamplesQuantized(const int16_t* input, size_t numSamples,
+                                                           void* output, size_t maxFrames, size_t* framesProduced) {
+    return streamSamples(input, numSamples, static_cast<uint8_t*>(output), getOutputData(),
+                         getOutputBytesPerFrame(), maxFrames, framesProduced);
+}
+
+long MelSpectrogramProcessor::processAudioSamplesMfcc(const int16_t* input, size_t numSamples,
+                                                      float* output, size_t maxFrames, size_t* framesProduced) {
+    if (!mfccPlan_) {
+        if (framesProduced) {
+            *framesProduced = 0;
+        }
+        return -1;
+    }
+    return streamSamples(input, numSamples, reinterpret_cast<uint8_t*>(output), mfcc_,
+                         mfccPlan_->getNumCoefficients() * sizeof(float), maxFrames, framesProduced);
+}
+
+long MelSpectrogramProcessor::processAudioSamplesDeltas(const int16_t* input, size_t numSamples,
+                                                        float* output, size_t maxFrames, size_t* framesProduced) {
+    if (!deltas_) {
+        if (framesProduced) {
+            *framesProduced = 0;
+        }
+        return -1;
+    }
+    return streamSamples(input, numSamples, reinterpret_cast<uint8_t*>(output), nullptr,
+                         deltas_->getFrameSize() * sizeof(float), maxFrames, framesProduced);
+}
+
+size_t MelSpectrogramProcessor::flushDeltas(float* output, size_t maxFrames) {
+    if (!deltas_ || output == nullptr) {
+        return 0;
+    }
+    const size_t frameSize = deltas_->getFrameSize();
+    size_t frames = 0;
+    while (frames < maxFrames && deltas_->drain()) {
+        deltaFrame_ = deltas_->getOutput();
+        std::copy(deltaFrame_, deltaFrame_ + frameSize, output + frames * frameSize);
+        frames++;
+    }
+    return frames;
+}
+
+long MelSpectrogramProcessor::streamSamples(const int16_t* input, size_t numSamples, uint8_t* output,
+                                            const void* frameSource, size_t frameBytes,
+                                            size_t maxFrames, size_t* framesProduced, float* decibels) {
+    if (framesProduced) {
+        *framesProduced = 0;
+    }
+    if ((input == nullptr && numSamples > 0) ||
+        config_.hopSize <= 0 || config_.hopSize > config_.frameSize) {
+        return -1;
+    }
+    if (output == nullptr) {
+        maxFrames = static_cast<size_t>(-1);
+    }
+    
+    const long frameSize = config_.frameSize;
+    const long available = static_cast<long>(numSamples);
+    
+    // Start of the next frame relative to input[0]; negative while it begins in the carry-over
+    long frameStart = -static_cast<long>(pendingSamples_);
+    size_t frames = 0;
+    
+    while (frames < maxFrames && frameStart + frameSize <= available) {
+        const int16_t* frame = input + frameStart;
+        if (frameStart < 0) {
+            const long carried = -frameStart;
+            std::copy(pendingInput_ + (pendingSamples_ - carried),
+                      pendingInput_ + pendingSamples_, straddleFrame_);
+            std::copy(input, input + (frameSize - carried), straddleFrame_ + carried);
+            frame = straddleFrame_;
+        }
+        
+        processFrame(frame);
+        frameStart += config_.hopSize;
+        // The delta stage completes no frame while its lookahead fills
+        const void* finished = frameSource != nullptr ? frameSource : deltaFrame_;
+        if (finished == nullptr) {
+            continue;
+        }
+        if (output != nullptr) {
+            const uint8_t* source = static_cast<const uint8_t*>(finished);
+            std::copy(source, source + frameBytes, output + frames * frameBytes);
+        }
+        if (decibels != nullptr) {
+            std::copy(decibels_, decibels_ + config_.numMelBands, decibels + frames * config_.numMelBands);
+        }
+        frames++;
+    }
+    
+    // Keep everything from the next frame start onwards, unless output ran out,
+    // in which case the caller resubmits input[consumed...]
+    const bool outputFull = frameStart + frameSize <= available;
+    const long consumed = outputFull ? std::max(frameStart, 0L) : available;
+    
+    if (frameStart < 0) {
+        const long carried = -frameStart;
+        std::copy(pendingInput_ + (pendingSamples_ - carried),
+                  pendingInput_ + pendingSamples_, pendingInput_);
+        std::copy(input, input + consumed, pendingInput_ + carried);
+        pendingSamples_ = static_cast<size_t>(carried + consumed);
+    } else {
+        std::copy(input + frameStart, input + std::max(consumed, frameStart), pendingInput_);
+        pendingSamples_ = static_cast<size_t>(std::max(consumed - frameStart, 0L));
+    }
+    
+    if (framesProduced) {
+        *framesProduced = frames;
+    }
+    return consumed;
+}
+
+void MelSpectrogramProcessor::resetStream() {
+    pendingSamples_ = 0;
+    frontEndState_.reset();
+    activityGate_.reset();
+    floorCached_ = false;
+    if (deltas_) {
+        deltas_->reset();
+    }
+    deltaFrame_ = nullptr;
+}
+
+void MelSpectrogramProcessor::setActivityGate(const ActivityGateConfig& config) {
+    activityGate_.setConfig(config);
+    resetStream();
+}
+
+bool MelSpectrogramProcessor::setFrontEnd(const FrontEndConfig& frontEnd) {
+    if (frontEnd.enabled() && config_.fixedPoint != 0) {
+        return false;
+    }
+    // Every float path conditions frames with the front end, so the plan stays
+    frontEnd_ = frontEnd;
+    resetStream();
+    return true;
+}
+
+void MelSpectrogramProcessor::processFrame(const int16_t* input) {
     auto startTime = std::chrono::high_resolution_clock::now();
     
-    // Convert int16 to float and apply window
-    for (int i = 0; i < config_.frameSize; ++i) {
-        fftInput_[i] = std::complex<float>(
-            input[i] * windowFunction_[i] / 32768.0f, 0.0f
-        );
+    frameCount_++;
+    if (activityGate_.getConfig().enabled) {
+        const bool active = activityGate_.update(measureActivity(input, config_.frameSize));
+        if (!active && floorCached_) {
+            // The buffers still hold the floor frame
+            stats_.skippedFrames++;
+            stats_.skipRatio = static_cast<float>(stats_.skippedFrames) / frameCount_;
+            repeatFrame(input, startTime);
+            return;
+        }
+        floorCached_ = !active;
+        stats_.skipRatio = static_cast<float>(stats_.skippedFrames) / frameCount_;
+    }
+    // Decimate computed frames only; a new floor frame is always computed
+    if (quality_.decimation > 1 && !floorCached_) {
+        const bool compute = decimationPhase_ == 0;
+        decimationPhase_ = (decimationPhase_ + 1) % quality_.decimation;
+        if (!compute) {
+            repeatFrame(input, startTime);
+            return;
+        }
     }
     
-    performFFT();
-    computePowerSpectrum();
-    applyMelFilterBank();
-    convertToLogScale();
-    applyColorMapping();
+    void* quantized = outputFormat_ == MelOutputFormat::FLOAT32 ? nullptr : quantizedSpectrum_;
+    if (reducedPlan_) {
+        computeReducedFrame(input, quantized);
+    } else if (pipeline_) {
+        pipeline_->computeFrame(input, frontEnd_, &frontEndState_, config_.hopSize, melSpectrum_,
+                                outputFormat_, quantized, decibels_);
+    } else if (fixedPlan_) {
+        // Integer pipeline end to end; produces the same normalized (and quantized) frame
+        const int blockShift = fixedPlan_->windowFrame(input, fixedInput_);
+        fixedPlan_->fft(fixedInput_, fixedOutput_);
+        const int powerShift = fixedPlan_->powerSpectrum(fixedOutput_, fixedPower_);
+        fixedPlan_->applyFilterBank(fixedPower_, fixedMel_);
+        fixedPlan_->logScale(fixedMel_, powerShift - 2 * blockShift, melSpectrum_, outputFormat_, quantized,
+                             decibels_);
+    } else {
+        // Convert, filter and window in one pass
+        conditionFrame(input, config_.frameSize, plan_->getScaledWindow(), frontEnd_, &frontEndState_,
+                       config_.hopSize, fftInput_);
+        
+        performFFT();
+        computePowerSpectrum();
+        applyMelFilterBank();
+        convertToLogScale();
+    }
+    if (mfccPlan_) {
+        mfccPlan_->compute(decibels_, mfcc_);
+    }
+    if (quality_.colorMapping) {
+        applyColorMapping();
+    }
+    finishFrame(startTime);
+}
+
+void MelSpectrogramProcessor::repeatFrame(const int16_t* input,
+                                          std::chrono::high_resolution_clock::time_point startTime) {
+    // Only the filter memory moves on
+    advanceFrontEnd(input, config_.hopSize, frontEnd_, &frontEndState_);
+    finishFrame(startTime);
+}
+
+void MelSpectrogramProcessor::computeReducedFrame(const int16_t* input, void* quantized) {
+    const MelPlan& plan = *reducedPlan_;
+    const int frameSize = plan.getConfig().frameSize;
+    const int bands = plan.getConfig().numMelBands;
+    
+    // The newest samples of the frame; the front end is run up to them on a copy of its memory
+    const int offset = config_.frameSize - frameSize;
+    FrontEndState state = frontEndState_;
+    advanceFrontEnd(input, offset, frontEnd_, &state);
+    conditionFrame(input + offset, frameSize, plan.getScaledWindow(), frontEnd_, &state, 0, reducedInput_);
+    advanceFrontEnd(input, config_.hopSize, frontEnd_, &frontEndState_);
+    
+    plan.fft(reducedInput_, reducedOutput_);
+    plan.powerSpectrum(reducedOutput_, reducedPower_);
+    plan.applyFilterBank(reducedPower_, reducedMel_);
+    MelPlan::logScale(reducedMel_, bands, MelOutputFormat::FLOAT32, nullptr, reducedDecibels_);
+    
+    // Back up to numMelBands
+    interpolateBands(reducedMel_, bands, melSpectrum_, config_.numMelBands);
+    interpolateBands(reducedDecibels_, bands, decibels_, config_.numMelBands);
+    if (quantized != nullptr) {
+        quantizeUnit(melSpectrum_, config_.numMelBands, outputFormat_, quantized);
+    }
+}
+
+void MelSpectrogramProcessor::applyQualityLevel(int level) {
+    qualityLevel_ = level;
+    quality_ = qualityLevelFor(level);
+    decimationPhase_ = 0;
+    stats_.qualityLevel = level;
+    // Runs between frames on the DSP thread: everything the level needs was built by selectPlan
+    reducedPlan_ = reducedPlans_[std::max(0, std::min(level, MAX_QUALITY_LEVEL))].get();
+}
+
+void MelSpectrogramProcessor::setQualityController(const QualityControllerConfig& config) {
+    qualityController_.setConfig(config);
+    applyQualityLevel(0);
+}
+
+void MelSpectrogramProcessor::setMfcc(const MfccConfig& config) {
+    mfccConfig_ = config;
+    mfccPlan_.reset(config.enabled ? new MfccPlan(config_.numMelBands, config) : nullptr);
+    allocateBuffers();
+    resetStream();
+}
+
+void MelSpectrogramProcessor::setDeltas(const DeltaConfig& config) {
+    deltaConfig_ = config;
+    deltas_.reset(config.enabled ? new DeltaStream(config_.numMelBands, config.window) : nullptr);
+    allocateBuffers();
+    resetStream();
+}
+
+void MelSpectrogramProcessor::setQualityLevel(int level) {
+    qualityController_.setLevel(level);
+    applyQualityLevel(qualityController_.getLevel());
+}
+
+void MelSpectrogramProcessor::finishFrame(std::chrono::high_resolution_clock::time_point startTime) {
+    if (frameRing_ != nullptr && frameRing_->getNumMelBands() == config_.numMelBands) {
+        frameRing_->publish(melSpectrum_);
+    }
+    if (deltas_) {
+        deltaFrame_ = deltas_->push(decibels_) ? deltas_->getOutput() : nullptr;
+    }
     
     // Update stats
     auto endTime = std::chrono::high_resolution_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime);
     stats_.processingTimeMs = duration.count() / 1000.0f;
     
-    frameCount_++;
+    // Between frames: a new level applies from the next one
+    const int level = qualityController_.update(stats_.processingTimeMs, getFrameDeadlineMs());
+    stats_.cpuUsage = qualityController_.getLoad();
+    stats_.deadlineMissRate = qualityController_.getMissRate();
+    if (level != qualityLevel_) {
+        applyQualityLevel(level);
+    }
+    
     if (frameCount_ % 30 == 0) { // Update FPS every 30 frames
         auto totalDuration = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - lastFrameTime_);
         stats_.fps = 30000.0f / totalDuration.count();
         lastFrameTime_ = endTime;
     }
+}
+
+void MelSpectrogramProcessor::selectPlan() {
+    plan_.reset();
+    fixedPlan_.reset();
+    reducedPlan_ = nullptr;
+    for (std::shared_ptr<const MelPlan>& reduced : reducedPlans_) {
+        reduced.reset();
+    }
+
+    if (config_.fixedPoint != 0) {
+        frontEnd_ = FrontEndConfig();  // The integer pipeline has no front end
+        fixedPlan_ = FixedMelPlan::acquire(config_);
+        return;
+    }
+    // Common configurations have compile-time tables; allocateBuffers() builds their pipeline
+    if (!hasMelPipeline(config_)) {
+        plan_ = MelPlan::acquire(config_);
+    }
     
-    return true;
+    // Every reduced quality level's plan, tables included, so switching levels builds nothing
+    for (int level = 1; level <= MAX_QUALITY_LEVEL; ++level) {
+        const QualityLevel quality = qualityLevelFor(level);
+        if (quality.bandDivisor == 1 && quality.fftDivisor == 1) {
+            continue;
+        }
+        AudioConfig reduced = config_;
+        reduced.numMelBands = std::max(1, config_.numMelBands / quality.bandDivisor);
+        reduced.frameSize = std::max(16, config_.frameSize / quality.fftDivisor);
+        reduced.hopSize = std::min(config_.hopSize, reduced.frameSize);
+        reducedPlans_[level] = MelPlan::acquire(reduced);
+        reducedPlans_[level]->prepareRuntimeTables();
+    }
+}
+
+void MelSpectrogramProcessor::allocateBuffers() {
+    const size_t frameSize = static_cast<size_t>(config_.frameSize);
+    const size_t bands = static_cast<size_t>(config_.numMelBands);
+    const size_t pipelineBytes = plan_ || fixedPlan_ ? 0 : getMelPipelineSize(config_);
+    const size_t fftSize = plan_ ? frameSize : 0;
+    const size_t bins = plan_ ? frameSize / 2 + 1 : 0;
+    const size_t fixedSize = fixedPlan_ ? frameSize : 0;
+    const size_t fixedBins = fixedPlan_ ? frameSize / 2 + 1 : 0;
+    const size_t fixedBands = fixedPlan_ ? bands : 0;
+    size_t reducedFrame = 0;
+    size_t reducedBands = 0;
+    for (const std::shared_ptr<const MelPlan>& reduced : reducedPlans_) {
+        if (reduced) {
+            reducedFrame = std::max(reducedFrame, static_cast<size_t>(reduced->getConfig().frameSize));
+            reducedBands = std::max(reducedBands, static_cast<size_t>(reduced->getConfig().numMelBands));
+        }
+    }
+    const size_t reducedBins = reducedFrame ? reducedFrame / 2 + 1 : 0;
+
+    // Processing order, so each step's output sits right after its input
+    destroyPipeline();
+    arena_.clear();
+    const size_t pending = arena_.reserve<int16_t>(frameSize);
+    const size_t straddle = arena_.reserve<int16_t>(frameSize);
+    const size_t pipeline = arena_.reserve<uint8_t>(pipelineBytes);
+    const size_t fftInput = arena_.reserve<std::complex<float>>(fftSize);
+    const size_t fftOutput = arena_.reserve<std::complex<float>>(fftSize);
+    const size_t power = arena_.reserve<float>(bins);
+    const size_t fixedInput = arena_.reserve<kiss_fft_fixed_cpx>(fixedSize);
+    const size_t fixedOutput = arena_.reserve<kiss_fft_fixed_cpx>(fixedSize);
+    const size_t fixedPower = arena_.reserve<uint32_t>(fixedBins);
+    const size_t fixedMel = arena_.reserve<uint64_t>(fixedBands);
+    const size_t mel = arena_.reserve<float>(bands);
+    const size_t quantized = arena_.reserve<uint16_t>(bands);
+    const size_t colors = arena_.reserve<uint8_t>(bands * 4);
+    const size_t decibels = arena_.reserve<float>(bands);
+    const size_t mfcc = arena_.reserve<float>(mfccPlan_ ? mfccPlan_->getNumCoefficients() : 0);
+    // Reduced quality levels, shared by all of them
+    const size_t reducedInput = arena_.reserve<std::complex<float>>(reducedFrame);
+    const size_t reducedOutput = arena_.reserve<std::complex<float>>(reducedFrame);
+    const size_t reducedPower = arena_.reserve<float>(reducedBins);
+    const size_t reducedMel = arena_.reserve<float>(reducedBands);
+    const size_t reducedDecibels = arena_.reserve<float>(reducedBands);
+    arena_.allocate();
+
+    pendingInput_ = arena_.at<int16_t>(pending);
+    straddleFrame_ = arena_.at<int16_t>(straddle);
+    pipeline_ = pipelineBytes ? createMelPipeline(config_, arena_.at<uint8_t>(pipeline)) : nullptr;
+    fftInput_ = fftSize ? arena_.at<std::complex<float>>(fftInput) : nullptr;
+    fftOutput_ = fftSize ? arena_.at<std::complex<float>>(fftOutput) : nullptr;
+    powerSpectrum_ = bins ? arena_.at<float>(power) : nullptr;
+    fixedInput_ = fixedSize ? arena_.at<kiss_fft_fixed_cpx>(fixedInput) : nullptr;
+    fixedOutput_ = fixedSize ? arena_.at<kiss_fft_fixed_cpx>(fixedOutput) : nullptr;
+    fixedPower_ = fixedSize ? arena_.at<uint32_t>(fixedPower) : nullptr;
+    fixedMel_ = fixedSize ? arena_.at<uint64_t>(fixedMel) : nullptr;
+    melSpectrum_ = arena_.at<float>(mel);
+    quantizedSpectrum_ = arena_.at<uint8_t>(quantized);
+    colorMappedData_ = arena_.at<uint8_t>(colors);
+    decibels_ = arena_.at<float>(decibels);
+    mfcc_ = mfccPlan_ ? arena_.at<float>(mfcc) : nullptr;
+    reducedInput_ = reducedFrame ? arena_.at<std::complex<float>>(reducedInput) : nullptr;
+    reducedOutput_ = reducedFrame ? arena_.at<std::complex<float>>(reducedOutput) : nullptr;
+    reducedPower_ = reducedFrame ? arena_.at<float>(reducedPower) : nullptr;
+    reducedMel_ = reducedFrame ? arena_.at<float>(reducedMel) : nullptr;
+    reducedDecibels_ = reducedFrame ? arena_.at<float>(reducedDecibels) : nullptr;
+}
+
+void MelSpectrogramProcessor::destroyPipeline() {
+    // It lives in arena_, so only its destructor runs; the storage goes with the arena
+    if (pipeline_) {
+        pipeline_->~MelPipelineBase();
+        pipeline_ = nullptr;
+    }
 }
 
 void MelSpectrogramProcessor::performFFT() {
-    kiss_fft(reinterpret_cast<kiss_fft_cfg>(kissFFTConfig_), 
-             reinterpret_cast<kiss_fft_cpx*>(fftInput_.data()),
-             reinterpret_cast<kiss_fft_cpx*>(fftOutput_.data()));
+    plan_->fft(fftInput_, fftOutput_);
 }
 
 void MelSpectrogramProcessor::computePowerSpectrum() {
-    for (int i = 0; i <= config_.frameSize / 2; ++i) {
-        float real = fftOutput_[i].real();
-        float imag = fftOutput_[i].imag();
-        powerSpectrum_[i] = (real * real + imag * imag) / config_.frameSize;
-    }
+    plan_->powerSpectrum(fftOutput_, powerSpectrum_);
 }
 
 void MelSpectrogramProcessor::applyMelFilterBank() {
-    std::fill(melSpectrum_.begin(), melSpectrum_.end(), 0.0f);
-    
-    for (int melBand = 0; melBand < config_.numMelBands; ++melBand) {
-        for (int freqBin = 0; freqBin <= config_.frameSize / 2; ++freqBin) {
-            melSpectrum_[melBand] += powerSpectrum_[freqBin] * melFilterBank_[melBand][freqBin];
-        }
-    }
+    plan_->applyFilterBank(powerSpectrum_, melSpectrum_);
 }
 
 void MelSpectrogramProcessor::convertToLogScale() {
-    for (auto& value : melSpectrum_) {
-        value = 10.0f * std::log10(std::max(value, MIN_LOG_VALUE));
-    }
-    
-    // Normalize to 0-1 range
-    float minValue = *std::min_element(melSpectrum_.begin(), melSpectrum_.end());
-    float maxValue = *std::max_element(melSpectrum_.begin(), melSpectrum_.end());
-    float range = maxValue - minValue;
-    
-    if (range > 0) {
-        for (auto& value : melSpectrum_) {
-            value = (value - minValue) / range;
-        }
+    MelPlan::logScale(melSpectrum_, config_.numMelBands, outputFormat_,
+                      outputFormat_ == MelOutputFormat::FLOAT32 ? nullptr : quantizedSpectrum_, decibels_);
+}
+
+void MelSpectrogramProcessor::setOutputFormat(MelOutputFormat format) {
+    outputFormat_ = format;
+    floorCached_ = false;
+    std::fill(quantizedSpectrum_, quantizedSpectrum_ + getOutputBytesPerFrame(), 0);
+}
+
+const void* MelSpectrogramProcessor::getOutputData() const {
+    if (outputFormat_ == MelOutputFormat::FLOAT32) {
+        return melSpectrum_;
     }
+    return quantizedSpectrum_;
 }
 
 void MelSpectrogramProcessor::applyColorMapping() {
@@ -135,93 +503,47 @@ void MelSpectrogramProcessor::applyColorMapping() {
     }
 }
 
-void MelSpectrogramProcessor::createWindowFunction() {
-    // Hann window
-    for (int i = 0; i < config_.frameSize; ++i) {
-        windowFunction_[i] = 0.5f * (1.0f - std::cos(2.0f * PI * i / (config_.frameSize - 1)));
-    }
-}
-
-void MelSpectrogramProcessor::createMelFilterBank() {
-    melFilterBank_.resize(config_.numMelBands);
-    
-    float minMel = freqToMel(config_.minFreq);
-    float maxMel = freqToMel(config_.maxFreq);
-    
-    std::vector<float> melPoints(config_.numMelBands + 2);
-    for (int i = 0; i < config_.numMelBands + 2; ++i) {
-        melPoints[i] = minMel + (maxMel - minMel) * i / (config_.numMelBands + 1);
-    }
-    
-    std::vector<float> freqPoints(config_.numMelBands + 2);
-    for (int i = 0; i < config_.numMelBands + 2; ++i) {
-        freqPoints[i] = melToFreq(melPoints[i]);
-    }
-    
-    for (int melBand = 0; melBand < config_.numMelBands; ++melBand) {
-        melFilterBank_[melBand].resize(config_.frameSize / 2 + 1);
-        
-        float leftFreq = freqPoints[melBand];
-        float centerFreq = freqPoints[melBand + 1];
-        float rightFreq = freqPoints[melBand + 2];
-        
-        for (int freqBin = 0; freqBin <= config_.frameSize / 2; ++freqBin) {
-            float freq = static_cast<float>(freqBin) * config_.sampleRate / config_.frameSize;
-            
-            if (freq >= leftFreq && freq <= centerFreq) {
-                melFilterBank_[melBand][freqBin] = (freq - leftFreq) / (centerFreq - leftFreq);
-            } else if (freq >= centerFreq && freq <= rightFreq) {
-                melFilterBank_[melBand][freqBin] = (rightFreq - freq) / (rightFreq - centerFreq);
-            } else {
-                melFilterBank_[melBand][freqBin] = 0.0f;
-            }
-        }
-    }
-}
-
-float MelSpectrogramProcessor::freqToMel(float freq) const {
-    return 2595.0f * std::log10(1.0f + freq / 700.0f);
-}
-
-float MelSpectrogramProcessor::melToFreq(float mel) const {
-    return 700.0f * (std::pow(10.0f, mel / 2595.0f) - 1.0f);
-}
-
 std::vector<float> MelSpectrogramProcessor::getMelSpectrum() const {
-    return melSpectrum_;
+    return std::vector<float>(melSpectrum_, melSpectrum_ + config_.numMelBands);
 }
 
 std::vector<uint8_t> MelSpectrogramProcessor::getColorMappedData() const {
-    return colorMappedData_;
+    return std::vector<uint8_t>(colorMappedData_, colorMappedData_ + config_.numMelBands * 4);
+}
+
+size_t MelSpectrogramProcessor::getMemoryFootprint() const {
+    size_t bytes = arena_.size();
+    if (deltas_) {
+        bytes += deltas_->getBytes();
+    }
+    return bytes;
 }
 
 bool MelSpectrogramProcessor::isOverloaded() const {
-    return stats_.processingTimeMs > 50.0f; // 50ms threshold
+    return stats_.processingTimeMs > getFrameDeadlineMs() || qualityController_.isOverBudget();
 }
 
 void MelSpectrogramProcessor::resetStats() {
     stats_ = ProcessingStats{};
+    stats_.qualityLevel = qualityLevel_;
     frameCount_ = 0;
 }
 
 void MelSpectrogramProcessor::updateConfig(const AudioConfig& config) {
     config_ = config;
     
-    // Reinitialize buffers with new config
-    windowFunction_.resize(config_.frameSize);
-    fftInput_.resize(config_.frameSize);
-    fftOutput_.resize(config_.frameSize);
-    powerSpectrum_.resize(config_.frameSize / 2 + 1);
-    melSpectrum_.resize(config_.numMelBands);
-    colorMappedData_.resize(config_.numMelBands * 4); // RGBA
-    
-    // Recreate window function and filter bank
-    createWindowFunction();
-    createMelFilterBank();
+    // Pick up the plan for the new config, including its FFT size, and rebuild the buffers
+    selectPlan();
+    mfccPlan_.reset(mfccConfig_.enabled ? new MfccPlan(config_.numMelBands, mfccConfig_) : nullptr);
+    deltas_.reset(deltaConfig_.enabled ? new DeltaStream(config_.numMelBands, deltaConfig_.window) : nullptr);
+    allocateBuffers();
+    applyQualityLevel(qualityLevel_);
+    resetStream();
 }
 
 void MelSpectrogramProcessor::setColorMap(const std::vector<std::tuple<uint8_t, uint8_t, uint8_t>>& colormap) {
     colorMap_ = colormap;
+    floorCached_ = false;
 }
 
 // Color map creation functions
@@ -0,0 +1,59 @@
+#include "mfcc.h"
+#include <algorithm>
+#include <cmath>
+
+namespace melspectrogram {
+
+namespace {
+    constexpr double PI = 3.14159265358979323846;
+
+    // Four partial sums so the loop pipelines without reassociating float adds
+    inline float dot(const float* a, const float* b, int count) {
+        float s0 = 0.0f, s1 = 0.0f, s2 = 0.0f, s3 = 0.0f;
+        int i = 0;
+        for (; i + 4 <= count; i += 4) {
+            s0 += a[i] * b[i];
+            s1 += a[i + 1] * b[i + 1];
+            s2 += a[i + 2] * b[i + 2];
+            s3 += a[i + 3] * b[i + 3];
+        }
+        for (; i < count; ++i) {
+            s0 += a[i] * b[i];
+        }
+        return (s0 + s1) + (s2 + s3);
+    }
+}
+
+MfccPlan::MfccPlan(int numMelBands, const MfccConfig& config)
+    : numBands_(std::max(numMelBands, 1)),
+      numCoefficients_(std::max(1, std::min(config.numCoefficients, std::max(numMelBands, 1)))) {
+    matrix_.resize(static_cast<size_t>(numCoefficients_) * numBands_);
+    const double n = static_cast<double>(numBands_);
+    for (int k = 0; k < numCoefficients_; ++k) {
+        double scale = k == 0 ? std::sqrt(1.0 / n) : std::sqrt(2.0 / n);
+        if (config.lifter > 0) {
+            scale *= 1.0 + 0.5 * config.lifter * std::sin(PI * k / config.lifter);
+        }
+        float* row = matrix_.data() + static_cast<size_t>(k) * numBands_;
+        for (int band = 0; band < numBands_; ++band) {
+            row[band] = static_cast<float>(scale * std::cos(PI * k * (2.0 * band + 1.0) / (2.0 * n)));
+        }
+    }
+}
+
+void MfccPlan::compute(const float* logMel, float* mfcc) const {
+    for (int k = 0; k < numCoefficients_; ++k) {
+        mfcc[k] = dot(matrix_.data() + static_cast<size_t>(k) * numBands_, logMel, numBands_);
+    }
+}
+
+void MfccPlan::computeBatch(const float* logMel, size_t frames, float* mfcc) const {
+    for (int k = 0; k < numCoefficients_; ++k) {
+        const float* row = matrix_.data() + static_cast<size_t>(k) * numBands_;
+        for (size_t f = 0; f < frames; ++f) {
+            mfcc[f * numCoefficients_ + k] = dot(row, logMel + f * numBands_, numBands_);
+        }
+    }
+}
+
+} // namespace melspectrogram
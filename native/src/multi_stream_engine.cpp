@@ -0,0 +1,281 @@
+#include "multi_stream_engine.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace melspectrogram {
+
+MultiStreamEngine::MultiStreamEngine(int numWorkers, int maxBatchFrames)
+    : numWorkers_(numWorkers > 0 ? numWorkers : static_cast<int>(std::thread::hardware_concurrency())),
+      maxBatchFrames_(static_cast<size_t>(std::max(1, maxBatchFrames))),
+      nextGroup_(0), nextStreamId_(1), readyStreams_(0), busyWorkers_(0),
+      running_(false), shouldStop_(false),
+      framesProcessed_(0), batchesProcessed_(0), samplesDropped_(0) {
+    numWorkers_ = std::max(1, numWorkers_);
+}
+
+MultiStreamEngine::~MultiStreamEngine() {
+    stop();
+}
+
+bool MultiStreamEngine::start() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (running_) {
+        return false;
+    }
+    shouldStop_ = false;
+    running_ = true;
+    for (int i = 0; i < numWorkers_; ++i) {
+        workers_.emplace_back(&MultiStreamEngine::workerThread, this);
+    }
+    return true;
+}
+
+void MultiStreamEngine::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        shouldStop_ = true;
+    }
+    workCV_.notify_all();
+    for (auto& worker : workers_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    workers_.clear();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    running_ = false;
+    idleCV_.notify_all();
+}
+
+int MultiStreamEngine::addStream(const AudioConfig& config, FrameCallback callback, size_t maxBufferedSamples) {
+    if (config.hopSize <= 0 || config.hopSize > config.frameSize || config.numMelBands <= 0) {
+        return -1;
+    }
+
+    // Build the plan outside the engine lock; it is shared with any processor using the config
+    std::shared_ptr<const MelPlan> plan = MelPlan::acquire(config);
+
+    auto stream = std::make_unique<Stream>();
+    stream->callback = std::move(callback);
+    stream->hopSize = static_cast<size_t>(config.hopSize);
+    if (maxBufferedSamples == 0) {
+        maxBufferedSamples = static_cast<size_t>(std::max(config.sampleRate, 0)) * 2;
+    }
+    stream->maxBuffered = std::max(maxBufferedSamples, static_cast<size_t>(config.frameSize) * 2);
+    stream->samples.reserve(stream->maxBuffered);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    ConfigGroup* group = nullptr;
+    for (auto& candidate : groups_) {
+        if (candidate->plan == plan) {
+            group = candidate.get();
+            break;
+        }
+    }
+    if (group == nullptr) {
+        groups_.push_back(std::make_unique<ConfigGroup>());
+        group = groups_.back().get();
+        group->plan = plan;
+    }
+    group->numStreams++;
+
+    stream->id = nextStreamId_++;
+    stream->group = group;
+    const int id = stream->id;
+    streams_[id] = std::move(stream);
+    return id;
+}
+
+bool MultiStreamEngine::removeStream(int streamId) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto it = streams_.find(streamId);
+    if (it == streams_.end()) {
+        return false;
+    }
+    Stream* stream = it->second.get();
+    ConfigGroup* group = stream->group;
+
+    if (stream->queued) {
+        group->ready.erase(std::find(group->ready.begin(), group->ready.end(), stream));
+        stream->queued = false;
+        readyStreams_--;
+    }
+    // Its last batch may still be running; the worker drops it from the queue afterwards
+    idleCV_.wait(lock, [stream] { return !stream->inFlight; });
+    streams_.erase(it);
+
+    if (--group->numStreams == 0) {
+        auto groupIt = std::find_if(groups_.begin(), groups_.end(),
+                                    [group](const std::unique_ptr<ConfigGroup>& g) { return g.get() == group; });
+        groups_.erase(groupIt);
+        nextGroup_ = 0;
+    }
+    idleCV_.notify_all();
+    return true;
+}
+
+size_t MultiStreamEngine::pushSamples(int streamId, const int16_t* samples, size_t count) {
+    if (samples == nullptr || count == 0) {
+        return 0;
+    }
+
+    bool wake = false;
+    size_t accepted = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = streams_.find(streamId);
+        if (it == streams_.end()) {
+            return 0;
+        }
+        Stream& stream = *it->second;
+
+        const size_t buffered = stream.samples.size() - stream.readPos;
+        accepted = std::min(count, stream.maxBuffered - buffered);
+        samplesDropped_ += count - accepted;
+
+        // Slide consumed samples out instead of growing; capacity covers maxBuffered
+        if (stream.samples.size() + accepted > stream.samples.capacity()) {
+            stream.samples.erase(stream.samples.begin(), stream.samples.begin() + stream.readPos);
+            stream.readPos = 0;
+        }
+        stream.samples.insert(stream.samples.end(), samples, samples + accepted);
+
+        const bool wasQueued = stream.queued;
+        enqueueIfReady(stream);
+        wake = !wasQueued && stream.queued;
+    }
+    if (wake) {
+        workCV_.notify_one();
+    }
+    return accepted;
+}
+
+size_t MultiStreamEngine::availableFrames(const Stream& stream) const {
+    const AudioConfig& config = stream.group->plan->getConfig();
+    const size_t buffered = stream.samples.size() - stream.readPos;
+    const size_t frameSize = static_cast<size_t>(config.frameSize);
+    if (buffered < frameSize) {
+        return 0;
+    }
+    return (buffered - frameSize) / stream.hopSize + 1;
+}
+
+void MultiStreamEngine::enqueueIfReady(Stream& stream) {
+    if (!stream.queued && !stream.inFlight && availableFrames(stream) > 0) {
+        stream.group->ready.push_back(&stream);
+        stream.queued = true;
+        readyStreams_++;
+    }
+}
+
+MultiStreamEngine::ConfigGroup* MultiStreamEngine::nextReadyGroup() {
+    for (size_t i = 0; i < groups_.size(); ++i) {
+        const size_t index = (nextGroup_ + i) % groups_.size();
+        if (!groups_[index]->ready.empty()) {
+            nextGroup_ = (index + 1) % groups_.size();
+            return groups_[index].get();
+        }
+    }
+    return nullptr;
+}
+
+void MultiStreamEngine::workerThread() {
+    // Worker-local buffers; they only grow when a larger configuration shows up
+    std::vector<int16_t> frameData;
+    std::vector<const int16_t*> framePtrs(maxBatchFrames_);
+    std::vector<float> output;
+    std::vector<BatchEntry> batch;
+    batch.reserve(maxBatchFrames_);
+    MelPlan::Scratch scratch;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        workCV_.wait(lock, [this] { return readyStreams_ > 0 || shouldStop_; });
+        if (shouldStop_) {
+            break;
+        }
+
+        ConfigGroup* group = nextReadyGroup();
+        std::shared_ptr<const MelPlan> plan = group->plan;
+        const AudioConfig& config = plan->getConfig();
+        const size_t frameSize = static_cast<size_t>(config.frameSize);
+        const size_t bands = static_cast<size_t>(config.numMelBands);
+        if (frameData.size() < maxBatchFrames_ * frameSize) {
+            frameData.resize(maxBatchFrames_ * frameSize);
+        }
+        if (output.size() < maxBatchFrames_ * bands) {
+            output.resize(maxBatchFrames_ * bands);
+        }
+
+        // Equal share per ready stream, in FIFO order, so a backlogged stream cannot starve the rest
+        const size_t share = std::max<size_t>(1, maxBatchFrames_ / group->ready.size());
+        size_t frames = 0;
+        batch.clear();
+        while (!group->ready.empty() && frames < maxBatchFrames_) {
+            Stream* stream = group->ready.front();
+            group->ready.pop_front();
+            stream->queued = false;
+            readyStreams_--;
+
+            const size_t take = std::min({availableFrames(*stream), share, maxBatchFrames_ - frames});
+            for (size_t i = 0; i < take; ++i) {
+                std::memcpy(frameData.data() + (frames + i) * frameSize,
+                            stream->samples.data() + stream->readPos, frameSize * sizeof(int16_t));
+                framePtrs[frames + i] = frameData.data() + (frames + i) * frameSize;
+                stream->readPos += stream->hopSize;
+            }
+            stream->inFlight = true;
+            batch.push_back({stream, frames, take});
+            frames += take;
+        }
+        busyWorkers_++;
+        lock.unlock();
+
+        plan->computeBatch(framePtrs.data(), frames, output.data(), scratch);
+        for (const BatchEntry& entry : batch) {
+            if (entry.stream->callback) {
+                entry.stream->callback(entry.stream->id, output.data() + entry.firstFrame * bands, entry.numFrames);
+            }
+        }
+
+        lock.lock();
+        busyWorkers_--;
+        framesProcessed_ += frames;
+        batchesProcessed_++;
+        bool requeued = false;
+        for (const BatchEntry& entry : batch) {
+            entry.stream->inFlight = false;
+            enqueueIfReady(*entry.stream);
+            requeued = requeued || entry.stream->queued;
+        }
+        if (requeued) {
+            workCV_.notify_one();
+        }
+        idleCV_.notify_all();
+    }
+}
+
+bool MultiStreamEngine::waitIdle(int timeoutMs) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return idleCV_.wait_for(lock, std::chrono::milliseconds(timeoutMs), [this] {
+        return (readyStreams_ == 0 && busyWorkers_ == 0) || !running_;
+    });
+}
+
+MultiStreamStats MultiStreamEngine::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    MultiStreamStats stats;
+    stats.framesProcessed = framesProcessed_;
+    stats.batchesProcessed = batchesProcessed_;
+    stats.samplesDropped = samplesDropped_;
+    stats.averageBatchFrames = batchesProcessed_ > 0
+        ? static_cast<float>(framesProcessed_) / batchesProcessed_ : 0.0f;
+    stats.activeStreams = static_cast<int>(streams_.size());
+    stats.configGroups = static_cast<int>(groups_.size());
+    stats.numWorkers = numWorkers_;
+    return stats;
+}
+
+} // namespace melspectrogram
@@ -0,0 +1,232 @@
+#include "offline_spectrogram.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace melspectrogram {
+
+namespace {
+    uint32_t readU32(const uint8_t* p) {
+        return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+               (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+    }
+
+    uint16_t readU16(const uint8_t* p) {
+        return static_cast<uint16_t>(p[0] | (p[1] << 8));
+    }
+
+    constexpr uint16_t WAVE_FORMAT_PCM = 1;
+    constexpr uint16_t WAVE_FORMAT_EXTENSIBLE = 0xFFFE;
+
+    // A worker's remaining chunks [next, end); the owner takes from the front, thieves from the back
+    struct ChunkRange {
+        std::mutex mutex;
+        size_t next = 0;
+        size_t end = 0;
+    };
+}
+
+// MappedWav
+
+MappedWav::MappedWav()
+    : samples_(nullptr), numFrames_(0), sampleRate_(0), numChannels_(0) {
+}
+
+bool MappedWav::fail(const std::string& message) {
+    close();
+    error_ = message;
+    return false;
+}
+
+bool MappedWav::open(const std::string& path) {
+    close();
+    error_.clear();
+
+    // The whole file is read front to back
+    if (!file_.open(path, true)) {
+        return fail(file_.getError());
+    }
+
+    const uint8_t* base = file_.data();
+    const size_t fileSize = file_.size();
+    if (fileSize < 12 || std::memcmp(base, "RIFF", 4) != 0 || std::memcmp(base + 8, "WAVE", 4) != 0) {
+        return fail("Not a RIFF/WAVE file");
+    }
+
+    bool haveFormat = false;
+    size_t offset = 12;
+    while (offset + 8 <= fileSize) {
+        const uint8_t* chunk = base + offset;
+        const size_t chunkSize = readU32(chunk + 4);
+        const size_t bodySize = std::min(chunkSize, fileSize - offset - 8);
+
+        if (std::memcmp(chunk, "fmt ", 4) == 0 && bodySize >= 16) {
+            const uint16_t format = readU16(chunk + 8);
+            numChannels_ = readU16(chunk + 10);
+            sampleRate_ = static_cast<int>(readU32(chunk + 12));
+            const uint16_t bits = readU16(chunk + 22);
+            if ((format != WAVE_FORMAT_PCM && format != WAVE_FORMAT_EXTENSIBLE) || bits != 16) {
+                return fail("Only 16-bit PCM WAV is supported");
+            }
+            if (numChannels_ <= 0 || sampleRate_ <= 0) {
+                return fail("Invalid WAV format chunk");
+            }
+            haveFormat = true;
+        } else if (std::memcmp(chunk, "data", 4) == 0) {
+            if (!haveFormat) return fail("WAV data chunk before format chunk");
+            // RIFF chunks are word aligned, so the samples are int16-aligned in the mapping
+            samples_ = reinterpret_cast<const int16_t*>(chunk + 8);
+            numFrames_ = bodySize / (sizeof(int16_t) * numChannels_);
+            return true;
+        }
+        offset += 8 + chunkSize + (chunkSize & 1);
+    }
+    return fail("WAV file has no data chunk");
+}
+
+void MappedWav::close() {
+    file_.close();
+    samples_ = nullptr;
+    numFrames_ = 0;
+    sampleRate_ = 0;
+    numChannels_ = 0;
+}
+
+bool MappedWav::extractChannel(int channel, std::vector<int16_t>& output) const {
+    if (!isOpen() || channel < 0 || channel >= numChannels_) {
+        return false;
+    }
+    output.resize(numFrames_);
+    for (size_t i = 0; i < numFrames_; ++i) {
+        output[i] = samples_[i * numChannels_ + channel];
+    }
+    return true;
+}
+
+// OfflineSpectrogram
+
+OfflineSpectrogram::OfflineSpectrogram(const AudioConfig& config, int numThreads, size_t chunkFrames)
+    : config_(config),
+      numThreads_(numThreads > 0 ? numThreads : static_cast<int>(std::thread::hardware_concurrency())),
+      chunkFrames_(chunkFrames) {
+    numThreads_ = std::max(1, numThreads_);
+}
+
+size_t OfflineSpectrogram::frameCount(size_t numSamples, const AudioConfig& config) {
+    if (config.hopSize <= 0 || config.frameSize <= 0 || numSamples < static_cast<size_t>(config.frameSize)) {
+        return 0;
+    }
+    return (numSamples - config.frameSize) / config.hopSize + 1;
+}
+
+long OfflineSpectrogram::process(const int16_t* samples, size_t numSamples, float* output, size_t maxFrames) {
+    stats_ = OfflineStats{};
+    if ((samples == nullptr && numSamples > 0) || output == nullptr ||
+        config_.hopSize <= 0 || config_.hopSize > config_.frameSize) {
+        return -1;
+    }
+
+    auto startTime = std::chrono::steady_clock::now();
+    const size_t numFrames = std::min(frameCount(numSamples, config_), maxFrames);
+    const size_t hop = static_cast<size_t>(config_.hopSize);
+    const size_t bands = static_cast<size_t>(config_.numMelBands);
+
+    size_t chunkFrames = chunkFrames_;
+    if (chunkFrames == 0) {
+        chunkFrames = std::max<size_t>(32, numFrames / (static_cast<size_t>(numThreads_) * 8));
+    }
+    const size_t numChunks = (numFrames + chunkFrames - 1) / chunkFrames;
+    const int numThreads = static_cast<int>(std::min<size_t>(numThreads_, std::max<size_t>(numChunks, 1)));
+
+    // Even initial slices; the rest is balanced by stealing
+    std::vector<std::unique_ptr<ChunkRange>> ranges;
+    for (int t = 0; t < numThreads; ++t) {
+        ranges.push_back(std::make_unique<ChunkRange>());
+        ranges[t]->next = numChunks * t / numThreads;
+        ranges[t]->end = numChunks * (t + 1) / numThreads;
+    }
+    std::atomic<size_t> steals{0};
+
+    auto worker = [&](int self) {
+        // Per-worker scratch; the plan tables are shared through the plan cache
+        MelSpectrogramProcessor processor(config_);
+        ChunkRange& own = *ranges[self];
+
+        while (true) {
+            size_t chunk;
+            {
+                std::lock_guard<std::mutex> lock(own.mutex);
+                chunk = own.next < own.end ? own.next++ : numChunks;
+            }
+
+            if (chunk == numChunks) {
+                // Find the victim with the most work left and take the upper half of it
+                int victim = -1;
+                size_t most = 0;
+                for (int t = 0; t < numThreads; ++t) {
+                    if (t == self) continue;
+                    std::lock_guard<std::mutex> lock(ranges[t]->mutex);
+                    const size_t remaining = ranges[t]->end - ranges[t]->next;
+                    if (remaining > most) {
+                        most = remaining;
+                        victim = t;
+                    }
+                }
+                if (victim < 0) {
+                    break;
+                }
+
+                size_t stolenBegin;
+                size_t stolenEnd;
+                {
+                    std::lock_guard<std::mutex> lock(ranges[victim]->mutex);
+                    const size_t remaining = ranges[victim]->end - ranges[victim]->next;
+                    if (remaining == 0) continue;
+                    stolenEnd = ranges[victim]->end;
+                    stolenBegin = stolenEnd - (remaining + 1) / 2;
+                    ranges[victim]->end = stolenBegin;
+                }
+                steals++;
+
+                std::lock_guard<std::mutex> lock(own.mutex);
+                own.next = stolenBegin;
+                own.end = stolenEnd;
+                continue;
+            }
+
+            const size_t firstFrame = chunk * chunkFrames;
+            const size_t frames = std::min(chunkFrames, numFrames - firstFrame);
+            // The chunk's last window runs frameSize - hop samples into the next chunk
+            const size_t chunkSamples = (frames - 1) * hop + config_.frameSize;
+            size_t produced = 0;
+            processor.resetStream();
+            processor.processAudioSamples(samples + firstFrame * hop, chunkSamples,
+                                          output + firstFrame * bands, frames, &produced);
+        }
+    };
+
+    if (numFrames > 0) {
+        std::vector<std::thread> threads;
+        for (int t = 1; t < numThreads; ++t) {
+            threads.emplace_back(worker, t);
+        }
+        worker(0);
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+
+    stats_.framesProcessed = numFrames;
+    stats_.chunks = numChunks;
+    stats_.steals = steals.load();
+    stats_.numThreads = numThreads;
+    stats_.elapsedMs = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - startTime).count() / 1000.0f;
+    return static_cast<long>(numFrames);
+}
+
+} // namespace melspectrogram
@@ -0,0 +1,318 @@
+#include "pipeline_runner.h"
+#include "texture_renderer.h"
+#include "session_recorder.h"
+#include "resampler.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace melspectrogram {
+
+PipelineRunner::PipelineRunner(MelSpectrogramProcessor& processor, const AudioConfig& config,
+                               int columnCapacity, size_t sampleCapacity)
+    : processor_(processor), config_(config), input_(nullptr), startedRecording_(false), recorder_(nullptr),
+      inputRate_(config.sampleRate), sampleHead_(0), sampleCount_(0), busy_(false),
+      columnCapacity_(std::max(1, columnCapacity)), columnHead_(0), columnCount_(0) {
+
+    // Default to half a second of audio, and always at least a few frames
+    if (sampleCapacity == 0) {
+        sampleCapacity = static_cast<size_t>(std::max(config_.sampleRate / 2, 0));
+    }
+    sampleCapacity = std::max(sampleCapacity, static_cast<size_t>(std::max(config_.frameSize, 1)) * 4);
+    samples_.resize(sampleCapacity);
+    columns_.resize(static_cast<size_t>(columnCapacity_) * config_.numMelBands);
+}
+
+PipelineRunner::~PipelineRunner() {
+    stop();
+}
+
+bool PipelineRunner::start(audio::AudioInput* input) {
+    if (running_ || config_.hopSize <= 0 || config_.hopSize > config_.frameSize) {
+        return false;
+    }
+
+    // A live input dictates the rate; the resampler is built before the DSP thread needs it
+    if (input) {
+        inputRate_ = input->getSampleRate();
+    }
+    // The rate may have changed since the recorder was attached
+    if (recorder_ && !recorderMatches(*recorder_)) {
+        return false;
+    }
+    resampler_.reset();
+    if (inputRate_ != config_.sampleRate) {
+        resampler_.reset(new Resampler(inputRate_, config_.sampleRate));
+    }
+
+    shouldStop_ = false;
+    running_ = true;
+    thread_ = std::thread(&PipelineRunner::dspThread, this);
+
+    input_ = input;
+    if (input_) {
+        input_->setAudioCallback([this](const int16_t* data, size_t size) {
+            pushSamples(data, size);
+        });
+        startedRecording_ = !input_->isRecording();
+        if (startedRecording_ && !input_->startRecording()) {
+            input_->setAudioCallback(nullptr);
+            input_ = nullptr;
+            stop();
+            return false;
+        }
+    }
+    return true;
+}
+
+void PipelineRunner::stop() {
+    if (input_) {
+        // Once this returns no callback is in flight
+        input_->setAudioCallback(nullptr);
+        if (startedRecording_) {
+            input_->stopRecording();
+        }
+        input_ = nullptr;
+        startedRecording_ = false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(sampleMutex_);
+        shouldStop_ = true;
+    }
+    sampleCV_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    running_ = false;
+    idleCV_.notify_all();
+}
+
+bool PipelineRunner::setRecorder(SessionRecorder* recorder) {
+    if (running_ || (recorder && !recorderMatches(*recorder))) {
+        return false;
+    }
+    recorder_ = recorder;
+    return true;
+}
+
+bool PipelineRunner::recorderMatches(const SessionRecorder& recorder) const {
+    // pushMel() reads frames as the recorder's band count and the archive times them by its hop and rate
+    const RecorderConfig& recording = recorder.getConfig();
+    if (recording.recordMel && (recording.numMelBands != config_.numMelBands ||
+                                recording.hopSize != config_.hopSize ||
+                                recording.sampleRate != config_.sampleRate)) {
+        return false;
+    }
+    // PCM is recorded as it arrives, before resampling
+    return !recording.recordPcm || recorder.getPcmSampleRate() == inputRate_;
+}
+
+bool PipelineRunner::setInputRate(int inputRate) {
+    if (running_ || inputRate < 0) {
+        return false;
+    }
+    inputRate_ = inputRate == 0 ? config_.sampleRate : inputRate;
+    return true;
+}
+
+size_t PipelineRunner::pushSamples(const int16_t* samples, size_t count) {
+    if (samples == nullptr || count == 0) {
+        return 0;
+    }
+
+    // The recording keeps everything that arrived, even what the DSP FIFO has to drop
+    if (recorder_) {
+        recorder_->pushPcm(samples, count);
+    }
+
+    size_t accepted;
+    {
+        std::lock_guard<std::mutex> lock(sampleMutex_);
+        const size_t capacity = samples_.size();
+        accepted = std::min(count, capacity - sampleCount_);
+
+        // Copy in up to two segments around the wrap point
+        const size_t tail = (sampleHead_ + sampleCount_) % capacity;
+        const size_t first = std::min(accepted, capacity - tail);
+        std::memcpy(samples_.data() + tail, samples, first * sizeof(int16_t));
+        std::memcpy(samples_.data(), samples + first, (accepted - first) * sizeof(int16_t));
+        sampleCount_ += accepted;
+    }
+    if (accepted > 0) {
+        sampleCV_.notify_one();
+    }
+
+    std::lock_guard<std::mutex> lock(statsMutex_);
+    stats_.samplesReceived += count;
+    stats_.samplesDropped += count - accepted;
+    return accepted;
+}
+
+void PipelineRunner::dspThread() {
+    // Working buffers are sized once; the loop itself does not allocate
+    const size_t blockCapacity = std::min(samples_.size(), static_cast<size_t>(config_.hopSize) * 16);
+    const size_t maxFrames = blockCapacity / config_.hopSize + 2;
+    std::vector<int16_t> block(blockCapacity);
+    std::vector<int16_t> resampled(resampler_ ? resampler_->getMaxOutput(blockCapacity) : 0);
+    std::vector<float> frames(maxFrames * config_.numMelBands);
+    // The recorder archives the dB log-mel, not the normalized columns
+    std::vector<float> decibels(recorder_ ? frames.size() : 0);
+
+    while (true) {
+        size_t count;
+        {
+            std::unique_lock<std::mutex> lock(sampleMutex_);
+            busy_ = false;
+            if (sampleCount_ == 0) {
+                idleCV_.notify_all();
+            }
+            sampleCV_.wait(lock, [this] { return sampleCount_ > 0 || shouldStop_; });
+            if (shouldStop_) {
+                break;
+            }
+
+            count = std::min(sampleCount_, blockCapacity);
+            const size_t capacity = samples_.size();
+            const size_t first = std::min(count, capacity - sampleHead_);
+            std::memcpy(block.data(), samples_.data() + sampleHead_, first * sizeof(int16_t));
+            std::memcpy(block.data() + first, samples_.data(), (count - first) * sizeof(int16_t));
+            sampleHead_ = (sampleHead_ + count) % capacity;
+            sampleCount_ -= count;
+            busy_ = true;
+        }
+
+        auto startTime = std::chrono::steady_clock::now();
+
+        const int16_t* analysis = block.data();
+        if (resampler_) {
+            count = resampler_->process(block.data(), count, resampled.data(), resampled.size());
+            analysis = resampled.data();
+        }
+
+        const int skippedBefore = processor_.getStats().skippedFrames;
+        size_t offset = 0;
+        size_t framesThisBlock = 0;
+        while (offset < count) {
+            size_t produced = 0;
+            const long consumed = processor_.processAudioSamples(analysis + offset, count - offset,
+                                                                 frames.data(), maxFrames, &produced,
+                                                                 recorder_ ? decibels.data() : nullptr);
+            if (consumed <= 0 && produced == 0) {
+                break;
+            }
+            queueColumns(frames.data(), produced);
+            if (recorder_ && produced > 0) {
+                recorder_->pushMel(decibels.data(), produced);
+            }
+            framesThisBlock += produced;
+            offset += static_cast<size_t>(std::max(consumed, 0L));
+        }
+
+        auto endTime = std::chrono::steady_clock::now();
+        const float blockTimeMs = std::chrono::duration_cast<std::chrono::microseconds>(
+            endTime - startTime).count() / 1000.0f;
+
+        std::lock_guard<std::mutex> lock(statsMutex_);
+        stats_.framesProcessed += framesThisBlock;
+        const ProcessingStats processing = processor_.getStats();
+        stats_.framesSkipped += static_cast<uint64_t>(std::max(processing.skippedFrames - skippedBefore, 0));
+        stats_.qualityLevel = processing.qualityLevel;
+        stats_.averageBlockTimeMs = stats_.averageBlockTimeMs == 0.0f
+            ? blockTimeMs : stats_.averageBlockTimeMs * 0.9f + blockTimeMs * 0.1f;
+        stats_.maxBlockTimeMs = std::max(stats_.maxBlockTimeMs, blockTimeMs);
+    }
+
+    std::lock_guard<std::mutex> lock(sampleMutex_);
+    busy_ = false;
+}
+
+void PipelineRunner::queueColumns(const float* columns, size_t count) {
+    const int bands = config_.numMelBands;
+    uint64_t dropped = 0;
+    {
+        std::lock_guard<std::mutex> lock(columnMutex_);
+        for (size_t i = 0; i < count; ++i) {
+            if (columnCount_ == columnCapacity_) {
+                // Consumer is behind: keep the newest columns
+                columnHead_ = (columnHead_ + 1) % columnCapacity_;
+                columnCount_--;
+                dropped++;
+            }
+            const int slot = (columnHead_ + columnCount_) % columnCapacity_;
+            std::memcpy(columns_.data() + static_cast<size_t>(slot) * bands,
+                        columns + i * bands, bands * sizeof(float));
+            columnCount_++;
+        }
+    }
+
+    if (dropped > 0) {
+        std::lock_guard<std::mutex> lock(statsMutex_);
+        stats_.columnsDropped += dropped;
+    }
+}
+
+int PipelineRunner::pollColumns(TextureRenderer& renderer) {
+    int delivered = 0;
+    {
+        std::lock_guard<std::mutex> lock(columnMutex_);
+        const int bands = config_.numMelBands;
+        while (columnCount_ > 0) {
+            if (!renderer.enqueueColumn(columns_.data() + static_cast<size_t>(columnHead_) * bands, bands)) {
+                break;
+            }
+            columnHead_ = (columnHead_ + 1) % columnCapacity_;
+            columnCount_--;
+            delivered++;
+        }
+    }
+
+    if (delivered > 0) {
+        renderer.flush();
+        std::lock_guard<std::mutex> lock(statsMutex_);
+        stats_.columnsDelivered += delivered;
+    }
+    return delivered;
+}
+
+int PipelineRunner::readColumns(float* output, int maxColumns) {
+    if (output == nullptr || maxColumns <= 0) {
+        return 0;
+    }
+
+    int delivered = 0;
+    {
+        std::lock_guard<std::mutex> lock(columnMutex_);
+        const int bands = config_.numMelBands;
+        while (columnCount_ > 0 && delivered < maxColumns) {
+            std::memcpy(output + static_cast<size_t>(delivered) * bands,
+                        columns_.data() + static_cast<size_t>(columnHead_) * bands, bands * sizeof(float));
+            columnHead_ = (columnHead_ + 1) % columnCapacity_;
+            columnCount_--;
+            delivered++;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(statsMutex_);
+    stats_.columnsDelivered += delivered;
+    return delivered;
+}
+
+PipelineStats PipelineRunner::getStats() const {
+    PipelineStats stats;
+    {
+        std::lock_guard<std::mutex> lock(statsMutex_);
+        stats = stats_;
+    }
+    std::lock_guard<std::mutex> lock(columnMutex_);
+    stats.queuedColumns = columnCount_;
+    return stats;
+}
+
+bool PipelineRunner::waitIdle(int timeoutMs) {
+    std::unique_lock<std::mutex> lock(sampleMutex_);
+    return idleCV_.wait_for(lock, std::chrono::milliseconds(timeoutMs),
+                            [this] { return (sampleCount_ == 0 && !busy_) || !running_; });
+}
+
+} // namespace melspectrogram
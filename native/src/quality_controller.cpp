@@ -0,0 +1,64 @@
+#include "quality_controller.h"
+#include <algorithm>
+
+namespace melspectrogram {
+
+QualityLevel qualityLevelFor(int level) {
+    level = std::max(0, std::min(level, MAX_QUALITY_LEVEL));
+    QualityLevel quality;
+    if (level >= 1) quality.decimation = 2;
+    if (level >= 2) quality.bandDivisor = 2;
+    if (level >= 3) quality.fftDivisor = 2;
+    if (level >= 4) quality.colorMapping = false;
+    return quality;
+}
+
+void QualityController::setConfig(const QualityControllerConfig& config) {
+    config_ = config;
+    reset();
+}
+
+int QualityController::update(float frameTimeMs, float deadlineMs) {
+    const float load = deadlineMs > 0.0f ? frameTimeMs / deadlineMs : 0.0f;
+    const float missed = load > config_.budget ? 1.0f : 0.0f;
+    missRate_ += config_.smoothing * (missed - missRate_);
+    load_ += config_.smoothing * (load - load_);
+    framesSinceChange_++;
+
+    if (!config_.enabled) {
+        return level_;
+    }
+
+    if (isOverBudget()) {
+        calmFrames_ = 0;
+        if (level_ < MAX_QUALITY_LEVEL && framesSinceChange_ >= config_.holdFrames) {
+            level_++;
+            framesSinceChange_ = 0;
+        }
+    } else if (missRate_ < config_.maxMissRate * 0.25f && load_ < config_.budget * 0.5f) {
+        if (++calmFrames_ >= config_.recoverFrames && level_ > 0) {
+            level_--;
+            framesSinceChange_ = 0;
+            calmFrames_ = 0;
+        }
+    } else {
+        calmFrames_ = 0;
+    }
+    return level_;
+}
+
+void QualityController::setLevel(int level) {
+    level_ = std::max(0, std::min(level, MAX_QUALITY_LEVEL));
+    framesSinceChange_ = 0;
+    calmFrames_ = 0;
+}
+
+void QualityController::reset() {
+    level_ = 0;
+    missRate_ = 0.0f;
+    load_ = 0.0f;
+    framesSinceChange_ = 0;
+    calmFrames_ = 0;
+}
+
+} // namespace melspectrogram
@@ -0,0 +1,329 @@
+#include "render_backend.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#ifdef __APPLE__
+#include <OpenGL/OpenGL.h>
+#include <OpenGL/gl.h>
+#include <OpenGL/glext.h>
+#else
+#include <GLES3/gl3.h>
+#endif
+
+#if defined(__ANDROID__)
+#include <EGL/egl.h>
+#elif defined(_WIN32)
+#include <windows.h>
+#elif !defined(__APPLE__)
+#include <dlfcn.h>
+#endif
+
+namespace melspectrogram {
+
+namespace {
+    uint32_t opaqueBlack() {
+        const uint8_t rgba[4] = {0, 0, 0, 255};
+        uint32_t pixel;
+        std::memcpy(&pixel, rgba, sizeof(pixel));
+        return pixel;
+    }
+}
+
+// CpuRasterBackend
+
+CpuRasterBackend::CpuRasterBackend() : width_(0), height_(0) {}
+
+bool CpuRasterBackend::initialize(int width, int height) {
+    if (width <= 0 || height <= 0) {
+        return false;
+    }
+
+    width_ = width;
+    height_ = height;
+    framebuffer_.assign(static_cast<size_t>(width_) * height_, opaqueBlack());
+    return true;
+}
+
+void CpuRasterBackend::shutdown() {
+    framebuffer_.clear();
+    framebuffer_.shrink_to_fit();
+}
+
+void CpuRasterBackend::writeColumn(int x, const uint32_t* column) {
+    uint32_t* dst = framebuffer_.data() + x;
+    for (int y = 0; y < height_; ++y) {
+        *dst = column[y];
+        dst += width_;
+    }
+}
+
+void CpuRasterBackend::writeColumns(int x, int count, const uint32_t* pixels, int rowStride) {
+    for (int y = 0; y < height_; ++y) {
+        std::memcpy(framebuffer_.data() + static_cast<size_t>(y) * width_ + x,
+                    pixels + static_cast<size_t>(y) * rowStride, count * sizeof(uint32_t));
+    }
+}
+
+const uint8_t* CpuRasterBackend::getPixels() const {
+    return reinterpret_cast<const uint8_t*>(framebuffer_.data());
+}
+
+// OpenGLBackend
+
+OpenGLBackend::OpenGLBackend()
+    : width_(0), height_(0), textureId_(0),
+      readFramebuffer_(0), packBuffer_(0), readbackFence_(nullptr) {}
+
+OpenGLBackend::~OpenGLBackend() {
+    shutdown();
+}
+
+bool OpenGLBackend::initialize(int width, int height) {
+    width_ = width;
+    height_ = height;
+
+    if (!setupOpenGL()) {
+        return false;
+    }
+
+    return createTexture();
+}
+
+bool OpenGLBackend::hasCurrentContext() {
+#if defined(__ANDROID__)
+    return eglGetCurrentContext() != EGL_NO_CONTEXT;
+#elif defined(__APPLE__)
+    return CGLGetCurrentContext() != nullptr;
+#elif defined(_WIN32)
+    // ANGLE's EGL or native WGL, whichever module the application loaded
+    typedef void* (WINAPI *GetCurrentContext)();
+    const struct { const char* module; const char* name; } entries[] = {
+        {"libEGL.dll", "eglGetCurrentContext"}, {"opengl32.dll", "wglGetCurrentContext"}};
+    for (const auto& entry : entries) {
+        HMODULE module = GetModuleHandleA(entry.module);
+        GetCurrentContext getCurrent = module == nullptr ? nullptr :
+            reinterpret_cast<GetCurrentContext>(GetProcAddress(module, entry.name));
+        if (getCurrent != nullptr && getCurrent() != nullptr) {
+            return true;
+        }
+    }
+    return false;
+#else
+    // Desktop contexts come from EGL or GLX. Look both up in the libraries already loaded:
+    // neither is a link dependency, and a library nobody loaded has no current context.
+    typedef void* (*GetCurrentContext)();
+    for (const char* name : {"eglGetCurrentContext", "glXGetCurrentContext"}) {
+        GetCurrentContext getCurrent = reinterpret_cast<GetCurrentContext>(dlsym(RTLD_DEFAULT, name));
+        if (getCurrent != nullptr && getCurrent() != nullptr) {
+            return true;
+        }
+    }
+    return false;
+#endif
+}
+
+bool OpenGLBackend::setupOpenGL() {
+    // GL calls without a current context are undefined, so headless callers stop here
+    if (!hasCurrentContext()) {
+        return false;
+    }
+
+    // Clear any existing errors
+    glGetError();
+
+    GLint maxTextureSize = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+
+    if (glGetError() != GL_NO_ERROR || maxTextureSize <= 0) {
+        std::cerr << "OpenGL context not usable" << std::endl;
+        return false;
+    }
+
+    if (width_ > maxTextureSize || height_ > maxTextureSize) {
+        std::cerr << "Texture size exceeds GL_MAX_TEXTURE_SIZE" << std::endl;
+        return false;
+    }
+
+    // Enable blending for transparency (if needed)
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    return true;
+}
+
+bool OpenGLBackend::createTexture() {
+    glGenTextures(1, &textureId_);
+
+    if (textureId_ == 0) {
+        std::cerr << "Failed to generate OpenGL texture" << std::endl;
+        return false;
+    }
+
+    glBindTexture(GL_TEXTURE_2D, textureId_);
+
+    // Set texture parameters; REPEAT on S lets the shader scroll by the ring offset
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    // Create texture with initial data (opaque black)
+    std::vector<uint32_t> initialData(static_cast<size_t>(width_) * height_, opaqueBlack());
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width_, height_, 0,
+                 GL_RGBA, GL_UNSIGNED_BYTE, initialData.data());
+
+    if (glGetError() != GL_NO_ERROR) {
+        std::cerr << "Failed to create OpenGL texture" << std::endl;
+        glDeleteTextures(1, &textureId_);
+        textureId_ = 0;
+        return false;
+    }
+
+    return true;
+}
+
+void OpenGLBackend::writeColumn(int x, const uint32_t* column) {
+    glBindTexture(GL_TEXTURE_2D, textureId_);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, x, 0, 1, height_,
+                    GL_RGBA, GL_UNSIGNED_BYTE, column);
+}
+
+void OpenGLBackend::writeColumns(int x, int count, const uint32_t* pixels, int rowStride) {
+    glBindTexture(GL_TEXTURE_2D, textureId_);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, rowStride);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, x, 0, count, height_,
+                    GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+}
+
+#ifndef __APPLE__
+bool OpenGLBackend::requestReadback() {
+    if (textureId_ == 0 || readbackFence_ != nullptr) {
+        return false;
+    }
+
+    const GLsizeiptr byteSize = static_cast<GLsizeiptr>(width_) * height_ * 4;
+    if (packBuffer_ == 0) {
+        glGenBuffers(1, &packBuffer_);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, packBuffer_);
+        glBufferData(GL_PIXEL_PACK_BUFFER, byteSize, nullptr, GL_STREAM_READ);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+
+    GLint previousReadFbo = 0;
+    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previousReadFbo);
+
+    if (readFramebuffer_ == 0) {
+        glGenFramebuffers(1, &readFramebuffer_);
+    }
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, readFramebuffer_);
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textureId_, 0);
+
+    bool ok = glCheckFramebufferStatus(GL_READ_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    if (ok) {
+        // With a pack buffer bound, glReadPixels only queues the copy
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, packBuffer_);
+        glPixelStorei(GL_PACK_ALIGNMENT, 4);
+        glReadPixels(0, 0, width_, height_, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+        readbackFence_ = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        // Make sure the fence reaches the GPU so polling can observe it
+        glFlush();
+        ok = readbackFence_ != nullptr;
+    } else {
+        std::cerr << "Readback framebuffer incomplete" << std::endl;
+    }
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, static_cast<GLuint>(previousReadFbo));
+    return ok;
+}
+
+bool OpenGLBackend::pollReadback(std::vector<uint8_t>& pixels) {
+    if (readbackFence_ == nullptr) {
+        return false;
+    }
+
+    GLsync fence = static_cast<GLsync>(readbackFence_);
+    const GLenum status = glClientWaitSync(fence, 0, 0);
+    if (status == GL_TIMEOUT_EXPIRED) {
+        return false;
+    }
+
+    glDeleteSync(fence);
+    readbackFence_ = nullptr;
+    if (status == GL_WAIT_FAILED) {
+        return false;
+    }
+
+    const size_t byteSize = static_cast<size_t>(width_) * height_ * 4;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, packBuffer_);
+    const void* mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, byteSize, GL_MAP_READ_BIT);
+    bool ok = mapped != nullptr;
+    if (ok) {
+        pixels.resize(byteSize);
+        std::memcpy(pixels.data(), mapped, byteSize);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    return ok;
+}
+
+void OpenGLBackend::releaseReadback() {
+    if (readbackFence_ != nullptr) {
+        glDeleteSync(static_cast<GLsync>(readbackFence_));
+        readbackFence_ = nullptr;
+    }
+    if (packBuffer_ != 0) {
+        glDeleteBuffers(1, &packBuffer_);
+        packBuffer_ = 0;
+    }
+    if (readFramebuffer_ != 0) {
+        glDeleteFramebuffers(1, &readFramebuffer_);
+        readFramebuffer_ = 0;
+    }
+}
+#else
+// The legacy macOS GL headers lack sync objects; callers fall back to the CPU path
+bool OpenGLBackend::requestReadback() {
+    return false;
+}
+
+bool OpenGLBackend::pollReadback(std::vector<uint8_t>& pixels) {
+    (void)pixels;
+    return false;
+}
+
+void OpenGLBackend::releaseReadback() {}
+#endif
+
+void OpenGLBackend::shutdown() {
+    releaseReadback();
+    if (textureId_ != 0) {
+        glDeleteTextures(1, &textureId_);
+        textureId_ = 0;
+    }
+}
+
+std::unique_ptr<RenderBackend> createRenderBackend(RenderBackendType type, int width, int height) {
+    if (type == RenderBackendType::OPENGL || type == RenderBackendType::AUTO) {
+        std::unique_ptr<RenderBackend> backend(new OpenGLBackend());
+        if (backend->initialize(width, height)) {
+            return backend;
+        }
+        if (type == RenderBackendType::OPENGL) {
+            return nullptr;
+        }
+    }
+
+    std::unique_ptr<RenderBackend> backend(new CpuRasterBackend());
+    if (!backend->initialize(width, height)) {
+        return nullptr;
+    }
+    return backend;
+}
+
+} // namespace melspectrogram
@@ -0,0 +1,173 @@
+#include "resampler.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace melspectrogram {
+
+namespace {
+    constexpr double PI = 3.14159265358979323846;
+    constexpr double KAISER_BETA = 8.0;  // About 80 dB of stopband attenuation
+    // Stopband attenuation for KAISER_BETA, inverting Kaiser's beta = 0.1102 (A - 8.7)
+    constexpr double KAISER_ATTENUATION_DB = KAISER_BETA / 0.1102 + 8.7;
+
+    int greatestCommonDivisor(int a, int b) {
+        while (b != 0) {
+            const int t = a % b;
+            a = b;
+            b = t;
+        }
+        return a;
+    }
+
+    // Zeroth-order modified Bessel function of the first kind, by its power series
+    double besselI0(double x) {
+        double sum = 1.0;
+        double term = 1.0;
+        const double quarterSquare = x * x / 4.0;
+        for (int k = 1; k < 50 && term > sum * 1e-12; ++k) {
+            term *= quarterSquare / (static_cast<double>(k) * k);
+            sum += term;
+        }
+        return sum;
+    }
+
+    // Taps is a multiple of 4, so there is no scalar tail
+    inline float dot(const float* taps, const float* samples, int count) {
+#if defined(__SSE2__)
+        __m128 sum = _mm_setzero_ps();
+        for (int i = 0; i < count; i += 4) {
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(taps + i), _mm_loadu_ps(samples + i)));
+        }
+        sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+        sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(1, 1, 1, 1)));
+        return _mm_cvtss_f32(sum);
+#elif defined(__ARM_NEON)
+        float32x4_t sum = vdupq_n_f32(0.0f);
+        for (int i = 0; i < count; i += 4) {
+            sum = vmlaq_f32(sum, vld1q_f32(taps + i), vld1q_f32(samples + i));
+        }
+        const float32x2_t pair = vadd_f32(vget_low_f32(sum), vget_high_f32(sum));
+        return vget_lane_f32(vpadd_f32(pair, pair), 0);
+#else
+        float sum = 0.0f;
+        for (int i = 0; i < count; ++i) {
+            sum += taps[i] * samples[i];
+        }
+        return sum;
+#endif
+    }
+}
+
+int canonicalAnalysisRate(int inputRate, float maxFreq) {
+    for (int rate : {16000, 32000}) {
+        if (rate < inputRate && maxFreq <= Resampler::getPassbandEdge(inputRate, rate)) {
+            return rate;
+        }
+    }
+    return inputRate;
+}
+
+float Resampler::getPassbandEdge(int inputRate, int outputRate, int zeroCrossings, float rolloff) {
+    const double nyquist = 0.5 * std::min(std::max(inputRate, 1), std::max(outputRate, 1));
+    const double cutoff = std::max(0.1f, std::min(rolloff, 1.0f)) * nyquist;
+    // Kaiser's estimate: a filter N samples long has a transition (A - 7.95) / (14.36 N) wide,
+    // and designFilter makes N zeroCrossings / cutoff
+    const double transition = (KAISER_ATTENUATION_DB - 7.95) / (14.36 * std::max(zeroCrossings, 1)) * cutoff;
+    return static_cast<float>(cutoff - transition / 2.0);
+}
+
+Resampler::Resampler(int inputRate, int outputRate, int zeroCrossings, float rolloff)
+    : inputRate_(std::max(inputRate, 1)), outputRate_(std::max(outputRate, 1)) {
+    const int divisor = greatestCommonDivisor(inputRate_, outputRate_);
+    upFactor_ = outputRate_ / divisor;
+    downFactor_ = inputRate_ / divisor;
+    designFilter(std::max(zeroCrossings, 1), std::max(0.1f, std::min(rolloff, 1.0f)));
+    reset();
+}
+
+void Resampler::designFilter(int zeroCrossings, float rolloff) {
+    // Cutoff in cycles per input sample; the sinc's zero crossings are 1 / (2 cutoff) input samples apart
+    const double cutoff = rolloff * 0.5 * std::min(1.0, static_cast<double>(outputRate_) / inputRate_);
+    taps_ = static_cast<int>(std::ceil(zeroCrossings / cutoff));
+    taps_ = (taps_ + 3) / 4 * 4;
+
+    const int length = upFactor_ * taps_;
+    const double centre = (length - 1) / 2.0;
+    const double norm = besselI0(KAISER_BETA);
+    std::vector<double> prototype(length);
+    for (int k = 0; k < length; ++k) {
+        const double t = (k - centre) / upFactor_;  // In input samples
+        const double x = 2.0 * cutoff * t;
+        const double sinc = std::abs(x) < 1e-12 ? 1.0 : std::sin(PI * x) / (PI * x);
+        const double r = (k - centre) / (centre + 0.5);
+        const double window = besselI0(KAISER_BETA * std::sqrt(std::max(0.0, 1.0 - r * r))) / norm;
+        prototype[k] = 2.0 * cutoff * sinc * window;
+    }
+
+    // Phase p sees input x[i - j] through prototype[p + j * L]; rows run oldest sample first,
+    // each normalized to unit DC gain
+    phases_.assign(static_cast<size_t>(length), 0.0f);
+    for (int p = 0; p < upFactor_; ++p) {
+        double sum = 0.0;
+        for (int j = 0; j < taps_; ++j) {
+            sum += prototype[p + j * upFactor_];
+        }
+        float* row = phases_.data() + static_cast<size_t>(p) * taps_;
+        for (int j = 0; j < taps_; ++j) {
+            row[taps_ - 1 - j] = static_cast<float>(prototype[p + j * upFactor_] / sum);
+        }
+    }
+}
+
+double Resampler::getDelay() const {
+    // Prototype centre, in input samples, converted to output samples
+    const double centre = (upFactor_ * taps_ - 1) / 2.0 / upFactor_;
+    return centre * outputRate_ / inputRate_;
+}
+
+size_t Resampler::getMaxOutput(size_t count) const {
+    const size_t available = buffer_.size() + count;
+    if (available <= position_) {
+        return 0;
+    }
+    return (available - position_) * upFactor_ / downFactor_ + 1;
+}
+
+size_t Resampler::process(const int16_t* input, size_t count, int16_t* output, size_t capacity) {
+    const size_t start = buffer_.size();
+    buffer_.resize(start + count);
+    for (size_t i = 0; i < count; ++i) {
+        buffer_[start + i] = input[i];
+    }
+
+    size_t written = 0;
+    while (position_ < buffer_.size() && written < capacity) {
+        const float* samples = buffer_.data() + (position_ + 1 - taps_);
+        const float value = dot(phases_.data() + static_cast<size_t>(phase_) * taps_, samples, taps_);
+        output[written++] = static_cast<int16_t>(std::max(-32768.0f, std::min(32767.0f, std::round(value))));
+
+        phase_ += downFactor_;
+        position_ += phase_ / upFactor_;
+        phase_ %= upFactor_;
+    }
+
+    // Keep the history the next output reaches back into; capacity stays for the next call
+    const size_t drop = std::min(position_ + 1 - taps_, buffer_.size());
+    buffer_.erase(buffer_.begin(), buffer_.begin() + drop);
+    position_ -= drop;
+    return written;
+}
+
+void Resampler::reset() {
+    buffer_.assign(static_cast<size_t>(taps_ - 1), 0.0f);
+    position_ = static_cast<size_t>(taps_ - 1);
+    phase_ = 0;
+}
+
+} // namespace melspectrogram
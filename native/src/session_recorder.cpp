@@ -0,0 +1,510 @@
+#include "session_recorder.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace melspectrogram {
+
+namespace {
+    constexpr size_t BLOCK_ALIGNMENT = 4096;
+
+    // Sample data starts here; the gap before the data chunk is a JUNK chunk
+    constexpr size_t WAV_DATA_OFFSET = 4096;
+
+    void putU32(uint8_t* p, uint32_t value) {
+        p[0] = static_cast<uint8_t>(value);
+        p[1] = static_cast<uint8_t>(value >> 8);
+        p[2] = static_cast<uint8_t>(value >> 16);
+        p[3] = static_cast<uint8_t>(value >> 24);
+    }
+
+    void putU16(uint8_t* p, uint16_t value) {
+        p[0] = static_cast<uint8_t>(value);
+        p[1] = static_cast<uint8_t>(value >> 8);
+    }
+
+    void makeWavHeader(uint8_t* header, int sampleRate, uint32_t dataBytes) {
+        std::memset(header, 0, WAV_DATA_OFFSET);
+        std::memcpy(header, "RIFF", 4);
+        putU32(header + 4, static_cast<uint32_t>(WAV_DATA_OFFSET - 8) + dataBytes);
+        std::memcpy(header + 8, "WAVE", 4);
+
+        std::memcpy(header + 12, "fmt ", 4);
+        putU32(header + 16, 16);
+        putU16(header + 20, 1);                                    // PCM
+        putU16(header + 22, 1);                                    // Mono
+        putU32(header + 24, static_cast<uint32_t>(sampleRate));
+        putU32(header + 28, static_cast<uint32_t>(sampleRate) * 2);
+        putU16(header + 32, 2);                                    // Block align
+        putU16(header + 34, 16);                                   // Bits per sample
+
+        std::memcpy(header + 36, "JUNK", 4);
+        putU32(header + 40, static_cast<uint32_t>(WAV_DATA_OFFSET - 8 - 44));
+
+        std::memcpy(header + WAV_DATA_OFFSET - 8, "data", 4);
+        putU32(header + WAV_DATA_OFFSET - 4, dataBytes);
+    }
+}
+
+constexpr uint64_t SessionRecorder::MAX_WAV_DATA_BYTES;
+
+// BlockChannel
+
+void SessionRecorder::BlockChannel::allocate(size_t blockSize, size_t itemSize, int blocks) {
+    itemBytes = itemSize;
+    blockBytes = std::max(itemSize, blockSize / itemSize * itemSize);
+    numBlocks = std::max(2, blocks);
+
+    blockStride = (blockBytes + BLOCK_ALIGNMENT - 1) / BLOCK_ALIGNMENT * BLOCK_ALIGNMENT;
+    storage.assign(blockStride * numBlocks + BLOCK_ALIGNMENT, 0);
+    const uintptr_t raw = reinterpret_cast<uintptr_t>(storage.data());
+    base = storage.data() + ((raw + BLOCK_ALIGNMENT - 1) / BLOCK_ALIGNMENT * BLOCK_ALIGNMENT - raw);
+
+    const size_t slots = static_cast<size_t>(numBlocks) + 1;
+    fullSlots.assign(slots, 0);
+    fullLengths.assign(slots, 0);
+    freeSlots.assign(slots, 0);
+    for (int i = 0; i < numBlocks; ++i) {
+        freeSlots[i] = static_cast<uint32_t>(i);
+    }
+    freeHead = 0;
+    freeTail = static_cast<size_t>(numBlocks);
+    fullHead = 0;
+    fullTail = 0;
+    fillBlock = -1;
+    fillBytes = 0;
+    itemsDropped = 0;
+}
+
+size_t SessionRecorder::BlockChannel::push(const uint8_t* data, size_t bytes) {
+    const size_t slots = freeSlots.size();
+    size_t accepted = 0;
+    while (accepted < bytes) {
+        if (fillBlock < 0) {
+            const size_t head = freeHead.load(std::memory_order_relaxed);
+            if (head == freeTail.load(std::memory_order_acquire)) {
+                break;
+            }
+            fillBlock = static_cast<int>(freeSlots[head]);
+            freeHead.store((head + 1) % slots, std::memory_order_release);
+            fillBytes = 0;
+        }
+
+        const size_t count = std::min(bytes - accepted, blockBytes - fillBytes);
+        std::memcpy(block(static_cast<uint32_t>(fillBlock)) + fillBytes, data + accepted, count);
+        fillBytes += count;
+        accepted += count;
+        if (fillBytes == blockBytes) {
+            handOver();
+        }
+    }
+
+    if (accepted < bytes) {
+        itemsDropped.fetch_add((bytes - accepted) / itemBytes, std::memory_order_relaxed);
+    }
+    return accepted;
+}
+
+void SessionRecorder::BlockChannel::handOver() {
+    if (fillBlock < 0) {
+        return;
+    }
+    if (fillBytes > 0) {
+        const size_t tail = fullTail.load(std::memory_order_relaxed);
+        fullSlots[tail] = static_cast<uint32_t>(fillBlock);
+        fullLengths[tail] = static_cast<uint32_t>(fillBytes);
+        fullTail.store((tail + 1) % fullSlots.size(), std::memory_order_release);
+    } else {
+        release(static_cast<uint32_t>(fillBlock));
+    }
+    fillBlock = -1;
+    fillBytes = 0;
+}
+
+bool SessionRecorder::BlockChannel::popFull(uint32_t& index, uint32_t& length) {
+    const size_t head = fullHead.load(std::memory_order_relaxed);
+    if (head == fullTail.load(std::memory_order_acquire)) {
+        return false;
+    }
+    index = fullSlots[head];
+    length = fullLengths[head];
+    fullHead.store((head + 1) % fullSlots.size(), std::memory_order_release);
+    return true;
+}
+
+void SessionRecorder::BlockChannel::release(uint32_t index) {
+    const size_t tail = freeTail.load(std::memory_order_relaxed);
+    freeSlots[tail] = index;
+    freeTail.store((tail + 1) % freeSlots.size(), std::memory_order_release);
+}
+
+int SessionRecorder::BlockChannel::backlog() const {
+    const size_t slots = fullSlots.size();
+    if (slots == 0) return 0;
+    const size_t head = fullHead.load(std::memory_order_acquire);
+    const size_t tail = fullTail.load(std::memory_order_acquire);
+    return static_cast<int>((tail + slots - head) % slots);
+}
+
+// SessionRecorder
+
+SessionRecorder::SessionRecorder(const RecorderConfig& config)
+    : config_(config), pcmFile_(nullptr), pcmSegment_(0), pcmSegmentSamples_(0),
+      segmentSamples_(0), melSegment_(0), melSegmentFrames_(0), melTotalFrames_(0), segmentFrames_(0),
+      shouldStop_(false) {
+}
+
+SessionRecorder::~SessionRecorder() {
+    stop();
+}
+
+bool SessionRecorder::start() {
+    if (running_) {
+        return false;
+    }
+    if (config_.pathPrefix.empty() || config_.sampleRate <= 0 || config_.numMelBands <= 0 ||
+        config_.hopSize <= 0 || config_.pcmSampleRate < 0 || config_.rotateSeconds < 0.0 || (!config_.recordPcm && !config_.recordMel)) {
+        setError("Invalid recorder configuration");
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(statsMutex_);
+        stats_ = RecorderStats{};
+        error_.clear();
+    }
+
+    // All memory the producers touch is allocated here, before any real-time thread pushes
+    if (config_.recordPcm) {
+        pcm_.allocate(config_.blockBytes, sizeof(int16_t), config_.backlogBlocks);
+    }
+    if (config_.recordMel) {
+        mel_.allocate(config_.blockBytes, sizeof(float) * config_.numMelBands, config_.backlogBlocks);
+    }
+
+    // A WAV's 32-bit sizes cap PCM segments, and the mel stream follows so the segments still line up
+    double rotateSeconds = config_.rotateSeconds;
+    uint64_t maxSamples = UINT64_MAX;
+    if (config_.recordPcm) {
+        const uint64_t maxBytes = config_.maxWavBytes > 0 ? std::min(config_.maxWavBytes, MAX_WAV_DATA_BYTES)
+                                                          : MAX_WAV_DATA_BYTES;
+        maxSamples = std::max<uint64_t>(maxBytes / sizeof(int16_t), 1);
+        const double maxSeconds = static_cast<double>(maxSamples) / getPcmSampleRate();
+        if (rotateSeconds == 0.0 || rotateSeconds > maxSeconds) {
+            rotateSeconds = maxSeconds;
+        }
+    }
+
+    // Each stream rotates on its own count; both cover rotateSeconds of audio
+    segmentSamples_ = std::min(static_cast<uint64_t>(rotateSeconds * getPcmSampleRate()), maxSamples);
+    segmentFrames_ = static_cast<uint64_t>(rotateSeconds * config_.sampleRate) /
+                     static_cast<uint64_t>(config_.hopSize);
+    if (rotateSeconds > 0.0) {
+        segmentSamples_ = std::max<uint64_t>(segmentSamples_, 1);
+        segmentFrames_ = std::max<uint64_t>(segmentFrames_, 1);
+    }
+    pcmSegment_ = 0;
+    pcmSegmentSamples_ = 0;
+    melSegment_ = 0;
+    melSegmentFrames_ = 0;
+    melTotalFrames_ = 0;
+
+    // Open the first segments up front so a bad path fails here rather than on the I/O thread
+    if ((config_.recordPcm && !openPcmSegment()) || (config_.recordMel && !openMelSegment())) {
+        closePcmSegment();
+        closeMelSegment();
+        return false;
+    }
+
+    shouldStop_ = false;
+    running_ = true;
+    thread_ = std::thread(&SessionRecorder::ioThread, this);
+    return true;
+}
+
+void SessionRecorder::stop() {
+    if (!thread_.joinable()) {
+        return;
+    }
+
+    // The producers are done, so their partial blocks can be handed over from here
+    if (config_.recordPcm) pcm_.handOver();
+    if (config_.recordMel) mel_.handOver();
+
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex_);
+        shouldStop_ = true;
+    }
+    wakeCV_.notify_all();
+    thread_.join();
+    running_ = false;
+}
+
+bool SessionRecorder::pushPcm(const int16_t* samples, size_t count) {
+    if (!running_ || !config_.recordPcm || samples == nullptr) {
+        return false;
+    }
+    const size_t bytes = count * sizeof(int16_t);
+    return pcm_.push(reinterpret_cast<const uint8_t*>(samples), bytes) == bytes;
+}
+
+bool SessionRecorder::pushMel(const float* frames, size_t numFrames) {
+    if (!running_ || !config_.recordMel || frames == nullptr) {
+        return false;
+    }
+    const size_t bytes = numFrames * mel_.itemBytes;
+    return mel_.push(reinterpret_cast<const uint8_t*>(frames), bytes) == bytes;
+}
+
+void SessionRecorder::ioThread() {
+    while (true) {
+        bool stopping;
+        {
+            std::unique_lock<std::mutex> lock(wakeMutex_);
+            wakeCV_.wait_for(lock, std::chrono::milliseconds(std::max(1, config_.pollIntervalMs)),
+                             [this] { return shouldStop_; });
+            stopping = shouldStop_;
+        }
+        drain();
+        if (stopping) {
+            break;
+        }
+    }
+
+    closePcmSegment();
+    closeMelSegment();
+}
+
+void SessionRecorder::drain() {
+    {
+        std::lock_guard<std::mutex> lock(statsMutex_);
+        const int backlog = (config_.recordPcm ? pcm_.backlog() : 0) + (config_.recordMel ? mel_.backlog() : 0);
+        stats_.maxBacklogBlocks = std::max(stats_.maxBacklogBlocks, backlog);
+    }
+
+    // Interleave the streams so neither starves the other under load
+    bool more = true;
+    while (more) {
+        more = false;
+        uint32_t index;
+        uint32_t length;
+        if (config_.recordPcm && pcm_.popFull(index, length)) {
+            writePcm(pcm_.block(index), length);
+            pcm_.release(index);
+            more = true;
+        }
+        if (config_.recordMel && mel_.popFull(index, length)) {
+            writeMel(reinterpret_cast<const float*>(mel_.block(index)), length / mel_.itemBytes);
+            mel_.release(index);
+            more = true;
+        }
+    }
+}
+
+bool SessionRecorder::writePcm(const uint8_t* data, size_t bytes) {
+    size_t samples = bytes / sizeof(int16_t);
+    while (samples > 0) {
+        if (pcmFile_ == nullptr) {
+            return false;
+        }
+        if (segmentSamples_ > 0 && pcmSegmentSamples_ == segmentSamples_) {
+            closePcmSegment();
+            pcmSegment_++;
+            if (!openPcmSegment()) {
+                return false;
+            }
+        }
+
+        size_t count = samples;
+        if (segmentSamples_ > 0) {
+            count = static_cast<size_t>(std::min<uint64_t>(count, segmentSamples_ - pcmSegmentSamples_));
+        }
+
+        auto startTime = std::chrono::steady_clock::now();
+        const size_t written = std::fwrite(data, sizeof(int16_t), count, pcmFile_);
+        const float ms = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - startTime).count() / 1000.0f;
+        recordWrite(ms, written * sizeof(int16_t));
+
+        pcmSegmentSamples_ += written;
+        {
+            std::lock_guard<std::mutex> lock(statsMutex_);
+            stats_.pcmSamplesWritten += written;
+        }
+        if (written != count) {
+            setError("Failed to write PCM segment");
+            return false;
+        }
+        data += count * sizeof(int16_t);
+        samples -= count;
+    }
+    return true;
+}
+
+bool SessionRecorder::writeMel(const float* frames, size_t numFrames) {
+    const size_t bands = static_cast<size_t>(config_.numMelBands);
+    while (numFrames > 0) {
+        if (!melWriter_) {
+            return false;
+        }
+        if (segmentFrames_ > 0 && melSegmentFrames_ == segmentFrames_) {
+            closeMelSegment();
+            melSegment_++;
+            if (!openMelSegment()) {
+                return false;
+            }
+        }
+
+        size_t count = numFrames;
+        if (segmentFrames_ > 0) {
+            count = static_cast<size_t>(std::min<uint64_t>(count, segmentFrames_ - melSegmentFrames_));
+        }
+
+        auto startTime = std::chrono::steady_clock::now();
+        const uint64_t before = melWriter_->getBytesWritten();
+        const bool ok = melWriter_->append(frames, count);
+        const float ms = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - startTime).count() / 1000.0f;
+        recordWrite(ms, static_cast<size_t>(melWriter_->getBytesWritten() - before));
+
+        if (!ok) {
+            setError(melWriter_->getError());
+            return false;
+        }
+        melSegmentFrames_ += count;
+        melTotalFrames_ += count;
+        {
+            std::lock_guard<std::mutex> lock(statsMutex_);
+            stats_.melFramesWritten += count;
+        }
+        frames += count * bands;
+        numFrames -= count;
+    }
+    return true;
+}
+
+std::string SessionRecorder::segmentPath(int segment, const char* extension) const {
+    char suffix[16];
+    std::snprintf(suffix, sizeof(suffix), "_%04d", segment);
+    return config_.pathPrefix + suffix + extension;
+}
+
+bool SessionRecorder::openPcmSegment() {
+    const std::string path = segmentPath(pcmSegment_, ".wav");
+    pcmFile_ = std::fopen(path.c_str(), "wb");
+    if (pcmFile_ == nullptr) {
+        setError("Cannot create " + path);
+        return false;
+    }
+    // Blocks are already large; stdio buffering would only add a copy
+    std::setvbuf(pcmFile_, nullptr, _IONBF, 0);
+
+    std::vector<uint8_t> header(WAV_DATA_OFFSET);
+    makeWavHeader(header.data(), getPcmSampleRate(), 0);
+    if (std::fwrite(header.data(), 1, header.size(), pcmFile_) != header.size()) {
+        setError("Cannot write " + path);
+        std::fclose(pcmFile_);
+        pcmFile_ = nullptr;
+        return false;
+    }
+    pcmSegmentSamples_ = 0;
+
+    std::lock_guard<std::mutex> lock(statsMutex_);
+    stats_.segments = std::max(stats_.segments, pcmSegment_ + 1);
+    stats_.bytesWritten += header.size();
+    return true;
+}
+
+void SessionRecorder::closePcmSegment() {
+    if (pcmFile_ == nullptr) {
+        return;
+    }
+
+    // Patch the sizes now that the data length is known
+    uint8_t header[WAV_DATA_OFFSET];
+    const uint32_t dataBytes = static_cast<uint32_t>(pcmSegmentSamples_ * sizeof(int16_t));
+    makeWavHeader(header, getPcmSampleRate(), dataBytes);
+    if (std::fseek(pcmFile_, 4, SEEK_SET) != 0 || std::fwrite(header + 4, 4, 1, pcmFile_) != 1 ||
+        std::fseek(pcmFile_, static_cast<long>(WAV_DATA_OFFSET - 4), SEEK_SET) != 0 ||
+        std::fwrite(header + WAV_DATA_OFFSET - 4, 4, 1, pcmFile_) != 1) {
+        setError("Failed to finalize PCM segment");
+    }
+    std::fclose(pcmFile_);
+    pcmFile_ = nullptr;
+}
+
+bool SessionRecorder::openMelSegment() {
+    MelArchiveConfig archive;
+    archive.numMelBands = config_.numMelBands;
+    archive.bitDepth = config_.melBitDepth;
+    archive.dynamicRangeDb = config_.melDynamicRangeDb;
+    archive.sampleRate = config_.sampleRate;
+    archive.hopSize = config_.hopSize;
+    archive.startTimeUs = static_cast<int64_t>(
+        static_cast<double>(melTotalFrames_) * config_.hopSize * 1e6 / config_.sampleRate);
+
+    const std::string path = segmentPath(melSegment_, ".mela");
+    std::unique_ptr<MelArchiveWriter> writer(new MelArchiveWriter());
+    if (!writer->open(path, archive)) {
+        setError(writer->getError());
+        return false;
+    }
+    melWriter_ = std::move(writer);
+    melSegmentFrames_ = 0;
+
+    std::lock_guard<std::mutex> lock(statsMutex_);
+    stats_.segments = std::max(stats_.segments, melSegment_ + 1);
+    return true;
+}
+
+void SessionRecorder::closeMelSegment() {
+    if (!melWriter_) {
+        return;
+    }
+    const uint64_t before = melWriter_->getBytesWritten();
+    if (!melWriter_->close()) {
+        setError(melWriter_->getError());
+    }
+    {
+        std::lock_guard<std::mutex> lock(statsMutex_);
+        stats_.bytesWritten += melWriter_->getBytesWritten() - before;
+    }
+    melWriter_.reset();
+}
+
+void SessionRecorder::recordWrite(float ms, size_t bytes) {
+    std::lock_guard<std::mutex> lock(statsMutex_);
+    stats_.bytesWritten += bytes;
+    stats_.averageWriteMs = stats_.averageWriteMs == 0.0f ? ms : stats_.averageWriteMs * 0.9f + ms * 0.1f;
+    stats_.maxWriteMs = std::max(stats_.maxWriteMs, ms);
+}
+
+void SessionRecorder::setError(const std::string& message) {
+    std::lock_guard<std::mutex> lock(statsMutex_);
+    error_ = message;
+    stats_.writeErrors++;
+}
+
+RecorderStats SessionRecorder::getStats() const {
+    RecorderStats stats;
+    {
+        std::lock_guard<std::mutex> lock(statsMutex_);
+        stats = stats_;
+    }
+    if (config_.recordPcm && pcm_.numBlocks > 0) {
+        stats.pcmSamplesDropped = pcm_.itemsDropped.load(std::memory_order_relaxed);
+        stats.backlogBlocks += pcm_.backlog();
+    }
+    if (config_.recordMel && mel_.numBlocks > 0) {
+        stats.melFramesDropped = mel_.itemsDropped.load(std::memory_order_relaxed);
+        stats.backlogBlocks += mel_.backlog();
+    }
+    return stats;
+}
+
+std::string SessionRecorder::getError() const {
+    std::lock_guard<std::mutex> lock(statsMutex_);
+    return error_;
+}
+
+} // namespace melspectrogram
@@ -0,0 +1,469 @@
+#include "spectrogram_exporter.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#ifdef FLUTTER_SP_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace melspectrogram {
+
+namespace {
+    constexpr size_t OUTPUT_CHUNK_SIZE = 64 * 1024;
+    constexpr size_t MAX_STORED_BLOCK = 65535;
+
+    const uint32_t* crcTable() {
+        static const std::vector<uint32_t> table = [] {
+            std::vector<uint32_t> t(256);
+            for (uint32_t n = 0; n < 256; ++n) {
+                uint32_t c = n;
+                for (int k = 0; k < 8; ++k) {
+                    c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                }
+                t[n] = c;
+            }
+            return t;
+        }();
+        return table.data();
+    }
+
+    uint32_t updateCrc(uint32_t crc, const uint8_t* data, size_t size) {
+        const uint32_t* table = crcTable();
+        crc = ~crc;
+        for (size_t i = 0; i < size; ++i) {
+            crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+        }
+        return ~crc;
+    }
+
+    void putBigEndian32(uint8_t* dst, uint32_t value) {
+        dst[0] = static_cast<uint8_t>(value >> 24);
+        dst[1] = static_cast<uint8_t>(value >> 16);
+        dst[2] = static_cast<uint8_t>(value >> 8);
+        dst[3] = static_cast<uint8_t>(value);
+    }
+
+    class FileSink {
+    public:
+        explicit FileSink(const std::string& path) : out_(path, std::ios::binary | std::ios::trunc) {}
+
+        bool isOpen() const { return out_.is_open(); }
+        bool good() const { return out_.good(); }
+        size_t bytesWritten() const { return bytesWritten_; }
+
+        void write(const uint8_t* data, size_t size) {
+            out_.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(size));
+            bytesWritten_ += size;
+        }
+
+        void close() { out_.close(); }
+
+    private:
+        std::ofstream out_;
+        size_t bytesWritten_ = 0;
+    };
+
+    /**
+     * Streams a zlib-wrapped deflate stream into PNG IDAT chunks of at most OUTPUT_CHUNK_SIZE.
+     * Level 0 (or builds without zlib) emits stored blocks.
+     */
+    class PngStreamWriter {
+    public:
+        PngStreamWriter(FileSink& sink, int width, int height, int level)
+            : sink_(sink), level_(level), adler_(1) {
+            static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+            sink_.write(signature, sizeof(signature));
+
+            uint8_t ihdr[13];
+            putBigEndian32(ihdr, static_cast<uint32_t>(width));
+            putBigEndian32(ihdr + 4, static_cast<uint32_t>(height));
+            ihdr[8] = 8;   // Bit depth
+            ihdr[9] = 6;   // Color type RGBA
+            ihdr[10] = 0;  // Deflate
+            ihdr[11] = 0;  // Adaptive filtering
+            ihdr[12] = 0;  // No interlace
+            writeChunk("IHDR", ihdr, sizeof(ihdr));
+
+            output_.reserve(OUTPUT_CHUNK_SIZE);
+#ifdef FLUTTER_SP_HAVE_ZLIB
+            if (level_ > 0) {
+                std::memset(&zstream_, 0, sizeof(zstream_));
+                zlibActive_ = deflateInit(&zstream_, std::min(level_, 9)) == Z_OK;
+            }
+            if (zlibActive_) {
+                deflateBuffer_.resize(OUTPUT_CHUNK_SIZE);
+                return;
+            }
+#endif
+            // zlib header: deflate, 32K window, no preset dictionary, fastest
+            const uint8_t header[2] = {0x78, 0x01};
+            appendOutput(header, sizeof(header));
+            stored_.reserve(MAX_STORED_BLOCK);
+        }
+
+        ~PngStreamWriter() {
+#ifdef FLUTTER_SP_HAVE_ZLIB
+            if (zlibActive_) {
+                deflateEnd(&zstream_);
+            }
+#endif
+        }
+
+        bool writeRow(const uint8_t* row, size_t size) {
+#ifdef FLUTTER_SP_HAVE_ZLIB
+            if (zlibActive_) {
+                return deflateData(row, size, Z_NO_FLUSH);
+            }
+#endif
+            adler_ = updateAdler(adler_, row, size);
+            while (size > 0) {
+                const size_t take = std::min(size, MAX_STORED_BLOCK - stored_.size());
+                stored_.insert(stored_.end(), row, row + take);
+                row += take;
+                size -= take;
+                if (stored_.size() == MAX_STORED_BLOCK) {
+                    emitStoredBlock(false);
+                }
+            }
+            return true;
+        }
+
+        bool finish() {
+#ifdef FLUTTER_SP_HAVE_ZLIB
+            if (zlibActive_) {
+                if (!deflateData(nullptr, 0, Z_FINISH)) {
+                    return false;
+                }
+                flushIdat();
+                writeChunk("IEND", nullptr, 0);
+                return true;
+            }
+#endif
+            emitStoredBlock(true);
+            uint8_t trailer[4];
+            putBigEndian32(trailer, adler_);
+            appendOutput(trailer, sizeof(trailer));
+            flushIdat();
+            writeChunk("IEND", nullptr, 0);
+            return true;
+        }
+
+    private:
+        static uint32_t updateAdler(uint32_t adler, const uint8_t* data, size_t size) {
+            uint32_t a = adler & 0xFFFF;
+            uint32_t b = adler >> 16;
+            while (size > 0) {
+                // 5552 is the largest run that cannot overflow 32-bit sums
+                const size_t run = std::min<size_t>(size, 5552);
+                for (size_t i = 0; i < run; ++i) {
+                    a += data[i];
+                    b += a;
+                }
+                a %= 65521;
+                b %= 65521;
+                data += run;
+                size -= run;
+            }
+            return (b << 16) | a;
+        }
+
+        void emitStoredBlock(bool final) {
+            const uint16_t len = static_cast<uint16_t>(stored_.size());
+            const uint16_t nlen = static_cast<uint16_t>(~len);
+            const uint8_t header[5] = {
+                static_cast<uint8_t>(final ? 1 : 0),
+                static_cast<uint8_t>(len & 0xFF), static_cast<uint8_t>(len >> 8),
+                static_cast<uint8_t>(nlen & 0xFF), static_cast<uint8_t>(nlen >> 8)
+            };
+            appendOutput(header, sizeof(header));
+            appendOutput(stored_.data(), stored_.size());
+            stored_.clear();
+        }
+
+#ifdef FLUTTER_SP_HAVE_ZLIB
+        bool deflateData(const uint8_t* data, size_t size, int flush) {
+            zstream_.next_in = const_cast<Bytef*>(data);
+            zstream_.avail_in = static_cast<uInt>(size);
+            int result = Z_OK;
+            do {
+                zstream_.next_out = deflateBuffer_.data();
+                zstream_.avail_out = static_cast<uInt>(deflateBuffer_.size());
+                result = deflate(&zstream_, flush);
+                if (result == Z_STREAM_ERROR) {
+                    return false;
+                }
+                appendOutput(deflateBuffer_.data(), deflateBuffer_.size() - zstream_.avail_out);
+            } while (zstream_.avail_out == 0 || (flush == Z_FINISH && result != Z_STREAM_END));
+            return true;
+        }
+#endif
+
+        void appendOutput(const uint8_t* data, size_t size) {
+            while (size > 0) {
+                const size_t take = std::min(size, OUTPUT_CHUNK_SIZE - output_.size());
+                output_.insert(output_.end(), data, data + take);
+                data += take;
+                size -= take;
+                if (output_.size() == OUTPUT_CHUNK_SIZE) {
+                    flushIdat();
+                }
+            }
+        }
+
+        void flushIdat() {
+            if (!output_.empty()) {
+                writeChunk("IDAT", output_.data(), output_.size());
+                output_.clear();
+            }
+        }
+
+        void writeChunk(const char* type, const uint8_t* data, size_t size) {
+            uint8_t header[8];
+            putBigEndian32(header, static_cast<uint32_t>(size));
+            std::memcpy(header + 4, type, 4);
+            sink_.write(header, sizeof(header));
+            if (size > 0) {
+                sink_.write(data, size);
+            }
+
+            uint32_t crc = updateCrc(0, header + 4, 4);
+            crc = updateCrc(crc, data, size);
+            uint8_t trailer[4];
+            putBigEndian32(trailer, crc);
+            sink_.write(trailer, sizeof(trailer));
+        }
+
+        FileSink& sink_;
+        int level_;
+        uint32_t adler_;
+        std::vector<uint8_t> output_;
+        std::vector<uint8_t> stored_;
+#ifdef FLUTTER_SP_HAVE_ZLIB
+        z_stream zstream_;
+        bool zlibActive_ = false;
+        std::vector<uint8_t> deflateBuffer_;
+#endif
+    };
+
+    bool encodePng(const RingSnapshot& snapshot, FileSink& sink, const ExportOptions& options) {
+        const int width = snapshot.width;
+        const size_t rowBytes = static_cast<size_t>(width) * 4;
+        std::vector<uint8_t> raw(rowBytes);
+        std::vector<uint8_t> filtered(rowBytes + 1);
+
+        PngStreamWriter writer(sink, width, snapshot.height, options.compressionLevel);
+        for (int y = 0; y < snapshot.height; ++y) {
+            // Expand one row of the waterfall in time order
+            const uint32_t* bandColors = snapshot.bandColors.data() + snapshot.rowBand[y];
+            for (int x = 0; x < width; ++x) {
+                const int slot = (snapshot.ringOffset + x) % width;
+                std::memcpy(&raw[x * 4], bandColors + slot * snapshot.numMelBands, 4);
+            }
+
+            if (options.subFilter) {
+                filtered[0] = 1;
+                std::memcpy(&filtered[1], raw.data(), std::min<size_t>(4, rowBytes));
+                for (size_t i = 4; i < rowBytes; ++i) {
+                    filtered[i + 1] = static_cast<uint8_t>(raw[i] - raw[i - 4]);
+                }
+            } else {
+                filtered[0] = 0;
+                std::memcpy(&filtered[1], raw.data(), rowBytes);
+            }
+
+            if (!writer.writeRow(filtered.data(), filtered.size())) {
+                return false;
+            }
+        }
+        return writer.finish();
+    }
+
+    bool encodeRaw(const RingSnapshot& snapshot, FileSink& sink, ExportFormat format) {
+        const int width = snapshot.width;
+        const int bands = snapshot.numMelBands;
+        const float range = snapshot.maxValue - snapshot.minValue;
+        const float scale = range > 0.0f ? 255.0f / range : 0.0f;
+
+        std::vector<uint8_t> buffer;
+        buffer.reserve(OUTPUT_CHUNK_SIZE + bands * sizeof(float));
+        for (int x = 0; x < width; ++x) {
+            const int slot = (snapshot.ringOffset + x) % width;
+            const float* frame = snapshot.melValues.data() + static_cast<size_t>(slot) * bands;
+
+            if (format == ExportFormat::RAW_FLOAT32) {
+                const uint8_t* bytes = reinterpret_cast<const uint8_t*>(frame);
+                buffer.insert(buffer.end(), bytes, bytes + bands * sizeof(float));
+            } else {
+                for (int band = 0; band < bands; ++band) {
+                    float q = (frame[band] - snapshot.minValue) * scale;
+                    q = q > 0.0f ? q : 0.0f;
+                    q = q < 255.0f ? q : 255.0f;
+                    buffer.push_back(static_cast<uint8_t>(q + 0.5f));
+                }
+            }
+
+            if (buffer.size() >= OUTPUT_CHUNK_SIZE) {
+                sink.write(buffer.data(), buffer.size());
+                buffer.clear();
+            }
+        }
+        sink.write(buffer.data(), buffer.size());
+        return true;
+    }
+}
+
+SpectrogramExporter::SpectrogramExporter(size_t maxQueuedJobs)
+    : maxQueuedJobs_(std::max<size_t>(1, maxQueuedJobs)), activeJobs_(0) {
+    worker_ = std::thread(&SpectrogramExporter::workerThread, this);
+}
+
+SpectrogramExporter::~SpectrogramExporter() {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        shouldStop_ = true;
+    }
+    queueCV_.notify_all();
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+}
+
+bool SpectrogramExporter::exportAsync(const TextureRenderer& renderer, const std::string& path,
+                                      const ExportOptions& options, CompletionCallback callback) {
+    if (!renderer.isInitialized()) {
+        return false;
+    }
+
+    {
+        // Don't pay for the snapshot if the job would be rejected anyway
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        if (queue_.size() >= maxQueuedJobs_) {
+            std::lock_guard<std::mutex> statsLock(statsMutex_);
+            stats_.jobsRejected++;
+            return false;
+        }
+    }
+
+    RingSnapshot snapshot;
+    renderer.snapshotRing(snapshot);
+    return exportAsync(std::move(snapshot), path, options, std::move(callback));
+}
+
+bool SpectrogramExporter::exportAsync(RingSnapshot snapshot, const std::string& path,
+                                      const ExportOptions& options, CompletionCallback callback) {
+    if (snapshot.width <= 0 || snapshot.height <= 0 || path.empty()) {
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        if (queue_.size() >= maxQueuedJobs_ || shouldStop_) {
+            std::lock_guard<std::mutex> statsLock(statsMutex_);
+            stats_.jobsRejected++;
+            return false;
+        }
+        queue_.push_back(Job{std::move(snapshot), path, options, std::move(callback)});
+    }
+    queueCV_.notify_one();
+    return true;
+}
+
+bool SpectrogramExporter::waitIdle(int timeoutMs) {
+    std::unique_lock<std::mutex> lock(queueMutex_);
+    return idleCV_.wait_for(lock, std::chrono::milliseconds(timeoutMs),
+                            [this] { return queue_.empty() && activeJobs_ == 0; });
+}
+
+size_t SpectrogramExporter::getPendingJobs() const {
+    std::lock_guard<std::mutex> lock(queueMutex_);
+    return queue_.size() + activeJobs_;
+}
+
+SpectrogramExporter::Stats SpectrogramExporter::getStats() const {
+    std::lock_guard<std::mutex> lock(statsMutex_);
+    return stats_;
+}
+
+void SpectrogramExporter::workerThread() {
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex_);
+            queueCV_.wait(lock, [this] { return !queue_.empty() || shouldStop_; });
+
+            // Drain queued jobs before stopping so accepted exports are not lost
+            if (queue_.empty()) {
+                break;
+            }
+            job = std::move(queue_.front());
+            queue_.pop_front();
+            activeJobs_++;
+        }
+
+        auto startTime = std::chrono::steady_clock::now();
+        size_t bytes = 0;
+        const bool success = encodeToFile(job.snapshot, job.path, job.options, &bytes);
+        auto endTime = std::chrono::steady_clock::now();
+
+        {
+            std::lock_guard<std::mutex> lock(statsMutex_);
+            if (success) {
+                stats_.jobsCompleted++;
+                stats_.bytesWritten += bytes;
+            } else {
+                stats_.jobsFailed++;
+            }
+            stats_.lastEncodeTimeMs = std::chrono::duration<float, std::milli>(endTime - startTime).count();
+        }
+
+        if (job.callback) {
+            job.callback(job.path, success);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(queueMutex_);
+            activeJobs_--;
+        }
+        idleCV_.notify_all();
+    }
+}
+
+bool SpectrogramExporter::encodeToFile(const RingSnapshot& snapshot, const std::string& path,
+                                       const ExportOptions& options, size_t* bytesWritten) {
+    const std::string partialPath = path + ".part";
+    FileSink sink(partialPath);
+    if (!sink.isOpen()) {
+        std::cerr << "Failed to open export file: " << partialPath << std::endl;
+        return false;
+    }
+
+    bool ok = false;
+    if (options.format == ExportFormat::PNG) {
+        ok = encodePng(snapshot, sink, options);
+    } else {
+        ok = encodeRaw(snapshot, sink, options.format);
+    }
+
+    ok = ok && sink.good();
+    sink.close();
+
+    // rename() does not replace an existing file on every platform
+    if (ok) {
+        std::remove(path.c_str());
+    }
+    if (!ok || std::rename(partialPath.c_str(), path.c_str()) != 0) {
+        std::remove(partialPath.c_str());
+        return false;
+    }
+
+    if (bytesWritten != nullptr) {
+        *bytesWritten = sink.bytesWritten();
+    }
+    return true;
+}
+
+} // namespace melspectrogram
@@ -2,17 +2,74 @@
 #include <algorithm>
 #include <chrono>
 #include <cmath>
+#include <cstring>
 #include <iostream>
 
-#ifdef __APPLE__
-#include <OpenGL/gl.h>
-#include <OpenGL/glext.h>
-#else
-#include <GLES3/gl3.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
 #endif
 
 namespace melspectrogram {
 
+namespace {
+    constexpr int COLOR_LUT_SIZE = 256;
+
+    uint32_t packRGBA(uint8_t r, uint8_t g, uint8_t b, uint8_t a) {
+        const uint8_t rgba[4] = {r, g, b, a};
+        uint32_t pixel;
+        std::memcpy(&pixel, rgba, sizeof(pixel));
+        return pixel;
+    }
+
+    // Maps values to LUT entries: index = clamp((v - minValue) * scale, 0, LUT_SIZE - 1), rounded.
+    // NaN maps to index 0.
+    void colorizeBands(const float* values, int count, float minValue, float scale,
+                       const uint32_t* lut, uint32_t* out) {
+        int i = 0;
+#if defined(__SSE2__)
+        const __m128 vMin = _mm_set1_ps(minValue);
+        const __m128 vScale = _mm_set1_ps(scale);
+        const __m128 vZero = _mm_setzero_ps();
+        const __m128 vTop = _mm_set1_ps(static_cast<float>(COLOR_LUT_SIZE - 1));
+        const __m128 vHalf = _mm_set1_ps(0.5f);
+        alignas(16) int32_t lanes[4];
+        for (; i + 4 <= count; i += 4) {
+            __m128 x = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(values + i), vMin), vScale);
+            x = _mm_min_ps(_mm_max_ps(x, vZero), vTop);
+            _mm_store_si128(reinterpret_cast<__m128i*>(lanes), _mm_cvttps_epi32(_mm_add_ps(x, vHalf)));
+            out[i + 0] = lut[lanes[0]];
+            out[i + 1] = lut[lanes[1]];
+            out[i + 2] = lut[lanes[2]];
+            out[i + 3] = lut[lanes[3]];
+        }
+#elif defined(__ARM_NEON)
+        const float32x4_t vMin = vdupq_n_f32(minValue);
+        const float32x4_t vScale = vdupq_n_f32(scale);
+        const float32x4_t vZero = vdupq_n_f32(0.0f);
+        const float32x4_t vTop = vdupq_n_f32(static_cast<float>(COLOR_LUT_SIZE - 1));
+        const float32x4_t vHalf = vdupq_n_f32(0.5f);
+        int32_t lanes[4];
+        for (; i + 4 <= count; i += 4) {
+            float32x4_t x = vmulq_f32(vsubq_f32(vld1q_f32(values + i), vMin), vScale);
+            x = vminq_f32(vmaxq_f32(x, vZero), vTop);
+            vst1q_s32(lanes, vcvtq_s32_f32(vaddq_f32(x, vHalf)));
+            out[i + 0] = lut[lanes[0]];
+            out[i + 1] = lut[lanes[1]];
+            out[i + 2] = lut[lanes[2]];
+            out[i + 3] = lut[lanes[3]];
+        }
+#endif
+        for (; i < count; ++i) {
+            float x = (values[i] - minValue) * scale;
+            x = x > 0.0f ? x : 0.0f;
+            x = x < COLOR_LUT_SIZE - 1 ? x : static_cast<float>(COLOR_LUT_SIZE - 1);
+            out[i] = lut[static_cast<int>(x + 0.5f)];
+        }
+    }
+}
+
 // Viridis color map data (normalized to 0-1 range)
 const std::vector<std::tuple<float, uint8_t, uint8_t, uint8_t>> TextureRenderer::viridisColors_ = {
     {0.0f, 68, 1, 84},
@@ -52,23 +109,34 @@ const std::vector<std::tuple<float, uint8_t, uint8_t, uint8_t>> TextureRenderer:
     {1.0f, 240, 249, 33}
 };
 
-TextureRenderer::TextureRenderer(int width, int height, int numMelBands)
+TextureRenderer::TextureRenderer(int width, int height, int numMelBands,
+                                 RenderBackendType backendType)
     : width_(width), height_(height), numMelBands_(numMelBands),
-      initialized_(false), textureId_(0), currentColorMap_(ColorMapType::VIRIDIS),
-      minValue_(0.0f), maxValue_(1.0f), currentColumn_(0), lastUpdateTimeMs_(0.0f),
-      mockMode_(false) {
-    
-    textureData_.resize(width_ * height_ * 4, 0); // RGBA format
-    ringBuffer_.resize(width_ * numMelBands_ * 4, 0); // RGBA format
+      initialized_(false), backendType_(backendType), currentColorMap_(ColorMapType::VIRIDIS),
+      byteColorsDirty_(true), minValue_(0.0f), maxValue_(1.0f), currentColumn_(0),
+      pendingStart_(0), pendingColumns_(0), uploadCount_(0),
+      readbackPending_(false), readbackOnGpu_(false), readbackOffset_(0), lastUpdateTimeMs_(0.0f) {
+    
+    ringBuffer_.resize(width_ * numMelBands_, packRGBA(0, 0, 0, 255));
+    melRing_.resize(width_ * numMelBands_, 0.0f);
+    columnPixels_.resize(height_);
+    columnValues_.resize(std::max(numMelBands_, 0));
+    byteColors_.resize(256);
+    
+    // Rows are stored top first, so row 0 shows the highest band
+    rowBand_.resize(height_);
+    for (int y = 0; y < height_; ++y) {
+        int band = (y * numMelBands_) / height_;
+        if (band >= numMelBands_) band = numMelBands_ - 1;
+        rowBand_[height_ - 1 - y] = band;
+    }
     
     createColorMaps();
-    
-    std::cout << "TextureRenderer initialized for OpenGL rendering" << std::endl;
 }
 
 TextureRenderer::~TextureRenderer() {
-    if (initialized_ && !mockMode_) {
-        cleanupOpenGL();
+    if (backend_) {
+        backend_->shutdown();
     }
 }
 
@@ -77,136 +145,254 @@ bool TextureRenderer::initialize() {
         return true;
     }
     
-    if (!setupOpenGL()) {
+    if (width_ <= 0 || height_ <= 0 || numMelBands_ <= 0) {
         return false;
     }
     
-    if (!createTexture()) {
-        cleanupOpenGL();
+    return attachBackend(createRenderBackend(backendType_, width_, height_));
+}
+
+bool TextureRenderer::initialize(std::unique_ptr<RenderBackend> backend) {
+    if (initialized_) {
+        return true;
+    }
+    
+    if (!backend || width_ <= 0 || height_ <= 0 || numMelBands_ <= 0 ||
+        !backend->initialize(width_, height_)) {
         return false;
     }
     
-    initialized_ = true;
-    return true;
+    return attachBackend(std::move(backend));
 }
 
-bool TextureRenderer::setupOpenGL() {
-    // Check if OpenGL context is available by trying a simple operation
-    GLenum error = glGetError(); // Clear any existing errors
-    
-    // Try to get a simple state - this will fail if no context
-    GLint maxTextureSize;
-    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
-    
-    if (glGetError() != GL_NO_ERROR) {
-        std::cerr << "OpenGL context not available" << std::endl;
+bool TextureRenderer::attachBackend(std::unique_ptr<RenderBackend> backend) {
+    if (!backend) {
         return false;
     }
     
-    // Enable blending for transparency (if needed)
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    backend_ = std::move(backend);
+    backendType_ = backend_->getType();
     
+    // Backends that need uploads get a staging image so columns can be batched
+    if (backend_->getPixels() == nullptr) {
+        stagingPixels_.assign(static_cast<size_t>(width_) * height_, packRGBA(0, 0, 0, 255));
+    }
+    
+    initialized_ = true;
     return true;
 }
 
-bool TextureRenderer::createTexture() {
-    glGenTextures(1, &textureId_);
+bool TextureRenderer::updateColumn(const std::vector<float>& melData) {
+    return updateColumn(melData.data(), static_cast<int>(melData.size()));
+}
+
+bool TextureRenderer::updateColumn(const float* melData, int numBands) {
+    auto startTime = std::chrono::high_resolution_clock::now();
     
-    if (textureId_ == 0) {
-        std::cerr << "Failed to generate OpenGL texture" << std::endl;
+    if (!enqueueColumn(melData, numBands)) {
         return false;
     }
+    finishUpdate(startTime);
+    return true;
+}
+
+bool TextureRenderer::updateColumn(const uint8_t* melData, int numBands) {
+    auto startTime = std::chrono::high_resolution_clock::now();
     
-    glBindTexture(GL_TEXTURE_2D, textureId_);
+    if (!enqueueColumn(melData, numBands)) {
+        return false;
+    }
+    finishUpdate(startTime);
+    return true;
+}
+
+bool TextureRenderer::updateColumn(const uint16_t* melData, int numBands) {
+    auto startTime = std::chrono::high_resolution_clock::now();
     
-    // Set texture parameters
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    if (!enqueueColumn(melData, numBands)) {
+        return false;
+    }
+    finishUpdate(startTime);
+    return true;
+}
+
+void TextureRenderer::finishUpdate(std::chrono::high_resolution_clock::time_point startTime) {
+    flush();
     
-    // Create texture with initial data (all black)
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width_, height_, 0, 
-                 GL_RGBA, GL_UNSIGNED_BYTE, textureData_.data());
+    auto endTime = std::chrono::high_resolution_clock::now();
+    lastUpdateTimeMs_ = std::chrono::duration<float, std::milli>(endTime - startTime).count();
+}
+
+bool TextureRenderer::enqueueColumn(const float* melData, int numBands) {
+    if (!initialized_) {
+        return false;
+    }
     
-    if (glGetError() != GL_NO_ERROR) {
-        std::cerr << "Failed to create OpenGL texture" << std::endl;
-        glDeleteTextures(1, &textureId_);
-        textureId_ = 0;
+    if (melData == nullptr || numBands != numMelBands_) {
         return false;
     }
     
+    // Convert mel data to colors straight into the ring buffer slot
+    const float range = maxValue_ - minValue_;
+    const float scale = range > 0.0f ? (COLOR_LUT_SIZE - 1) / range : 0.0f;
+    uint32_t* bandColors = ringBuffer_.data() + currentColumn_ * numMelBands_;
+    colorizeBands(melData, numMelBands_, minValue_, scale,
+                  colorLuts_[static_cast<int>(currentColorMap_)].data(), bandColors);
+    storeColumn(melData);
     return true;
 }
 
-bool TextureRenderer::updateColumn(const std::vector<float>& melData) {
+bool TextureRenderer::enqueueColumn(const uint8_t* melData, int numBands) {
     if (!initialized_) {
         return false;
     }
     
-    if (melData.size() != static_cast<size_t>(numMelBands_)) {
+    if (melData == nullptr || numBands != numMelBands_) {
         return false;
     }
     
-    auto startTime = std::chrono::high_resolution_clock::now();
+    // Every byte value has a precomputed color, so no float conversion is needed to colorize
+    if (byteColorsDirty_) {
+        updateByteColors();
+    }
+    uint32_t* bandColors = ringBuffer_.data() + currentColumn_ * numMelBands_;
+    for (int i = 0; i < numMelBands_; ++i) {
+        bandColors[i] = byteColors_[melData[i]];
+    }
     
-    // Convert mel data to colors and update ring buffer
-    for (int band = 0; band < numMelBands_; ++band) {
-        float value = melData[band];
-        
-        // Clamp value to valid range
-        value = std::max(minValue_, std::min(maxValue_, value));
-        
-        // Normalize to 0-1 range
-        float normalized = (value - minValue_) / (maxValue_ - minValue_);
-        
-        uint8_t r, g, b;
-        applyColorMap(normalized, &r, &g, &b);
-        
-        // Store in ring buffer (column-major order for efficient updates)
-        int bufferIndex = (currentColumn_ * numMelBands_ + band) * 4;
-        ringBuffer_[bufferIndex + 0] = r;
-        ringBuffer_[bufferIndex + 1] = g;
-        ringBuffer_[bufferIndex + 2] = b;
-        ringBuffer_[bufferIndex + 3] = 255; // Full opacity
-    }
-    
-    // Update the texture with the new column data
-    if (!mockMode_) {
-        updateTextureSubImage();
+    // The data ring and history keep floats
+    dequantize(melData, numMelBands_, MelOutputFormat::UINT8, columnValues_.data());
+    storeColumn(columnValues_.data());
+    return true;
+}
+
+bool TextureRenderer::enqueueColumn(const uint16_t* melData, int numBands) {
+    if (melData == nullptr || numBands != numMelBands_) {
+        return false;
+    }
+    
+    dequantize(melData, numMelBands_, MelOutputFormat::FLOAT16, columnValues_.data());
+    return enqueueColumn(columnValues_.data(), numBands);
+}
+
+void TextureRenderer::storeColumn(const float* melData) {
+    const uint32_t* bandColors = ringBuffer_.data() + currentColumn_ * numMelBands_;
+    std::memcpy(melRing_.data() + currentColumn_ * numMelBands_, melData, numMelBands_ * sizeof(float));
+    
+    if (stagingPixels_.empty()) {
+        // CPU-addressable backends have no upload cost; write the column in place
+        for (int y = 0; y < height_; ++y) {
+            columnPixels_[y] = bandColors[rowBand_[y]];
+        }
+        backend_->writeColumn(currentColumn_, columnPixels_.data());
     } else {
-        // In mock mode, just update the mock texture data
+        // Expand into the staging image at the column's ring position
+        uint32_t* dst = stagingPixels_.data() + currentColumn_;
         for (int y = 0; y < height_; ++y) {
-            int band = (y * numMelBands_) / height_;
-            if (band >= numMelBands_) band = numMelBands_ - 1;
-            
-            int bufferIndex = (currentColumn_ * numMelBands_ + band) * 4;
-            int textureIndex = ((height_ - 1 - y) * width_ + currentColumn_) * 4;
-            
-            mockTextureData_[textureIndex + 0] = ringBuffer_[bufferIndex + 0];
-            mockTextureData_[textureIndex + 1] = ringBuffer_[bufferIndex + 1];
-            mockTextureData_[textureIndex + 2] = ringBuffer_[bufferIndex + 2];
-            mockTextureData_[textureIndex + 3] = ringBuffer_[bufferIndex + 3];
+            dst[static_cast<size_t>(y) * width_] = bandColors[rowBand_[y]];
+        }
+        if (pendingColumns_ == 0) {
+            pendingStart_ = currentColumn_;
+        }
+        if (pendingColumns_ < width_) {
+            pendingColumns_++;
+        } else {
+            // More columns than the texture holds: the oldest pending one was overwritten
+            pendingStart_ = (pendingStart_ + 1) % width_;
         }
     }
     
+    if (history_) {
+        history_->pushColumn(melData, numMelBands_);
+    }
+    
     // Advance to next column (ring buffer)
     advanceColumn();
+}
+
+void TextureRenderer::updateByteColors() {
+    // Colors of q / 255 through the float path, so both inputs render identically
+    float values[256];
+    for (int i = 0; i < 256; ++i) {
+        values[i] = i / 255.0f;
+    }
+    const float range = maxValue_ - minValue_;
+    const float scale = range > 0.0f ? (COLOR_LUT_SIZE - 1) / range : 0.0f;
+    colorizeBands(values, 256, minValue_, scale, colorLuts_[static_cast<int>(currentColorMap_)].data(),
+                  byteColors_.data());
+    byteColorsDirty_ = false;
+}
+
+int TextureRenderer::flush() {
+    if (!initialized_ || pendingColumns_ == 0) {
+        return 0;
+    }
     
-    auto endTime = std::chrono::high_resolution_clock::now();
-    lastUpdateTimeMs_ = std::chrono::duration<float, std::milli>(endTime - startTime).count();
+    // Pending columns are contiguous in ring order; split once at the wraparound
+    const int firstCount = std::min(pendingColumns_, width_ - pendingStart_);
+    backend_->writeColumns(pendingStart_, firstCount, stagingPixels_.data() + pendingStart_, width_);
+    int uploads = 1;
+    
+    if (pendingColumns_ > firstCount) {
+        backend_->writeColumns(0, pendingColumns_ - firstCount, stagingPixels_.data(), width_);
+        uploads++;
+    }
     
+    pendingColumns_ = 0;
+    uploadCount_ += uploads;
+    return uploads;
+}
+
+bool TextureRenderer::enableHistory(int levelCapacity, int numLevels, PoolingMode pooling) {
+    if (levelCapacity <= 0 || numLevels <= 0) {
+        return false;
+    }
+    
+    history_.reset(new MelHistoryPyramid(numMelBands_, levelCapacity, numLevels, pooling));
     return true;
 }
 
-void TextureRenderer::applyColorMap(float value, uint8_t* r, uint8_t* g, uint8_t* b) {
-    const auto& colorMap = colorMaps_[static_cast<int>(currentColorMap_)];
-    auto color = interpolateColor(value, colorMap);
+int TextureRenderer::renderHistory(int level, int64_t startColumn, int64_t endColumn, int maxColumns,
+                                   std::vector<uint8_t>& rgba) const {
+    if (!history_ || maxColumns <= 0) {
+        return -1;
+    }
+    
+    std::vector<float> columns(static_cast<size_t>(maxColumns) * numMelBands_);
+    const int numColumns = history_->extractRange(level, startColumn, endColumn,
+                                                  columns.data(), maxColumns);
+    if (numColumns < 0) {
+        return -1;
+    }
+    
+    // Retained columns at this level, in level units
+    const int64_t firstColumn = (startColumn >= 0) ? (startColumn >> level)
+                                                   : -((-startColumn + (int64_t(1) << level) - 1) >> level);
+    const int64_t oldestColumn = history_->getOldestColumn(level) >> level;
+    const int64_t endRetained = history_->getLevelColumns(level);
+    
+    rgba.resize(static_cast<size_t>(numColumns) * height_ * 4);
+    
+    const float range = maxValue_ - minValue_;
+    const float scale = range > 0.0f ? (COLOR_LUT_SIZE - 1) / range : 0.0f;
+    const uint32_t* lut = colorLuts_[static_cast<int>(currentColorMap_)].data();
+    const uint32_t black = packRGBA(0, 0, 0, 255);
+    std::vector<uint32_t> bandColors(numMelBands_);
     
-    *r = std::get<0>(color);
-    *g = std::get<1>(color);
-    *b = std::get<2>(color);
+    for (int x = 0; x < numColumns; ++x) {
+        const int64_t k = firstColumn + x;
+        if (k < oldestColumn || k >= endRetained) {
+            std::fill(bandColors.begin(), bandColors.end(), black);
+        } else {
+            colorizeBands(columns.data() + static_cast<size_t>(x) * numMelBands_, numMelBands_,
+                          minValue_, scale, lut, bandColors.data());
+        }
+        for (int y = 0; y < height_; ++y) {
+            std::memcpy(&rgba[(static_cast<size_t>(y) * numColumns + x) * 4], &bandColors[rowBand_[y]], 4);
+        }
+    }
+    
+    return numColumns;
 }
 
 std::tuple<uint8_t, uint8_t, uint8_t> TextureRenderer::interpolateColor(
@@ -245,48 +431,19 @@ std::tuple<uint8_t, uint8_t, uint8_t> TextureRenderer::interpolateColor(
     return std::make_tuple(r, g, b);
 }
 
-void TextureRenderer::updateTextureSubImage() {
-    glBindTexture(GL_TEXTURE_2D, textureId_);
-    
-    // Update the entire texture from the ring buffer
-    // We need to reorganize the ring buffer data to match texture layout
-    std::vector<uint8_t> organizedData(width_ * height_ * 4);
-    
-    for (int x = 0; x < width_; ++x) {
-        // Calculate the column index in the ring buffer
-        int ringCol = (currentColumn_ - width_ + x + width_) % width_;
-        
-        for (int y = 0; y < height_; ++y) {
-            // Map y coordinate to mel band (with interpolation if needed)
-            int band = (y * numMelBands_) / height_;
-            if (band >= numMelBands_) band = numMelBands_ - 1;
-            
-            int srcIndex = (ringCol * numMelBands_ + band) * 4;
-            int dstIndex = ((height_ - 1 - y) * width_ + x) * 4; // Flip vertically
-            
-            organizedData[dstIndex + 0] = ringBuffer_[srcIndex + 0];
-            organizedData[dstIndex + 1] = ringBuffer_[srcIndex + 1];
-            organizedData[dstIndex + 2] = ringBuffer_[srcIndex + 2];
-            organizedData[dstIndex + 3] = ringBuffer_[srcIndex + 3];
-        }
-    }
-    
-    // Update the entire texture
-    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width_, height_,
-                    GL_RGBA, GL_UNSIGNED_BYTE, organizedData.data());
-}
-
 void TextureRenderer::advanceColumn() {
     currentColumn_ = (currentColumn_ + 1) % width_;
 }
 
 void TextureRenderer::setColorMap(ColorMapType type) {
     currentColorMap_ = type;
+    byteColorsDirty_ = true;
 }
 
 void TextureRenderer::setMinMaxValues(float minValue, float maxValue) {
     minValue_ = minValue;
     maxValue_ = maxValue;
+    byteColorsDirty_ = true;
 }
 
 std::vector<uint8_t> TextureRenderer::getTextureData() const {
@@ -294,26 +451,118 @@ std::vector<uint8_t> TextureRenderer::getTextureData() const {
         return {};
     }
     
-    std::vector<uint8_t> data(width_ * height_ * 4);
+    std::vector<uint8_t> data;
+    assembleTimeOrdered(data);
+    return data;
+}
+
+void TextureRenderer::assembleTimeOrdered(std::vector<uint8_t>& rgba) const {
+    rgba.resize(static_cast<size_t>(width_) * height_ * 4);
+    
+    // Oldest column is the next one to be overwritten
+    const int firstSpan = width_ - currentColumn_;
+    for (int y = 0; y < height_; ++y) {
+        const uint32_t* src = ringBuffer_.data() + rowBand_[y];
+        uint8_t* dst = rgba.data() + static_cast<size_t>(y) * width_ * 4;
+        for (int x = 0; x < firstSpan; ++x) {
+            std::memcpy(dst + x * 4, src + (currentColumn_ + x) * numMelBands_, 4);
+        }
+        for (int x = firstSpan; x < width_; ++x) {
+            std::memcpy(dst + x * 4, src + (x - firstSpan) * numMelBands_, 4);
+        }
+    }
+}
+
+void TextureRenderer::snapshotRing(RingSnapshot& snapshot) const {
+    snapshot.width = width_;
+    snapshot.height = height_;
+    snapshot.numMelBands = numMelBands_;
+    snapshot.ringOffset = currentColumn_;
+    snapshot.minValue = minValue_;
+    snapshot.maxValue = maxValue_;
+    snapshot.bandColors = ringBuffer_;
+    snapshot.melValues = melRing_;
+    snapshot.rowBand = rowBand_;
+}
+
+void TextureRenderer::rotateToTimeOrder(const std::vector<uint8_t>& ringOrder, int ringOffset,
+                                        std::vector<uint8_t>& rgba) const {
+    rgba.resize(static_cast<size_t>(width_) * height_ * 4);
+    
+    const size_t rowBytes = static_cast<size_t>(width_) * 4;
+    const size_t headBytes = static_cast<size_t>(width_ - ringOffset) * 4;
+    for (int y = 0; y < height_; ++y) {
+        const uint8_t* src = ringOrder.data() + y * rowBytes;
+        uint8_t* dst = rgba.data() + y * rowBytes;
+        std::memcpy(dst, src + ringOffset * 4, headBytes);
+        std::memcpy(dst + headBytes, src, rowBytes - headBytes);
+    }
+}
+
+bool TextureRenderer::requestReadback(ReadbackCallback callback) {
+    if (!initialized_ || readbackPending_) {
+        return false;
+    }
+    
+    // The GPU copy must see every column already in the ring buffer
+    flush();
+    
+    readbackCallback_ = std::move(callback);
+    readbackOffset_ = currentColumn_;
+    readbackOnGpu_ = backend_->requestReadback();
+    if (!readbackOnGpu_) {
+        // Snapshot now so later columns don't leak into the export
+        assembleTimeOrdered(readbackPixels_);
+    }
+    readbackPending_ = true;
+    return true;
+}
+
+bool TextureRenderer::pollReadback(std::vector<uint8_t>* rgba) {
+    if (!readbackPending_) {
+        return false;
+    }
     
-    if (!mockMode_ && textureId_ != 0) {
-        glBindTexture(GL_TEXTURE_2D, textureId_);
-        // OpenGL ES does not support glGetTexImage; use glReadPixels on the framebuffer
-        // Assuming texture is attached to the current framebuffer; if not, fallback
-        GLint prevFbo = 0;
-        glGetIntegerv(GL_FRAMEBUFFER_BINDING, &prevFbo);
-        if (prevFbo != 0) {
-            glReadPixels(0, 0, width_, height_, GL_RGBA, GL_UNSIGNED_BYTE, data.data());
+    if (readbackOnGpu_) {
+        std::vector<uint8_t> ringOrder;
+        if (backend_->pollReadback(ringOrder)) {
+            rotateToTimeOrder(ringOrder, readbackOffset_, readbackPixels_);
+        } else if (backend_->isReadbackPending()) {
+            return false;
         } else {
-            // Fallback to internal texture data if no framebuffer is bound
-            data = textureData_;
+            // The GPU copy failed; fall back to the ring buffer
+            assembleTimeOrdered(readbackPixels_);
         }
-    } else {
-        // Fallback to internal texture data
-        data = textureData_;
     }
     
-    return data;
+    readbackPending_ = false;
+    readbackOnGpu_ = false;
+    
+    ReadbackCallback callback = std::move(readbackCallback_);
+    readbackCallback_ = nullptr;
+    if (callback) {
+        callback(readbackPixels_, width_, height_);
+    }
+    if (rgba != nullptr) {
+        rgba->swap(readbackPixels_);
+    }
+    return true;
+}
+
+unsigned int TextureRenderer::getTextureId() const {
+    return backend_ ? backend_->getTextureId() : 0;
+}
+
+const uint8_t* TextureRenderer::getPixels() const {
+    return backend_ ? backend_->getPixels() : nullptr;
+}
+
+int TextureRenderer::getPixelStride() const {
+    return backend_ ? backend_->getStride() : 0;
+}
+
+RenderBackendType TextureRenderer::getBackendType() const {
+    return backend_ ? backend_->getType() : backendType_;
 }
 
 void TextureRenderer::createColorMaps() {
@@ -321,14 +570,17 @@ void TextureRenderer::createColorMaps() {
     colorMaps_.push_back(viridisColors_);
     colorMaps_.push_back(infernoColors_);
     colorMaps_.push_back(plasmaColors_);
-}
-
-void TextureRenderer::cleanupOpenGL() {
-    if (textureId_ != 0) {
-        glDeleteTextures(1, &textureId_);
-        textureId_ = 0;
+    
+    // Precompute packed lookup tables so colorization is a single indexed load per band
+    colorLuts_.clear();
+    for (const auto& colorMap : colorMaps_) {
+        std::vector<uint32_t> lut(COLOR_LUT_SIZE);
+        for (int i = 0; i < COLOR_LUT_SIZE; ++i) {
+            auto color = interpolateColor(i / static_cast<float>(COLOR_LUT_SIZE - 1), colorMap);
+            lut[i] = packRGBA(std::get<0>(color), std::get<1>(color), std::get<2>(color), 255);
+        }
+        colorLuts_.push_back(std::move(lut));
     }
-    initialized_ = false;
 }
 
 } // namespace melspectrogram
\ No newline at end of file
@@ -0,0 +1,158 @@
+#include <gtest/gtest.h>
+#include "activity_gate.h"
+#include "mel_spectrogram.h"
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace melspectrogram;
+
+namespace {
+    constexpr float PI = 3.14159265359f;
+
+    std::vector<int16_t> makeTone(size_t samples, float frequency, float amplitude, int sampleRate) {
+        std::vector<int16_t> signal(samples);
+        for (size_t i = 0; i < samples; ++i) {
+            signal[i] = static_cast<int16_t>(amplitude * 32767.0f *
+                                             std::sin(2.0f * PI * frequency * i / sampleRate));
+        }
+        return signal;
+    }
+
+    std::vector<int16_t> makeNoise(size_t samples, float amplitude) {
+        std::mt19937 rng(5);
+        std::normal_distribution<float> noise(0.0f, amplitude * 32767.0f);
+        std::vector<int16_t> signal(samples);
+        for (size_t i = 0; i < samples; ++i) {
+            signal[i] = static_cast<int16_t>(std::max(-32768.0f, std::min(32767.0f, noise(rng))));
+        }
+        return signal;
+    }
+
+    FrameActivity level(float levelDb) {
+        FrameActivity activity;
+        activity.levelDb = levelDb;
+        activity.flatness = 0.1f;
+        return activity;
+    }
+}
+
+// Test 1: Level and flatness of known signals
+TEST(ActivityGateTest, MeasureActivity) {
+    // Full-scale sine has RMS 1/sqrt(2): -3 dBFS
+    auto tone = makeTone(1024, 500.0f, 1.0f, 16000);
+    FrameActivity activity = measureActivity(tone.data(), 1024);
+    EXPECT_NEAR(activity.levelDb, -3.01f, 0.1f);
+    EXPECT_LT(activity.flatness, 0.1f);
+
+    auto noise = makeNoise(1024, 0.1f);
+    activity = measureActivity(noise.data(), 1024);
+    EXPECT_NEAR(activity.levelDb, -20.0f, 0.5f);
+    EXPECT_GT(activity.flatness, 0.9f);
+
+    // Constant offset is not activity
+    std::vector<int16_t> offset(1024, 12000);
+    activity = measureActivity(offset.data(), 1024);
+    EXPECT_LE(activity.levelDb, -200.0f);
+}
+
+// Test 2: Opens at the threshold, holds through the hangover, closes below threshold - hysteresis
+TEST(ActivityGateTest, Hysteresis) {
+    ActivityGateConfig config;
+    config.enabled = true;
+    config.thresholdDb = -40.0f;
+    config.hysteresisDb = 6.0f;
+    config.hangoverFrames = 2;
+    ActivityGate gate(config);
+
+    EXPECT_FALSE(gate.update(level(-42.0f)));
+    EXPECT_TRUE(gate.update(level(-39.0f)));
+    // Inside the hysteresis band the gate stays open indefinitely
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_TRUE(gate.update(level(-44.0f)));
+    }
+    EXPECT_TRUE(gate.update(level(-60.0f)));
+    EXPECT_TRUE(gate.update(level(-60.0f)));
+    EXPECT_FALSE(gate.update(level(-60.0f)));
+    // Closed again: the band no longer opens it
+    EXPECT_FALSE(gate.update(level(-44.0f)));
+    EXPECT_TRUE(gate.update(level(-40.0f)));
+
+    config.enabled = false;
+    gate.setConfig(config);
+    EXPECT_TRUE(gate.update(level(-120.0f)));
+}
+
+// Test 3: Loud but noise-like frames are gated when the flatness test is on
+TEST(ActivityGateTest, FlatnessVeto) {
+    ActivityGateConfig config;
+    config.enabled = true;
+    config.hangoverFrames = 0;
+    config.maxFlatness = 0.8f;
+    ActivityGate gate(config);
+
+    auto noise = makeNoise(1024, 0.2f);
+    auto tone = makeTone(1024, 300.0f, 0.2f, 16000);
+    EXPECT_FALSE(gate.update(measureActivity(noise.data(), 1024)));
+    EXPECT_TRUE(gate.update(measureActivity(tone.data(), 1024)));
+    EXPECT_FALSE(gate.update(measureActivity(noise.data(), 1024)));
+}
+
+// Test 4: Processor repeats the floor frame on quiet input and reports the skip ratio
+TEST(ActivityGateTest, ProcessorSkipsQuietFrames) {
+    AudioConfig config;
+    config.sampleRate = 16000;
+    config.frameSize = 512;
+    config.hopSize = 256;
+    config.numMelBands = 40;
+
+    // One second of faint noise, then a loud tone
+    std::vector<int16_t> input = makeNoise(16000, 0.0005f);
+    auto tone = makeTone(8000, 700.0f, 0.5f, 16000);
+    input.insert(input.end(), tone.begin(), tone.end());
+
+    MelSpectrogramProcessor plain(config);
+    MelSpectrogramProcessor gated(config);
+    ActivityGateConfig gate;
+    gate.enabled = true;
+    gate.hangoverFrames = 2;
+    gated.setActivityGate(gate);
+    EXPECT_TRUE(gated.getActivityGate().enabled);
+
+    const size_t capacity = 128;
+    std::vector<float> plainOut(capacity * config.numMelBands);
+    std::vector<float> gatedOut(capacity * config.numMelBands);
+    size_t plainFrames = 0;
+    size_t gatedFrames = 0;
+    plain.processAudioSamples(input.data(), input.size(), plainOut.data(), capacity, &plainFrames);
+    gated.processAudioSamples(input.data(), input.size(), gatedOut.data(), capacity, &gatedFrames);
+    ASSERT_EQ(plainFrames, gatedFrames);
+    EXPECT_TRUE(gated.isActive());
+
+    // Every quiet frame is the first one, computed once and then repeated
+    const size_t bands = config.numMelBands;
+    const size_t quietFrames = (16000 - config.frameSize) / config.hopSize + 1;
+    for (size_t f = 1; f < quietFrames; ++f) {
+        for (size_t b = 0; b < bands; ++b) {
+            ASSERT_EQ(gatedOut[f * bands + b], gatedOut[b]) << "frame " << f;
+        }
+    }
+    for (size_t b = 0; b < bands; ++b) {
+        EXPECT_EQ(gatedOut[b], plainOut[b]);
+    }
+    // Once the tone starts the frames are computed again
+    const size_t last = gatedFrames - 1;
+    for (size_t b = 0; b < bands; ++b) {
+        EXPECT_EQ(gatedOut[last * bands + b], plainOut[last * bands + b]);
+    }
+
+    ProcessingStats stats = gated.getStats();
+    EXPECT_EQ(stats.skippedFrames, static_cast<int>(quietFrames) - 1);
+    EXPECT_NEAR(stats.skipRatio, static_cast<float>(quietFrames - 1) / gatedFrames, 1e-5f);
+    EXPECT_EQ(plain.getStats().skippedFrames, 0);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -4,6 +4,7 @@
 #include <thread>
 #include <vector>
 #include <numeric>
+#include <cmath>
 
 using namespace audio;
 
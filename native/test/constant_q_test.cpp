@@ -0,0 +1,227 @@
+#include <gtest/gtest.h>
+#include "constant_q.h"
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <random>
+#include <vector>
+
+using namespace melspectrogram;
+
+namespace {
+    constexpr double PI = 3.14159265358979323846;
+
+    std::vector<int16_t> makeTones(size_t samples, const std::vector<double>& frequencies, double amplitude,
+                                   int sampleRate) {
+        std::vector<int16_t> signal(samples, 0);
+        for (size_t i = 0; i < samples; ++i) {
+            double value = 0.0;
+            for (size_t t = 0; t < frequencies.size(); ++t) {
+                value += std::sin(2.0 * PI * frequencies[t] * i / sampleRate + 0.7 * t);
+            }
+            signal[i] = static_cast<int16_t>(std::lround(32767.0 * amplitude * value));
+        }
+        return signal;
+    }
+
+    // Power of bin at frequency f centred on sample centre, straight from the definition at full rate
+    double directPower(const std::vector<int16_t>& signal, long centre, double frequency, double q, int sampleRate) {
+        const double length = q * sampleRate / frequency;
+        const long half = static_cast<long>(length / 2.0);
+        std::complex<double> sum(0.0, 0.0);
+        for (long t = -half; t <= half; ++t) {
+            const long index = centre + t;
+            if (index < 0 || index >= static_cast<long>(signal.size())) {
+                continue;
+            }
+            const double window = 0.5 * (1.0 + std::cos(2.0 * PI * t / length)) / length;
+            const double phase = 2.0 * PI * frequency * t / sampleRate;
+            sum += signal[index] / 32768.0 * window * std::complex<double>(std::cos(phase), -std::sin(phase));
+        }
+        return std::norm(sum);
+    }
+
+    // Power columns, one per hop, streamed a hop at a time
+    std::vector<std::vector<float>> powerColumns(ConstantQProcessor& cqt, const std::vector<int16_t>& signal) {
+        const size_t hop = static_cast<size_t>(cqt.getHopSize());
+        std::vector<std::vector<float>> columns;
+        for (size_t offset = 0; offset + hop <= signal.size(); offset += hop) {
+            size_t frames = 0;
+            EXPECT_EQ(cqt.processAudioSamples(signal.data() + offset, hop, nullptr, 0, &frames), static_cast<long>(hop));
+            EXPECT_EQ(frames, 1u);
+            columns.emplace_back(cqt.getPowerData(), cqt.getPowerData() + cqt.getNumBins());
+        }
+        return columns;
+    }
+}
+
+// Test 1: Validation, shared plans and a sparse kernel
+TEST(ConstantQTest, PlanAndKernel) {
+    CqtConfig config;
+    EXPECT_TRUE(CqtPlan::validate(config));
+    auto plan = CqtPlan::acquire(config);
+    ASSERT_TRUE(plan);
+    EXPECT_EQ(CqtPlan::acquire(config), plan);
+    CqtConfig otherHop = config;
+    otherHop.hopSize = 256;
+    EXPECT_EQ(CqtPlan::acquire(otherHop), plan);
+    EXPECT_EQ(plan->getNumBins(), 84);
+    EXPECT_NEAR(plan->getBinFrequency(45), 440.0f, 0.01f);  // A4 from C1
+
+    // The lowest atom of the top octave fits one FFT, which is all any octave needs
+    const int n = plan->getFftSize();
+    EXPECT_GE(n, plan->getQ() * config.sampleRate / plan->getBinFrequency(plan->getNumBins() - 12));
+    EXPECT_LE(n, 1024);
+    EXPECT_LT(plan->getKernelNonZeros(), static_cast<size_t>(config.binsPerOctave * n / 8));
+    for (int k = 0; k < config.binsPerOctave; ++k) {
+        EXPECT_LT(plan->getKernelStart(k), plan->getKernelEnd(k));
+        if (k > 0) {
+            EXPECT_GE(plan->getKernelStart(k), plan->getKernelStart(k - 1));
+        }
+    }
+    EXPECT_EQ(plan->getDecimatorTaps().size() % 2, 1u);
+
+    CqtConfig odd = config;
+    odd.hopSize = 500;  // Not a multiple of 64
+    EXPECT_FALSE(CqtPlan::validate(odd));
+    CqtConfig high = config;
+    high.minFreq = 200.0f;  // Top octave above a quarter of the rate
+    EXPECT_FALSE(CqtPlan::validate(high));
+    EXPECT_FALSE(CqtPlan::acquire(high));
+
+    ConstantQProcessor invalid(high);
+    EXPECT_FALSE(invalid.isValid());
+    EXPECT_EQ(invalid.getNumBins(), 0);
+    int16_t sample = 0;
+    EXPECT_EQ(invalid.processAudioSamples(&sample, 1, nullptr, 0, nullptr), -1);
+}
+
+// Test 2: A tone on a bin peaks there with the same power whichever octave computes it
+TEST(ConstantQTest, TonesAcrossOctaves) {
+    CqtConfig config;
+    ConstantQProcessor cqt(config);
+    ASSERT_TRUE(cqt.isValid());
+    const double amplitude = 0.5;
+    const size_t samples = cqt.getLatencySamples() + 40 * config.hopSize;
+
+    for (int bin : {79, 57, 30, 5}) {
+        cqt.reset();
+        const auto signal = makeTones(samples, {cqt.getPlan().getBinFrequency(bin)}, amplitude, config.sampleRate);
+        const auto columns = powerColumns(cqt, signal);
+        const std::vector<float>& last = columns.back();
+        EXPECT_EQ(std::max_element(last.begin(), last.end()) - last.begin(), bin);
+        EXPECT_NEAR(last[bin], amplitude * amplitude / 16.0, 0.1 * amplitude * amplitude / 16.0) << "bin " << bin;
+        // A semitone away the atom has dropped well down
+        EXPECT_LT(last[bin - 1], 0.5f * last[bin]);
+        EXPECT_LT(last[bin + 1], 0.5f * last[bin]);
+
+        // The normalized column peaks at the same bin
+        const float* column = cqt.getOutputData();
+        EXPECT_EQ(std::max_element(column, column + cqt.getNumBins()) - column, bin);
+        EXPECT_LE(column[bin], 1.0f);
+    }
+}
+
+// Test 3: Every octave matches the constant-Q transform taken directly at full rate
+TEST(ConstantQTest, MatchesDirectTransform) {
+    CqtConfig config;
+    ConstantQProcessor cqt(config);
+    // Whole hops, so the last column ends on the last sample
+    const size_t samples = (cqt.getLatencySamples() / config.hopSize + 24) * config.hopSize;
+    const double q = cqt.getPlan().getQ();
+
+    for (int bin : {83, 62, 40, 13, 2}) {
+        cqt.reset();
+        // Off-bin neighbours beat against the tone, so the power depends on where the atom sits
+        const double f = cqt.getPlan().getBinFrequency(bin);
+        const double step = std::pow(2.0, 1.0 / config.binsPerOctave);
+        const auto signal = makeTones(samples, {f, f * std::pow(step, 0.3), f * std::pow(step, -0.4)}, 0.25,
+                                      config.sampleRate);
+        powerColumns(cqt, signal);
+
+        const long centre = static_cast<long>(samples) - cqt.getLatencySamples();
+        const double expected = directPower(signal, centre, f, q, config.sampleRate);
+        EXPECT_NEAR(cqt.getPowerData()[bin], expected, 0.02 * expected) << "bin " << bin;
+    }
+}
+
+// Test 4: An impulse shows up getLatencySamples() late in every octave
+TEST(ConstantQTest, ImpulseAlignment) {
+    CqtConfig config;
+    ConstantQProcessor cqt(config);
+    const size_t hop = static_cast<size_t>(config.hopSize);
+    const size_t impulse = 5 * hop + 100;
+    std::vector<int16_t> signal(impulse + cqt.getLatencySamples() + 8 * hop, 0);
+    signal[impulse] = 20000;
+
+    const auto columns = powerColumns(cqt, signal);
+    const long expected = static_cast<long>((impulse + cqt.getLatencySamples()) / hop) - 1;
+    for (int bin : {83, 50, 20, 0}) {
+        long peak = 0;
+        for (size_t frame = 1; frame < columns.size(); ++frame) {
+            if (columns[frame][bin] > columns[peak][bin]) {
+                peak = static_cast<long>(frame);
+            }
+        }
+        EXPECT_LE(std::abs(peak - expected), 1) << "bin " << bin;
+        EXPECT_GT(columns[peak][bin], 0.0f);
+    }
+}
+
+// Test 5: Chunked streaming gives the same columns as one call, and maxFrames holds back input
+TEST(ConstantQTest, Streaming) {
+    CqtConfig config;
+    config.minFreq = 55.0f;
+    config.numOctaves = 5;
+    config.binsPerOctave = 24;
+    config.hopSize = 256;
+    ConstantQProcessor cqt(config);
+    ASSERT_TRUE(cqt.isValid());
+    const size_t bins = static_cast<size_t>(cqt.getNumBins());
+
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> noise(-8000, 8000);
+    std::vector<int16_t> signal(40 * config.hopSize + 77);
+    for (auto& sample : signal) {
+        sample = static_cast<int16_t>(noise(rng));
+    }
+
+    std::vector<float> whole(41 * bins);
+    size_t frames = 0;
+    EXPECT_EQ(cqt.processAudioSamples(signal.data(), signal.size(), whole.data(), 41, &frames),
+              static_cast<long>(signal.size()));
+    EXPECT_EQ(frames, 40u);
+    whole.resize(40 * bins);
+
+    cqt.reset();
+    std::vector<float> chunked;
+    std::vector<float> output(3 * bins);
+    std::uniform_int_distribution<size_t> chunk(1, 700);
+    size_t offset = 0;
+    while (offset < signal.size()) {
+        const size_t count = std::min(chunk(rng), signal.size() - offset);
+        // Room for up to three columns; whatever is held back comes again with the next chunk
+        const long consumed = cqt.processAudioSamples(signal.data() + offset, count, output.data(), 3, &frames);
+        ASSERT_GT(consumed, 0);
+        EXPECT_LE(frames, 3u);
+        chunked.insert(chunked.end(), output.begin(), output.begin() + frames * bins);
+        offset += static_cast<size_t>(consumed);
+    }
+    ASSERT_EQ(chunked.size(), whole.size());
+    for (size_t i = 0; i < whole.size(); ++i) {
+        ASSERT_EQ(chunked[i], whole[i]) << "value " << i;
+    }
+
+    // A full output stops at the hop boundary
+    cqt.reset();
+    EXPECT_EQ(cqt.processAudioSamples(signal.data(), signal.size(), output.data(), 1, &frames),
+              static_cast<long>(config.hopSize));
+    EXPECT_EQ(frames, 1u);
+    EXPECT_EQ(cqt.processAudioSamples(signal.data(), signal.size(), output.data(), 0, &frames), 0);
+    EXPECT_EQ(frames, 0u);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
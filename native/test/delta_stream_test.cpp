@@ -0,0 +1,224 @@
+#include <gtest/gtest.h>
+#include "delta_stream.h"
+#include "mel_spectrogram.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace melspectrogram;
+
+namespace {
+    typedef std::vector<std::vector<float>> Frames;
+
+    Frames makeFrames(size_t count, int features, int seed) {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> value(0.0f, 1.0f);
+        Frames frames(count, std::vector<float>(features));
+        for (auto& frame : frames) {
+            for (float& v : frame) {
+                v = value(rng);
+            }
+        }
+        return frames;
+    }
+
+    // Whole-sequence regression with clamped frame indices, in double
+    Frames regress(const Frames& x, int window) {
+        const long count = static_cast<long>(x.size());
+        double squares = 0.0;
+        for (int n = 1; n <= window; ++n) {
+            squares += n * n;
+        }
+        Frames d(x.size(), std::vector<float>(x[0].size()));
+        for (long t = 0; t < count; ++t) {
+            for (size_t i = 0; i < x[0].size(); ++i) {
+                double sum = 0.0;
+                for (int n = 1; n <= window; ++n) {
+                    sum += n * (static_cast<double>(x[std::min(t + n, count - 1)][i]) - x[std::max(t - n, 0L)][i]);
+                }
+                d[t][i] = static_cast<float>(sum / (2.0 * squares));
+            }
+        }
+        return d;
+    }
+
+    void expectFrame(const float* output, const std::vector<float>& x, const std::vector<float>& d,
+                     const std::vector<float>& dd, size_t t) {
+        const size_t features = x.size();
+        for (size_t i = 0; i < features; ++i) {
+            ASSERT_EQ(output[i], x[i]) << "frame " << t;
+            ASSERT_NEAR(output[features + i], d[i], 1e-5f) << "frame " << t << " band " << i;
+            ASSERT_NEAR(output[2 * features + i], dd[i], 1e-5f) << "frame " << t << " band " << i;
+        }
+    }
+
+    std::vector<int16_t> makeSweep(size_t samples, int sampleRate) {
+        std::vector<int16_t> signal(samples);
+        double phase = 0.0;
+        for (size_t i = 0; i < samples; ++i) {
+            const double frequency = 200.0 + 6000.0 * i / samples;
+            phase += 2.0 * 3.14159265358979 * frequency / sampleRate;
+            signal[i] = static_cast<int16_t>(12000.0 * std::sin(phase));
+        }
+        return signal;
+    }
+}
+
+// Test 1: Streamed output matches whole-sequence deltas, 2N frames late, edges clamped
+TEST(DeltaStreamTest, MatchesWholeSequence) {
+    for (int window : {1, 2, 3}) {
+        const int features = 37;  // Not a multiple of the vector width
+        const Frames x = makeFrames(20, features, window);
+        const Frames d = regress(x, window);
+        const Frames dd = regress(d, window);
+
+        DeltaStream stream(features, window);
+        EXPECT_EQ(stream.getLatencyFrames(), 2 * window);
+        EXPECT_EQ(stream.getFrameSize(), static_cast<size_t>(3 * features));
+        size_t emitted = 0;
+        for (size_t t = 0; t < x.size(); ++t) {
+            const bool ready = stream.push(x[t].data());
+            ASSERT_EQ(ready, t >= static_cast<size_t>(2 * window)) << "window " << window << " push " << t;
+            if (ready) {
+                ASSERT_EQ(stream.getOutputIndex(), static_cast<int64_t>(emitted));
+                expectFrame(stream.getOutput(), x[emitted], d[emitted], dd[emitted], emitted);
+                emitted++;
+            }
+        }
+        while (stream.drain()) {
+            ASSERT_EQ(stream.getOutputIndex(), static_cast<int64_t>(emitted));
+            expectFrame(stream.getOutput(), x[emitted], d[emitted], dd[emitted], emitted);
+            emitted++;
+        }
+        EXPECT_EQ(emitted, x.size());
+    }
+}
+
+// Test 2: Streams shorter than the lookahead drain completely; reset starts over
+TEST(DeltaStreamTest, ShortStreamsAndReset) {
+    DeltaStream stream(8, 2);
+    EXPECT_FALSE(stream.drain());
+    EXPECT_EQ(stream.getOutput(), nullptr);
+    for (size_t count : {1u, 3u, 5u}) {
+        const Frames x = makeFrames(count, 8, static_cast<int>(count));
+        const Frames d = regress(x, 2);
+        const Frames dd = regress(d, 2);
+        stream.reset();
+        size_t emitted = 0;
+        for (const auto& frame : x) {
+            if (stream.push(frame.data())) {
+                expectFrame(stream.getOutput(), x[emitted], d[emitted], dd[emitted], emitted);
+                emitted++;
+            }
+        }
+        while (stream.drain()) {
+            expectFrame(stream.getOutput(), x[emitted], d[emitted], dd[emitted], emitted);
+            emitted++;
+        }
+        EXPECT_EQ(emitted, count);
+    }
+}
+
+// Test 3: The processor streams [log-mel dB | delta | delta-delta] behind the mel frames
+TEST(DeltaStreamTest, ProcessorStreaming) {
+    AudioConfig config;
+    const size_t bands = static_cast<size_t>(config.numMelBands);
+    const size_t hops = 12;
+    const auto signal = makeSweep(config.frameSize + (hops - 1) * config.hopSize, config.sampleRate);
+
+    // The dB frames a processor computes hop by hop
+    MelSpectrogramProcessor plain(config);
+    DeltaConfig deltas;
+    deltas.enabled = true;
+    plain.setDeltas(deltas);
+    Frames x(hops);
+    for (size_t t = 0; t < hops; ++t) {
+        ASSERT_TRUE(plain.processAudioFrame(signal.data() + t * config.hopSize, config.frameSize));
+        ASSERT_NE(plain.getDecibelData(), nullptr);
+        x[t].assign(plain.getDecibelData(), plain.getDecibelData() + bands);
+    }
+    const Frames d = regress(x, 2);
+    const Frames dd = regress(d, 2);
+
+    MelSpectrogramProcessor processor(config);
+    std::vector<float> output(hops * 3 * bands);
+    size_t frames = 0;
+    EXPECT_EQ(processor.processAudioSamplesDeltas(signal.data(), signal.size(), output.data(), hops, &frames), -1);
+
+    processor.setDeltas(deltas);
+    ASSERT_EQ(processor.getDeltaFrameSize(), 3 * bands);
+    ASSERT_EQ(processor.getDeltaLatencyFrames(), 4);
+
+    // Half the input, then the rest: frames come out 4 hops late either way
+    const size_t half = config.frameSize + 5 * config.hopSize;
+    EXPECT_EQ(processor.processAudioSamplesDeltas(signal.data(), half, output.data(), hops, &frames),
+              static_cast<long>(half));
+    EXPECT_EQ(frames, 2u);
+    EXPECT_EQ(processor.getDeltaFrameIndex(), 1);
+    size_t total = frames;
+    processor.processAudioSamplesDeltas(signal.data() + half, signal.size() - half,
+                                        output.data() + total * 3 * bands, hops - total, &frames);
+    total += frames;
+    EXPECT_EQ(total, hops - 4);
+    // The latest frame is read in place
+    ASSERT_NE(processor.getDeltaData(), nullptr);
+    expectFrame(processor.getDeltaData(), x[total - 1], d[total - 1], dd[total - 1], total - 1);
+
+    total += processor.flushDeltas(output.data() + total * 3 * bands, hops - total);
+    ASSERT_EQ(total, hops);
+    for (size_t t = 0; t < hops; ++t) {
+        expectFrame(output.data() + t * 3 * bands, x[t], d[t], dd[t], t);
+    }
+    EXPECT_EQ(processor.flushDeltas(output.data(), hops), 0u);
+}
+
+// Test 4: A broadband loudness step shows in every band's delta, which the 0-1 frames would hide
+TEST(DeltaStreamTest, LoudnessStep) {
+    AudioConfig config;
+    const size_t bands = static_cast<size_t>(config.numMelBands);
+    const size_t hops = 16;
+    const size_t step = 8;
+    // Noise repeating every hop, so frames away from the step are identical, then twice as
+    // loud from the step's frame on: +6 dB in every band
+    std::mt19937 rng(3);
+    std::uniform_int_distribution<int> noise(-2000, 2000);
+    std::vector<int16_t> period(config.hopSize);
+    for (auto& sample : period) {
+        sample = static_cast<int16_t>(noise(rng));
+    }
+    std::vector<int16_t> signal(config.frameSize + (hops - 1) * config.hopSize);
+    for (size_t i = 0; i < signal.size(); ++i) {
+        const int gain = i >= step * config.hopSize ? 2 : 1;
+        signal[i] = static_cast<int16_t>(gain * period[i % config.hopSize]);
+    }
+
+    MelSpectrogramProcessor processor(config);
+    DeltaConfig deltas;
+    deltas.enabled = true;
+    processor.setDeltas(deltas);
+    std::vector<float> output(hops * 3 * bands);
+    size_t frames = 0;
+    processor.processAudioSamplesDeltas(signal.data(), signal.size(), output.data(), hops, &frames);
+    frames += processor.flushDeltas(output.data() + frames * 3 * bands, hops - frames);
+    ASSERT_EQ(frames, hops);
+
+    // Frames up to step - frameSize / hop are quiet and frames from step on loud, so the
+    // regression around step - 2 spans the full rise between its outer frames
+    const size_t quiet = step - static_cast<size_t>(config.frameSize / config.hopSize);
+    ASSERT_GE(quiet, 4u);
+    const float* before = output.data() + quiet * 3 * bands;
+    const float* after = output.data() + step * 3 * bands;
+    const float* rising = output.data() + (step - 2) * 3 * bands;
+    const float* steady = output.data() + (quiet - 2) * 3 * bands;
+    for (size_t band = 0; band < bands; ++band) {
+        EXPECT_NEAR(after[band] - before[band], 6.02f, 0.05f) << "band " << band;
+        EXPECT_GT(rising[bands + band], 0.5f) << "band " << band;
+        EXPECT_NEAR(steady[bands + band], 0.0f, 1e-3f) << "band " << band;
+    }
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,147 @@
+#include <gtest/gtest.h>
+#include "feature_graph.h"
+#include "mel_plan.h"
+#include "mel_spectrogram.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace melspectrogram;
+
+namespace {
+    std::vector<int16_t> makeTone(size_t samples, double frequency, int sampleRate, size_t start = 0) {
+        std::vector<int16_t> signal(samples, 0);
+        for (size_t i = start; i < samples; ++i) {
+            signal[i] = static_cast<int16_t>(12000.0 * std::sin(2.0 * 3.14159265358979 * frequency * i / sampleRate));
+        }
+        return signal;
+    }
+
+    template <class T>
+    std::unique_ptr<FeatureExtractor> make() {
+        return std::unique_ptr<FeatureExtractor>(new T());
+    }
+}
+
+// Test 1: Only the stages some extractor needs run, once per hop however many extractors share them
+TEST(FeatureGraphTest, LazyShareOncePerHop) {
+    AudioConfig config;
+    const auto signal = makeTone(config.frameSize, 1000.0, config.sampleRate);
+
+    FeatureGraph graph(config);
+    EXPECT_EQ(graph.getDeepestNode(), FeatureNode::COUNT);
+    EXPECT_FALSE(graph.processFrame(signal.data(), signal.size()));
+
+    EXPECT_EQ(graph.addExtractor(make<SpectralCentroidExtractor>()), 0);
+    EXPECT_EQ(graph.addExtractor(make<SpectralFluxExtractor>()), 1);
+    EXPECT_EQ(graph.addExtractor(make<ChromaExtractor>()), 2);
+    EXPECT_EQ(graph.getDeepestNode(), FeatureNode::POWER_SPECTRUM);
+    EXPECT_FALSE(graph.processFrame(signal.data(), signal.size() - 1));
+    for (int hop = 0; hop < 3; ++hop) {
+        ASSERT_TRUE(graph.processFrame(signal.data(), signal.size()));
+    }
+    EXPECT_EQ(graph.getNodeEvaluations(FeatureNode::WINDOWED_FRAME), 3u);
+    EXPECT_EQ(graph.getNodeEvaluations(FeatureNode::SPECTRUM), 3u);
+    EXPECT_EQ(graph.getNodeEvaluations(FeatureNode::POWER_SPECTRUM), 3u);
+    EXPECT_EQ(graph.getNodeEvaluations(FeatureNode::MEL_ENERGIES), 0u);
+    EXPECT_EQ(graph.getNodeEvaluations(FeatureNode::LOG_MEL), 0u);
+
+    // A mel feature adds the two mel stages and nothing else
+    const size_t before = graph.getMemoryFootprint();
+    EXPECT_EQ(graph.addExtractor(make<MelExtractor>()), 3);
+    EXPECT_EQ(graph.getDeepestNode(), FeatureNode::LOG_MEL);
+    EXPECT_GT(graph.getMemoryFootprint(), before);
+    ASSERT_TRUE(graph.processFrame(signal.data(), signal.size()));
+    EXPECT_EQ(graph.getNodeEvaluations(FeatureNode::SPECTRUM), 4u);
+    EXPECT_EQ(graph.getNodeEvaluations(FeatureNode::MEL_ENERGIES), 1u);
+    EXPECT_EQ(graph.getNodeEvaluations(FeatureNode::LOG_MEL), 1u);
+
+    // Outputs sit back to back in registration order
+    EXPECT_EQ(graph.getTotalOutputSize(), static_cast<size_t>(1 + 1 + 12 + config.numMelBands));
+    EXPECT_EQ(graph.getOutput(2), graph.getOutputs() + 2);
+    EXPECT_EQ(graph.getOutput(3), graph.getOutputs() + 14);
+    EXPECT_EQ(graph.getOutputSize(3), config.numMelBands);
+}
+
+// Test 2: Mel and MFCC nodes give what the processor's runtime path gives
+TEST(FeatureGraphTest, MatchesProcessor) {
+    AudioConfig config;
+    config.numMelBands = 36;  // No compile-time pipeline, so the processor runs the same MelPlan stages
+    const auto signal = makeTone(config.frameSize, 700.0, config.sampleRate);
+
+    FeatureGraph graph(config);
+    const int mel = graph.addExtractor(make<MelExtractor>());
+    const int mfcc = graph.addExtractor(make<MfccExtractor>());
+    ASSERT_TRUE(graph.processFrame(signal.data(), signal.size()));
+
+    MelSpectrogramProcessor processor(config);
+    MfccConfig mfccConfig;
+    mfccConfig.enabled = true;
+    processor.setMfcc(mfccConfig);
+    ASSERT_TRUE(processor.processAudioFrame(signal.data(), signal.size()));
+    for (int band = 0; band < config.numMelBands; ++band) {
+        EXPECT_EQ(graph.getOutput(mel)[band], processor.getMelData()[band]) << "band " << band;
+    }
+    ASSERT_EQ(graph.getOutputSize(mfcc), processor.getNumMfcc());
+    for (int k = 0; k < processor.getNumMfcc(); ++k) {
+        EXPECT_EQ(graph.getOutput(mfcc)[k], processor.getMfccData()[k]) << "k " << k;
+    }
+}
+
+// Test 3: Spectral features of a tone: centroid, octave bands and chroma
+TEST(FeatureGraphTest, ToneFeatures) {
+    AudioConfig config;
+    config.frameSize = 4096;
+    config.hopSize = 2048;
+    config.minFreq = 50.0f;
+    const auto signal = makeTone(config.frameSize, 440.0, config.sampleRate);
+
+    FeatureGraph graph(config);
+    const int centroid = graph.addExtractor(make<SpectralCentroidExtractor>());
+    const std::vector<float> edges = BandEnergyExtractor::octaveEdges(50.0f, 6400.0f);
+    ASSERT_EQ(edges.size(), 8u);
+    const int bands = graph.addExtractor(std::unique_ptr<FeatureExtractor>(new BandEnergyExtractor(edges)));
+    const int chroma = graph.addExtractor(make<ChromaExtractor>());
+    ASSERT_TRUE(graph.processFrame(signal.data(), signal.size()));
+
+    EXPECT_NEAR(graph.getOutput(centroid)[0], 440.0f, 10.0f);
+    // 440 Hz lies in [400, 800)
+    const float* energies = graph.getOutput(bands);
+    EXPECT_EQ(std::max_element(energies, energies + 7) - energies, 3);
+    EXPECT_GT(energies[3], energies[2] + 20.0f);
+    const float* pitch = graph.getOutput(chroma);
+    EXPECT_FLOAT_EQ(pitch[9], 1.0f);  // A
+    for (int i = 0; i < 12; ++i) {
+        if (i != 9) {
+            EXPECT_LT(pitch[i], 0.1f) << "class " << i;
+        }
+    }
+}
+
+// Test 4: Flux is zero on the first hop, rises at an onset and stays low on a steady tone
+TEST(FeatureGraphTest, FluxAcrossHops) {
+    AudioConfig config;
+    const size_t hops = 6;
+    const size_t onset = config.frameSize + 2 * config.hopSize;
+    const auto signal = makeTone(config.frameSize + (hops - 1) * config.hopSize, 1000.0, config.sampleRate, onset);
+
+    FeatureGraph graph(config);
+    const int flux = graph.addExtractor(make<SpectralFluxExtractor>());
+    std::vector<float> values;
+    for (size_t hop = 0; hop < hops; ++hop) {
+        ASSERT_TRUE(graph.processFrame(signal.data() + hop * config.hopSize, config.frameSize));
+        values.push_back(graph.getOutput(flux)[0]);
+    }
+    EXPECT_EQ(values[0], 0.0f);
+    EXPECT_EQ(values[1], 0.0f);           // Silence
+    EXPECT_GT(values[3], 100.0f * values[5] + 1e-3f);  // The onset against the steady tone
+
+    graph.reset();
+    ASSERT_TRUE(graph.processFrame(signal.data() + 4 * config.hopSize, config.frameSize));
+    EXPECT_EQ(graph.getOutput(flux)[0], 0.0f);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,152 @@
+#include <gtest/gtest.h>
+#include "fixed_mel_plan.h"
+#include "mel_plan.h"
+#include "mel_spectrogram.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace melspectrogram;
+
+namespace {
+    constexpr float PI = 3.14159265359f;
+
+    std::vector<int16_t> toPcm(const std::vector<float>& signal) {
+        std::vector<int16_t> pcm(signal.size());
+        for (size_t i = 0; i < signal.size(); ++i) {
+            const float clamped = std::max(-1.0f, std::min(1.0f, signal[i]));
+            pcm[i] = static_cast<int16_t>(std::lround(clamped * 32767.0f));
+        }
+        return pcm;
+    }
+
+    // Two tones over white noise at the given peak level
+    std::vector<int16_t> tonesWithNoise(size_t samples, int sampleRate, float level, unsigned seed) {
+        std::mt19937 rng(seed);
+        std::normal_distribution<float> noise(0.0f, 0.02f);
+        std::vector<float> signal(samples);
+        for (size_t i = 0; i < samples; ++i) {
+            const float t = static_cast<float>(i) / sampleRate;
+            signal[i] = level * (0.6f * std::sin(2.0f * PI * 440.0f * t) +
+                                 0.3f * std::sin(2.0f * PI * 2500.0f * t) + noise(rng));
+        }
+        return toPcm(signal);
+    }
+
+    std::vector<int16_t> chirpWithNoise(size_t samples, int sampleRate) {
+        std::mt19937 rng(11);
+        std::normal_distribution<float> noise(0.0f, 0.01f);
+        std::vector<float> signal(samples);
+        const float duration = static_cast<float>(samples) / sampleRate;
+        for (size_t i = 0; i < samples; ++i) {
+            const float t = static_cast<float>(i) / sampleRate;
+            // 100 Hz to 7 kHz linear sweep
+            const float phase = 2.0f * PI * (100.0f * t + 0.5f * (6900.0f / duration) * t * t);
+            signal[i] = 0.8f * std::sin(phase) + noise(rng);
+        }
+        return toPcm(signal);
+    }
+
+    // Largest difference between the two plans' normalized frames over every hop of pcm
+    float maxFrameError(const AudioConfig& config, const std::vector<int16_t>& pcm) {
+        std::shared_ptr<const MelPlan> floatPlan = MelPlan::acquire(config);
+        std::shared_ptr<const FixedMelPlan> fixedPlan = FixedMelPlan::acquire(config);
+        MelPlan::Scratch floatScratch;
+        FixedMelPlan::Scratch fixedScratch;
+        std::vector<float> expected(config.numMelBands);
+        std::vector<float> actual(config.numMelBands);
+
+        float maxError = 0.0f;
+        for (size_t start = 0; start + config.frameSize <= pcm.size(); start += config.hopSize) {
+            floatPlan->computeFrame(pcm.data() + start, expected.data(), floatScratch);
+            fixedPlan->computeFrame(pcm.data() + start, actual.data(), fixedScratch);
+            for (int band = 0; band < config.numMelBands; ++band) {
+                maxError = std::max(maxError, std::fabs(actual[band] - expected[band]));
+            }
+        }
+        return maxError;
+    }
+}
+
+// Test 1: The interpolated table log2 is within 1/4096 of the exact value across the range
+TEST(FixedMelPlanTest, Log2TableTest) {
+    std::mt19937_64 rng(5);
+    for (int i = 0; i < 20000; ++i) {
+        const uint64_t value = (rng() >> (rng() % 64)) | 1;
+        const double expected = std::log2(static_cast<double>(value));
+        ASSERT_NEAR(FixedMelPlan::log2Q16(value) / 65536.0, expected, 1.0 / 4096) << value;
+    }
+    EXPECT_EQ(FixedMelPlan::log2Q16(1), 0);
+    EXPECT_EQ(FixedMelPlan::log2Q16(1ull << 40), 40 * 65536);
+}
+
+// Test 2: Normalized frames match the float plan on tones over noise, at full and quiet levels
+TEST(FixedMelPlanTest, TonesAccuracyTest) {
+    AudioConfig config;
+    EXPECT_LT(maxFrameError(config, tonesWithNoise(config.sampleRate, config.sampleRate, 0.9f, 1)), 0.01f);
+    // 60 dB down: block scaling keeps the quiet frame's resolution
+    EXPECT_LT(maxFrameError(config, tonesWithNoise(config.sampleRate, config.sampleRate, 0.001f, 2)), 0.01f);
+}
+
+// Test 3: Chirp over noise, also with an FFT size that is not a power of four
+TEST(FixedMelPlanTest, ChirpAccuracyTest) {
+    AudioConfig config;
+    EXPECT_LT(maxFrameError(config, chirpWithNoise(config.sampleRate, config.sampleRate)), 0.01f);
+
+    AudioConfig small;
+    small.sampleRate = 16000;
+    small.frameSize = 512;
+    small.hopSize = 256;
+    small.numMelBands = 40;
+    EXPECT_LT(maxFrameError(small, chirpWithNoise(small.sampleRate, small.sampleRate)), 0.01f);
+}
+
+// Test 4: Silence reaches the -100 dB floor in both plans
+TEST(FixedMelPlanTest, SilenceTest) {
+    AudioConfig config;
+    std::vector<int16_t> silence(config.frameSize, 0);
+    std::vector<float> expected(config.numMelBands);
+    std::vector<float> actual(config.numMelBands);
+    MelPlan::Scratch floatScratch;
+    FixedMelPlan::Scratch fixedScratch;
+    MelPlan::acquire(config)->computeFrame(silence.data(), expected.data(), floatScratch);
+    FixedMelPlan::acquire(config)->computeFrame(silence.data(), actual.data(), fixedScratch);
+    for (int band = 0; band < config.numMelBands; ++band) {
+        EXPECT_FLOAT_EQ(actual[band], expected[band]);
+        EXPECT_FLOAT_EQ(actual[band], -100.0f);
+    }
+}
+
+// Test 5: fixedPoint in the config switches a processor over, including quantized output
+TEST(FixedMelPlanTest, ProcessorSelectionTest) {
+    AudioConfig config;
+    config.fixedPoint = 1;
+    const std::vector<int16_t> pcm = tonesWithNoise(config.frameSize * 4, config.sampleRate, 0.5f, 3);
+
+    MelSpectrogramProcessor processor(config);
+    processor.setOutputFormat(MelOutputFormat::UINT8);
+    ASSERT_TRUE(processor.processAudioFrame(pcm.data(), config.frameSize));
+
+    std::vector<float> expected(config.numMelBands);
+    std::vector<uint8_t> expectedBytes(config.numMelBands);
+    FixedMelPlan::Scratch scratch;
+    FixedMelPlan::acquire(config)->computeFrame(pcm.data(), expected.data(), scratch,
+                                                MelOutputFormat::UINT8, expectedBytes.data());
+    EXPECT_EQ(processor.getMelSpectrum(), expected);
+    const uint8_t* bytes = static_cast<const uint8_t*>(processor.getOutputData());
+    EXPECT_EQ(std::vector<uint8_t>(bytes, bytes + config.numMelBands), expectedBytes);
+
+    // And back to the float plan
+    config.fixedPoint = 0;
+    processor.updateConfig(config);
+    ASSERT_TRUE(processor.processAudioFrame(pcm.data(), config.frameSize));
+    MelPlan::Scratch floatScratch;
+    MelPlan::acquire(config)->computeFrame(pcm.data(), expected.data(), floatScratch);
+    EXPECT_EQ(processor.getMelSpectrum(), expected);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
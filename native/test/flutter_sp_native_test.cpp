@@ -0,0 +1,485 @@
+#include <gtest/gtest.h>
+#include "flutter_sp_native.h"
+#include "render_backend.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    std::vector<int16_t> makeSine(int numSamples, float frequency, int sampleRate) {
+        std::vector<int16_t> samples(numSamples);
+        for (int i = 0; i < numSamples; ++i) {
+            samples[i] = static_cast<int16_t>(12000.0f * std::sin(2.0f * 3.14159265f * frequency * i / sampleRate));
+        }
+        return samples;
+    }
+}
+
+class FlutterSpNativeTest : public ::testing::Test {
+protected:
+    void TearDown() override {
+        cleanup();
+    }
+};
+
+// Test 1: Sessions own independent pipelines
+TEST_F(FlutterSpNativeTest, IndependentSessionsTest) {
+    FspSession* a = fsp_session_create();
+    FspSession* b = fsp_session_create();
+    ASSERT_NE(a, nullptr);
+    ASSERT_NE(b, nullptr);
+
+    melspectrogram::AudioConfig configA;
+    melspectrogram::AudioConfig configB;
+    configB.frameSize = 512;
+    configB.numMelBands = 40;
+    ASSERT_EQ(fsp_init_mel_processor(a, &configA), 0);
+    ASSERT_EQ(fsp_init_mel_processor(b, &configB), 0);
+    EXPECT_EQ(fsp_get_mel_data_size(a), 64);
+    EXPECT_EQ(fsp_get_mel_data_size(b), 40);
+
+    ASSERT_EQ(fsp_init_texture_renderer_with_backend(a, 32, 16, 64, 2), 0);
+    EXPECT_EQ(fsp_get_texture_width(a), 32);
+    EXPECT_EQ(fsp_get_texture_width(b), 0);
+
+    // The default session is untouched by handle calls
+    EXPECT_EQ(get_texture_width(), 0);
+    EXPECT_EQ(get_mel_data_size(), 0);
+
+    fsp_session_destroy(a);
+    fsp_session_destroy(b);
+}
+
+// Test 2: Sessions process concurrently and match a single-threaded run
+TEST_F(FlutterSpNativeTest, ConcurrentSessionsTest) {
+    const int numSessions = 4;
+    const int numFrames = 50;
+    melspectrogram::AudioConfig config;
+
+    std::vector<FspSession*> sessions(numSessions);
+    std::vector<std::vector<int16_t>> inputs(numSessions);
+    for (int s = 0; s < numSessions; ++s) {
+        sessions[s] = fsp_session_create();
+        ASSERT_EQ(fsp_init_mel_processor(sessions[s], &config), 0);
+        ASSERT_EQ(fsp_init_texture_renderer_with_backend(sessions[s], 64, 32, config.numMelBands, 2), 0);
+        inputs[s] = makeSine(config.frameSize, 200.0f + 700.0f * s, config.sampleRate);
+    }
+
+    std::vector<std::vector<float>> results(numSessions, std::vector<float>(config.numMelBands));
+    std::vector<int> failures(numSessions, 0);
+    std::vector<std::thread> threads;
+    for (int s = 0; s < numSessions; ++s) {
+        threads.emplace_back([&, s] {
+            for (int frame = 0; frame < numFrames; ++frame) {
+                const int produced = fsp_process_audio_frame(sessions[s], inputs[s].data(), config.frameSize,
+                                                             results[s].data(), config.numMelBands);
+                if (produced != config.numMelBands ||
+                    fsp_update_texture_column(sessions[s], results[s].data(), produced) != 0) {
+                    failures[s]++;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    FspSession* reference = fsp_session_create();
+    ASSERT_EQ(fsp_init_mel_processor(reference, &config), 0);
+    std::vector<float> expected(config.numMelBands);
+    for (int s = 0; s < numSessions; ++s) {
+        EXPECT_EQ(failures[s], 0);
+        EXPECT_EQ(fsp_get_texture_current_column(sessions[s]), numFrames % 64);
+        ASSERT_EQ(fsp_process_audio_frame(reference, inputs[s].data(), config.frameSize,
+                                          expected.data(), config.numMelBands), config.numMelBands);
+        for (int band = 0; band < config.numMelBands; ++band) {
+            EXPECT_FLOAT_EQ(results[s][band], expected[band]);
+        }
+        fsp_session_destroy(sessions[s]);
+    }
+    fsp_session_destroy(reference);
+}
+
+// Test 3: Error strings are per thread
+TEST_F(FlutterSpNativeTest, ThreadLocalErrorTest) {
+    FspSession* session = fsp_session_create();
+    EXPECT_EQ(fsp_update_texture_column(session, nullptr, 0), -1);
+    const std::string mainError = fsp_get_error_message();
+    EXPECT_NE(mainError.find("not initialized"), std::string::npos);
+
+    std::string workerError;
+    std::thread worker([&] {
+        EXPECT_EQ(fsp_init_texture_renderer_with_backend(session, 8, 8, 4, 7), -1);
+        workerError = fsp_get_error_message();
+    });
+    worker.join();
+
+    EXPECT_NE(workerError.find("backend"), std::string::npos);
+    EXPECT_EQ(mainError, fsp_get_error_message());
+
+    EXPECT_EQ(fsp_start_recording(nullptr), -1);
+    EXPECT_NE(std::string(fsp_get_error_message()).find("session"), std::string::npos);
+    fsp_session_destroy(session);
+}
+
+// Test 4: The single-pipeline API still works on the default session
+TEST_F(FlutterSpNativeTest, DefaultSessionTest) {
+    melspectrogram::AudioConfig config;
+    ASSERT_EQ(init_mel_processor(&config), 0);
+    EXPECT_EQ(get_mel_data_size(), config.numMelBands);
+
+    auto input = makeSine(config.frameSize, 1000.0f, config.sampleRate);
+    std::vector<float> mel(config.numMelBands);
+    EXPECT_EQ(process_audio_frame(input.data(), config.frameSize, mel.data(), config.numMelBands),
+              config.numMelBands);
+
+    ASSERT_EQ(init_texture_renderer_with_backend(16, 8, config.numMelBands, 2), 0);
+    EXPECT_EQ(update_texture_column(mel.data(), config.numMelBands), 0);
+    EXPECT_EQ(get_texture_current_column(), 1);
+
+    cleanup();
+    EXPECT_EQ(get_texture_width(), 0);
+    EXPECT_EQ(get_mel_data_size(), 0);
+}
+
+// Test 5: Batched processing emits every hop into caller-owned memory
+TEST_F(FlutterSpNativeTest, BatchedFramesTest) {
+    melspectrogram::AudioConfig config;
+    FspSession* session = fsp_session_create();
+    ASSERT_EQ(fsp_init_mel_processor(session, &config), 0);
+
+    // Eight hops of audio delivered in one call, plus a partial frame
+    const int numSamples = config.frameSize + 7 * config.hopSize + 100;
+    auto input = makeSine(numSamples, 1500.0f, config.sampleRate);
+    std::vector<float> output(16 * config.numMelBands);
+    int frames = -1;
+    EXPECT_EQ(fsp_process_audio_frames(session, input.data(), numSamples,
+                                       output.data(), static_cast<int>(output.size()), &frames), numSamples);
+    EXPECT_EQ(frames, 8);
+
+    std::vector<float> expected(config.numMelBands);
+    FspSession* reference = fsp_session_create();
+    ASSERT_EQ(fsp_init_mel_processor(reference, &config), 0);
+    for (int frame = 0; frame < frames; ++frame) {
+        fsp_process_audio_frame(reference, input.data() + frame * config.hopSize, config.frameSize,
+                                expected.data(), config.numMelBands);
+        for (int band = 0; band < config.numMelBands; ++band) {
+            EXPECT_FLOAT_EQ(output[frame * config.numMelBands + band], expected[band]);
+        }
+    }
+
+    // Too small for a single frame: nothing past the carried-over samples is consumed
+    EXPECT_EQ(fsp_process_audio_frames(session, input.data(), config.frameSize,
+                                       output.data(), config.numMelBands - 1, &frames), 0);
+    EXPECT_EQ(frames, 0);
+
+    fsp_session_destroy(reference);
+    fsp_session_destroy(session);
+}
+
+// Test 6: Frames reach the shared ring without a copy-out call
+TEST_F(FlutterSpNativeTest, SharedMelRingTest) {
+    melspectrogram::AudioConfig config;
+    FspSession* session = fsp_session_create();
+    ASSERT_EQ(fsp_init_mel_processor(session, &config), 0);
+    EXPECT_EQ(fsp_get_mel_ring(session, nullptr), nullptr);
+    EXPECT_EQ(fsp_process_audio_frames(session, nullptr, 0, nullptr, 0, nullptr), -1);
+    ASSERT_EQ(fsp_enable_mel_ring(session, 8), 0);
+
+    int sizeBytes = 0;
+    const uint8_t* block = static_cast<const uint8_t*>(fsp_get_mel_ring(session, &sizeBytes));
+    ASSERT_NE(block, nullptr);
+    EXPECT_GT(sizeBytes, 0);
+
+    auto input = makeSine(config.frameSize + 2 * config.hopSize, 440.0f, config.sampleRate);
+    int frames = 0;
+    EXPECT_EQ(fsp_process_audio_frames(session, input.data(), static_cast<int>(input.size()),
+                                       nullptr, 0, &frames), static_cast<int>(input.size()));
+    EXPECT_EQ(frames, 3);
+
+    uint64_t sequence = 0;
+    uint32_t dataOffset = 0;
+    uint32_t frameStride = 0;
+    std::memcpy(&sequence, block + 24, sizeof(sequence));
+    std::memcpy(&frameStride, block + 16, sizeof(frameStride));
+    std::memcpy(&dataOffset, block + 20, sizeof(dataOffset));
+    EXPECT_EQ(sequence, 3u);
+
+    // Newest frame matches what the copy-out path returns for the same hop
+    std::vector<float> expected(config.numMelBands);
+    FspSession* reference = fsp_session_create();
+    ASSERT_EQ(fsp_init_mel_processor(reference, &config), 0);
+    fsp_process_audio_frame(reference, input.data() + 2 * config.hopSize, config.frameSize,
+                            expected.data(), config.numMelBands);
+    const float* newest = reinterpret_cast<const float*>(block + dataOffset + 2 * frameStride);
+    for (int band = 0; band < config.numMelBands; ++band) {
+        EXPECT_FLOAT_EQ(newest[band], expected[band]);
+    }
+
+    // Re-init with the same band count keeps the block readers already hold
+    ASSERT_EQ(fsp_init_mel_processor(session, &config), 0);
+    EXPECT_EQ(fsp_get_mel_ring(session, nullptr), block);
+
+    fsp_session_destroy(reference);
+    fsp_session_destroy(session);
+}
+
+// Test 7: The pipeline runs on its own thread; direct processing is locked out meanwhile
+TEST_F(FlutterSpNativeTest, PipelineTest) {
+    melspectrogram::AudioConfig config;
+    FspSession* session = fsp_session_create();
+    melspectrogram::PipelineStats stats;
+    EXPECT_EQ(fsp_start_pipeline(session, 64), -1);
+    EXPECT_EQ(fsp_get_pipeline_stats(session, &stats), -1);
+
+    ASSERT_EQ(fsp_init_mel_processor(session, &config), 0);
+    ASSERT_EQ(fsp_init_texture_renderer_with_backend(session, 64, config.numMelBands, config.numMelBands,
+                                                     static_cast<int>(melspectrogram::RenderBackendType::CPU)), 0);
+    ASSERT_EQ(fsp_start_pipeline(session, 64), 0);
+    EXPECT_EQ(fsp_start_pipeline(session, 64), -1);
+
+    auto input = makeSine(config.frameSize + 4 * config.hopSize, 440.0f, config.sampleRate);
+    std::vector<float> output(config.numMelBands);
+    EXPECT_EQ(fsp_process_audio_frame(session, input.data(), config.frameSize,
+                                      output.data(), config.numMelBands), -1);
+    EXPECT_EQ(fsp_init_mel_processor(session, &config), -1);
+    EXPECT_NE(std::string(fsp_get_error_message()).find("pipeline"), std::string::npos);
+
+    EXPECT_EQ(fsp_push_pipeline_audio(session, input.data(), static_cast<int>(input.size())),
+              static_cast<int>(input.size()));
+    int delivered = 0;
+    for (int attempt = 0; attempt < 200 && delivered < 5; ++attempt) {
+        delivered += fsp_poll_pipeline(session);
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    EXPECT_EQ(delivered, 5);
+    EXPECT_EQ(fsp_get_texture_current_column(session), 5);
+
+    EXPECT_EQ(fsp_get_pipeline_stats(session, &stats), 1);
+    EXPECT_EQ(stats.framesProcessed, 5u);
+    EXPECT_EQ(stats.columnsDelivered, 5u);
+
+    ASSERT_EQ(fsp_stop_pipeline(session), 0);
+    EXPECT_EQ(fsp_get_pipeline_stats(session, &stats), 0);
+    EXPECT_EQ(fsp_push_pipeline_audio(session, input.data(), 16), -1);
+    EXPECT_EQ(fsp_process_audio_frame(session, input.data(), config.frameSize,
+                                      output.data(), config.numMelBands), config.numMelBands);
+    fsp_session_destroy(session);
+}
+
+// Test 8: Quantized frames and texture columns through the C API
+TEST_F(FlutterSpNativeTest, QuantizedOutputTest) {
+    melspectrogram::AudioConfig config;
+    FspSession* session = fsp_session_create();
+    ASSERT_EQ(fsp_init_mel_processor(session, &config), 0);
+    EXPECT_EQ(fsp_set_mel_output_format(session, 3), -1);
+    EXPECT_EQ(fsp_set_mel_output_format(session, 1), config.numMelBands);
+
+    const int numSamples = config.frameSize + 3 * config.hopSize;
+    auto input = makeSine(numSamples, 900.0f, config.sampleRate);
+    std::vector<uint8_t> bytes(4 * config.numMelBands);
+    int frames = -1;
+    EXPECT_EQ(fsp_process_audio_frames_quantized(session, input.data(), numSamples, bytes.data(),
+                                                 static_cast<int>(bytes.size()), &frames), numSamples);
+    EXPECT_EQ(frames, 4);
+
+    // Same frames as the float call, quantized
+    FspSession* reference = fsp_session_create();
+    ASSERT_EQ(fsp_init_mel_processor(reference, &config), 0);
+    std::vector<float> floats(4 * config.numMelBands);
+    fsp_process_audio_frames(reference, input.data(), numSamples, floats.data(),
+                             static_cast<int>(floats.size()), &frames);
+    for (size_t i = 0; i < floats.size(); ++i) {
+        ASSERT_EQ(bytes[i], static_cast<uint8_t>(floats[i] * 255.0f + 0.5f)) << i;
+    }
+
+    // Half output is two bytes per band and survives a processor re-init
+    EXPECT_EQ(fsp_set_mel_output_format(session, 2), config.numMelBands * 2);
+    ASSERT_EQ(fsp_init_mel_processor(session, &config), 0);
+    std::vector<uint16_t> halves(config.numMelBands);
+    EXPECT_EQ(fsp_process_audio_frames_quantized(session, input.data(), config.frameSize, halves.data(),
+                                                 config.numMelBands * 2, &frames), config.frameSize);
+    EXPECT_EQ(frames, 1);
+    EXPECT_NEAR(melspectrogram::halfToFloat(halves[5]), floats[5], 1e-3f);
+
+    ASSERT_EQ(fsp_init_texture_renderer_with_backend(session, 8, config.numMelBands, config.numMelBands,
+        static_cast<int>(melspectrogram::RenderBackendType::CPU)), 0);
+    EXPECT_EQ(fsp_update_texture_column_quantized(session, bytes.data(), config.numMelBands, 1), 0);
+    // The CPU backend writes enqueued columns immediately, so nothing is left pending
+    EXPECT_EQ(fsp_enqueue_texture_column_quantized(session, halves.data(), config.numMelBands, 2), 0);
+    EXPECT_EQ(fsp_get_texture_current_column(session), 2);
+    EXPECT_EQ(fsp_update_texture_column_quantized(session, bytes.data(), config.numMelBands, 7), -1);
+
+    // Color maps outside ColorMapType are refused rather than indexing past the tables
+    EXPECT_EQ(fsp_set_texture_color_map(session, 2), 0);
+    EXPECT_EQ(fsp_set_texture_color_map(session, 3), -1);
+    EXPECT_NE(std::string(fsp_get_error_message()).find("color map"), std::string::npos);
+    EXPECT_EQ(fsp_set_texture_color_map(session, -1), -1);
+    EXPECT_EQ(fsp_update_texture_column_quantized(session, bytes.data(), config.numMelBands, 1), 0);
+
+    fsp_session_destroy(reference);
+    fsp_session_destroy(session);
+}
+
+// Test 9: Front-end filtering through the C API, kept across a re-init
+TEST_F(FlutterSpNativeTest, FrontEndTest) {
+    melspectrogram::AudioConfig config;
+    FspSession* session = fsp_session_create();
+    EXPECT_EQ(fsp_set_front_end(session, 1, 0.97f), -1);
+    ASSERT_EQ(fsp_init_mel_processor(session, &config), 0);
+    EXPECT_EQ(fsp_set_front_end(session, 1, 1.5f), -1);
+    ASSERT_EQ(fsp_set_front_end(session, 1, 0.97f), 0);
+    ASSERT_EQ(fsp_init_mel_processor(session, &config), 0);
+
+    FspSession* reference = fsp_session_create();
+    ASSERT_EQ(fsp_init_mel_processor(reference, &config), 0);
+
+    const int numSamples = config.frameSize + 3 * config.hopSize;
+    auto input = makeSine(numSamples, 900.0f, config.sampleRate);
+    std::vector<float> filtered(4 * config.numMelBands);
+    std::vector<float> plain(4 * config.numMelBands);
+    int frames = -1;
+    fsp_process_audio_frames(session, input.data(), numSamples, filtered.data(),
+                             static_cast<int>(filtered.size()), &frames);
+    EXPECT_EQ(frames, 4);
+    fsp_process_audio_frames(reference, input.data(), numSamples, plain.data(),
+                             static_cast<int>(plain.size()), &frames);
+    EXPECT_NE(filtered, plain);
+
+    config.fixedPoint = 1;
+    ASSERT_EQ(fsp_init_mel_processor(session, &config), 0);
+    EXPECT_EQ(fsp_set_front_end(session, 1, 0.0f), -1);
+
+    fsp_session_destroy(reference);
+    fsp_session_destroy(session);
+}
+
+// Test 10: Activity gating through the C API repeats the floor frame on silence
+TEST_F(FlutterSpNativeTest, ActivityGateTest) {
+    melspectrogram::AudioConfig config;
+    FspSession* session = fsp_session_create();
+    EXPECT_EQ(fsp_set_activity_gate(session, 1, -50.0f, 6.0f, 2, 1.0f), -1);
+    ASSERT_EQ(fsp_init_mel_processor(session, &config), 0);
+    EXPECT_EQ(fsp_set_activity_gate(session, 1, -50.0f, -1.0f, 2, 1.0f), -1);
+    ASSERT_EQ(fsp_set_activity_gate(session, 1, -50.0f, 6.0f, 2, 1.0f), 0);
+    // Kept across a re-init, like the output format
+    ASSERT_EQ(fsp_init_mel_processor(session, &config), 0);
+
+    const int numSamples = config.frameSize + 3 * config.hopSize;
+    std::vector<int16_t> silence(numSamples, 0);
+    std::vector<float> output(4 * config.numMelBands);
+    int frames = -1;
+    fsp_process_audio_frames(session, silence.data(), numSamples, output.data(),
+                             static_cast<int>(output.size()), &frames);
+    ASSERT_EQ(frames, 4);
+    for (int f = 1; f < frames; ++f) {
+        for (int b = 0; b < config.numMelBands; ++b) {
+            ASSERT_EQ(output[f * config.numMelBands + b], output[b]);
+        }
+    }
+
+    fsp_session_destroy(session);
+}
+
+// Test 11: A feature graph computes several features per frame, without a mel processor
+TEST_F(FlutterSpNativeTest, FeatureGraphTest) {
+    melspectrogram::AudioConfig config;
+    FspSession* session = fsp_session_create();
+    std::vector<int16_t> frame = makeSine(config.frameSize, 1000.0f, config.sampleRate);
+    std::vector<float> output(256);
+    EXPECT_EQ(fsp_process_feature_frame(session, frame.data(), config.frameSize, output.data(), 256), -1);
+    EXPECT_EQ(fsp_init_feature_graph(session, &config, 0), -1);
+
+    // Mel, centroid and chroma
+    const int size = fsp_init_feature_graph(session, &config, 1 | 4 | 32);
+    ASSERT_EQ(size, config.numMelBands + 1 + 12);
+    EXPECT_EQ(fsp_process_feature_frame(session, frame.data(), config.frameSize, output.data(), size - 1), -1);
+    ASSERT_EQ(fsp_process_feature_frame(session, frame.data(), config.frameSize, output.data(), size), size);
+    EXPECT_NEAR(output[config.numMelBands], 1000.0f, 50.0f);
+
+    fsp_session_destroy(session);
+}
+
+// Test 12: Constant-Q columns go to the texture renderer like mel columns
+TEST_F(FlutterSpNativeTest, ConstantQTest) {
+    FspSession* session = fsp_session_create();
+    const int sampleRate = 32000;
+    const int hop = 512;
+    std::vector<int16_t> input = makeSine(40 * hop, 440.0f, sampleRate);
+    std::vector<float> columns(2 * 84);
+    int frames = 0;
+    EXPECT_EQ(fsp_process_cqt_frames(session, input.data(), hop, columns.data(), 84, &frames), -1);
+    EXPECT_EQ(fsp_init_cqt(session, sampleRate, 500, 32.7032f, 12, 7), -1);
+
+    const int bins = fsp_init_cqt(session, sampleRate, hop, 32.7032f, 12, 7);
+    ASSERT_EQ(bins, 84);
+    // Room for two columns: input stops after the second hop
+    EXPECT_EQ(fsp_process_cqt_frames(session, input.data(), static_cast<int>(input.size()), columns.data(),
+                                     2 * bins, &frames), 2 * hop);
+    EXPECT_EQ(frames, 2);
+    EXPECT_EQ(fsp_process_cqt_frames(session, input.data(), static_cast<int>(input.size()), nullptr, 0, &frames),
+              static_cast<int>(input.size()));
+    EXPECT_EQ(frames, 40);
+    // The last column, filled with the tone, peaks at A4
+    EXPECT_EQ(fsp_process_cqt_frames(session, input.data(), hop, columns.data(), bins, &frames), hop);
+    ASSERT_EQ(frames, 1);
+    EXPECT_EQ(std::max_element(columns.begin(), columns.begin() + bins) - columns.begin(), 45);
+
+    ASSERT_EQ(fsp_init_texture_renderer_with_backend(session, 8, bins, bins,
+        static_cast<int>(melspectrogram::RenderBackendType::CPU)), 0);
+    EXPECT_EQ(fsp_enqueue_texture_column(session, columns.data(), bins), 0);
+    EXPECT_EQ(fsp_get_texture_current_column(session), 1);
+
+    fsp_session_destroy(session);
+}
+
+// Test 13: A single frame with nowhere to go is rejected before it touches the stream
+TEST_F(FlutterSpNativeTest, FrameOutputValidationTest) {
+    melspectrogram::AudioConfig config;
+    FspSession* session = fsp_session_create();
+    FspSession* reference = fsp_session_create();
+    for (FspSession* s : {session, reference}) {
+        ASSERT_EQ(fsp_init_mel_processor(s, &config), 0);
+        // Pre-emphasis carries the last sample into the next frame
+        ASSERT_EQ(fsp_set_front_end(s, 1, 0.97f), 0);
+    }
+
+    auto first = makeSine(config.frameSize, 700.0f, config.sampleRate);
+    auto second = makeSine(config.frameSize, 1300.0f, config.sampleRate);
+    std::vector<float> mel(config.numMelBands);
+    EXPECT_EQ(fsp_process_audio_frame(session, first.data(), config.frameSize, nullptr, config.numMelBands), -1);
+    EXPECT_NE(std::string(fsp_get_error_message()).find("output"), std::string::npos);
+    EXPECT_EQ(fsp_process_audio_frame(session, first.data(), config.frameSize, mel.data(),
+                                      config.numMelBands - 1), -1);
+    EXPECT_NE(std::string(fsp_get_error_message()).find("too small"), std::string::npos);
+
+    // Neither rejected call moved the filter state on
+    std::vector<float> expected(config.numMelBands);
+    ASSERT_EQ(fsp_process_audio_frame(session, second.data(), config.frameSize, mel.data(), config.numMelBands),
+              config.numMelBands);
+    ASSERT_EQ(fsp_process_audio_frame(reference, second.data(), config.frameSize, expected.data(),
+                                      config.numMelBands), config.numMelBands);
+    EXPECT_EQ(mel, expected);
+
+    fsp_session_destroy(reference);
+    fsp_session_destroy(session);
+}
+
+// Test 14: The analysis rate a front end should configure for its device rate
+TEST_F(FlutterSpNativeTest, CanonicalAnalysisRateTest) {
+    EXPECT_EQ(fsp_canonical_analysis_rate(48000, 8000.0f), 32000);
+    EXPECT_EQ(fsp_canonical_analysis_rate(48000, 5000.0f), 16000);
+    EXPECT_EQ(canonical_analysis_rate(44100, 8000.0f), 32000);
+    EXPECT_EQ(canonical_analysis_rate(16000, 8000.0f), 16000);
+    EXPECT_EQ(fsp_canonical_analysis_rate(0, 8000.0f), -1);
+    EXPECT_NE(std::string(fsp_get_error_message()).find("sample rate"), std::string::npos);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
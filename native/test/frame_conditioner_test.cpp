@@ -0,0 +1,223 @@
+#include <gtest/gtest.h>
+#include "frame_conditioner.h"
+#include "mel_plan.h"
+#include "mel_spectrogram.h"
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace melspectrogram;
+
+namespace {
+    std::vector<int16_t> makeNoise(size_t samples, int offset) {
+        std::mt19937 rng(11);
+        std::uniform_int_distribution<int> noise(-12000, 12000);
+        std::vector<int16_t> signal(samples);
+        for (size_t i = 0; i < samples; ++i) {
+            signal[i] = static_cast<int16_t>(noise(rng) + offset);
+        }
+        return signal;
+    }
+
+    std::vector<float> makeWindow(int frameSize) {
+        std::vector<float> window(frameSize);
+        for (int i = 0; i < frameSize; ++i) {
+            window[i] = (0.25f + 0.75f * i / frameSize) / 32768.0f;
+        }
+        return window;
+    }
+
+    // The filters in double over the whole stream, one sample at a time
+    std::vector<double> referenceStream(const std::vector<int16_t>& input, const FrontEndConfig& config) {
+        std::vector<double> out(input.size());
+        double previousX = 0.0;
+        double previousY = 0.0;
+        for (size_t n = 0; n < input.size(); ++n) {
+            const double x = input[n];
+            const double y = config.dcBlock ? x - previousX + config.dcPole * previousY : x;
+            out[n] = y - config.preEmphasis * previousY;
+            previousX = x;
+            previousY = y;
+        }
+        return out;
+    }
+}
+
+// Test 1: Disabled front end is exactly the old per-sample windowing
+TEST(FrameConditionerTest, DisabledMatchesPlainWindow) {
+    for (int frameSize : {5, 64, 257, 512}) {
+        const std::vector<int16_t> input = makeNoise(frameSize, 0);
+        const std::vector<float> window = makeWindow(frameSize);
+        std::vector<std::complex<float>> output(frameSize);
+        conditionFrame(input.data(), frameSize, window.data(), FrontEndConfig(), nullptr, 0, output.data());
+        for (int i = 0; i < frameSize; ++i) {
+            ASSERT_EQ(output[i], std::complex<float>(input[i] * window[i], 0.0f)) << "size " << frameSize << " i " << i;
+        }
+    }
+}
+
+// Test 2: Vectorized filters track the double-precision stream, including odd sizes that hit the scalar tail
+TEST(FrameConditionerTest, FiltersMatchReference) {
+    FrontEndConfig configs[3];
+    configs[0].dcBlock = true;
+    configs[1].preEmphasis = 0.97f;
+    configs[2].dcBlock = true;
+    configs[2].preEmphasis = 0.97f;
+
+    for (const FrontEndConfig& config : configs) {
+        for (int frameSize : {7, 64, 130}) {
+            // A large offset makes the DC blocker's recurrence do real work
+            const std::vector<int16_t> input = makeNoise(frameSize, 8000);
+            const std::vector<float> window(frameSize, 1.0f);
+            const std::vector<double> expected = referenceStream(input, config);
+
+            FrontEndState state;
+            std::vector<std::complex<float>> output(frameSize);
+            conditionFrame(input.data(), frameSize, window.data(), config, &state, frameSize, output.data());
+            for (int i = 0; i < frameSize; ++i) {
+                ASSERT_NEAR(output[i].real(), expected[i], 0.05) << "size " << frameSize << " i " << i;
+                ASSERT_EQ(output[i].imag(), 0.0f);
+            }
+        }
+    }
+}
+
+// Test 3: State saved after each hop lets overlapping frames continue one stream
+TEST(FrameConditionerTest, StateCarriesAcrossHops) {
+    FrontEndConfig config;
+    config.dcBlock = true;
+    config.preEmphasis = 0.97f;
+    const int frameSize = 256;
+    const int hopSize = 93;
+    const std::vector<int16_t> input = makeNoise(4096, -6000);
+    const std::vector<float> window(frameSize, 1.0f);
+    const std::vector<double> expected = referenceStream(input, config);
+
+    FrontEndState state;
+    std::vector<std::complex<float>> output(frameSize);
+    for (size_t start = 0; start + frameSize <= input.size(); start += hopSize) {
+        conditionFrame(input.data() + start, frameSize, window.data(), config, &state, hopSize, output.data());
+        for (int i = 0; i < frameSize; ++i) {
+            ASSERT_NEAR(output[i].real(), expected[start + i], 0.5) << "frame at " << start << " i " << i;
+        }
+    }
+}
+
+// Test 4: DC blocker removes a constant offset
+TEST(FrameConditionerTest, DcBlockRemovesOffset) {
+    FrontEndConfig config;
+    config.dcBlock = true;
+    const int frameSize = 512;
+    const std::vector<int16_t> input(frameSize, 10000);
+    const std::vector<float> window(frameSize, 1.0f);
+
+    FrontEndState state;
+    std::vector<std::complex<float>> output(frameSize);
+    for (int frame = 0; frame < 8; ++frame) {
+        conditionFrame(input.data(), frameSize, window.data(), config, &state, frameSize, output.data());
+    }
+    EXPECT_LT(std::abs(output[frameSize - 1].real()), 1.0f);
+}
+
+// Test 5: Processor applies the front end on the stream, inside the compile-time pipeline for this config
+TEST(FrameConditionerTest, ProcessorFrontEnd) {
+    AudioConfig config;
+    config.sampleRate = 16000;
+    config.frameSize = 512;
+    config.hopSize = 256;
+    config.numMelBands = 40;
+
+    MelSpectrogramProcessor plain(config);
+    MelSpectrogramProcessor filtered(config);
+    FrontEndConfig frontEnd;
+    frontEnd.dcBlock = true;
+    frontEnd.preEmphasis = 0.97f;
+    ASSERT_TRUE(filtered.setFrontEnd(frontEnd));
+    EXPECT_TRUE(filtered.getFrontEnd().dcBlock);
+
+    const std::vector<int16_t> input = makeNoise(config.frameSize * 6, 4000);
+    const size_t capacity = 16;
+    std::vector<float> plainOut(capacity * config.numMelBands);
+    std::vector<float> filteredOut(capacity * config.numMelBands);
+    size_t plainFrames = 0;
+    size_t filteredFrames = 0;
+    plain.processAudioSamples(input.data(), input.size(), plainOut.data(), capacity, &plainFrames);
+    filtered.processAudioSamples(input.data(), input.size(), filteredOut.data(), capacity, &filteredFrames);
+    ASSERT_EQ(plainFrames, filteredFrames);
+    ASSERT_GT(filteredFrames, 0u);
+    EXPECT_NE(plainOut, filteredOut);
+
+    // The pipeline's filtered frames agree with the runtime-table steps on the same stream
+    auto plan = MelPlan::acquire(config);
+    ASSERT_TRUE(plan->isSpecialized());
+    FrontEndState state;
+    std::vector<std::complex<float>> fftInput(config.frameSize);
+    std::vector<std::complex<float>> fftOutput(config.frameSize);
+    std::vector<float> power(plan->getNumBins());
+    std::vector<float> expected(config.numMelBands);
+    for (size_t f = 0; f < filteredFrames; ++f) {
+        conditionFrame(input.data() + f * config.hopSize, config.frameSize, plan->getScaledWindow(), frontEnd,
+                       &state, config.hopSize, fftInput.data());
+        plan->fft(fftInput.data(), fftOutput.data());
+        plan->powerSpectrum(fftOutput.data(), power.data());
+        plan->applyFilterBank(power.data(), expected.data());
+        MelPlan::logScale(expected.data(), config.numMelBands);
+        for (int band = 0; band < config.numMelBands; ++band) {
+            ASSERT_NEAR(filteredOut[f * config.numMelBands + band], expected[band], 1e-4f)
+                << "frame " << f << " band " << band;
+        }
+    }
+
+    // Same stream split differently gives the same frames: the filter memory follows the hops
+    MelSpectrogramProcessor split(config);
+    ASSERT_TRUE(split.setFrontEnd(frontEnd));
+    std::vector<float> splitOut(capacity * config.numMelBands);
+    size_t first = 0;
+    size_t second = 0;
+    const size_t cut = 700;
+    split.processAudioSamples(input.data(), cut, splitOut.data(), capacity, &first);
+    split.processAudioSamples(input.data() + cut, input.size() - cut,
+                              splitOut.data() + first * config.numMelBands, capacity - first, &second);
+    ASSERT_EQ(first + second, filteredFrames);
+    for (size_t i = 0; i < filteredFrames * config.numMelBands; ++i) {
+        ASSERT_FLOAT_EQ(splitOut[i], filteredOut[i]) << "value " << i;
+    }
+
+    // Turning it off again returns to the unfiltered output
+    ASSERT_TRUE(filtered.setFrontEnd(FrontEndConfig()));
+    filtered.processAudioSamples(input.data(), input.size(), filteredOut.data(), capacity, &filteredFrames);
+    EXPECT_EQ(plainOut, filteredOut);
+
+    config.fixedPoint = 1;
+    MelSpectrogramProcessor fixed(config);
+    EXPECT_FALSE(fixed.setFrontEnd(frontEnd));
+    EXPECT_FALSE(fixed.getFrontEnd().enabled());
+}
+
+// Test 6: The real-FFT input form holds exactly the real parts of the complex form
+TEST(FrameConditionerTest, RealOutputMatchesComplex) {
+    FrontEndConfig frontEnd;
+    frontEnd.dcBlock = true;
+    frontEnd.preEmphasis = 0.97f;
+    for (int frameSize : {5, 64, 257}) {
+        const std::vector<int16_t> input = makeNoise(frameSize, 3000);
+        const std::vector<float> window = makeWindow(frameSize);
+        std::vector<std::complex<float>> complexOut(frameSize);
+        std::vector<float> realOut(frameSize);
+        FrontEndState complexState;
+        FrontEndState realState;
+        conditionFrame(input.data(), frameSize, window.data(), frontEnd, &complexState, frameSize / 2,
+                       complexOut.data());
+        conditionFrame(input.data(), frameSize, window.data(), frontEnd, &realState, frameSize / 2, realOut.data());
+        for (int i = 0; i < frameSize; ++i) {
+            ASSERT_EQ(realOut[i], complexOut[i].real()) << "size " << frameSize << " i " << i;
+        }
+        EXPECT_EQ(realState.previousInput, complexState.previousInput);
+        EXPECT_EQ(realState.previousOutput, complexState.previousOutput);
+    }
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
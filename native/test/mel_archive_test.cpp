@@ -0,0 +1,365 @@
+#include <gtest/gtest.h>
+#include "mel_archive.h"
+#include "mel_spectrogram.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace melspectrogram;
+
+namespace {
+    // Slowly drifting band energies in 0-1, like a normalized spectrogram
+    std::vector<float> makeFrames(size_t frames, int bands) {
+        std::vector<float> data(frames * bands);
+        for (size_t f = 0; f < frames; ++f) {
+            for (int b = 0; b < bands; ++b) {
+                const float v = 0.5f + 0.35f * std::sin(0.013f * f + 0.2f * b) + 0.1f * std::cos(0.051f * f * (1 + b % 3));
+                data[f * bands + b] = std::min(std::max(v, 0.0f), 1.0f);
+            }
+        }
+        return data;
+    }
+
+    std::string tempPath(const std::string& name) {
+        return ::testing::TempDir() + name;
+    }
+
+    long fileSize(const std::string& path) {
+        FILE* file = std::fopen(path.c_str(), "rb");
+        std::fseek(file, 0, SEEK_END);
+        const long size = std::ftell(file);
+        std::fclose(file);
+        return size;
+    }
+
+    std::vector<uint8_t> readFile(const std::string& path) {
+        std::vector<uint8_t> bytes(static_cast<size_t>(fileSize(path)));
+        FILE* file = std::fopen(path.c_str(), "rb");
+        EXPECT_EQ(std::fread(bytes.data(), 1, bytes.size(), file), bytes.size());
+        std::fclose(file);
+        return bytes;
+    }
+
+    void writeFile(const std::string& path, const std::vector<uint8_t>& bytes) {
+        FILE* file = std::fopen(path.c_str(), "wb");
+        std::fwrite(bytes.data(), 1, bytes.size(), file);
+        std::fclose(file);
+    }
+
+    void putU64(uint8_t* p, uint64_t value) {
+        for (int i = 0; i < 8; ++i) p[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+// Test 1: 8- and 12-bit round trips stay within half a quantization step
+TEST(MelArchiveTest, RoundTripTest) {
+    const int bands = 40;
+    const size_t frames = 1000;
+    auto data = makeFrames(frames, bands);
+
+    for (int bitDepth : {8, 12}) {
+        MelArchiveConfig config;
+        config.numMelBands = bands;
+        config.chunkFrames = 64;
+        config.bitDepth = bitDepth;
+        const std::string path = tempPath("roundtrip_" + std::to_string(bitDepth) + ".mela");
+
+        MelArchiveWriter writer;
+        ASSERT_TRUE(writer.open(path, config)) << writer.getError();
+        // Uneven appends straddle chunk boundaries
+        size_t written = 0;
+        for (size_t step = 1; written < frames; step = step * 3 % 97 + 1) {
+            const size_t count = std::min(step, frames - written);
+            ASSERT_TRUE(writer.append(data.data() + written * bands, count));
+            written += count;
+        }
+        ASSERT_TRUE(writer.close());
+        EXPECT_EQ(writer.getFramesWritten(), frames);
+
+        MelArchiveReader reader;
+        ASSERT_TRUE(reader.open(path)) << reader.getError();
+        EXPECT_FALSE(reader.wasRecovered());
+        EXPECT_EQ(reader.getNumFrames(), frames);
+        EXPECT_EQ(reader.getNumChunks(), 16u);
+        EXPECT_EQ(reader.getConfig().bitDepth, bitDepth);
+
+        std::vector<float> decoded(data.size());
+        ASSERT_EQ(reader.readFrames(0, frames, decoded.data()), static_cast<long>(frames));
+        const float tolerance = 0.5f / ((1 << bitDepth) - 1) + 1e-6f;
+        float maxError = 0.0f;
+        for (size_t i = 0; i < data.size(); ++i) {
+            maxError = std::max(maxError, std::fabs(decoded[i] - data[i]));
+        }
+        EXPECT_LE(maxError, tolerance) << bitDepth << "-bit";
+    }
+}
+
+// Test 2: Compression ratios at 8 bits
+TEST(MelArchiveTest, CompressionRatioTest) {
+    // Smooth, slowly evolving spectra: the case long device histories are dominated by
+    const int bands = 64;
+    const size_t smoothFrames = 4000;
+    auto smooth = makeFrames(smoothFrames, bands);
+    MelArchiveConfig config;
+    config.numMelBands = bands;
+    const std::string smoothPath = tempPath("ratio_smooth.mela");
+    MelArchiveWriter writer;
+    ASSERT_TRUE(writer.open(smoothPath, config));
+    ASSERT_TRUE(writer.append(smooth.data(), smoothFrames));
+    ASSERT_TRUE(writer.close());
+    EXPECT_EQ(static_cast<long>(writer.getBytesWritten()), fileSize(smoothPath));
+    EXPECT_GE(static_cast<double>(smooth.size() * sizeof(float)) / fileSize(smoothPath), 10.0);
+
+    // Processor output, archived as dB: each chunk keeps 70 dB below its peak,
+    // so the noise floor far beneath the tones costs nothing
+    AudioConfig audio;
+    MelSpectrogramProcessor processor(audio);
+    std::vector<int16_t> signal(audio.sampleRate * 20);
+    for (size_t i = 0; i < signal.size(); ++i) {
+        const float t = static_cast<float>(i) / audio.sampleRate;
+        signal[i] = static_cast<int16_t>(6000.0f * std::sin(2.0f * 3.14159265f * (300.0f + 40.0f * t) * t) +
+                                         3000.0f * std::sin(2.0f * 3.14159265f * 1250.0f * t));
+    }
+    const size_t maxFrames = signal.size() / audio.hopSize;
+    std::vector<float> frames(maxFrames * audio.numMelBands);
+    std::vector<float> decibels(frames.size());
+    size_t produced = 0;
+    processor.processAudioSamples(signal.data(), signal.size(), frames.data(), maxFrames, &produced,
+                                  decibels.data());
+    ASSERT_GT(produced, 1000u);
+    decibels.resize(produced * audio.numMelBands);
+
+    const std::string path = tempPath("ratio_processor.mela");
+    config.dynamicRangeDb = 70.0f;
+    ASSERT_TRUE(writer.open(path, config));
+    ASSERT_TRUE(writer.append(decibels.data(), produced));
+    ASSERT_TRUE(writer.close());
+    EXPECT_GE(static_cast<double>(decibels.size() * sizeof(float)) / fileSize(path), 10.0);
+
+    // Within half a step of the value raised to its chunk's floor
+    MelArchiveReader reader;
+    ASSERT_TRUE(reader.open(path));
+    std::vector<float> decoded(decibels.size());
+    ASSERT_EQ(reader.readFrames(0, produced, decoded.data()), static_cast<long>(produced));
+    const size_t chunkValues = static_cast<size_t>(config.chunkFrames) * audio.numMelBands;
+    for (size_t chunk = 0; chunk < decibels.size(); chunk += chunkValues) {
+        const size_t end = std::min(chunk + chunkValues, decibels.size());
+        const float peak = *std::max_element(decibels.begin() + chunk, decibels.begin() + end);
+        const float tolerance = 0.5f * config.dynamicRangeDb / 255 + 1e-3f;
+        for (size_t i = chunk; i < end; ++i) {
+            ASSERT_NEAR(decoded[i], std::max(decibels[i], peak - config.dynamicRangeDb), tolerance) << i;
+        }
+    }
+}
+
+// Test 3: Range and time reads decode only what they touch and match a full read
+TEST(MelArchiveTest, RandomAccessTest) {
+    const int bands = 64;
+    const size_t frames = 5000;
+    auto data = makeFrames(frames, bands);
+    MelArchiveConfig config;
+    config.numMelBands = bands;
+    config.chunkFrames = 128;
+    config.sampleRate = 16000;
+    config.hopSize = 160;
+    const std::string path = tempPath("random.mela");
+
+    MelArchiveWriter writer;
+    ASSERT_TRUE(writer.open(path, config));
+    ASSERT_TRUE(writer.append(data.data(), frames));
+    ASSERT_TRUE(writer.close());
+
+    MelArchiveReader reader;
+    ASSERT_TRUE(reader.open(path));
+    std::vector<float> all(frames * bands);
+    ASSERT_EQ(reader.readFrames(0, frames, all.data()), static_cast<long>(frames));
+
+    // Across a chunk boundary, and past the end
+    std::vector<float> slice(300 * bands);
+    ASSERT_EQ(reader.readFrames(100, 300, slice.data()), 300);
+    EXPECT_TRUE(std::equal(slice.begin(), slice.end(), all.begin() + 100 * bands));
+    EXPECT_EQ(reader.readFrames(frames - 10, 300, slice.data()), 10);
+    EXPECT_EQ(reader.readFrames(frames, 1, slice.data()), 0);
+
+    // 100 frames per second at this hop
+    EXPECT_EQ(reader.frameAtTime(12.345), 1234u);
+    std::vector<float> range;
+    ASSERT_EQ(reader.readTimeRange(10.0, 10.5, range), 50);
+    EXPECT_TRUE(std::equal(range.begin(), range.end(), all.begin() + 1000 * bands));
+
+    // Random single-frame seeks, each decoding a fresh chunk
+    std::mt19937 rng(7);
+    std::vector<float> frame(bands);
+    const int seeks = 200;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < seeks; ++i) {
+        const uint64_t index = rng() % frames;
+        ASSERT_EQ(reader.readFrames(index, 1, frame.data()), 1);
+        ASSERT_TRUE(std::equal(frame.begin(), frame.end(), all.begin() + index * bands));
+    }
+    const double perSeekMs = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count() / seeks;
+    EXPECT_LT(perSeekMs, 1.0);
+}
+
+// Test 4: An archive that was never closed is recovered by scanning its chunks
+TEST(MelArchiveTest, RecoveryTest) {
+    const int bands = 16;
+    auto data = makeFrames(250, bands);
+    MelArchiveConfig config;
+    config.numMelBands = bands;
+    config.chunkFrames = 100;
+    const std::string path = tempPath("recover.mela");
+
+    MelArchiveWriter writer;
+    ASSERT_TRUE(writer.open(path, config));
+    ASSERT_TRUE(writer.append(data.data(), 250));
+
+    // Two full chunks are on disk; the last 50 frames are still pending
+    MelArchiveReader reader;
+    ASSERT_TRUE(reader.open(path)) << reader.getError();
+    EXPECT_TRUE(reader.wasRecovered());
+    EXPECT_EQ(reader.getNumFrames(), 200u);
+    std::vector<float> frame(bands);
+    EXPECT_EQ(reader.readFrames(199, 1, frame.data()), 1);
+
+    ASSERT_TRUE(writer.close());
+    ASSERT_TRUE(reader.open(path));
+    EXPECT_FALSE(reader.wasRecovered());
+    EXPECT_EQ(reader.getNumFrames(), 250u);
+}
+
+// Test 5: Constant and non-finite input, bad files
+TEST(MelArchiveTest, EdgeCaseTest) {
+    const int bands = 8;
+    MelArchiveConfig config;
+    config.numMelBands = bands;
+    config.chunkFrames = 4;
+    const std::string path = tempPath("edge.mela");
+
+    std::vector<float> data(8 * bands, 0.25f);
+    data[3] = NAN;
+    data[bands * 5] = INFINITY;
+    data[bands * 5 + 1] = 2.0f;
+
+    MelArchiveWriter writer;
+    EXPECT_FALSE(writer.append(data.data(), 1));
+    MelArchiveConfig bad = config;
+    bad.bitDepth = 17;
+    EXPECT_FALSE(writer.open(path, bad));
+    ASSERT_TRUE(writer.open(path, config));
+    ASSERT_TRUE(writer.append(data.data(), 8));
+    ASSERT_TRUE(writer.close());
+
+    MelArchiveReader reader;
+    ASSERT_TRUE(reader.open(path));
+    std::vector<float> decoded(data.size());
+    ASSERT_EQ(reader.readFrames(0, 8, decoded.data()), 8);
+    // First chunk is constant apart from the NaN, which decodes to the chunk minimum
+    for (int i = 0; i < 4 * bands; ++i) {
+        EXPECT_FLOAT_EQ(decoded[i], 0.25f);
+    }
+    EXPECT_FLOAT_EQ(decoded[bands * 5], 2.0f);
+    EXPECT_FLOAT_EQ(decoded[bands * 5 + 1], 2.0f);
+    EXPECT_NEAR(decoded[bands * 6], 0.25f, 1.75f / 255 / 2 + 1e-6f);
+
+    // Not an archive
+    EXPECT_FALSE(reader.open(tempPath("missing.mela")));
+    FILE* file = std::fopen(tempPath("garbage.mela").c_str(), "wb");
+    std::fputs("this is not an archive at all, not even close to one...................", file);
+    std::fclose(file);
+    EXPECT_FALSE(reader.open(tempPath("garbage.mela")));
+    EXPECT_FALSE(reader.getError().empty());
+}
+
+// Test 6: A trailer that disagrees with the chunks is ignored and the chunks are scanned
+TEST(MelArchiveTest, DamagedIndexTest) {
+    const int bands = 16;
+    auto data = makeFrames(250, bands);
+    MelArchiveConfig config;
+    config.numMelBands = bands;
+    config.chunkFrames = 100;
+    const std::string path = tempPath("index.mela");
+
+    MelArchiveWriter writer;
+    ASSERT_TRUE(writer.open(path, config));
+    ASSERT_TRUE(writer.append(data.data(), 250));
+    ASSERT_TRUE(writer.close());
+    MelArchiveReader reader;
+    ASSERT_TRUE(reader.open(path));
+    EXPECT_FALSE(reader.wasRecovered());
+    std::vector<float> expected(250 * bands);
+    ASSERT_EQ(reader.readFrames(0, 250, expected.data()), 250);
+
+    // Three chunks: the index is the 48 bytes before the 32-byte trailer
+    const auto original = readFile(path);
+    const size_t trailer = original.size() - 32;
+    const size_t index = trailer - 3 * 16;
+    const std::string damagedPath = tempPath("index_damaged.mela");
+    for (int damage = 0; damage < 5; ++damage) {
+        auto bytes = original;
+        switch (damage) {
+            case 0: putU64(&bytes[trailer + 16], 999); break;                       // totalFrames too high
+            case 1: putU64(&bytes[trailer + 16], 200); break;                       // ... and too low
+            case 2: std::swap_ranges(&bytes[index], &bytes[index + 16], &bytes[index + 16]); break;  // Unsorted
+            case 3: putU64(&bytes[index + 2 * 16 + 8], original.size()); break;     // Offset past the data
+            case 4: putU64(&bytes[index + 16], 150); break;                         // Disagrees with the chunk
+        }
+        writeFile(damagedPath, bytes);
+
+        ASSERT_TRUE(reader.open(damagedPath)) << "damage " << damage;
+        EXPECT_TRUE(reader.wasRecovered()) << "damage " << damage;
+        EXPECT_EQ(reader.getNumFrames(), 250u) << "damage " << damage;
+        EXPECT_EQ(reader.getNumChunks(), 3u) << "damage " << damage;
+        std::vector<float> decoded(250 * bands);
+        ASSERT_EQ(reader.readFrames(0, 250, decoded.data()), 250) << "damage " << damage;
+        EXPECT_EQ(decoded, expected) << "damage " << damage;
+    }
+}
+
+// Test 7: A chunk that fails to decode does not leave the cache claiming the previous one
+TEST(MelArchiveTest, CorruptChunkCacheTest) {
+    const int bands = 16;
+    auto data = makeFrames(250, bands);
+    MelArchiveConfig config;
+    config.numMelBands = bands;
+    config.chunkFrames = 100;
+    const std::string path = tempPath("cache.mela");
+
+    MelArchiveWriter writer;
+    ASSERT_TRUE(writer.open(path, config));
+    ASSERT_TRUE(writer.append(data.data(), 250));
+    ASSERT_TRUE(writer.close());
+    MelArchiveReader reader;
+    ASSERT_TRUE(reader.open(path));
+    std::vector<float> expected(100 * bands);
+    ASSERT_EQ(reader.readFrames(0, 100, expected.data()), 100);
+
+    // Give the short last chunk an impossible Rice parameter
+    auto bytes = readFile(path);
+    size_t last = 0;
+    for (size_t i = 0; i + 4 <= bytes.size(); i += 8) {
+        if (std::memcmp(&bytes[i], "MCHK", 4) == 0) last = i;
+    }
+    bytes[last + 32] = 0x3F;
+    writeFile(path, bytes);
+
+    ASSERT_TRUE(reader.open(path));
+    std::vector<float> decoded(100 * bands);
+    ASSERT_EQ(reader.readFrames(0, 100, decoded.data()), 100);
+    EXPECT_EQ(reader.readFrames(200, 50, decoded.data()), -1);
+    EXPECT_EQ(reader.getError(), "Corrupt chunk coding parameters");
+    // The first chunk decodes again instead of coming from the half-overwritten cache
+    ASSERT_EQ(reader.readFrames(0, 100, decoded.data()), 100);
+    EXPECT_EQ(decoded, expected);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,183 @@
+#include <gtest/gtest.h>
+#include "mel_frame_ring.h"
+#include "mel_spectrogram.h"
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+using namespace melspectrogram;
+
+namespace {
+    // Reads a frame using only the raw block and the documented byte offsets,
+    // the way a foreign runtime mapping the memory would
+    struct RawRingReader {
+        explicit RawRingReader(const uint8_t* block) : base(block) {
+            std::memcpy(&capacity, base + 8, 4);
+            std::memcpy(&numMelBands, base + 12, 4);
+            std::memcpy(&frameStride, base + 16, 4);
+            std::memcpy(&dataOffset, base + 20, 4);
+        }
+
+        uint64_t sequence() const {
+            return reinterpret_cast<const std::atomic<uint64_t>*>(base + 24)->load(std::memory_order_acquire);
+        }
+
+        uint64_t writeSequence() const {
+            return reinterpret_cast<const std::atomic<uint64_t>*>(base + 32)->load(std::memory_order_relaxed);
+        }
+
+        bool read(uint64_t index, float* output) const {
+            const uint64_t published = sequence();
+            if (index >= published || published - index > capacity) return false;
+            std::memcpy(output, base + dataOffset + (index % capacity) * frameStride,
+                        numMelBands * sizeof(float));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            return writeSequence() <= index + capacity;
+        }
+
+        const uint8_t* base;
+        uint32_t capacity = 0;
+        uint32_t numMelBands = 0;
+        uint32_t frameStride = 0;
+        uint32_t dataOffset = 0;
+    };
+
+    std::vector<float> frameFor(uint64_t index, int numBands) {
+        std::vector<float> frame(numBands);
+        for (int band = 0; band < numBands; ++band) {
+            frame[band] = static_cast<float>(index) + band * 0.001f;
+        }
+        return frame;
+    }
+}
+
+// Test 1: Header and slot layout
+TEST(MelFrameRingTest, LayoutTest) {
+    MelFrameRing ring(40, 8);
+    const uint8_t* block = ring.data();
+
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(block) % 64, 0u);
+    uint32_t fields[6];
+    std::memcpy(fields, block, sizeof(fields));
+    EXPECT_EQ(fields[0], MEL_FRAME_RING_MAGIC);
+    EXPECT_EQ(fields[1], MEL_FRAME_RING_VERSION);
+    EXPECT_EQ(fields[2], 8u);
+    EXPECT_EQ(fields[3], 40u);
+    EXPECT_EQ(fields[4] % 64, 0u);
+    EXPECT_GE(fields[4], 40u * sizeof(float));
+    EXPECT_EQ(fields[5], 64u);
+    EXPECT_EQ(ring.size(), fields[5] + 8u * fields[4]);
+    EXPECT_EQ(std::memcmp(block, "MELR", 4), 0);
+}
+
+// Test 2: Publishing, reading and overwrite detection on one thread
+TEST(MelFrameRingTest, PublishReadTest) {
+    MelFrameRing ring(16, 4);
+    std::vector<float> out(16);
+    EXPECT_EQ(ring.readLatest(out.data()), -1);
+    EXPECT_FALSE(ring.readFrame(0, out.data()));
+
+    for (uint64_t i = 0; i < 6; ++i) {
+        ring.publish(frameFor(i, 16).data());
+    }
+    EXPECT_EQ(ring.getSequence(), 6u);
+    EXPECT_EQ(ring.header()->writeIndex.load(), 2u);
+
+    // Frames 2..5 are retained, 0..1 are gone, 6 does not exist yet
+    EXPECT_FALSE(ring.readFrame(1, out.data()));
+    EXPECT_FALSE(ring.readFrame(6, out.data()));
+    for (uint64_t i = 2; i < 6; ++i) {
+        ASSERT_TRUE(ring.readFrame(i, out.data()));
+        EXPECT_EQ(out, frameFor(i, 16));
+    }
+
+    // A write in progress invalidates the slot it is overwriting
+    float* slot = ring.beginWrite();
+    EXPECT_FALSE(ring.readFrame(2, out.data()));
+    EXPECT_TRUE(ring.readFrame(3, out.data()));
+    auto frame = frameFor(6, 16);
+    std::memcpy(slot, frame.data(), frame.size() * sizeof(float));
+    ring.commitWrite();
+    EXPECT_EQ(ring.readLatest(out.data()), 6);
+    EXPECT_EQ(out, frame);
+}
+
+// Test 3: A concurrent reader never accepts a torn frame
+TEST(MelFrameRingTest, ConcurrentReaderTest) {
+    const int numBands = 64;
+    const uint64_t numFrames = 200000;
+    MelFrameRing ring(numBands, 4);
+    RawRingReader reader(ring.data());
+    std::atomic<bool> done{false};
+
+    std::thread writer([&] {
+        std::vector<float> frame(numBands);
+        for (uint64_t i = 0; i < numFrames; ++i) {
+            std::fill(frame.begin(), frame.end(), static_cast<float>(i));
+            ring.publish(frame.data());
+        }
+        done = true;
+    });
+
+    std::vector<float> out(numBands);
+    uint64_t accepted = 0;
+    uint64_t lastIndex = 0;
+    int torn = 0;
+    int outOfOrder = 0;
+    while (!done || accepted == 0) {
+        const uint64_t published = reader.sequence();
+        if (published == 0) continue;
+        const uint64_t index = published - 1;
+        if (!reader.read(index, out.data())) continue;
+
+        for (float value : out) {
+            if (value != static_cast<float>(index)) {
+                torn++;
+                break;
+            }
+        }
+        if (index < lastIndex) outOfOrder++;
+        lastIndex = index;
+        accepted++;
+    }
+    writer.join();
+
+    EXPECT_EQ(torn, 0);
+    EXPECT_EQ(outOfOrder, 0);
+    EXPECT_GT(accepted, 0u);
+    EXPECT_EQ(reader.sequence(), numFrames);
+}
+
+// Test 4: The processor publishes each hop into an attached ring
+TEST(MelFrameRingTest, ProcessorPublishTest) {
+    AudioConfig config;
+    MelSpectrogramProcessor processor(config);
+    MelSpectrogramProcessor reference(config);
+    MelFrameRing ring(config.numMelBands, 16);
+    processor.setFrameRing(&ring);
+
+    std::vector<int16_t> signal(config.frameSize + 3 * config.hopSize);
+    for (size_t i = 0; i < signal.size(); ++i) {
+        signal[i] = static_cast<int16_t>(8000.0f * std::sin(0.05f * i));
+    }
+
+    size_t frames = 0;
+    EXPECT_EQ(processor.processAudioSamples(signal.data(), signal.size(), nullptr, 0, &frames),
+              static_cast<long>(signal.size()));
+    EXPECT_EQ(frames, 4u);
+    ASSERT_EQ(ring.getSequence(), 4u);
+
+    std::vector<float> out(config.numMelBands);
+    for (uint64_t i = 0; i < 4; ++i) {
+        reference.processAudioFrame(signal.data() + i * config.hopSize, config.frameSize);
+        ASSERT_TRUE(ring.readFrame(i, out.data()));
+        EXPECT_EQ(out, reference.getMelSpectrum());
+    }
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
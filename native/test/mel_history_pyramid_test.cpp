@@ -0,0 +1,107 @@
+#include <gtest/gtest.h>
+#include "mel_history_pyramid.h"
+#include <vector>
+
+using namespace melspectrogram;
+
+class MelHistoryPyramidTest : public ::testing::Test {
+protected:
+    // Column value i in every band, so pooled values are easy to predict
+    void pushRamp(MelHistoryPyramid& pyramid, int count) {
+        std::vector<float> column(pyramid.getNumMelBands());
+        for (int i = 0; i < count; ++i) {
+            std::fill(column.begin(), column.end(), static_cast<float>(i));
+            ASSERT_TRUE(pyramid.pushColumn(column.data(), static_cast<int>(column.size())));
+        }
+    }
+};
+
+// Test 1: Level 0 keeps the most recent columns in time order
+TEST_F(MelHistoryPyramidTest, BaseLevelRingTest) {
+    MelHistoryPyramid pyramid(4, 8, 3);
+    pushRamp(pyramid, 20);
+    EXPECT_EQ(pyramid.getTotalColumns(), 20);
+    EXPECT_EQ(pyramid.getOldestColumn(0), 12);
+
+    std::vector<float> out(8 * 4);
+    int written = pyramid.extractRange(0, 12, 20, out.data(), 8);
+    ASSERT_EQ(written, 8);
+    for (int i = 0; i < 8; ++i) {
+        EXPECT_FLOAT_EQ(out[i * 4], static_cast<float>(12 + i));
+    }
+}
+
+// Test 2: Max pooling halves time resolution per level
+TEST_F(MelHistoryPyramidTest, MaxPoolingTest) {
+    MelHistoryPyramid pyramid(2, 16, 3, PoolingMode::MAX);
+    pushRamp(pyramid, 16);
+
+    std::vector<float> out(16 * 2);
+    ASSERT_EQ(pyramid.extractRange(1, 0, 16, out.data(), 16), 8);
+    for (int k = 0; k < 8; ++k) {
+        EXPECT_FLOAT_EQ(out[k * 2], static_cast<float>(2 * k + 1));
+    }
+
+    ASSERT_EQ(pyramid.extractRange(2, 0, 16, out.data(), 16), 4);
+    for (int k = 0; k < 4; ++k) {
+        EXPECT_FLOAT_EQ(out[k * 2 + 1], static_cast<float>(4 * k + 3));
+    }
+}
+
+// Test 3: Mean pooling averages pairs
+TEST_F(MelHistoryPyramidTest, MeanPoolingTest) {
+    MelHistoryPyramid pyramid(1, 16, 3, PoolingMode::MEAN);
+    pushRamp(pyramid, 8);
+
+    std::vector<float> out(4);
+    ASSERT_EQ(pyramid.extractRange(2, 0, 8, out.data(), 4), 2);
+    EXPECT_FLOAT_EQ(out[0], 1.5f);
+    EXPECT_FLOAT_EQ(out[1], 5.5f);
+}
+
+// Test 4: Coarse levels retain history that level 0 has dropped
+TEST_F(MelHistoryPyramidTest, LongHistoryTest) {
+    MelHistoryPyramid pyramid(1, 4, 4);
+    pushRamp(pyramid, 32);
+
+    EXPECT_EQ(pyramid.getOldestColumn(0), 28);
+    EXPECT_EQ(pyramid.getOldestColumn(3), 0);
+
+    std::vector<float> out(4, -1.0f);
+    ASSERT_EQ(pyramid.extractRange(3, 0, 32, out.data(), 4), 4);
+    EXPECT_FLOAT_EQ(out[0], 7.0f);
+    EXPECT_FLOAT_EQ(out[3], 31.0f);
+
+    // Ranges that are no longer retained are filled
+    ASSERT_EQ(pyramid.extractRange(0, 0, 4, out.data(), 4, -1.0f), 4);
+    EXPECT_FLOAT_EQ(out[0], -1.0f);
+}
+
+// Test 5: Memory stays bounded no matter how much is pushed
+TEST_F(MelHistoryPyramidTest, BoundedMemoryTest) {
+    MelHistoryPyramid pyramid(64, 256, 10);
+    size_t footprint = pyramid.getMemoryFootprint();
+    pushRamp(pyramid, 5000);
+    EXPECT_EQ(pyramid.getMemoryFootprint(), footprint);
+    EXPECT_LE(footprint, 10u * (256 + 1) * 64 * sizeof(float));
+}
+
+// Test 6: Level selection and argument validation
+TEST_F(MelHistoryPyramidTest, SelectLevelTest) {
+    MelHistoryPyramid pyramid(8, 64, 6);
+    EXPECT_EQ(pyramid.selectLevel(512, 512), 0);
+    EXPECT_EQ(pyramid.selectLevel(513, 512), 1);
+    EXPECT_EQ(pyramid.selectLevel(4096, 512), 3);
+    EXPECT_EQ(pyramid.selectLevel(1 << 30, 512), 5);
+
+    std::vector<float> column(4);
+    EXPECT_FALSE(pyramid.pushColumn(column.data(), 4));
+    std::vector<float> out(8);
+    EXPECT_EQ(pyramid.extractRange(6, 0, 8, out.data(), 1), -1);
+    EXPECT_EQ(pyramid.extractRange(0, 8, 0, out.data(), 1), -1);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,198 @@
+#include <gtest/gtest.h>
+#include "mel_pipeline.h"
+#include "mel_plan.h"
+#include "mel_spectrogram.h"
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace melspectrogram;
+
+namespace {
+    constexpr float PI = 3.14159265359f;
+
+    AudioConfig makeConfig(int sampleRate, int frameSize, int numMelBands) {
+        AudioConfig config;
+        config.sampleRate = sampleRate;
+        config.frameSize = frameSize;
+        config.hopSize = frameSize / 2;
+        config.numMelBands = numMelBands;
+        return config;
+    }
+
+    std::vector<int16_t> makeSignal(size_t samples, int sampleRate) {
+        std::mt19937 rng(7);
+        std::normal_distribution<float> noise(0.0f, 0.05f);
+        std::vector<int16_t> signal(samples);
+        for (size_t i = 0; i < samples; ++i) {
+            const float t = static_cast<float>(i) / sampleRate;
+            const float value = 0.5f * std::sin(2.0f * PI * 600.0f * t) +
+                                0.2f * std::sin(2.0f * PI * 3100.0f * t) + noise(rng);
+            signal[i] = static_cast<int16_t>(std::max(-1.0f, std::min(1.0f, value)) * 32767.0f);
+        }
+        return signal;
+    }
+
+    // The runtime-table steps, which MelPlan keeps for every configuration
+    void runtimeFrame(const MelPlan& plan, const int16_t* input, float* mel) {
+        const AudioConfig& config = plan.getConfig();
+        std::vector<std::complex<float>> fftInput(config.frameSize);
+        std::vector<std::complex<float>> fftOutput(config.frameSize);
+        std::vector<float> power(plan.getNumBins());
+        plan.windowFrame(input, fftInput.data());
+        plan.fft(fftInput.data(), fftOutput.data());
+        plan.powerSpectrum(fftOutput.data(), power.data());
+        plan.applyFilterBank(power.data(), mel);
+        MelPlan::logScale(mel, config.numMelBands);
+    }
+
+    template <class Pipeline>
+    void expectTablesMatch(const AudioConfig& config) {
+        auto plan = MelPlan::acquire(config);
+        for (int band = 0; band < config.numMelBands; ++band) {
+            // MelPlan works in float, the tables in double: a bin exactly on a triangle edge may keep a ~1e-7 weight in one only
+            EXPECT_NEAR(Pipeline::getFilterStart(band), plan->getFilterStart(band), 1) << "band " << band;
+            EXPECT_NEAR(Pipeline::getFilterEnd(band), plan->getFilterEnd(band), 1) << "band " << band;
+            for (int bin = 0; bin < plan->getNumBins(); ++bin) {
+                ASSERT_NEAR(Pipeline::getFilterWeight(band, bin), plan->getFilter(band)[bin], 1e-4f)
+                    << "band " << band << " bin " << bin;
+            }
+        }
+        for (int i = 0; i < config.frameSize; ++i) {
+            ASSERT_NEAR(Pipeline::getWindow(i), plan->getWindow()[i], 1e-6f) << i;
+        }
+    }
+
+    template <class Pipeline>
+    void expectFramesMatch(const AudioConfig& config) {
+        auto plan = MelPlan::acquire(config);
+        Pipeline pipeline;
+        ASSERT_TRUE(pipeline.matches(config));
+
+        const std::vector<int16_t> signal = makeSignal(config.frameSize * 6, config.sampleRate);
+        std::vector<float> expected(config.numMelBands);
+        std::vector<float> actual(config.numMelBands);
+        for (size_t start = 0; start + config.frameSize <= signal.size(); start += config.hopSize) {
+            runtimeFrame(*plan, signal.data() + start, expected.data());
+            pipeline.computeFrame(signal.data() + start, actual.data());
+            for (int band = 0; band < config.numMelBands; ++band) {
+                ASSERT_NEAR(actual[band], expected[band], 1e-4f) << "band " << band;
+            }
+        }
+    }
+}
+
+// Test 1: The constexpr tables reproduce MelPlan's window and filter weights
+TEST(MelPipelineTest, TablesTest) {
+    static_assert(MelPipeline<16000, 512, 40>::getFilterEnd(39) > MelPipeline<16000, 512, 40>::getFilterStart(0),
+                  "tables are available at compile time");
+    expectTablesMatch<MelPipeline<32000, 1024, 64>>(makeConfig(32000, 1024, 64));
+    expectTablesMatch<MelPipeline<16000, 512, 40>>(makeConfig(16000, 512, 40));
+    expectTablesMatch<MelPipeline<48000, 2048, 128>>(makeConfig(48000, 2048, 128));
+}
+
+// Test 2: Each specialization matches the runtime pipeline
+TEST(MelPipelineTest, MatchesRuntimeTest) {
+    expectFramesMatch<MelPipeline<32000, 1024, 64>>(makeConfig(32000, 1024, 64));
+    expectFramesMatch<MelPipeline<16000, 512, 40>>(makeConfig(16000, 512, 40));
+    expectFramesMatch<MelPipeline<48000, 2048, 128>>(makeConfig(48000, 2048, 128));
+    // Templates are not limited to the registered sizes
+    expectFramesMatch<MelPipeline<22050, 256, 32, 50, 6000>>([] {
+        AudioConfig config = makeConfig(22050, 256, 32);
+        config.minFreq = 50.0f;
+        config.maxFreq = 6000.0f;
+        return config;
+    }());
+}
+
+// Test 3: The factory only hands out registered configurations
+TEST(MelPipelineTest, FactoryTest) {
+    for (const AudioConfig& config : {makeConfig(32000, 1024, 64), makeConfig(16000, 512, 40),
+                                      makeConfig(48000, 2048, 128)}) {
+        auto pipeline = createMelPipeline(config);
+        ASSERT_NE(pipeline, nullptr);
+        EXPECT_TRUE(pipeline->matches(config));
+        EXPECT_TRUE(hasMelPipeline(config));
+        EXPECT_TRUE(MelPlan::acquire(config)->isSpecialized());
+    }
+
+    AudioConfig other = makeConfig(32000, 1024, 64);
+    other.maxFreq = 12000.0f;
+    EXPECT_EQ(createMelPipeline(other), nullptr);
+    EXPECT_FALSE(MelPlan::acquire(other)->isSpecialized());
+    EXPECT_EQ(createMelPipeline(makeConfig(44100, 1024, 64)), nullptr);
+
+    // hopSize is not part of the match
+    AudioConfig hop = makeConfig(32000, 1024, 64);
+    hop.hopSize = 320;
+    EXPECT_TRUE(hasMelPipeline(hop));
+}
+
+// Test 4: Processor, plan and batch all run the specialization and agree exactly
+TEST(MelPipelineTest, ProcessorUsesPipelineTest) {
+    AudioConfig config = makeConfig(16000, 512, 40);
+    const std::vector<int16_t> signal = makeSignal(config.frameSize * 4, config.sampleRate);
+    std::vector<const int16_t*> frames;
+    for (size_t start = 0; start + config.frameSize <= signal.size(); start += config.hopSize) {
+        frames.push_back(signal.data() + start);
+    }
+
+    auto plan = MelPlan::acquire(config);
+    MelPlan::Scratch scratch;
+    std::vector<float> batch(frames.size() * config.numMelBands);
+    plan->computeBatch(frames.data(), frames.size(), batch.data(), scratch);
+    // Only the runtime-table path needs complex FFT buffers
+    EXPECT_TRUE(scratch.fftInput.empty());
+
+    MelPipeline<16000, 512, 40> pipeline;
+    MelSpectrogramProcessor processor(config);
+    processor.setOutputFormat(MelOutputFormat::UINT8);
+    std::vector<float> expected(config.numMelBands);
+    std::vector<uint8_t> expectedBytes(config.numMelBands);
+    for (size_t f = 0; f < frames.size(); ++f) {
+        pipeline.computeFrame(frames[f], expected.data(), MelOutputFormat::UINT8, expectedBytes.data());
+        ASSERT_TRUE(processor.processAudioFrame(frames[f], config.frameSize));
+        EXPECT_EQ(processor.getMelSpectrum(), expected);
+        EXPECT_EQ(std::vector<float>(batch.begin() + f * config.numMelBands,
+                                     batch.begin() + (f + 1) * config.numMelBands), expected);
+        const uint8_t* bytes = static_cast<const uint8_t*>(processor.getOutputData());
+        EXPECT_EQ(std::vector<uint8_t>(bytes, bytes + config.numMelBands), expectedBytes);
+    }
+}
+
+// Test 5: Batches of every registered size match frame-by-frame output exactly
+TEST(MelPipelineTest, BatchTest) {
+    for (const AudioConfig& config : {makeConfig(32000, 1024, 64), makeConfig(16000, 512, 40),
+                                      makeConfig(48000, 2048, 128)}) {
+        const std::vector<int16_t> signal = makeSignal(config.frameSize * 5, config.sampleRate);
+        std::vector<const int16_t*> frames;
+        for (size_t start = 0; start + config.frameSize <= signal.size(); start += config.hopSize) {
+            frames.push_back(signal.data() + start);
+        }
+
+        auto plan = MelPlan::acquire(config);
+        MelPlan::Scratch scratch;
+        std::vector<float> batch(frames.size() * config.numMelBands);
+        plan->computeBatch(frames.data(), frames.size(), batch.data(), scratch);
+
+        std::vector<float> expected(config.numMelBands);
+        for (size_t f = 0; f < frames.size(); ++f) {
+            plan->computeFrame(frames[f], expected.data(), scratch);
+            EXPECT_EQ(std::vector<float>(batch.begin() + f * config.numMelBands,
+                                         batch.begin() + (f + 1) * config.numMelBands), expected)
+                << config.sampleRate << " frame " << f;
+        }
+
+        // Runtime tables are still there for callers that step through them
+        std::vector<float> runtime(config.numMelBands);
+        runtimeFrame(*plan, frames[0], runtime.data());
+        for (int band = 0; band < config.numMelBands; ++band) {
+            EXPECT_NEAR(runtime[band], batch[band], 1e-4f) << "band " << band;
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
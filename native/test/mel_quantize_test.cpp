@@ -0,0 +1,142 @@
+#include <gtest/gtest.h>
+#include "mel_quantize.h"
+#include "mel_spectrogram.h"
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+using namespace melspectrogram;
+
+namespace {
+    float bitsFloat(uint32_t bits) {
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    // The documented uint8 rule, written out independently of the implementation
+    uint8_t referenceByte(float x) {
+        if (!(x > 0.0f)) return 0;
+        if (x >= 1.0f) return 255;
+        return static_cast<uint8_t>(std::floor(static_cast<double>(x) * 255.0 + 0.5));
+    }
+}
+
+// Test 1: Every finite half survives a round trip through float
+TEST(MelQuantizeTest, HalfRoundTripTest) {
+    for (uint32_t h = 0; h < 0x10000; ++h) {
+        const uint16_t half = static_cast<uint16_t>(h);
+        const float value = halfToFloat(half);
+        if (std::isnan(value)) {
+            EXPECT_TRUE(std::isnan(halfToFloat(floatToHalf(value))));
+            continue;
+        }
+        ASSERT_EQ(floatToHalf(value), half) << std::hex << h;
+    }
+    EXPECT_EQ(floatToHalf(1.0f), 0x3c00);
+    EXPECT_EQ(floatToHalf(-2.0f), 0xc000);
+    EXPECT_EQ(floatToHalf(65520.0f), 0x7c00);          // Rounds past the largest half
+    EXPECT_EQ(floatToHalf(std::numeric_limits<float>::infinity()), 0x7c00);
+    EXPECT_EQ(floatToHalf(5.9604645e-8f), 0x0001);     // Smallest subnormal
+}
+
+// Test 2: Halfway cases round to even
+TEST(MelQuantizeTest, HalfRoundingTest) {
+    // 1 + 2^-11 lies halfway between 1 and 1 + 2^-10: the even mantissa (1.0) wins
+    EXPECT_EQ(floatToHalf(1.0f + std::ldexp(1.0f, -11)), 0x3c00);
+    // 1 + 3 * 2^-11 is halfway between odd 0x3c01 and even 0x3c02
+    EXPECT_EQ(floatToHalf(1.0f + 3.0f * std::ldexp(1.0f, -11)), 0x3c02);
+    // Just above halfway rounds up
+    EXPECT_EQ(floatToHalf(bitsFloat(0x3f801001)), 0x3c01);
+    // Subnormal halfway: 1.5 * 2^-24 goes to 2 * 2^-24
+    EXPECT_EQ(floatToHalf(1.5f * 5.9604645e-8f), 0x0002);
+    EXPECT_EQ(floatToHalf(0.5f * 5.9604645e-8f), 0x0000);
+}
+
+// Test 3: The vector paths match the scalar rules for every lane position
+TEST(MelQuantizeTest, QuantizeUnitTest) {
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> dist(-0.1f, 1.1f);
+    std::vector<float> values(1003);
+    for (auto& v : values) v = dist(rng);
+    // Exact ties, edges, subnormal halves and NaN
+    values[0] = 0.5f / 255.0f;
+    values[1] = 127.5f / 255.0f;
+    values[2] = 1.0f;
+    values[3] = 0.0f;
+    values[4] = std::numeric_limits<float>::quiet_NaN();
+    values[5] = 3e-5f;
+    values[6] = 2.0f;
+    values[7] = -1.0f;
+
+    std::vector<uint8_t> bytes(values.size());
+    quantizeUnit(values.data(), values.size(), MelOutputFormat::UINT8, bytes.data());
+    std::vector<uint16_t> halves(values.size());
+    quantizeUnit(values.data(), values.size(), MelOutputFormat::FLOAT16, halves.data());
+
+    for (size_t i = 0; i < values.size(); ++i) {
+        const float clamped = std::isnan(values[i]) ? 0.0f : std::min(std::max(values[i], 0.0f), 1.0f);
+        ASSERT_EQ(bytes[i], referenceByte(values[i])) << i << " " << values[i];
+        ASSERT_EQ(halves[i], floatToHalf(clamped)) << i << " " << values[i];
+    }
+
+    std::vector<float> decoded(values.size());
+    dequantize(bytes.data(), bytes.size(), MelOutputFormat::UINT8, decoded.data());
+    EXPECT_FLOAT_EQ(decoded[2], 1.0f);
+    EXPECT_NEAR(decoded[100], std::min(std::max(values[100], 0.0f), 1.0f), 0.5f / 255.0f + 1e-6f);
+}
+
+// Test 4: The processor's quantized frames come from the same normalize pass as its floats
+TEST(MelQuantizeTest, ProcessorOutputTest) {
+    AudioConfig config;
+    std::vector<int16_t> signal(config.frameSize + 9 * config.hopSize);
+    for (size_t i = 0; i < signal.size(); ++i) {
+        signal[i] = static_cast<int16_t>(9000.0f * std::sin(0.05f * i) + 3000.0f * std::sin(0.61f * i));
+    }
+    const size_t maxFrames = 10;
+    const size_t bands = static_cast<size_t>(config.numMelBands);
+
+    MelSpectrogramProcessor reference(config);
+    std::vector<float> floats(maxFrames * bands);
+    size_t produced = 0;
+    reference.processAudioSamples(signal.data(), signal.size(), floats.data(), maxFrames, &produced);
+    ASSERT_EQ(produced, maxFrames);
+
+    for (MelOutputFormat format : {MelOutputFormat::UINT8, MelOutputFormat::FLOAT16}) {
+        MelSpectrogramProcessor processor(config);
+        processor.setOutputFormat(format);
+        EXPECT_EQ(processor.getOutputFormat(), format);
+        EXPECT_EQ(processor.getOutputBytesPerFrame(), bands * melOutputBytesPerBand(format));
+
+        std::vector<uint8_t> packed(maxFrames * processor.getOutputBytesPerFrame());
+        size_t frames = 0;
+        EXPECT_EQ(processor.processAudioSamplesQuantized(signal.data(), signal.size(), packed.data(),
+                                                         maxFrames, &frames), static_cast<long>(signal.size()));
+        ASSERT_EQ(frames, maxFrames);
+
+        // Floats are untouched by the quantized mode
+        EXPECT_EQ(processor.getMelSpectrum(),
+                  std::vector<float>(floats.end() - bands, floats.end()));
+
+        std::vector<uint8_t> expected(packed.size());
+        quantizeUnit(floats.data(), floats.size(), format, expected.data());
+        EXPECT_EQ(packed, expected);
+        EXPECT_EQ(std::memcmp(processor.getOutputData(), expected.data() + (maxFrames - 1) * processor.getOutputBytesPerFrame(),
+                              processor.getOutputBytesPerFrame()), 0);
+    }
+
+    // Switching back turns quantized output off
+    MelSpectrogramProcessor processor(config);
+    processor.setOutputFormat(MelOutputFormat::UINT8);
+    processor.setOutputFormat(MelOutputFormat::FLOAT32);
+    EXPECT_EQ(processor.getOutputBytesPerFrame(), bands * sizeof(float));
+    ASSERT_TRUE(processor.processAudioFrame(signal.data(), config.frameSize));
+    EXPECT_EQ(processor.getOutputData(), static_cast<const void*>(processor.getMelData()));
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
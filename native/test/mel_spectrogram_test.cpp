@@ -1,8 +1,11 @@
 #include <gtest/gtest.h>
 #include "mel_spectrogram.h"
+#include "mel_pipeline.h"
 #include <cmath>
 #include <vector>
 #include <numeric>
+#include <algorithm>
+#include <chrono>
 
 using namespace melspectrogram;
 
@@ -266,6 +269,123 @@ TEST_F(MelSpectrogramTest, BenchmarkTest) {
     EXPECT_GT(framesPerSecond, 20.0f);
 }
 
+// Test 11: Streaming input matches frame-by-frame processing at every hop
+TEST_F(MelSpectrogramTest, StreamingFramingTest) {
+    const int numSamples = config.frameSize * 6 + 300;
+    std::vector<int16_t> stream(numSamples);
+    generateWhiteNoise(stream, 0.3f);
+    
+    // Reference: one processAudioFrame call per hop
+    const int expectedFrames = (numSamples - config.frameSize) / config.hopSize + 1;
+    std::vector<float> expected;
+    MelSpectrogramProcessor reference(config);
+    for (int start = 0; start + config.frameSize <= numSamples; start += config.hopSize) {
+        ASSERT_TRUE(reference.processAudioFrame(stream.data() + start, config.frameSize));
+        auto mel = reference.getMelSpectrum();
+        expected.insert(expected.end(), mel.begin(), mel.end());
+    }
+    
+    // Feed uneven chunks, including ones smaller than a hop
+    const int chunkSizes[] = {100, 1500, 7, 512, 2048, 333};
+    std::vector<float> output(expectedFrames * config.numMelBands);
+    size_t totalFrames = 0;
+    int position = 0;
+    for (int i = 0; position < numSamples; ++i) {
+        const int chunk = std::min(chunkSizes[i % 6], numSamples - position);
+        size_t frames = 0;
+        const long consumed = processor->processAudioSamples(stream.data() + position, chunk,
+            output.data() + totalFrames * config.numMelBands, expectedFrames - totalFrames, &frames);
+        ASSERT_EQ(consumed, chunk);
+        position += chunk;
+        totalFrames += frames;
+    }
+    
+    ASSERT_EQ(totalFrames, static_cast<size_t>(expectedFrames));
+    for (size_t i = 0; i < expected.size(); ++i) {
+        EXPECT_FLOAT_EQ(output[i], expected[i]) << "at value " << i;
+    }
+    EXPECT_EQ(processor->getBufferedSamples(),
+              static_cast<size_t>(numSamples - expectedFrames * config.hopSize));
+}
+
+// Test 12: A full output buffer leaves the rest of the input for the next call
+TEST_F(MelSpectrogramTest, StreamingOutputFullTest) {
+    std::vector<int16_t> stream(config.frameSize * 4);
+    generateWhiteNoise(stream, 0.3f);
+    std::vector<float> output(2 * config.numMelBands);
+    
+    size_t frames = 0;
+    long consumed = processor->processAudioSamples(stream.data(), stream.size(), output.data(), 2, &frames);
+    EXPECT_EQ(frames, 2u);
+    EXPECT_EQ(consumed, 2 * config.hopSize);
+    EXPECT_EQ(processor->getBufferedSamples(), 0u);
+    
+    // Resubmitting the remainder continues at the third hop
+    MelSpectrogramProcessor reference(config);
+    reference.processAudioFrame(stream.data() + 2 * config.hopSize, config.frameSize);
+    consumed = processor->processAudioSamples(stream.data() + consumed, stream.size() - consumed,
+                                              output.data(), 1, &frames);
+    EXPECT_EQ(frames, 1u);
+    EXPECT_EQ(consumed, config.hopSize);
+    auto expected = reference.getMelSpectrum();
+    for (int band = 0; band < config.numMelBands; ++band) {
+        EXPECT_FLOAT_EQ(output[band], expected[band]);
+    }
+    
+    EXPECT_EQ(processor->processAudioSamples(nullptr, 10, output.data(), 1, &frames), -1);
+    processor->resetStream();
+    EXPECT_EQ(processor->getBufferedSamples(), 0u);
+}
+
+// Test 13: Buffers share one aligned arena and the footprint follows the plan in use
+TEST_F(MelSpectrogramTest, MemoryFootprintTest) {
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(processor->getMelData()) % 64, 0u);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(processor->getOutputData()) % 64, 0u);
+    // 44.1 kHz has no compile-time pipeline, so the processor also holds the float FFT buffers
+    AudioConfig generic = config;
+    generic.sampleRate = 44100;
+    MelSpectrogramProcessor runtime(generic);
+    const size_t frameBytes = config.frameSize * sizeof(int16_t);
+    const size_t fftBytes = config.frameSize * sizeof(std::complex<float>);
+    const size_t binBytes = AlignedArena::padded((config.frameSize / 2 + 1) * sizeof(float));
+    // Normalized mel, quantized mel, colors and the dB log-mel
+    const size_t bandBytes = AlignedArena::padded(config.numMelBands * sizeof(float)) +
+                             AlignedArena::padded(config.numMelBands * sizeof(uint16_t)) +
+                             AlignedArena::padded(config.numMelBands * 4) +
+                             AlignedArena::padded(config.numMelBands * sizeof(float));
+    // Reduced quality levels: the full frame with half the bands at level 2
+    const size_t reducedBytes = 2 * fftBytes + binBytes + 2 * AlignedArena::padded(config.numMelBands / 2 * sizeof(float));
+    EXPECT_EQ(runtime.getMemoryFootprint(), 2 * frameBytes + 2 * fftBytes + binBytes + bandBytes + reducedBytes);
+    // The compile-time pipeline is built inside the arena, and its half-size FFT needs far less
+    const size_t pipelineBytes = AlignedArena::padded(getMelPipelineSize(config));
+    ASSERT_GT(pipelineBytes, 0u);
+    EXPECT_EQ(processor->getMemoryFootprint(), 2 * frameBytes + pipelineBytes + bandBytes + reducedBytes);
+    EXPECT_LT(processor->getMemoryFootprint(), runtime.getMemoryFootprint());
+
+    // So is the fixed-point scratch; that pipeline has no reduced levels
+    AudioConfig integer = config;
+    integer.fixedPoint = 1;
+    MelSpectrogramProcessor fixed(integer);
+    const size_t fixedBytes = 2 * AlignedArena::padded(config.frameSize * sizeof(kiss_fft_fixed_cpx)) +
+                              AlignedArena::padded((config.frameSize / 2 + 1) * sizeof(uint32_t)) +
+                              AlignedArena::padded(config.numMelBands * sizeof(uint64_t));
+    EXPECT_EQ(fixed.getMemoryFootprint(), 2 * frameBytes + fixedBytes + bandBytes);
+
+    // Reconfiguring rebuilds the arena, and the output format keeps working from it
+    runtime.setOutputFormat(MelOutputFormat::FLOAT16);
+    generic.numMelBands = 40;
+    runtime.updateConfig(generic);
+    std::vector<int16_t> signal(config.frameSize);
+    generateSineWave(signal, 1000.0f);
+    ASSERT_TRUE(runtime.processAudioFrame(signal.data(), config.frameSize));
+    EXPECT_EQ(runtime.getMelSpectrum().size(), 40u);
+    EXPECT_EQ(runtime.getColorMappedData().size(), 160u);
+    const uint16_t* halves = static_cast<const uint16_t*>(runtime.getOutputData());
+    for (int band = 0; band < 40; ++band) {
+        EXPECT_EQ(halves[band], floatToHalf(runtime.getMelData()[band]));
+    }
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
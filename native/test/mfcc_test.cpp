@@ -0,0 +1,197 @@
+#include <gtest/gtest.h>
+#include "mfcc.h"
+#include "mel_plan.h"
+#include "mel_spectrogram.h"
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace melspectrogram;
+
+namespace {
+    constexpr double PI = 3.14159265358979323846;
+
+    std::vector<float> makeLogMel(int bands, int seed) {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> db(-90.0f, -10.0f);
+        std::vector<float> values(bands);
+        for (float& value : values) {
+            value = db(rng);
+        }
+        return values;
+    }
+
+    std::vector<int16_t> makeSignal(size_t samples, int sampleRate) {
+        std::mt19937 rng(3);
+        std::normal_distribution<float> noise(0.0f, 0.02f);
+        std::vector<int16_t> signal(samples);
+        for (size_t i = 0; i < samples; ++i) {
+            const float t = static_cast<float>(i) / sampleRate;
+            const float value = 0.4f * std::sin(2.0f * 3.14159265f * 440.0f * t) +
+                                0.2f * std::sin(2.0f * 3.14159265f * 2500.0f * t) + noise(rng);
+            signal[i] = static_cast<int16_t>(value * 32767.0f);
+        }
+        return signal;
+    }
+
+    // Log-mel in dB from the runtime steps, before normalization
+    std::vector<float> referenceLogMel(const AudioConfig& config, const int16_t* input) {
+        auto plan = MelPlan::acquire(config);
+        std::vector<std::complex<float>> fftInput(config.frameSize);
+        std::vector<std::complex<float>> fftOutput(config.frameSize);
+        std::vector<float> power(plan->getNumBins());
+        std::vector<float> mel(config.numMelBands);
+        plan->windowFrame(input, fftInput.data());
+        plan->fft(fftInput.data(), fftOutput.data());
+        plan->powerSpectrum(fftOutput.data(), power.data());
+        plan->applyFilterBank(power.data(), mel.data());
+        for (float& value : mel) {
+            value = 10.0f * std::log10(std::max(value, 1e-10f));
+        }
+        return mel;
+    }
+}
+
+// Test 1: Rows are the orthonormal DCT-II basis, truncated to K
+TEST(MfccTest, OrthonormalDct) {
+    MfccConfig config;
+    config.numCoefficients = 40;
+    config.lifter = 0;
+    MfccPlan full(40, config);
+    const float* matrix = full.getMatrix();
+    for (int a = 0; a < 40; ++a) {
+        for (int b = 0; b < 40; ++b) {
+            double sum = 0.0;
+            for (int n = 0; n < 40; ++n) {
+                sum += static_cast<double>(matrix[a * 40 + n]) * matrix[b * 40 + n];
+            }
+            ASSERT_NEAR(sum, a == b ? 1.0 : 0.0, 1e-5) << a << "," << b;
+        }
+    }
+
+    config.numCoefficients = 13;
+    MfccPlan truncated(40, config);
+    EXPECT_EQ(truncated.getNumCoefficients(), 13);
+    const auto logMel = makeLogMel(40, 1);
+    std::vector<float> mfcc(13);
+    truncated.compute(logMel.data(), mfcc.data());
+    for (int k = 0; k < 13; ++k) {
+        double expected = 0.0;
+        for (int n = 0; n < 40; ++n) {
+            expected += logMel[n] * std::cos(PI * k * (2.0 * n + 1.0) / 80.0);
+        }
+        expected *= k == 0 ? std::sqrt(1.0 / 40.0) : std::sqrt(2.0 / 40.0);
+        EXPECT_NEAR(mfcc[k], expected, 1e-3) << "k " << k;
+    }
+
+    // More coefficients than bands are clamped
+    config.numCoefficients = 100;
+    EXPECT_EQ(MfccPlan(20, config).getNumCoefficients(), 20);
+}
+
+// Test 2: Liftering scales coefficient k by 1 + (L / 2) sin(pi k / L)
+TEST(MfccTest, Lifter) {
+    MfccConfig plain;
+    plain.lifter = 0;
+    MfccConfig liftered;
+    liftered.lifter = 22;
+    MfccPlan a(64, plain);
+    MfccPlan b(64, liftered);
+    const auto logMel = makeLogMel(64, 2);
+    std::vector<float> x(13);
+    std::vector<float> y(13);
+    a.compute(logMel.data(), x.data());
+    b.compute(logMel.data(), y.data());
+    EXPECT_FLOAT_EQ(y[0], x[0]);
+    for (int k = 1; k < 13; ++k) {
+        EXPECT_NEAR(y[k], x[k] * (1.0 + 11.0 * std::sin(PI * k / 22.0)), 1e-3 * std::abs(y[k]) + 1e-4) << "k " << k;
+    }
+}
+
+// Test 3: Batched frames give exactly the per-frame results
+TEST(MfccTest, BatchMatchesFrames) {
+    MfccPlan plan(48, MfccConfig());
+    const size_t frames = 9;
+    std::vector<float> logMel;
+    for (size_t f = 0; f < frames; ++f) {
+        const auto frame = makeLogMel(48, static_cast<int>(f) + 10);
+        logMel.insert(logMel.end(), frame.begin(), frame.end());
+    }
+    std::vector<float> batch(frames * plan.getNumCoefficients());
+    plan.computeBatch(logMel.data(), frames, batch.data());
+    std::vector<float> single(plan.getNumCoefficients());
+    for (size_t f = 0; f < frames; ++f) {
+        plan.compute(logMel.data() + f * 48, single.data());
+        for (int k = 0; k < plan.getNumCoefficients(); ++k) {
+            ASSERT_EQ(batch[f * plan.getNumCoefficients() + k], single[k]) << "frame " << f;
+        }
+    }
+}
+
+// Test 4: The processor feeds un-normalized log-mel on every pipeline and leaves the mel output alone
+TEST(MfccTest, ProcessorPipelines) {
+    AudioConfig specialized;
+    specialized.sampleRate = 16000;
+    specialized.frameSize = 512;
+    specialized.hopSize = 256;
+    specialized.numMelBands = 40;
+    AudioConfig runtime = specialized;
+    runtime.numMelBands = 36;
+    AudioConfig fixed = specialized;
+    fixed.fixedPoint = 1;
+
+    MfccConfig mfcc;
+    mfcc.enabled = true;
+    for (const AudioConfig& config : {specialized, runtime, fixed}) {
+        const auto signal = makeSignal(config.frameSize, config.sampleRate);
+        MelSpectrogramProcessor plain(config);
+        MelSpectrogramProcessor processor(config);
+        EXPECT_EQ(processor.getMfccData(), nullptr);
+        processor.setMfcc(mfcc);
+        ASSERT_EQ(processor.getNumMfcc(), 13);
+        ASSERT_TRUE(plain.processAudioFrame(signal.data(), signal.size()));
+        ASSERT_TRUE(processor.processAudioFrame(signal.data(), signal.size()));
+        EXPECT_EQ(processor.getMelSpectrum(), plain.getMelSpectrum());
+
+        MfccPlan plan(config.numMelBands, mfcc);
+        std::vector<float> expected(13);
+        plan.compute(referenceLogMel(config, signal.data()).data(), expected.data());
+        // The integer pipeline's dB values are within a fraction of a dB of the float ones
+        const float tolerance = config.fixedPoint ? 2.0f : 0.01f;
+        for (int k = 0; k < 13; ++k) {
+            EXPECT_NEAR(processor.getMfccData()[k], expected[k], tolerance + 1e-3f * std::abs(expected[k]))
+                << "bands " << config.numMelBands << " fixed " << config.fixedPoint << " k " << k;
+        }
+    }
+}
+
+// Test 5: Streaming writes coefficients back to back into the caller's buffer
+TEST(MfccTest, ProcessorStreaming) {
+    AudioConfig config;
+    MelSpectrogramProcessor processor(config);
+    const auto signal = makeSignal(config.frameSize + 5 * config.hopSize, config.sampleRate);
+    std::vector<float> output(6 * 13);
+    size_t frames = 0;
+    EXPECT_EQ(processor.processAudioSamplesMfcc(signal.data(), signal.size(), output.data(), 6, &frames), -1);
+
+    MfccConfig mfcc;
+    mfcc.enabled = true;
+    processor.setMfcc(mfcc);
+    const long consumed = processor.processAudioSamplesMfcc(signal.data(), signal.size(), output.data(), 6, &frames);
+    EXPECT_EQ(consumed, static_cast<long>(signal.size()));
+    ASSERT_EQ(frames, 6u);
+
+    MelSpectrogramProcessor reference(config);
+    reference.setMfcc(mfcc);
+    for (size_t f = 0; f < frames; ++f) {
+        ASSERT_TRUE(reference.processAudioFrame(signal.data() + f * config.hopSize, config.frameSize));
+        for (int k = 0; k < 13; ++k) {
+            ASSERT_EQ(output[f * 13 + k], reference.getMfccData()[k]) << "frame " << f;
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,190 @@
+#include <gtest/gtest.h>
+#include "multi_stream_engine.h"
+#include "mel_plan.h"
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <vector>
+
+using namespace melspectrogram;
+
+namespace {
+    std::vector<int16_t> makeSignal(size_t count, float frequency) {
+        std::vector<int16_t> signal(count);
+        for (size_t i = 0; i < count; ++i) {
+            signal[i] = static_cast<int16_t>(9000.0f * std::sin(frequency * i) + 1500.0f * std::sin(0.9f * i));
+        }
+        return signal;
+    }
+
+    std::vector<float> referenceFrames(const AudioConfig& config, const std::vector<int16_t>& signal) {
+        MelSpectrogramProcessor processor(config);
+        const size_t maxFrames = signal.size() / config.hopSize + 1;
+        std::vector<float> frames(maxFrames * config.numMelBands);
+        size_t produced = 0;
+        processor.processAudioSamples(signal.data(), signal.size(), frames.data(), maxFrames, &produced);
+        frames.resize(produced * config.numMelBands);
+        return frames;
+    }
+
+    AudioConfig smallConfig() {
+        AudioConfig config;
+        config.sampleRate = 16000;
+        config.frameSize = 512;
+        config.hopSize = 256;
+        config.numMelBands = 40;
+        return config;
+    }
+}
+
+// Test 1: Plans are shared per configuration and batches match single frames exactly
+TEST(MultiStreamEngineTest, PlanSharingTest) {
+    AudioConfig config;
+    auto plan = MelPlan::acquire(config);
+    EXPECT_EQ(MelPlan::acquire(config), plan);
+    EXPECT_NE(MelPlan::acquire(smallConfig()), plan);
+    AudioConfig otherHop = config;
+    otherHop.hopSize /= 2;  // Framing only: the tables are the same
+    EXPECT_EQ(MelPlan::acquire(otherHop), plan);
+
+    auto signal = makeSignal(config.frameSize * 4, 0.02f);
+    std::vector<const int16_t*> frames;
+    for (int i = 0; i < 7; ++i) {
+        frames.push_back(signal.data() + i * config.hopSize);
+    }
+
+    MelPlan::Scratch scratch;
+    std::vector<float> batch(frames.size() * config.numMelBands);
+    plan->computeBatch(frames.data(), frames.size(), batch.data(), scratch);
+
+    MelSpectrogramProcessor processor(config);
+    std::vector<float> single(config.numMelBands);
+    for (size_t i = 0; i < frames.size(); ++i) {
+        plan->computeFrame(frames[i], single.data(), scratch);
+        EXPECT_TRUE(std::equal(single.begin(), single.end(), batch.begin() + i * config.numMelBands));
+        processor.processAudioFrame(frames[i], config.frameSize);
+        EXPECT_EQ(processor.getMelSpectrum(), single);
+    }
+}
+
+// Test 2: Every stream gets the frames its own processor would produce, in order
+TEST(MultiStreamEngineTest, MatchesProcessorTest) {
+    MultiStreamEngine engine(3, 8);
+    ASSERT_TRUE(engine.start());
+
+    const int numStreams = 6;
+    std::vector<AudioConfig> configs(numStreams);
+    std::vector<std::vector<int16_t>> signals(numStreams);
+    std::vector<std::vector<float>> received(numStreams);
+    std::vector<int> ids(numStreams);
+    for (int s = 0; s < numStreams; ++s) {
+        if (s % 2) configs[s] = smallConfig();
+        if (s == 4) configs[s].hopSize /= 2;  // Same group as streams 0 and 2, framed by its own hop
+        signals[s] = makeSignal(configs[s].frameSize * 12 + 77 * s, 0.01f + 0.013f * s);
+        const size_t bands = static_cast<size_t>(configs[s].numMelBands);
+        // Callbacks for one stream never overlap, so each only touches its own vector
+        ids[s] = engine.addStream(configs[s], [&received, s, bands](int, const float* frames, size_t count) {
+            received[s].insert(received[s].end(), frames, frames + count * bands);
+        });
+        ASSERT_GT(ids[s], 0);
+    }
+    EXPECT_EQ(engine.getStats().configGroups, 2);
+
+    // Interleave irregular chunks across streams, as network packets would arrive
+    const size_t chunks[] = {300, 1024, 17, 4096, 640};
+    std::vector<size_t> offsets(numStreams, 0);
+    for (bool pending = true; pending;) {
+        pending = false;
+        for (int s = 0; s < numStreams; ++s) {
+            const size_t remaining = signals[s].size() - offsets[s];
+            if (remaining == 0) continue;
+            const size_t chunk = std::min(chunks[(offsets[s] / 7 + s) % 5], remaining);
+            ASSERT_EQ(engine.pushSamples(ids[s], signals[s].data() + offsets[s], chunk), chunk);
+            offsets[s] += chunk;
+            pending = true;
+        }
+    }
+    ASSERT_TRUE(engine.waitIdle(5000));
+
+    uint64_t totalFrames = 0;
+    for (int s = 0; s < numStreams; ++s) {
+        auto expected = referenceFrames(configs[s], signals[s]);
+        EXPECT_EQ(received[s], expected) << "stream " << s;
+        totalFrames += expected.size() / configs[s].numMelBands;
+    }
+
+    MultiStreamStats stats = engine.getStats();
+    EXPECT_EQ(stats.framesProcessed, totalFrames);
+    EXPECT_EQ(stats.samplesDropped, 0u);
+    EXPECT_GE(stats.averageBatchFrames, 1.0f);
+    EXPECT_EQ(stats.activeStreams, numStreams);
+    EXPECT_EQ(stats.numWorkers, 3);
+    engine.stop();
+}
+
+// Test 3: A backlogged stream shares batches instead of starving the others
+TEST(MultiStreamEngineTest, FairSchedulingTest) {
+    AudioConfig config;
+    MultiStreamEngine engine(1, 8);
+    std::mutex orderMutex;
+    std::vector<int> order;
+    auto record = [&](int streamId, const float*, size_t count) {
+        std::lock_guard<std::mutex> lock(orderMutex);
+        order.insert(order.end(), count, streamId);
+    };
+
+    const int heavy = engine.addStream(config, record);
+    const int lightA = engine.addStream(config, record);
+    const int lightB = engine.addStream(config, record);
+
+    // Queue everything before the worker starts so the schedule is deterministic
+    auto heavySignal = makeSignal(config.frameSize + 63 * config.hopSize, 0.03f);
+    auto lightSignal = makeSignal(config.frameSize + 3 * config.hopSize, 0.05f);
+    engine.pushSamples(heavy, heavySignal.data(), heavySignal.size());
+    engine.pushSamples(lightA, lightSignal.data(), lightSignal.size());
+    engine.pushSamples(lightB, lightSignal.data(), lightSignal.size());
+    ASSERT_TRUE(engine.start());
+    ASSERT_TRUE(engine.waitIdle(5000));
+
+    ASSERT_EQ(order.size(), 72u);
+    EXPECT_EQ(std::count(order.begin(), order.end(), heavy), 64);
+    size_t lastLight = 0;
+    for (size_t i = 0; i < order.size(); ++i) {
+        if (order[i] != heavy) lastLight = i;
+    }
+    EXPECT_LT(lastLight, 16u);
+    EXPECT_GT(engine.getStats().averageBatchFrames, 4.0f);
+}
+
+// Test 4: Bounded input, invalid framing and stream removal
+TEST(MultiStreamEngineTest, BoundsAndRemovalTest) {
+    AudioConfig config;
+    MultiStreamEngine engine(2, 16);
+
+    AudioConfig bad = config;
+    bad.hopSize = 0;
+    EXPECT_EQ(engine.addStream(bad, nullptr), -1);
+
+    const int id = engine.addStream(config, nullptr, config.frameSize * 2);
+    ASSERT_GT(id, 0);
+    auto signal = makeSignal(3000, 0.02f);
+    EXPECT_EQ(engine.pushSamples(id, signal.data(), signal.size()), static_cast<size_t>(config.frameSize * 2));
+    EXPECT_EQ(engine.getStats().samplesDropped, 3000u - config.frameSize * 2);
+
+    // Removing a queued stream releases its group
+    EXPECT_TRUE(engine.removeStream(id));
+    EXPECT_FALSE(engine.removeStream(id));
+    EXPECT_EQ(engine.pushSamples(id, signal.data(), signal.size()), 0u);
+    MultiStreamStats stats = engine.getStats();
+    EXPECT_EQ(stats.activeStreams, 0);
+    EXPECT_EQ(stats.configGroups, 0);
+
+    ASSERT_TRUE(engine.start());
+    ASSERT_TRUE(engine.waitIdle(1000));
+    EXPECT_EQ(engine.getStats().framesProcessed, 0u);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
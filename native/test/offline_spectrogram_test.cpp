@@ -0,0 +1,152 @@
+#include <gtest/gtest.h>
+#include "offline_spectrogram.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace melspectrogram;
+
+namespace {
+    std::vector<int16_t> makeSignal(size_t count) {
+        std::vector<int16_t> signal(count);
+        for (size_t i = 0; i < count; ++i) {
+            // Chirp, so neighbouring frames differ and misplaced frames are caught
+            const float t = static_cast<float>(i);
+            signal[i] = static_cast<int16_t>(10000.0f * std::sin(0.002f * t + 0.0000004f * t * t));
+        }
+        return signal;
+    }
+
+    std::vector<float> sequential(const AudioConfig& config, const std::vector<int16_t>& signal) {
+        MelSpectrogramProcessor processor(config);
+        const size_t frames = OfflineSpectrogram::frameCount(signal.size(), config);
+        std::vector<float> output(frames * config.numMelBands);
+        size_t produced = 0;
+        processor.processAudioSamples(signal.data(), signal.size(), output.data(), frames, &produced);
+        EXPECT_EQ(produced, frames);
+        return output;
+    }
+
+    void appendU32(std::vector<uint8_t>& out, uint32_t value) {
+        for (int i = 0; i < 4; ++i) out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+
+    void appendU16(std::vector<uint8_t>& out, uint16_t value) {
+        out.push_back(static_cast<uint8_t>(value));
+        out.push_back(static_cast<uint8_t>(value >> 8));
+    }
+
+    std::string writeWav(const std::string& name, const std::vector<int16_t>& interleaved,
+                         int sampleRate, int channels) {
+        std::vector<uint8_t> bytes;
+        const uint32_t dataSize = static_cast<uint32_t>(interleaved.size() * 2);
+        bytes.insert(bytes.end(), {'R', 'I', 'F', 'F'});
+        appendU32(bytes, 4 + 8 + 16 + 8 + 6 + 8 + dataSize);
+        bytes.insert(bytes.end(), {'W', 'A', 'V', 'E', 'f', 'm', 't', ' '});
+        appendU32(bytes, 16);
+        appendU16(bytes, 1);
+        appendU16(bytes, static_cast<uint16_t>(channels));
+        appendU32(bytes, sampleRate);
+        appendU32(bytes, sampleRate * channels * 2);
+        appendU16(bytes, static_cast<uint16_t>(channels * 2));
+        appendU16(bytes, 16);
+        // An odd-sized chunk before the data exercises RIFF padding
+        bytes.insert(bytes.end(), {'L', 'I', 'S', 'T'});
+        appendU32(bytes, 5);
+        bytes.insert(bytes.end(), {'a', 'b', 'c', 'd', 'e', 0});
+        bytes.insert(bytes.end(), {'d', 'a', 't', 'a'});
+        appendU32(bytes, dataSize);
+        const uint8_t* raw = reinterpret_cast<const uint8_t*>(interleaved.data());
+        bytes.insert(bytes.end(), raw, raw + dataSize);
+
+        const std::string path = ::testing::TempDir() + name;
+        FILE* file = std::fopen(path.c_str(), "wb");
+        std::fwrite(bytes.data(), 1, bytes.size(), file);
+        std::fclose(file);
+        return path;
+    }
+}
+
+// Test 1: Parallel output is bit-identical to one sequential pass
+TEST(OfflineSpectrogramTest, MatchesSequentialTest) {
+    AudioConfig config;
+    auto signal = makeSignal(config.sampleRate * 3 + 777);
+    auto expected = sequential(config, signal);
+    const size_t frames = expected.size() / config.numMelBands;
+
+    // Tiny chunks force many chunk edges and steals
+    for (int threads : {1, 3, 8}) {
+        OfflineSpectrogram spectrogram(config, threads, 5);
+        std::vector<float> output(expected.size(), -1.0f);
+        EXPECT_EQ(spectrogram.process(signal.data(), signal.size(), output.data(), frames),
+                  static_cast<long>(frames));
+        EXPECT_EQ(output, expected) << threads << " threads";
+
+        OfflineStats stats = spectrogram.getStats();
+        EXPECT_EQ(stats.framesProcessed, frames);
+        EXPECT_EQ(stats.chunks, (frames + 4) / 5);
+        EXPECT_EQ(stats.numThreads, threads);
+    }
+}
+
+// Test 2: Other framings, automatic chunking and truncated output
+TEST(OfflineSpectrogramTest, FramingTest) {
+    AudioConfig config;
+    config.sampleRate = 16000;
+    config.frameSize = 512;
+    config.hopSize = 160;
+    config.numMelBands = 40;
+    auto signal = makeSignal(16000 * 2 + 3);
+    auto expected = sequential(config, signal);
+    const size_t frames = expected.size() / config.numMelBands;
+
+    OfflineSpectrogram spectrogram(config, 4);
+    std::vector<float> output(expected.size());
+    EXPECT_EQ(spectrogram.process(signal.data(), signal.size(), output.data(), frames), static_cast<long>(frames));
+    EXPECT_EQ(output, expected);
+
+    // maxFrames limits the work, not just the copy
+    std::vector<float> partial(10 * config.numMelBands);
+    EXPECT_EQ(spectrogram.process(signal.data(), signal.size(), partial.data(), 10), 10);
+    EXPECT_TRUE(std::equal(partial.begin(), partial.end(), expected.begin()));
+
+    EXPECT_EQ(OfflineSpectrogram::frameCount(511, config), 0u);
+    EXPECT_EQ(OfflineSpectrogram::frameCount(512, config), 1u);
+    EXPECT_EQ(spectrogram.process(signal.data(), 100, output.data(), frames), 0);
+    EXPECT_EQ(spectrogram.process(nullptr, 100, output.data(), frames), -1);
+}
+
+// Test 3: WAV files are mapped in place and decoded correctly
+TEST(OfflineSpectrogramTest, MappedWavTest) {
+    auto mono = makeSignal(5000);
+    MappedWav wav;
+    ASSERT_TRUE(wav.open(writeWav("offline_mono.wav", mono, 22050, 1))) << wav.getError();
+    EXPECT_EQ(wav.getSampleRate(), 22050);
+    EXPECT_EQ(wav.getNumChannels(), 1);
+    ASSERT_EQ(wav.numFrames(), mono.size());
+    EXPECT_EQ(std::memcmp(wav.samples(), mono.data(), mono.size() * sizeof(int16_t)), 0);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(wav.samples()) % alignof(int16_t), 0u);
+
+    std::vector<int16_t> stereo(mono.size() * 2);
+    for (size_t i = 0; i < mono.size(); ++i) {
+        stereo[i * 2] = mono[i];
+        stereo[i * 2 + 1] = static_cast<int16_t>(-mono[i]);
+    }
+    ASSERT_TRUE(wav.open(writeWav("offline_stereo.wav", stereo, 48000, 2)));
+    EXPECT_EQ(wav.numFrames(), mono.size());
+    std::vector<int16_t> left;
+    ASSERT_TRUE(wav.extractChannel(0, left));
+    EXPECT_EQ(left, mono);
+    EXPECT_FALSE(wav.extractChannel(2, left));
+
+    EXPECT_FALSE(wav.open(::testing::TempDir() + "offline_missing.wav"));
+    EXPECT_FALSE(wav.isOpen());
+    EXPECT_FALSE(wav.getError().empty());
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,332 @@
+#include <gtest/gtest.h>
+#include "pipeline_runner.h"
+#include "mel_frame_ring.h"
+#include "texture_renderer.h"
+#include "session_recorder.h"
+#include "offline_spectrogram.h"
+#include "mel_archive.h"
+#include "resampler.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+using namespace melspectrogram;
+
+namespace {
+    std::vector<int16_t> makeSignal(size_t count) {
+        std::vector<int16_t> signal(count);
+        for (size_t i = 0; i < count; ++i) {
+            signal[i] = static_cast<int16_t>(8000.0f * std::sin(0.031f * i) + 2000.0f * std::sin(0.27f * i));
+        }
+        return signal;
+    }
+
+    template <typename Predicate>
+    bool waitFor(Predicate predicate, int timeoutMs) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+        while (!predicate()) {
+            if (std::chrono::steady_clock::now() > deadline) return false;
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+        return true;
+    }
+}
+
+// Test 1: Columns produced on the DSP thread match direct processing
+TEST(PipelineRunnerTest, PushedSamplesMatchReferenceTest) {
+    AudioConfig config;
+    MelSpectrogramProcessor processor(config);
+    MelSpectrogramProcessor reference(config);
+    PipelineRunner runner(processor, config, 64);
+
+    const size_t numFrames = 20;
+    auto signal = makeSignal(config.frameSize + (numFrames - 1) * config.hopSize);
+    ASSERT_TRUE(runner.start());
+    EXPECT_TRUE(runner.isRunning());
+
+    // Irregular chunk sizes, as audio callbacks deliver them
+    size_t offset = 0;
+    const size_t chunks[] = {100, 777, 1024, 3, 2048};
+    for (int i = 0; offset < signal.size(); ++i) {
+        const size_t chunk = std::min(chunks[i % 5], signal.size() - offset);
+        EXPECT_EQ(runner.pushSamples(signal.data() + offset, chunk), chunk);
+        offset += chunk;
+    }
+    ASSERT_TRUE(runner.waitIdle(2000));
+
+    std::vector<float> columns(numFrames * config.numMelBands);
+    ASSERT_EQ(runner.readColumns(columns.data(), static_cast<int>(numFrames)), static_cast<int>(numFrames));
+    for (size_t i = 0; i < numFrames; ++i) {
+        ASSERT_TRUE(reference.processAudioFrame(signal.data() + i * config.hopSize, config.frameSize));
+        std::vector<float> column(columns.begin() + i * config.numMelBands,
+                                  columns.begin() + (i + 1) * config.numMelBands);
+        EXPECT_EQ(column, reference.getMelSpectrum()) << "frame " << i;
+    }
+
+    runner.stop();
+    EXPECT_FALSE(runner.isRunning());
+    PipelineStats stats = runner.getStats();
+    EXPECT_EQ(stats.samplesReceived, signal.size());
+    EXPECT_EQ(stats.samplesDropped, 0u);
+    EXPECT_EQ(stats.framesProcessed, numFrames);
+    EXPECT_EQ(stats.columnsDelivered, numFrames);
+    EXPECT_EQ(stats.queuedColumns, 0);
+    EXPECT_GT(stats.maxBlockTimeMs, 0.0f);
+}
+
+// Test 2: pollColumns hands columns to the renderer and the frame ring sees them too
+TEST(PipelineRunnerTest, PollIntoRendererTest) {
+    AudioConfig config;
+    MelSpectrogramProcessor processor(config);
+    MelFrameRing ring(config.numMelBands, 32);
+    processor.setFrameRing(&ring);
+    TextureRenderer renderer(128, config.numMelBands, config.numMelBands, RenderBackendType::CPU);
+    ASSERT_TRUE(renderer.initialize());
+
+    PipelineRunner runner(processor, config, 64);
+    ASSERT_TRUE(runner.start());
+    auto signal = makeSignal(config.frameSize + 9 * config.hopSize);
+    runner.pushSamples(signal.data(), signal.size());
+    ASSERT_TRUE(runner.waitIdle(2000));
+
+    EXPECT_EQ(runner.pollColumns(renderer), 10);
+    EXPECT_EQ(renderer.getCurrentColumn(), 10);
+    EXPECT_EQ(renderer.getPendingColumns(), 0);
+    EXPECT_EQ(ring.getSequence(), 10u);
+    EXPECT_EQ(runner.pollColumns(renderer), 0);
+    runner.stop();
+}
+
+// Test 3: Bounded queues drop the oldest columns and excess input, and count both
+TEST(PipelineRunnerTest, OverflowAccountingTest) {
+    AudioConfig config;
+    MelSpectrogramProcessor processor(config);
+    MelSpectrogramProcessor reference(config);
+    const size_t sampleCapacity = config.frameSize + 11 * config.hopSize;
+    PipelineRunner runner(processor, config, 4, sampleCapacity);
+
+    // Fill the FIFO before the DSP thread exists so the drop count is exact
+    auto signal = makeSignal(sampleCapacity + 100);
+    EXPECT_EQ(runner.pushSamples(signal.data(), signal.size()), sampleCapacity);
+    ASSERT_TRUE(runner.start());
+    ASSERT_TRUE(runner.waitIdle(2000));
+
+    PipelineStats stats = runner.getStats();
+    EXPECT_EQ(stats.samplesDropped, 100u);
+    EXPECT_EQ(stats.framesProcessed, 12u);
+    EXPECT_EQ(stats.columnsDropped, 8u);
+    EXPECT_EQ(stats.queuedColumns, 4);
+
+    // The newest four frames survive
+    std::vector<float> columns(4 * config.numMelBands);
+    ASSERT_EQ(runner.readColumns(columns.data(), 4), 4);
+    for (int i = 0; i < 12; ++i) {
+        reference.processAudioFrame(signal.data() + i * config.hopSize, config.frameSize);
+        if (i < 8) continue;
+        std::vector<float> column(columns.begin() + (i - 8) * config.numMelBands,
+                                  columns.begin() + (i - 7) * config.numMelBands);
+        EXPECT_EQ(column, reference.getMelSpectrum()) << "frame " << i;
+    }
+    runner.stop();
+}
+
+// Test 4: An audio input drives the pipeline without any caller involvement
+TEST(PipelineRunnerTest, AudioInputDrivenTest) {
+    AudioConfig config;
+    MelSpectrogramProcessor processor(config);
+    audio::AudioConfig audioConfig;
+    audio::AudioInput input(audioConfig);
+    ASSERT_TRUE(input.initialize());
+
+    PipelineRunner runner(processor, config, 256);
+    ASSERT_TRUE(runner.start(&input));
+    EXPECT_TRUE(input.isRecording());
+
+    auto signal = makeSignal(audioConfig.bufferSize * 4);
+    input.injectMockData(signal.data(), signal.size());
+    EXPECT_TRUE(waitFor([&] { return runner.getStats().framesProcessed >= 4; }, 3000));
+
+    runner.stop();
+    EXPECT_FALSE(input.isRecording());
+    EXPECT_GT(runner.getStats().queuedColumns, 0);
+
+    // A stopped runner no longer receives audio
+    const uint64_t received = runner.getStats().samplesReceived;
+    EXPECT_GT(received, 0u);
+    input.startRecording();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    input.stopRecording();
+    EXPECT_EQ(runner.getStats().samplesReceived, received);
+}
+
+// Test 5: Invalid framing is rejected at start
+TEST(PipelineRunnerTest, InvalidHopTest) {
+    AudioConfig config;
+    MelSpectrogramProcessor processor(config);
+    AudioConfig bad = config;
+    bad.hopSize = 0;
+    PipelineRunner runner(processor, bad);
+    EXPECT_FALSE(runner.start());
+    EXPECT_FALSE(runner.isRunning());
+}
+
+// Test 6: An attached recorder gets the raw input and every frame's dB log-mel
+TEST(PipelineRunnerTest, RecorderTeeTest) {
+    AudioConfig config;
+    const size_t numFrames = 40;
+    auto signal = makeSignal(config.frameSize + (numFrames - 1) * config.hopSize);
+    MelSpectrogramProcessor processor(config);
+    PipelineRunner runner(processor, config, 256, signal.size());
+
+    RecorderConfig recording;
+    recording.pathPrefix = ::testing::TempDir() + "pipeline_tee";
+    recording.sampleRate = config.sampleRate;
+    recording.numMelBands = config.numMelBands;
+    recording.hopSize = config.hopSize;
+    recording.pollIntervalMs = 5;
+    SessionRecorder recorder(recording);
+    ASSERT_TRUE(recorder.start());
+    ASSERT_TRUE(runner.setRecorder(&recorder));
+
+    ASSERT_TRUE(runner.start());
+    EXPECT_FALSE(runner.setRecorder(nullptr));
+    for (size_t offset = 0; offset < signal.size(); offset += 1024) {
+        runner.pushSamples(signal.data() + offset, std::min<size_t>(1024, signal.size() - offset));
+    }
+    ASSERT_TRUE(runner.waitIdle(2000));
+    std::vector<float> columns(numFrames * config.numMelBands);
+    ASSERT_EQ(runner.readColumns(columns.data(), static_cast<int>(numFrames)), static_cast<int>(numFrames));
+    runner.stop();
+    recorder.stop();
+
+    MappedWav wav;
+    ASSERT_TRUE(wav.open(recording.pathPrefix + "_0000.wav"));
+    ASSERT_EQ(wav.numFrames(), signal.size());
+    EXPECT_TRUE(std::equal(signal.begin(), signal.end(), wav.samples()));
+
+    // The same frames from a processor of its own, as dB
+    MelSpectrogramProcessor reference(config);
+    std::vector<float> expected(columns.size());
+    std::vector<float> decibels(columns.size());
+    size_t produced = 0;
+    reference.processAudioSamples(signal.data(), signal.size(), expected.data(), numFrames, &produced,
+                                  decibels.data());
+    ASSERT_EQ(produced, numFrames);
+    EXPECT_EQ(expected, columns);
+
+    // One chunk, kept to melDynamicRangeDb below its peak at melBitDepth bits
+    MelArchiveReader archive;
+    ASSERT_TRUE(archive.open(recording.pathPrefix + "_0000.mela"));
+    ASSERT_EQ(archive.getNumFrames(), numFrames);
+    std::vector<float> decoded(columns.size());
+    ASSERT_EQ(archive.readFrames(0, numFrames, decoded.data()), static_cast<long>(numFrames));
+    const float floor = *std::max_element(decibels.begin(), decibels.end()) - recording.melDynamicRangeDb;
+    const float tolerance = 0.5f * recording.melDynamicRangeDb / ((1 << recording.melBitDepth) - 1) + 1e-3f;
+    for (size_t i = 0; i < decibels.size(); ++i) {
+        ASSERT_NEAR(decoded[i], std::max(decibels[i], floor), tolerance) << i;
+    }
+}
+
+// Test 7: Device-rate input is resampled to the analysis rate before framing
+TEST(PipelineRunnerTest, ResampledInputTest) {
+    AudioConfig config;
+    config.sampleRate = 16000;
+    config.frameSize = 512;
+    config.hopSize = 256;
+    config.numMelBands = 40;
+    MelSpectrogramProcessor processor(config);
+    PipelineRunner runner(processor, config, 256, 48000);
+    ASSERT_TRUE(runner.setInputRate(48000));
+    EXPECT_EQ(runner.getInputRate(), 48000);
+
+    auto signal = makeSignal(24000);
+    ASSERT_TRUE(runner.start());
+    EXPECT_FALSE(runner.setInputRate(44100));
+    for (size_t offset = 0; offset < signal.size(); offset += 960) {
+        runner.pushSamples(signal.data() + offset, std::min<size_t>(960, signal.size() - offset));
+    }
+    ASSERT_TRUE(runner.waitIdle(2000));
+
+    // Same as resampling the whole stream up front and processing that at 16 kHz
+    Resampler resampler(48000, config.sampleRate);
+    std::vector<int16_t> resampled(resampler.getMaxOutput(signal.size()));
+    resampled.resize(resampler.process(signal.data(), signal.size(), resampled.data(), resampled.size()));
+    const size_t numFrames = (resampled.size() - config.frameSize) / config.hopSize + 1;
+    EXPECT_EQ(runner.getStats().framesProcessed, numFrames);
+
+    MelSpectrogramProcessor reference(config);
+    std::vector<float> columns(numFrames * config.numMelBands);
+    ASSERT_EQ(runner.readColumns(columns.data(), static_cast<int>(numFrames)), static_cast<int>(numFrames));
+    for (size_t i = 0; i < numFrames; ++i) {
+        ASSERT_TRUE(reference.processAudioFrame(resampled.data() + i * config.hopSize, config.frameSize));
+        std::vector<float> column(columns.begin() + i * config.numMelBands,
+                                  columns.begin() + (i + 1) * config.numMelBands);
+        EXPECT_EQ(column, reference.getMelSpectrum()) << "frame " << i;
+    }
+    runner.stop();
+}
+
+// Test 8: A recorder must describe the runner's mel frames and its input rate
+TEST(PipelineRunnerTest, RecorderConfigTest) {
+    AudioConfig config;
+    config.sampleRate = 16000;
+    config.frameSize = 512;
+    config.hopSize = 256;
+    config.numMelBands = 40;
+    MelSpectrogramProcessor processor(config);
+    PipelineRunner runner(processor, config, 256, 48000);
+
+    RecorderConfig recording;
+    recording.pathPrefix = ::testing::TempDir() + "pipeline_rates";
+    recording.sampleRate = config.sampleRate;
+    recording.numMelBands = config.numMelBands;
+    recording.hopSize = config.hopSize;
+    recording.pollIntervalMs = 5;
+
+    RecorderConfig mismatched = recording;
+    mismatched.numMelBands = 64;
+    SessionRecorder wrongBands(mismatched);
+    EXPECT_FALSE(runner.setRecorder(&wrongBands));
+    mismatched = recording;
+    mismatched.hopSize = 512;
+    SessionRecorder wrongHop(mismatched);
+    EXPECT_FALSE(runner.setRecorder(&wrongHop));
+    mismatched.recordMel = false;  // The hop no longer matters
+    SessionRecorder pcmOnly(mismatched);
+    EXPECT_TRUE(runner.setRecorder(&pcmOnly));
+    ASSERT_TRUE(runner.setRecorder(nullptr));
+
+    // Input at 48 kHz is recorded as it arrives, so the WAV needs that rate
+    SessionRecorder analysisRate(recording);
+    ASSERT_TRUE(runner.setRecorder(&analysisRate));
+    ASSERT_TRUE(runner.setInputRate(48000));
+    EXPECT_FALSE(runner.start());
+    EXPECT_FALSE(runner.setRecorder(&analysisRate));
+
+    recording.pcmSampleRate = 48000;
+    SessionRecorder recorder(recording);
+    ASSERT_TRUE(recorder.start());
+    ASSERT_TRUE(runner.setRecorder(&recorder));
+    ASSERT_TRUE(runner.start());
+    auto signal = makeSignal(9600);
+    runner.pushSamples(signal.data(), signal.size());
+    ASSERT_TRUE(runner.waitIdle(2000));
+    runner.stop();
+    recorder.stop();
+
+    MappedWav wav;
+    ASSERT_TRUE(wav.open(recording.pathPrefix + "_0000.wav"));
+    EXPECT_EQ(wav.getSampleRate(), 48000);
+    EXPECT_EQ(wav.numFrames(), signal.size());
+    MelArchiveReader archive;
+    ASSERT_TRUE(archive.open(recording.pathPrefix + "_0000.mela"));
+    EXPECT_EQ(archive.getConfig().sampleRate, config.sampleRate);
+    EXPECT_EQ(archive.getNumFrames(), runner.getStats().framesProcessed);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
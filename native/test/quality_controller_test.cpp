@@ -0,0 +1,202 @@
+#include <gtest/gtest.h>
+#include "quality_controller.h"
+#include "mel_spectrogram.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace melspectrogram;
+
+namespace {
+    constexpr float PI = 3.14159265359f;
+
+    AudioConfig makeConfig() {
+        AudioConfig config;
+        config.sampleRate = 16000;
+        config.frameSize = 1024;
+        config.hopSize = 256;
+        config.numMelBands = 48;
+        return config;
+    }
+
+    std::vector<int16_t> makeTone(size_t samples, float frequency, int sampleRate) {
+        std::vector<int16_t> signal(samples);
+        for (size_t i = 0; i < samples; ++i) {
+            signal[i] = static_cast<int16_t>(12000.0f * std::sin(2.0f * PI * frequency * i / sampleRate));
+        }
+        return signal;
+    }
+
+    std::vector<float> run(MelSpectrogramProcessor& processor, const std::vector<int16_t>& input,
+                           size_t capacity, size_t* frames) {
+        std::vector<float> output(capacity * 48);
+        processor.processAudioSamples(input.data(), input.size(), output.data(), capacity, frames);
+        output.resize(*frames * 48);
+        return output;
+    }
+}
+
+// Test 1: Each level adds one degradation to the previous one
+TEST(QualityControllerTest, Ladder) {
+    QualityLevel full = qualityLevelFor(0);
+    EXPECT_EQ(full.decimation, 1);
+    EXPECT_EQ(full.bandDivisor, 1);
+    EXPECT_EQ(full.fftDivisor, 1);
+    EXPECT_TRUE(full.colorMapping);
+
+    EXPECT_EQ(qualityLevelFor(1).decimation, 2);
+    EXPECT_EQ(qualityLevelFor(1).bandDivisor, 1);
+    EXPECT_EQ(qualityLevelFor(2).bandDivisor, 2);
+    EXPECT_EQ(qualityLevelFor(2).fftDivisor, 1);
+    EXPECT_EQ(qualityLevelFor(3).fftDivisor, 2);
+    EXPECT_TRUE(qualityLevelFor(3).colorMapping);
+    EXPECT_FALSE(qualityLevelFor(MAX_QUALITY_LEVEL).colorMapping);
+    EXPECT_EQ(qualityLevelFor(MAX_QUALITY_LEVEL + 3).decimation, 2);
+}
+
+// Test 2: Steps down once per hold period under pressure, back up only after a calm stretch
+TEST(QualityControllerTest, StepsWithHysteresis) {
+    QualityControllerConfig config;
+    config.enabled = true;
+    config.smoothing = 0.5f;
+    config.holdFrames = 4;
+    config.recoverFrames = 10;
+    QualityController controller(config);
+
+    // Every frame takes the whole deadline
+    int frames = 0;
+    while (controller.getLevel() < 2) {
+        controller.update(10.0f, 10.0f);
+        ++frames;
+        ASSERT_LT(frames, 100);
+    }
+    EXPECT_EQ(frames, 8);
+    for (int i = 0; i < 100; ++i) {
+        controller.update(10.0f, 10.0f);
+    }
+    EXPECT_EQ(controller.getLevel(), MAX_QUALITY_LEVEL);
+    EXPECT_TRUE(controller.isOverBudget());
+
+    // Load between budget / 2 and budget neither degrades nor recovers
+    for (int i = 0; i < 100; ++i) {
+        controller.update(4.0f, 10.0f);
+    }
+    EXPECT_EQ(controller.getLevel(), MAX_QUALITY_LEVEL);
+    EXPECT_FALSE(controller.isOverBudget());
+
+    // A calm stretch brings back one level per recoverFrames
+    for (int i = 0; i < 15; ++i) {
+        controller.update(0.5f, 10.0f);
+    }
+    EXPECT_EQ(controller.getLevel(), MAX_QUALITY_LEVEL - 1);
+    for (int i = 0; i < 100; ++i) {
+        controller.update(0.5f, 10.0f);
+    }
+    EXPECT_EQ(controller.getLevel(), 0);
+}
+
+// Test 3: Disabled controller only measures
+TEST(QualityControllerTest, DisabledKeepsLevel) {
+    QualityController controller;
+    for (int i = 0; i < 500; ++i) {
+        EXPECT_EQ(controller.update(20.0f, 10.0f), 0);
+    }
+    EXPECT_GT(controller.getMissRate(), 0.9f);
+    EXPECT_GT(controller.getLoad(), 1.9f);
+
+    controller.setLevel(7);
+    EXPECT_EQ(controller.getLevel(), MAX_QUALITY_LEVEL);
+}
+
+// Test 4: Degraded levels keep the output shape and stay close to full quality
+TEST(QualityControllerTest, ProcessorLevels) {
+    const AudioConfig config = makeConfig();
+    const auto input = makeTone(16000, 1200.0f, config.sampleRate);
+    const size_t bands = config.numMelBands;
+
+    MelSpectrogramProcessor full(config);
+    size_t fullFrames = 0;
+    const std::vector<float> reference = run(full, input, 64, &fullFrames);
+    const auto peakOf = [&](const std::vector<float>& frames, size_t f) {
+        return std::max_element(frames.begin() + f * bands, frames.begin() + (f + 1) * bands) -
+               (frames.begin() + f * bands);
+    };
+
+    // Level 1: every other hop repeats the frame before it
+    MelSpectrogramProcessor decimated(config);
+    decimated.setQualityLevel(1);
+    EXPECT_EQ(decimated.getQualityLevel(), 1);
+    size_t frames = 0;
+    std::vector<float> output = run(decimated, input, 64, &frames);
+    ASSERT_EQ(frames, fullFrames);
+    for (size_t f = 0; f < frames; ++f) {
+        const size_t source = f - f % 2;
+        for (size_t b = 0; b < bands; ++b) {
+            ASSERT_EQ(output[f * bands + b], reference[source * bands + b]) << "frame " << f;
+        }
+    }
+
+    // Levels 2 and 3: interpolated from fewer bands and a shorter frame; the tone stays put
+    for (int level : {2, 3}) {
+        MelSpectrogramProcessor reduced(config);
+        const float* mel = reduced.getMelData();
+        reduced.setQualityLevel(level);
+        output = run(reduced, input, 64, &frames);
+        ASSERT_EQ(frames, fullFrames);
+        // Every level's buffers were laid out up front; switching moves nothing
+        EXPECT_EQ(reduced.getMemoryFootprint(), full.getMemoryFootprint());
+        EXPECT_EQ(reduced.getMelData(), mel);
+        for (size_t f = 2; f < frames; f += 2) {
+            EXPECT_NEAR(peakOf(output, f), peakOf(reference, f), 2) << "level " << level << " frame " << f;
+            for (size_t b = 0; b < bands; ++b) {
+                ASSERT_GE(output[f * bands + b], 0.0f);
+                ASSERT_LE(output[f * bands + b], 1.0f);
+            }
+        }
+    }
+
+    // Level 4: color data stays at the last mapped frame
+    MelSpectrogramProcessor colorless(config);
+    std::vector<int16_t> silence(config.frameSize, 0);
+    ASSERT_TRUE(colorless.processAudioFrame(silence.data(), silence.size()));
+    const std::vector<uint8_t> colors = colorless.getColorMappedData();
+    colorless.setQualityLevel(MAX_QUALITY_LEVEL);
+    ASSERT_TRUE(colorless.processAudioFrame(input.data(), config.frameSize));
+    EXPECT_NE(colorless.getMelSpectrum(), full.getMelSpectrum());
+    EXPECT_EQ(colorless.getColorMappedData(), colors);
+}
+
+// Test 5: An impossible budget walks the processor down the ladder, a generous one back up
+TEST(QualityControllerTest, ProcessorAdapts) {
+    const AudioConfig config = makeConfig();
+    const auto input = makeTone(config.frameSize, 500.0f, config.sampleRate);
+    MelSpectrogramProcessor processor(config);
+
+    QualityControllerConfig quality;
+    quality.enabled = true;
+    quality.budget = 1e-9f;
+    quality.holdFrames = 3;
+    processor.setQualityController(quality);
+    for (int i = 0; i < 40; ++i) {
+        ASSERT_TRUE(processor.processAudioFrame(input.data(), input.size()));
+    }
+    EXPECT_EQ(processor.getQualityLevel(), MAX_QUALITY_LEVEL);
+    EXPECT_EQ(processor.getStats().qualityLevel, MAX_QUALITY_LEVEL);
+    EXPECT_TRUE(processor.isOverloaded());
+
+    quality.budget = 1e9f;
+    quality.recoverFrames = 2;
+    processor.setQualityController(quality);
+    EXPECT_EQ(processor.getQualityLevel(), 0);
+    processor.setQualityLevel(MAX_QUALITY_LEVEL);
+    for (int i = 0; i < 40; ++i) {
+        ASSERT_TRUE(processor.processAudioFrame(input.data(), input.size()));
+    }
+    EXPECT_EQ(processor.getQualityLevel(), 0);
+    EXPECT_FALSE(processor.isOverloaded());
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,181 @@
+#include <gtest/gtest.h>
+#include "resampler.h"
+#include "mel_spectrogram.h"
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace melspectrogram;
+
+namespace {
+    constexpr double PI = 3.14159265358979323846;
+
+    std::vector<int16_t> makeTone(size_t samples, double frequency, int sampleRate, double amplitude) {
+        std::vector<int16_t> signal(samples);
+        for (size_t i = 0; i < samples; ++i) {
+            signal[i] = static_cast<int16_t>(std::lround(amplitude * std::sin(2.0 * PI * frequency * i / sampleRate)));
+        }
+        return signal;
+    }
+
+    std::vector<int16_t> resampleAll(Resampler& resampler, const std::vector<int16_t>& input) {
+        std::vector<int16_t> output(resampler.getMaxOutput(input.size()));
+        output.resize(resampler.process(input.data(), input.size(), output.data(), output.size()));
+        return output;
+    }
+
+    // Equal tones every 50 Hz up to 9.5 kHz, with fixed random phases
+    std::vector<int16_t> makeComb(size_t samples, int sampleRate) {
+        std::mt19937 rng(3);
+        std::uniform_real_distribution<double> phase(0.0, 2.0 * PI);
+        std::vector<double> phases;
+        for (int f = 100; f <= 9500; f += 50) {
+            phases.push_back(phase(rng));
+        }
+        std::vector<int16_t> signal(samples);
+        for (size_t i = 0; i < samples; ++i) {
+            double value = 0.0;
+            for (size_t t = 0; t < phases.size(); ++t) {
+                value += std::sin(2.0 * PI * (100.0 + 50.0 * t) * i / sampleRate + phases[t]);
+            }
+            signal[i] = static_cast<int16_t>(std::lround(600.0 * value));
+        }
+        return signal;
+    }
+
+    // dB log-mel of the last frame over 32 ms frames and 10 ms hops, each band less band 10
+    std::vector<float> relativeMel(const std::vector<int16_t>& signal, int sampleRate) {
+        AudioConfig config;
+        config.sampleRate = sampleRate;
+        config.frameSize = sampleRate / 1000 * 32;
+        config.hopSize = sampleRate / 100;
+        config.maxFreq = 8000.0f;
+        MelSpectrogramProcessor processor(config);
+        DeltaConfig deltas;
+        deltas.enabled = true;
+        processor.setDeltas(deltas);  // For getDecibelData()
+        std::vector<float> output(signal.size() / config.hopSize * config.numMelBands);
+        size_t frames = 0;
+        processor.processAudioSamples(signal.data(), signal.size(), output.data(),
+                                      output.size() / config.numMelBands, &frames);
+        EXPECT_GT(frames, 0u);
+        std::vector<float> bands(processor.getDecibelData(), processor.getDecibelData() + config.numMelBands);
+        const float reference = bands[10];
+        for (float& band : bands) {
+            band -= reference;
+        }
+        return bands;
+    }
+
+    double rms(const std::vector<int16_t>& signal, size_t begin) {
+        double sum = 0.0;
+        for (size_t i = begin; i < signal.size(); ++i) {
+            sum += static_cast<double>(signal[i]) * signal[i];
+        }
+        return std::sqrt(sum / (signal.size() - begin));
+    }
+}
+
+// Test 1: Ratios reduce to phase counts; the analysis rate follows maxFreq
+TEST(ResamplerTest, RatiosAndRates) {
+    Resampler third(48000, 16000);
+    EXPECT_EQ(third.getNumPhases(), 1);
+    EXPECT_EQ(third.getTapsPerPhase() % 4, 0);
+    Resampler cd(44100, 16000);
+    EXPECT_EQ(cd.getNumPhases(), 160);
+    Resampler up(8000, 16000);
+    EXPECT_EQ(up.getNumPhases(), 2);
+
+    // maxFreq has to sit below the filter's transition band, not just below Nyquist
+    const float edge = Resampler::getPassbandEdge(48000, 16000);
+    EXPECT_GT(edge, 5500.0f);
+    EXPECT_LT(edge, 6000.0f);
+    EXPECT_EQ(canonicalAnalysisRate(48000, 5500.0f), 16000);
+    EXPECT_EQ(canonicalAnalysisRate(44100, 5500.0f), 16000);
+    EXPECT_EQ(canonicalAnalysisRate(48000, 8000.0f), 32000);
+    EXPECT_EQ(canonicalAnalysisRate(44100, 8000.0f), 32000);
+    EXPECT_EQ(canonicalAnalysisRate(48000, 11000.0f), 32000);
+    EXPECT_EQ(canonicalAnalysisRate(48000, 12000.0f), 48000);
+    EXPECT_EQ(canonicalAnalysisRate(48000, 20000.0f), 48000);
+    EXPECT_EQ(canonicalAnalysisRate(16000, 8000.0f), 16000);
+    EXPECT_EQ(canonicalAnalysisRate(8000, 4000.0f), 8000);
+}
+
+// Test 2: Passband tones come out at the new rate, delayed by getDelay()
+TEST(ResamplerTest, PassbandTone) {
+    for (int inputRate : {48000, 44100, 22050}) {
+        Resampler resampler(inputRate, 16000);
+        const auto input = makeTone(static_cast<size_t>(inputRate) / 4, 1000.0, inputRate, 10000.0);
+        const auto output = resampleAll(resampler, input);
+        EXPECT_NEAR(static_cast<double>(output.size()), input.size() * 16000.0 / inputRate, 2.0);
+
+        const double delay = resampler.getDelay();
+        for (size_t n = static_cast<size_t>(2 * delay) + 1; n < output.size(); ++n) {
+            const double expected = 10000.0 * std::sin(2.0 * PI * 1000.0 * (n - delay) / 16000.0);
+            ASSERT_NEAR(output[n], expected, 30.0) << "rate " << inputRate << " n " << n;
+        }
+    }
+}
+
+// Test 3: Content above the new Nyquist frequency is removed
+TEST(ResamplerTest, StopbandTone) {
+    Resampler resampler(48000, 16000);
+    const auto input = makeTone(24000, 11000.0, 48000, 20000.0);
+    const auto output = resampleAll(resampler, input);
+    const double attenuationDb = 20.0 * std::log10(rms(output, 200) / (20000.0 / std::sqrt(2.0)));
+    EXPECT_LT(attenuationDb, -60.0);
+}
+
+// Test 4: Chunked streaming reproduces the one-shot result exactly, even with short output room
+TEST(ResamplerTest, StreamingMatchesOneShot) {
+    const auto input = makeTone(20000, 440.0, 44100, 12000.0);
+    Resampler whole(44100, 16000);
+    const auto expected = resampleAll(whole, input);
+
+    Resampler chunked(44100, 16000);
+    std::vector<int16_t> output;
+    std::vector<int16_t> room(64);
+    const size_t chunks[] = {1, 441, 37, 1000, 5};
+    size_t offset = 0;
+    for (int i = 0; offset < input.size(); ++i) {
+        const size_t chunk = std::min(chunks[i % 5], input.size() - offset);
+        const size_t written = chunked.process(input.data() + offset, chunk, room.data(), room.size());
+        output.insert(output.end(), room.begin(), room.begin() + written);
+        offset += chunk;
+    }
+    // Drain what did not fit
+    size_t written;
+    while ((written = chunked.process(nullptr, 0, room.data(), room.size())) > 0) {
+        output.insert(output.end(), room.begin(), room.begin() + written);
+    }
+    EXPECT_EQ(output, expected);
+
+    chunked.reset();
+    EXPECT_EQ(resampleAll(chunked, input), expected);
+}
+
+// Test 5: At the canonical rate the top mel bands match the native-rate analysis
+TEST(ResamplerTest, TopMelBandsAtAnalysisRate) {
+    const int inputRate = 48000;
+    const auto input = makeComb(inputRate / 2, inputRate);
+    const auto native = relativeMel(input, inputRate);
+    const int bands = static_cast<int>(native.size());
+
+    const int rate = canonicalAnalysisRate(inputRate, 8000.0f);
+    ASSERT_EQ(rate, 32000);
+    Resampler resampler(inputRate, rate);
+    const auto analysis = relativeMel(resampleAll(resampler, input), rate);
+    for (int band = bands - 8; band < bands; ++band) {
+        EXPECT_NEAR(analysis[band], native[band], 0.5f) << "band " << band;
+    }
+
+    // 16 kHz would have cut the top band down through the transition
+    Resampler narrow(inputRate, 16000);
+    const auto cut = relativeMel(resampleAll(narrow, input), 16000);
+    EXPECT_LT(cut[bands - 1], native[bands - 1] - 6.0f);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,226 @@
+#include <gtest/gtest.h>
+#include "session_recorder.h"
+#include "offline_spectrogram.h"
+#include "mel_archive.h"
+#include <cmath>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace melspectrogram;
+
+namespace {
+    std::vector<int16_t> makeSignal(size_t count) {
+        std::vector<int16_t> signal(count);
+        for (size_t i = 0; i < count; ++i) {
+            signal[i] = static_cast<int16_t>(9000.0f * std::sin(0.021f * i) + 1500.0f * std::sin(0.43f * i));
+        }
+        return signal;
+    }
+
+    // dB log-mel values spanning 60 dB, inside the default dynamic range
+    std::vector<float> makeFrames(size_t frames, int bands) {
+        std::vector<float> data(frames * bands);
+        for (size_t i = 0; i < data.size(); ++i) {
+            data[i] = -40.0f + 30.0f * std::sin(0.01f * i);
+        }
+        return data;
+    }
+
+    RecorderConfig makeConfig(const std::string& name) {
+        RecorderConfig config;
+        config.pathPrefix = ::testing::TempDir() + name;
+        config.sampleRate = 16000;
+        config.numMelBands = 32;
+        config.hopSize = 160;
+        config.blockBytes = 8192;
+        config.pollIntervalMs = 5;
+        return config;
+    }
+}
+
+// Test 1: PCM and mel pushed from two producer threads come back intact
+TEST(SessionRecorderTest, RoundTripTest) {
+    RecorderConfig config = makeConfig("tee");
+    const auto signal = makeSignal(config.sampleRate * 3);
+    const size_t numFrames = signal.size() / config.hopSize;
+    const auto frames = makeFrames(numFrames, config.numMelBands);
+
+    SessionRecorder recorder(config);
+    ASSERT_TRUE(recorder.start()) << recorder.getError();
+    EXPECT_TRUE(recorder.isRunning());
+
+    // Audio-callback-sized pushes on one thread, a few frames at a time on another
+    std::thread audio([&] {
+        for (size_t offset = 0; offset < signal.size(); offset += 320) {
+            EXPECT_TRUE(recorder.pushPcm(signal.data() + offset, std::min<size_t>(320, signal.size() - offset)));
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    });
+    std::thread dsp([&] {
+        for (size_t f = 0; f < numFrames; f += 3) {
+            const size_t count = std::min<size_t>(3, numFrames - f);
+            EXPECT_TRUE(recorder.pushMel(frames.data() + f * config.numMelBands, count));
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    });
+    audio.join();
+    dsp.join();
+    recorder.stop();
+    EXPECT_FALSE(recorder.isRunning());
+
+    RecorderStats stats = recorder.getStats();
+    EXPECT_EQ(stats.pcmSamplesWritten, signal.size());
+    EXPECT_EQ(stats.pcmSamplesDropped, 0u);
+    EXPECT_EQ(stats.melFramesWritten, numFrames);
+    EXPECT_EQ(stats.melFramesDropped, 0u);
+    EXPECT_EQ(stats.segments, 1);
+    EXPECT_EQ(stats.writeErrors, 0);
+    EXPECT_EQ(stats.backlogBlocks, 0);
+    EXPECT_GT(stats.bytesWritten, signal.size() * sizeof(int16_t));
+    EXPECT_GE(stats.maxWriteMs, stats.averageWriteMs);
+
+    MappedWav wav;
+    ASSERT_TRUE(wav.open(config.pathPrefix + "_0000.wav")) << wav.getError();
+    EXPECT_EQ(wav.getSampleRate(), config.sampleRate);
+    ASSERT_EQ(wav.numFrames(), signal.size());
+    EXPECT_TRUE(std::equal(signal.begin(), signal.end(), wav.samples()));
+    // Sample data starts on a page boundary of the file
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(wav.samples()) % 4096, 0u);
+
+    MelArchiveReader archive;
+    ASSERT_TRUE(archive.open(config.pathPrefix + "_0000.mela")) << archive.getError();
+    ASSERT_EQ(archive.getNumFrames(), numFrames);
+    std::vector<float> decoded(frames.size());
+    ASSERT_EQ(archive.readFrames(0, numFrames, decoded.data()), static_cast<long>(numFrames));
+    for (size_t i = 0; i < frames.size(); ++i) {
+        ASSERT_NEAR(decoded[i], frames[i], 0.5f * 60.0f / 255 + 1e-3f) << i;
+    }
+}
+
+// Test 2: Segments rotate on audio duration and line up between the streams
+TEST(SessionRecorderTest, RotationTest) {
+    RecorderConfig config = makeConfig("rotate");
+    config.rotateSeconds = 1.0;
+    const auto signal = makeSignal(config.sampleRate * 5 / 2);
+    const size_t numFrames = signal.size() / config.hopSize;
+    const auto frames = makeFrames(numFrames, config.numMelBands);
+
+    SessionRecorder recorder(config);
+    ASSERT_TRUE(recorder.start());
+    for (size_t offset = 0; offset < signal.size(); offset += 1000) {
+        ASSERT_TRUE(recorder.pushPcm(signal.data() + offset, std::min<size_t>(1000, signal.size() - offset)));
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    for (size_t f = 0; f < numFrames; f += 10) {
+        ASSERT_TRUE(recorder.pushMel(frames.data() + f * config.numMelBands, std::min<size_t>(10, numFrames - f)));
+    }
+    recorder.stop();
+    EXPECT_EQ(recorder.getStats().segments, 3);
+
+    const size_t expectedSamples[] = {16000, 16000, 8000};
+    const uint64_t expectedFrames[] = {100, 100, 50};
+    size_t sampleOffset = 0;
+    for (int segment = 0; segment < 3; ++segment) {
+        const std::string suffix = "_000" + std::to_string(segment);
+        MappedWav wav;
+        ASSERT_TRUE(wav.open(config.pathPrefix + suffix + ".wav"));
+        ASSERT_EQ(wav.numFrames(), expectedSamples[segment]);
+        EXPECT_TRUE(std::equal(wav.samples(), wav.samples() + wav.numFrames(), signal.begin() + sampleOffset));
+        sampleOffset += wav.numFrames();
+
+        MelArchiveReader archive;
+        ASSERT_TRUE(archive.open(config.pathPrefix + suffix + ".mela"));
+        EXPECT_FALSE(archive.wasRecovered());
+        EXPECT_EQ(archive.getNumFrames(), expectedFrames[segment]);
+        EXPECT_EQ(archive.getConfig().startTimeUs, segment * 1000000);
+    }
+}
+
+// Test 3: WAV segments rotate at the 32-bit size limit even when rotation is off
+TEST(SessionRecorderTest, WavLimitTest) {
+    // The largest data size whose RIFF size still fits 32 bits, in whole samples
+    EXPECT_LE(SessionRecorder::MAX_WAV_DATA_BYTES + 4088, 0xFFFFFFFFull);
+    EXPECT_GT(SessionRecorder::MAX_WAV_DATA_BYTES + sizeof(int16_t) + 4088, 0xFFFFFFFFull);
+    EXPECT_EQ(SessionRecorder::MAX_WAV_DATA_BYTES % sizeof(int16_t), 0u);
+
+    // A one-second limit stands in for the real one; an odd byte count still means whole samples
+    for (double rotateSeconds : {0.0, 2.0}) {
+        RecorderConfig config = makeConfig("wav_limit");
+        config.rotateSeconds = rotateSeconds;
+        config.maxWavBytes = config.sampleRate * sizeof(int16_t) + 1;
+        const auto signal = makeSignal(config.sampleRate * 5 / 2);
+        const size_t numFrames = signal.size() / config.hopSize;
+        const auto frames = makeFrames(numFrames, config.numMelBands);
+
+        SessionRecorder recorder(config);
+        ASSERT_TRUE(recorder.start());
+        for (size_t offset = 0; offset < signal.size(); offset += 1000) {
+            ASSERT_TRUE(recorder.pushPcm(signal.data() + offset, std::min<size_t>(1000, signal.size() - offset)));
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+        for (size_t f = 0; f < numFrames; f += 10) {
+            ASSERT_TRUE(recorder.pushMel(frames.data() + f * config.numMelBands,
+                                         std::min<size_t>(10, numFrames - f)));
+        }
+        recorder.stop();
+        EXPECT_EQ(recorder.getStats().segments, 3) << rotateSeconds;
+
+        // Exactly at the limit, with the mel segments alongside
+        const size_t expectedSamples[] = {16000, 16000, 8000};
+        const uint64_t expectedFrames[] = {100, 100, 50};
+        for (int segment = 0; segment < 3; ++segment) {
+            const std::string suffix = "_000" + std::to_string(segment);
+            MappedWav wav;
+            ASSERT_TRUE(wav.open(config.pathPrefix + suffix + ".wav"));
+            EXPECT_EQ(wav.numFrames(), expectedSamples[segment]) << rotateSeconds;
+            MelArchiveReader archive;
+            ASSERT_TRUE(archive.open(config.pathPrefix + suffix + ".mela"));
+            EXPECT_EQ(archive.getNumFrames(), expectedFrames[segment]) << rotateSeconds;
+        }
+    }
+}
+
+// Test 4: A full backlog drops new data instead of blocking the producer
+TEST(SessionRecorderTest, BoundedBacklogTest) {
+    RecorderConfig config = makeConfig("backlog");
+    config.recordMel = false;
+    config.blockBytes = 4096;
+    config.backlogBlocks = 2;
+    config.pollIntervalMs = 2000;   // The I/O thread stays asleep for the push below
+
+    SessionRecorder recorder(config);
+    ASSERT_TRUE(recorder.start());
+    const auto signal = makeSignal(100000);
+    EXPECT_FALSE(recorder.pushPcm(signal.data(), signal.size()));
+    EXPECT_FALSE(recorder.pushMel(nullptr, 0));
+
+    RecorderStats stats = recorder.getStats();
+    EXPECT_EQ(stats.pcmSamplesDropped, signal.size() - 4096);
+    EXPECT_EQ(stats.backlogBlocks, 2);
+
+    recorder.stop();
+    stats = recorder.getStats();
+    EXPECT_EQ(stats.pcmSamplesWritten, 4096u);
+    EXPECT_EQ(stats.backlogBlocks, 0);
+}
+
+// Test 5: Invalid configurations and unwritable paths fail at start
+TEST(SessionRecorderTest, StartFailureTest) {
+    RecorderConfig config = makeConfig("bad");
+    config.pathPrefix.clear();
+    SessionRecorder empty(config);
+    EXPECT_FALSE(empty.start());
+    EXPECT_FALSE(empty.getError().empty());
+
+    config.pathPrefix = ::testing::TempDir() + "missing_dir/deeper/bad";
+    SessionRecorder unwritable(config);
+    EXPECT_FALSE(unwritable.start());
+    EXPECT_FALSE(unwritable.isRunning());
+    EXPECT_FALSE(unwritable.pushPcm(makeSignal(10).data(), 10));
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,229 @@
+#include <gtest/gtest.h>
+#include "spectrogram_exporter.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+#ifdef FLUTTER_SP_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+using namespace melspectrogram;
+
+class SpectrogramExporterTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        renderer = std::make_unique<TextureRenderer>(64, 32, 16, RenderBackendType::CPU);
+        ASSERT_TRUE(renderer->initialize());
+
+        // 80 columns into a 64-wide ring so the export has to unwrap it
+        std::vector<float> melData(16);
+        for (int frame = 0; frame < 80; ++frame) {
+            for (int band = 0; band < 16; ++band) {
+                melData[band] = ((frame + band) % 16) / 15.0f;
+            }
+            ASSERT_TRUE(renderer->updateColumn(melData));
+        }
+    }
+
+    void TearDown() override {
+        for (const auto& path : paths) {
+            std::remove(path.c_str());
+        }
+    }
+
+    std::string tempPath(const std::string& name) {
+        std::string path = ::testing::TempDir() + "spectrogram_exporter_test_" + name;
+        paths.push_back(path);
+        return path;
+    }
+
+    static std::vector<uint8_t> readFile(const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        return std::vector<uint8_t>(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    static uint32_t readBigEndian32(const uint8_t* p) {
+        return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | p[3];
+    }
+
+    // Returns the concatenated IDAT payload and checks the chunk framing
+    static std::vector<uint8_t> collectIdat(const std::vector<uint8_t>& png, int* width, int* height) {
+        static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+        EXPECT_GE(png.size(), 8u);
+        EXPECT_EQ(std::memcmp(png.data(), signature, 8), 0);
+
+        std::vector<uint8_t> idat;
+        size_t pos = 8;
+        bool sawEnd = false;
+        while (pos + 12 <= png.size()) {
+            const uint32_t length = readBigEndian32(&png[pos]);
+            const std::string type(reinterpret_cast<const char*>(&png[pos + 4]), 4);
+            const uint8_t* data = &png[pos + 8];
+            if (type == "IHDR") {
+                *width = static_cast<int>(readBigEndian32(data));
+                *height = static_cast<int>(readBigEndian32(data + 4));
+            } else if (type == "IDAT") {
+                idat.insert(idat.end(), data, data + length);
+            } else if (type == "IEND") {
+                sawEnd = true;
+            }
+#ifdef FLUTTER_SP_HAVE_ZLIB
+            const uint32_t crc = static_cast<uint32_t>(crc32(0, &png[pos + 4], length + 4));
+            EXPECT_EQ(crc, readBigEndian32(data + length)) << "Bad CRC in " << type;
+#endif
+            pos += 12 + length;
+        }
+        EXPECT_TRUE(sawEnd);
+        EXPECT_EQ(pos, png.size());
+        return idat;
+    }
+
+#ifdef FLUTTER_SP_HAVE_ZLIB
+    // Inflate and undo the row filters, returning raw RGBA
+    static std::vector<uint8_t> decodePixels(const std::vector<uint8_t>& idat, int width, int height) {
+        const size_t rowBytes = static_cast<size_t>(width) * 4;
+        std::vector<uint8_t> filtered((rowBytes + 1) * height);
+        uLongf size = static_cast<uLongf>(filtered.size());
+        EXPECT_EQ(uncompress(filtered.data(), &size, idat.data(), static_cast<uLong>(idat.size())), Z_OK);
+        EXPECT_EQ(size, filtered.size());
+
+        std::vector<uint8_t> pixels(rowBytes * height);
+        for (int y = 0; y < height; ++y) {
+            const uint8_t* src = &filtered[y * (rowBytes + 1)];
+            uint8_t* dst = &pixels[y * rowBytes];
+            for (size_t i = 0; i < rowBytes; ++i) {
+                const uint8_t left = (src[0] == 1 && i >= 4) ? dst[i - 4] : 0;
+                dst[i] = static_cast<uint8_t>(src[i + 1] + left);
+            }
+        }
+        return pixels;
+    }
+#endif
+
+    std::unique_ptr<TextureRenderer> renderer;
+    std::vector<std::string> paths;
+};
+
+// Test 1: Stored-mode PNG is well formed and matches the time-ordered texture
+TEST_F(SpectrogramExporterTest, StoredPngTest) {
+    RingSnapshot snapshot;
+    renderer->snapshotRing(snapshot);
+
+    ExportOptions options;
+    options.compressionLevel = 0;
+    const std::string path = tempPath("stored.png");
+    size_t bytes = 0;
+    ASSERT_TRUE(SpectrogramExporter::encodeToFile(snapshot, path, options, &bytes));
+
+    auto png = readFile(path);
+    EXPECT_EQ(png.size(), bytes);
+    int width = 0, height = 0;
+    auto idat = collectIdat(png, &width, &height);
+    EXPECT_EQ(width, 64);
+    EXPECT_EQ(height, 32);
+    // Stored blocks: filtered rows plus zlib and block framing
+    EXPECT_GT(idat.size(), static_cast<size_t>((64 * 4 + 1) * 32));
+
+#ifdef FLUTTER_SP_HAVE_ZLIB
+    EXPECT_EQ(decodePixels(idat, width, height), renderer->getTextureData());
+#endif
+}
+
+#ifdef FLUTTER_SP_HAVE_ZLIB
+// Test 2: Compressed PNG round-trips and is smaller than stored mode
+TEST_F(SpectrogramExporterTest, CompressedPngTest) {
+    RingSnapshot snapshot;
+    renderer->snapshotRing(snapshot);
+
+    const std::string path = tempPath("fast.png");
+    ExportOptions options;
+    options.compressionLevel = 1;
+    ASSERT_TRUE(SpectrogramExporter::encodeToFile(snapshot, path, options));
+
+    auto png = readFile(path);
+    int width = 0, height = 0;
+    auto idat = collectIdat(png, &width, &height);
+    EXPECT_LT(idat.size(), static_cast<size_t>(64 * 4 * 32));
+    EXPECT_EQ(decodePixels(idat, width, height), renderer->getTextureData());
+}
+#endif
+
+// Test 3: Raw dumps are frames in time order
+TEST_F(SpectrogramExporterTest, RawDumpTest) {
+    RingSnapshot snapshot;
+    renderer->snapshotRing(snapshot);
+
+    ExportOptions options;
+    options.format = ExportFormat::RAW_FLOAT32;
+    const std::string floatPath = tempPath("dump.f32");
+    ASSERT_TRUE(SpectrogramExporter::encodeToFile(snapshot, floatPath, options));
+    auto floatBytes = readFile(floatPath);
+    ASSERT_EQ(floatBytes.size(), 64u * 16 * sizeof(float));
+
+    options.format = ExportFormat::RAW_UINT8;
+    const std::string bytePath = tempPath("dump.u8");
+    ASSERT_TRUE(SpectrogramExporter::encodeToFile(snapshot, bytePath, options));
+    auto quantized = readFile(bytePath);
+    ASSERT_EQ(quantized.size(), 64u * 16);
+
+    // Oldest retained frame is frame 16 of the 80 pushed
+    for (int x = 0; x < 64; ++x) {
+        for (int band = 0; band < 16; ++band) {
+            const float expected = ((16 + x + band) % 16) / 15.0f;
+            float value;
+            std::memcpy(&value, &floatBytes[(x * 16 + band) * sizeof(float)], sizeof(float));
+            EXPECT_FLOAT_EQ(value, expected);
+            EXPECT_EQ(quantized[x * 16 + band], static_cast<uint8_t>(expected * 255.0f + 0.5f));
+        }
+    }
+}
+
+// Test 4: Background jobs complete without blocking the caller
+TEST_F(SpectrogramExporterTest, AsyncExportTest) {
+    SpectrogramExporter exporter(2);
+    std::atomic<int> callbacks{0};
+    std::atomic<bool> allSucceeded{true};
+
+    const std::string path = tempPath("async.png");
+    ASSERT_TRUE(exporter.exportAsync(*renderer, path, ExportOptions(),
+        [&](const std::string&, bool success) {
+            callbacks++;
+            if (!success) allSucceeded = false;
+        }));
+
+    ASSERT_TRUE(exporter.waitIdle(5000));
+    EXPECT_EQ(callbacks.load(), 1);
+    EXPECT_TRUE(allSucceeded.load());
+    EXPECT_EQ(exporter.getPendingJobs(), 0u);
+
+    auto stats = exporter.getStats();
+    EXPECT_EQ(stats.jobsCompleted, 1u);
+    EXPECT_EQ(stats.bytesWritten, readFile(path).size());
+}
+
+// Test 5: Failures are reported and leave no partial file
+TEST_F(SpectrogramExporterTest, ExportFailureTest) {
+    SpectrogramExporter exporter;
+    bool reported = false;
+    bool result = true;
+    ASSERT_TRUE(exporter.exportAsync(*renderer, "/nonexistent-dir/out.png", ExportOptions(),
+        [&](const std::string&, bool success) {
+            reported = true;
+            result = success;
+        }));
+    ASSERT_TRUE(exporter.waitIdle(5000));
+    EXPECT_TRUE(reported);
+    EXPECT_FALSE(result);
+    EXPECT_EQ(exporter.getStats().jobsFailed, 1u);
+
+    TextureRenderer uninitialized(8, 8, 4, RenderBackendType::CPU);
+    EXPECT_FALSE(exporter.exportAsync(uninitialized, tempPath("never.png")));
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -1,8 +1,10 @@
 #include <gtest/gtest.h>
 #include "texture_renderer.h"
+#include "render_backend.h"
 #include <chrono>
 #include <cmath>
 #include <vector>
+#include <cstring>
 
 using namespace melspectrogram;
 
@@ -10,6 +12,7 @@ class TextureRendererTest : public ::testing::Test {
 protected:
     void SetUp() override {
         renderer = std::make_unique<TextureRenderer>(512, 256, 64);
+        renderer->initialize();
     }
     
     void generateTestData(std::vector<float>& data, float frequency, float amplitude = 1.0f) {
@@ -227,6 +230,252 @@ TEST_F(TextureRendererTest, RingBufferTest) {
     EXPECT_EQ(textureData.size(), 512 * 256 * 4);
 }
 
+// Test 13: CPU backend writes columns at their ring position
+TEST_F(TextureRendererTest, CpuBackendRingOffsetTest) {
+    TextureRenderer cpuRenderer(8, 4, 4, RenderBackendType::CPU);
+    ASSERT_TRUE(cpuRenderer.initialize());
+    EXPECT_EQ(cpuRenderer.getBackendType(), RenderBackendType::CPU);
+    EXPECT_EQ(cpuRenderer.getTextureId(), 0u);
+    ASSERT_NE(cpuRenderer.getPixels(), nullptr);
+    EXPECT_EQ(cpuRenderer.getPixelStride(), 8 * 4);
+    
+    std::vector<float> low(4, 0.0f);
+    std::vector<float> high(4, 1.0f);
+    for (int i = 0; i < 10; ++i) {
+        ASSERT_TRUE(cpuRenderer.updateColumn(i % 2 == 0 ? low : high));
+    }
+    EXPECT_EQ(cpuRenderer.getRingOffset(), 10 % 8);
+    
+    // Pixels are exposed zero-copy; column x holds update number x (mod width)
+    const uint8_t* pixels = cpuRenderer.getPixels();
+    const int stride = cpuRenderer.getPixelStride();
+    for (int x = 0; x < 8; ++x) {
+        int lastUpdate = (x < 2) ? x + 8 : x;
+        bool isHigh = lastUpdate % 2 == 1;
+        for (int y = 0; y < 4; ++y) {
+            const uint8_t* pixel = pixels + y * stride + x * 4;
+            // Viridis endpoints: (68, 1, 84) at 0, (253, 231, 37) at 1
+            EXPECT_EQ(pixel[0], isHigh ? 253 : 68);
+            EXPECT_EQ(pixel[1], isHigh ? 231 : 1);
+            EXPECT_EQ(pixel[2], isHigh ? 37 : 84);
+            EXPECT_EQ(pixel[3], 255);
+        }
+    }
+}
+
+// Test 14: CPU backend colorization matches band layout (highest band on top row)
+TEST_F(TextureRendererTest, CpuBackendBandLayoutTest) {
+    TextureRenderer cpuRenderer(4, 8, 8, RenderBackendType::CPU);
+    ASSERT_TRUE(cpuRenderer.initialize());
+    cpuRenderer.setMinMaxValues(0.0f, 7.0f);
+    
+    std::vector<float> ramp(8);
+    for (int i = 0; i < 8; ++i) {
+        ramp[i] = static_cast<float>(i);
+    }
+    // Include a NaN to make sure it maps to the bottom of the color map
+    ramp[0] = std::nanf("");
+    ASSERT_TRUE(cpuRenderer.updateColumn(ramp.data(), static_cast<int>(ramp.size())));
+    
+    const uint8_t* pixels = cpuRenderer.getPixels();
+    const int stride = cpuRenderer.getPixelStride();
+    // Top row shows band 7 (max), bottom row shows band 0 (NaN -> min)
+    EXPECT_EQ(pixels[0], 253);
+    EXPECT_EQ(pixels[7 * stride], 68);
+    
+    // Green channel of viridis increases monotonically with value
+    for (int y = 1; y < 8; ++y) {
+        EXPECT_LE(pixels[y * stride + 1], pixels[(y - 1) * stride + 1]);
+    }
+}
+
+// Test 15: Explicit OpenGL backend fails cleanly without a context
+TEST_F(TextureRendererTest, AutoBackendFallbackTest) {
+    EXPECT_TRUE(renderer->isInitialized());
+    if (renderer->getBackendType() == RenderBackendType::CPU) {
+        TextureRenderer glRenderer(64, 32, 16, RenderBackendType::OPENGL);
+        EXPECT_FALSE(glRenderer.initialize());
+        EXPECT_FALSE(glRenderer.updateColumn(std::vector<float>(16, 0.5f)));
+    }
+}
+
+// Test 16: Zoomed-out history renders as a time-ordered texture
+TEST_F(TextureRendererTest, HistoryRenderTest) {
+    TextureRenderer cpuRenderer(4, 2, 2, RenderBackendType::CPU);
+    ASSERT_TRUE(cpuRenderer.initialize());
+    std::vector<uint8_t> image;
+    EXPECT_EQ(cpuRenderer.renderHistory(0, 0, 4, 4, image), -1); // Not enabled yet
+    
+    ASSERT_TRUE(cpuRenderer.enableHistory(8, 4));
+    std::vector<float> low(2, 0.0f);
+    std::vector<float> high(2, 1.0f);
+    for (int i = 0; i < 16; ++i) {
+        ASSERT_TRUE(cpuRenderer.updateColumn(i < 8 ? low : high));
+    }
+    EXPECT_EQ(cpuRenderer.getHistory()->getTotalColumns(), 16);
+    
+    // 16 columns at level 2 -> 4 columns: two low, two high
+    int width = cpuRenderer.renderHistory(2, 0, 16, 16, image);
+    ASSERT_EQ(width, 4);
+    ASSERT_EQ(image.size(), 4u * 2 * 4);
+    EXPECT_EQ(image[0], 68);
+    EXPECT_EQ(image[1 * 4], 68);
+    EXPECT_EQ(image[2 * 4], 253);
+    EXPECT_EQ(image[3 * 4], 253);
+    
+    // Level 0 no longer holds the first columns; they come back opaque black
+    width = cpuRenderer.renderHistory(0, 0, 2, 2, image);
+    ASSERT_EQ(width, 2);
+    EXPECT_EQ(image[0], 0);
+    EXPECT_EQ(image[3], 255);
+}
+
+// Test 17: Exported texture data is time ordered and reflects the latest columns
+TEST_F(TextureRendererTest, TimeOrderedExportTest) {
+    TextureRenderer cpuRenderer(4, 2, 2, RenderBackendType::CPU);
+    ASSERT_TRUE(cpuRenderer.initialize());
+    
+    std::vector<float> low(2, 0.0f);
+    std::vector<float> high(2, 1.0f);
+    // Six updates into a 4-wide ring: oldest-to-newest is low, high, low, high
+    for (int i = 0; i < 6; ++i) {
+        ASSERT_TRUE(cpuRenderer.updateColumn(i % 2 == 0 ? low : high));
+    }
+    
+    auto data = cpuRenderer.getTextureData();
+    ASSERT_EQ(data.size(), 4u * 2 * 4);
+    for (int y = 0; y < 2; ++y) {
+        for (int x = 0; x < 4; ++x) {
+            EXPECT_EQ(data[(y * 4 + x) * 4], x % 2 == 0 ? 68 : 253);
+        }
+    }
+}
+
+// Test 18: Asynchronous readback delivers a snapshot through poll and callback
+TEST_F(TextureRendererTest, AsyncReadbackTest) {
+    std::vector<float> melData(64, 1.0f);
+    renderer->updateColumn(melData);
+    
+    int callbackWidth = 0;
+    std::vector<uint8_t> callbackPixels;
+    ASSERT_TRUE(renderer->requestReadback(
+        [&](const std::vector<uint8_t>& rgba, int width, int) {
+            callbackWidth = width;
+            callbackPixels = rgba;
+        }));
+    EXPECT_TRUE(renderer->isReadbackPending());
+    EXPECT_FALSE(renderer->requestReadback()); // Only one in flight
+    
+    // Columns pushed after the request don't change the snapshot
+    std::vector<float> lowData(64, 0.0f);
+    renderer->updateColumn(lowData);
+    
+    std::vector<uint8_t> pixels;
+    bool done = false;
+    for (int i = 0; i < 100 && !done; ++i) {
+        done = renderer->pollReadback(&pixels);
+    }
+    ASSERT_TRUE(done);
+    EXPECT_FALSE(renderer->isReadbackPending());
+    EXPECT_EQ(callbackWidth, 512);
+    ASSERT_EQ(pixels.size(), 512u * 256 * 4);
+    EXPECT_EQ(pixels, callbackPixels);
+    // Newest column of the snapshot is the bright one
+    EXPECT_EQ(pixels[511 * 4], 253);
+    EXPECT_FALSE(renderer->pollReadback(&pixels));
+}
+
+// Backend that records uploads, standing in for a GPU texture
+class RecordingBackend : public RenderBackend {
+public:
+    struct Upload { int x; int count; };
+    
+    RenderBackendType getType() const override { return RenderBackendType::OPENGL; }
+    bool initialize(int width, int height) override {
+        width_ = width;
+        height_ = height;
+        image.assign(static_cast<size_t>(width) * height, 0);
+        return true;
+    }
+    void shutdown() override {}
+    void writeColumn(int x, const uint32_t* column) override {
+        writeColumns(x, 1, column, 1);
+    }
+    void writeColumns(int x, int count, const uint32_t* pixels, int rowStride) override {
+        uploads->push_back({x, count});
+        for (int y = 0; y < height_; ++y) {
+            for (int i = 0; i < count; ++i) {
+                image[y * width_ + x + i] = pixels[y * rowStride + i];
+            }
+        }
+    }
+    
+    std::vector<Upload>* uploads = nullptr;
+    std::vector<uint32_t> image;
+    
+private:
+    int width_ = 0;
+    int height_ = 0;
+};
+
+// Test 19: Batched columns flush in at most two uploads, split at the wraparound
+TEST_F(TextureRendererTest, ColumnBatchingTest) {
+    TextureRenderer batchRenderer(8, 4, 4);
+    std::vector<RecordingBackend::Upload> uploads;
+    std::unique_ptr<RecordingBackend> backend(new RecordingBackend());
+    backend->uploads = &uploads;
+    RecordingBackend* recorder = backend.get();
+    ASSERT_TRUE(batchRenderer.initialize(std::move(backend)));
+    
+    std::vector<float> melData(4, 1.0f);
+    for (int i = 0; i < 6; ++i) {
+        ASSERT_TRUE(batchRenderer.enqueueColumn(melData.data(), 4));
+    }
+    EXPECT_EQ(batchRenderer.getPendingColumns(), 6);
+    EXPECT_TRUE(uploads.empty());
+    
+    EXPECT_EQ(batchRenderer.flush(), 1);
+    ASSERT_EQ(uploads.size(), 1u);
+    EXPECT_EQ(uploads[0].x, 0);
+    EXPECT_EQ(uploads[0].count, 6);
+    EXPECT_EQ(batchRenderer.flush(), 0);
+    
+    // Columns 6, 7, 0, 1 wrap around the ring
+    uploads.clear();
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_TRUE(batchRenderer.enqueueColumn(melData.data(), 4));
+    }
+    EXPECT_EQ(batchRenderer.flush(), 2);
+    ASSERT_EQ(uploads.size(), 2u);
+    EXPECT_EQ(uploads[0].x, 6);
+    EXPECT_EQ(uploads[0].count, 2);
+    EXPECT_EQ(uploads[1].x, 0);
+    EXPECT_EQ(uploads[1].count, 2);
+    
+    // Overflowing the ring still costs at most two uploads covering every column
+    uploads.clear();
+    for (int i = 0; i < 20; ++i) {
+        ASSERT_TRUE(batchRenderer.enqueueColumn(melData.data(), 4));
+    }
+    EXPECT_EQ(batchRenderer.getPendingColumns(), 8);
+    EXPECT_LE(batchRenderer.flush(), 2);
+    int uploaded = 0;
+    for (const auto& upload : uploads) {
+        uploaded += upload.count;
+    }
+    EXPECT_EQ(uploaded, 8);
+    
+    // The uploaded texture matches the CPU-side export once rotated
+    std::vector<uint8_t> expected = batchRenderer.getTextureData();
+    const int offset = batchRenderer.getRingOffset();
+    for (int y = 0; y < 4; ++y) {
+        for (int x = 0; x < 8; ++x) {
+            uint32_t pixel = recorder->image[y * 8 + (offset + x) % 8];
+            EXPECT_EQ(std::memcmp(&pixel, &expected[(y * 8 + x) * 4], 4), 0);
+        }
+    }
+}
+
 // Helper function for white noise generation
 void generateWhiteNoise(std::vector<float>& data, float amplitude) {
     for (auto& sample : data) {
@@ -234,6 +483,64 @@ void generateWhiteNoise(std::vector<float>& data, float amplitude) {
     }
 }
 
+// Test 20: Quantized columns render like the floats they stand for
+TEST_F(TextureRendererTest, QuantizedColumnTest) {
+    const int bands = 16;
+    TextureRenderer floatRenderer(6, bands, bands, RenderBackendType::CPU);
+    TextureRenderer byteRenderer(6, bands, bands, RenderBackendType::CPU);
+    TextureRenderer halfRenderer(6, bands, bands, RenderBackendType::CPU);
+    ASSERT_TRUE(floatRenderer.initialize());
+    ASSERT_TRUE(byteRenderer.initialize());
+    ASSERT_TRUE(halfRenderer.initialize());
+    
+    // A narrower display range exercises the byte color table rebuild
+    for (TextureRenderer* r : {&floatRenderer, &byteRenderer, &halfRenderer}) {
+        r->setColorMap(ColorMapType::INFERNO);
+        r->setMinMaxValues(0.1f, 0.8f);
+    }
+    
+    std::vector<float> column(bands);
+    std::vector<uint8_t> bytes(bands);
+    std::vector<uint16_t> halves(bands);
+    std::vector<float> fromBytes(bands);
+    std::vector<float> fromHalves(bands);
+    for (int c = 0; c < 6; ++c) {
+        generateTestData(column, 1.0f + c);
+        quantizeUnit(column.data(), bands, MelOutputFormat::UINT8, bytes.data());
+        quantizeUnit(column.data(), bands, MelOutputFormat::FLOAT16, halves.data());
+        dequantize(bytes.data(), bands, MelOutputFormat::UINT8, fromBytes.data());
+        dequantize(halves.data(), bands, MelOutputFormat::FLOAT16, fromHalves.data());
+        
+        ASSERT_TRUE(byteRenderer.updateColumn(bytes.data(), bands));
+        ASSERT_TRUE(halfRenderer.updateColumn(halves.data(), bands));
+        ASSERT_TRUE(floatRenderer.updateColumn(fromBytes.data(), bands));
+    }
+    EXPECT_EQ(byteRenderer.getTextureData(), floatRenderer.getTextureData());
+    
+    // The data ring keeps the decoded floats
+    RingSnapshot byteSnapshot;
+    byteRenderer.snapshotRing(byteSnapshot);
+    EXPECT_FLOAT_EQ(byteSnapshot.melValues[5 * bands + 3], fromBytes[3]);
+    RingSnapshot halfSnapshot;
+    halfRenderer.snapshotRing(halfSnapshot);
+    EXPECT_FLOAT_EQ(halfSnapshot.melValues[5 * bands + 3], fromHalves[3]);
+    EXPECT_NEAR(fromHalves[3], column[3], 1e-3f);
+    
+    EXPECT_FALSE(byteRenderer.updateColumn(bytes.data(), bands - 1));
+    EXPECT_FALSE(halfRenderer.enqueueColumn(static_cast<const uint16_t*>(nullptr), bands));
+}
+
+// Test 21: Without a current context AUTO falls back to the CPU backend and OPENGL fails
+TEST(RenderBackendTest, HeadlessSelectionTest) {
+    if (OpenGLBackend::hasCurrentContext()) {
+        GTEST_SKIP() << "A GL context is current on this thread";
+    }
+    std::unique_ptr<RenderBackend> backend = createRenderBackend(RenderBackendType::AUTO, 8, 4);
+    ASSERT_NE(backend, nullptr);
+    EXPECT_EQ(backend->getType(), RenderBackendType::CPU);
+    EXPECT_EQ(createRenderBackend(RenderBackendType::OPENGL, 8, 4), nullptr);
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
@@ -0,0 +1,131 @@
+// melspec_batch: mel spectrogram of a WAV file on all cores.
+//
+// Usage: melspec_batch input.wav output.npy [options]
+//   --threads N       Worker threads (default: all cores)
+//   --frame N         Frame size in samples (default 1024)
+//   --hop N           Hop size in samples (default 512)
+//   --bands N         Mel bands (default 64)
+//   --min-freq HZ     Lowest filter frequency (default 20)
+//   --max-freq HZ     Highest filter frequency (default 8000, capped at Nyquist)
+//   --channel N       Channel of a multi-channel file (default 0)
+//   --chunk-frames N  Frames per work unit (default: automatic)
+//
+// The output is a float32 .npy array of shape (frames, bands), identical to
+// streaming the file through MelSpectrogramProcessor::processAudioSamples.
+
+#include "offline_spectrogram.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace melspectrogram;
+
+namespace {
+    void usage() {
+        std::fprintf(stderr,
+                     "usage: melspec_batch input.wav output.npy [--threads N] [--frame N] [--hop N]\n"
+                     "                     [--bands N] [--min-freq HZ] [--max-freq HZ] [--channel N]\n"
+                     "                     [--chunk-frames N]\n");
+    }
+
+    bool writeNpy(const std::string& path, const float* data, size_t rows, size_t cols) {
+        FILE* file = std::fopen(path.c_str(), "wb");
+        if (!file) return false;
+
+        std::string header = "{'descr': '<f4', 'fortran_order': False, 'shape': (" +
+                             std::to_string(rows) + ", " + std::to_string(cols) + "), }";
+        // Magic + version + length + header must be a multiple of 64 bytes, ending in '\n'
+        const size_t total = 10 + header.size() + 1;
+        header.append((64 - total % 64) % 64, ' ');
+        header.push_back('\n');
+        const uint16_t headerLength = static_cast<uint16_t>(header.size());
+
+        bool ok = std::fwrite("\x93NUMPY\x01\x00", 1, 8, file) == 8;
+        const uint8_t length[2] = {static_cast<uint8_t>(headerLength & 0xFF), static_cast<uint8_t>(headerLength >> 8)};
+        ok = ok && std::fwrite(length, 1, 2, file) == 2;
+        ok = ok && std::fwrite(header.data(), 1, header.size(), file) == header.size();
+        ok = ok && std::fwrite(data, sizeof(float), rows * cols, file) == rows * cols;
+        return std::fclose(file) == 0 && ok;
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        usage();
+        return 2;
+    }
+
+    AudioConfig config;
+    int threads = 0;
+    int channel = 0;
+    size_t chunkFrames = 0;
+    for (int i = 3; i < argc; ++i) {
+        const std::string option = argv[i];
+        if (i + 1 >= argc) {
+            usage();
+            return 2;
+        }
+        const char* value = argv[++i];
+        if (option == "--threads") threads = std::atoi(value);
+        else if (option == "--frame") config.frameSize = std::atoi(value);
+        else if (option == "--hop") config.hopSize = std::atoi(value);
+        else if (option == "--bands") config.numMelBands = std::atoi(value);
+        else if (option == "--min-freq") config.minFreq = static_cast<float>(std::atof(value));
+        else if (option == "--max-freq") config.maxFreq = static_cast<float>(std::atof(value));
+        else if (option == "--channel") channel = std::atoi(value);
+        else if (option == "--chunk-frames") chunkFrames = static_cast<size_t>(std::atol(value));
+        else {
+            usage();
+            return 2;
+        }
+    }
+
+    MappedWav wav;
+    if (!wav.open(argv[1])) {
+        std::fprintf(stderr, "melspec_batch: %s\n", wav.getError().c_str());
+        return 1;
+    }
+    config.sampleRate = wav.getSampleRate();
+    config.maxFreq = std::min(config.maxFreq, config.sampleRate / 2.0f);
+    if (config.frameSize <= 0 || config.hopSize <= 0 || config.hopSize > config.frameSize ||
+        config.numMelBands <= 0 || config.minFreq >= config.maxFreq) {
+        std::fprintf(stderr, "melspec_batch: invalid framing or filter options\n");
+        return 2;
+    }
+
+    // Mono files are processed straight from the mapping
+    const int16_t* samples = wav.samples();
+    size_t numSamples = wav.numFrames();
+    std::vector<int16_t> channelData;
+    if (wav.getNumChannels() > 1) {
+        if (!wav.extractChannel(channel, channelData)) {
+            std::fprintf(stderr, "melspec_batch: file has no channel %d\n", channel);
+            return 2;
+        }
+        samples = channelData.data();
+    }
+
+    const size_t numFrames = OfflineSpectrogram::frameCount(numSamples, config);
+    std::vector<float> output(numFrames * config.numMelBands);
+    OfflineSpectrogram spectrogram(config, threads, chunkFrames);
+    if (spectrogram.process(samples, numSamples, output.data(), numFrames) < 0) {
+        std::fprintf(stderr, "melspec_batch: processing failed\n");
+        return 1;
+    }
+
+    if (!writeNpy(argv[2], output.data(), numFrames, config.numMelBands)) {
+        std::fprintf(stderr, "melspec_batch: cannot write %s\n", argv[2]);
+        return 1;
+    }
+
+    const OfflineStats stats = spectrogram.getStats();
+    const double audioSeconds = static_cast<double>(numSamples) / config.sampleRate;
+    std::fprintf(stderr, "%zu frames x %d bands from %.1f s of audio in %.1f ms on %d threads "
+                 "(%zu chunks, %zu steals, %.0fx real time)\n",
+                 numFrames, config.numMelBands, audioSeconds, stats.elapsedMs, stats.numThreads,
+                 stats.chunks, stats.steals, stats.elapsedMs > 0 ? audioSeconds * 1000.0 / stats.elapsedMs : 0.0);
+    return 0;
+}